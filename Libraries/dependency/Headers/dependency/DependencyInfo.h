@@ -10,9 +10,13 @@
 #ifndef __dependency_DependencyInfo_h
 #define __dependency_DependencyInfo_h
 
+#include <dependency/DependencyInfoFormat.h>
+
 #include <string>
 #include <vector>
 
+namespace libutil { class Filesystem; }
+
 namespace dependency {
 
 /*
@@ -45,6 +49,13 @@ public:
     { return _outputs; }
     std::vector<std::string> &outputs()
     { return _outputs; }
+
+public:
+    /*
+     * Load dependency info from a file in any format. Some formats can
+     * contain multiple entries; all are appended to `dependencyInfo`.
+     */
+    static bool Load(libutil::Filesystem const *filesystem, std::string const &path, DependencyInfoFormat format, std::vector<DependencyInfo> *dependencyInfo);
 };
 
 }
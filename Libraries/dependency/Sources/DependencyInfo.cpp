@@ -8,8 +8,16 @@
  */
 
 #include <dependency/DependencyInfo.h>
+#include <dependency/BinaryDependencyInfo.h>
+#include <dependency/DirectoryDependencyInfo.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <libutil/Filesystem.h>
+
+#include <cassert>
+#include <cstdio>
 
 using dependency::DependencyInfo;
+using libutil::Filesystem;
 
 DependencyInfo::
 DependencyInfo(std::vector<std::string> const &inputs, std::vector<std::string> const &outputs) :
@@ -23,3 +31,52 @@ DependencyInfo() :
     DependencyInfo(std::vector<std::string>(), std::vector<std::string>())
 {
 }
+
+bool DependencyInfo::
+Load(Filesystem const *filesystem, std::string const &path, dependency::DependencyInfoFormat format, std::vector<DependencyInfo> *dependencyInfo)
+{
+    if (format == dependency::DependencyInfoFormat::Binary) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            fprintf(stderr, "error: failed to open %s\n", path.c_str());
+            return false;
+        }
+
+        auto binaryInfo = dependency::BinaryDependencyInfo::Deserialize(contents);
+        if (!binaryInfo) {
+            fprintf(stderr, "error: invalid binary dependency info\n");
+            return false;
+        }
+
+        dependencyInfo->push_back(binaryInfo->dependencyInfo());
+        return true;
+    } else if (format == dependency::DependencyInfoFormat::Directory) {
+        auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
+        if (!directoryInfo) {
+            fprintf(stderr, "error: invalid directory\n");
+            return false;
+        }
+
+        dependencyInfo->push_back(directoryInfo->dependencyInfo());
+        return true;
+    } else if (format == dependency::DependencyInfoFormat::Makefile) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            fprintf(stderr, "error: failed to open %s\n", path.c_str());
+            return false;
+        }
+
+        std::string makefileContents = std::string(contents.begin(), contents.end());
+        auto makefileInfo = dependency::MakefileDependencyInfo::Deserialize(makefileContents);
+        if (!makefileInfo) {
+            fprintf(stderr, "error: invalid makefile dependency info\n");
+            return false;
+        }
+
+        dependencyInfo->insert(dependencyInfo->end(), makefileInfo->dependencyInfo().begin(), makefileInfo->dependencyInfo().end());
+        return true;
+    } else {
+        assert(false);
+        return false;
+    }
+}
@@ -16,12 +16,8 @@
 #include <process/Context.h>
 
 #include <dependency/DependencyInfo.h>
-#include <dependency/BinaryDependencyInfo.h>
-#include <dependency/DirectoryDependencyInfo.h>
 #include <dependency/MakefileDependencyInfo.h>
 
-#include <cassert>
-
 using libutil::Escape;
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
@@ -143,55 +139,6 @@ Version()
     return 0;
 }
 
-static bool
-LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, dependency::DependencyInfoFormat format, std::vector<dependency::DependencyInfo> *dependencyInfo)
-{
-    if (format == dependency::DependencyInfoFormat::Binary) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, path)) {
-            fprintf(stderr, "error: failed to open %s\n", path.c_str());
-            return false;
-        }
-
-        auto binaryInfo = dependency::BinaryDependencyInfo::Deserialize(contents);
-        if (!binaryInfo) {
-            fprintf(stderr, "error: invalid binary dependency info\n");
-            return false;
-        }
-
-        dependencyInfo->push_back(binaryInfo->dependencyInfo());
-        return true;
-    } else if (format == dependency::DependencyInfoFormat::Directory) {
-        auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
-        if (!directoryInfo) {
-            fprintf(stderr, "error: invalid directory\n");
-            return false;
-        }
-
-        dependencyInfo->push_back(directoryInfo->dependencyInfo());
-        return true;
-    } else if (format == dependency::DependencyInfoFormat::Makefile) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, path)) {
-            fprintf(stderr, "error: failed to open %s\n", path.c_str());
-            return false;
-        }
-
-        std::string makefileContents = std::string(contents.begin(), contents.end());
-        auto makefileInfo = dependency::MakefileDependencyInfo::Deserialize(makefileContents);
-        if (!makefileInfo) {
-            fprintf(stderr, "error: invalid makefile dependency info\n");
-            return false;
-        }
-
-        dependencyInfo->insert(dependencyInfo->end(), makefileInfo->dependencyInfo().begin(), makefileInfo->dependencyInfo().end());
-        return true;
-    } else {
-        assert(false);
-        return false;
-    }
-}
-
 static std::string
 SerializeMakefileDependencyInfo(std::string const &currentDirectory, std::string const &output, std::vector<std::string> const &inputs)
 {
@@ -247,7 +194,7 @@ main(int argc, char **argv)
          * Load the dependency info.
          */
         std::vector<dependency::DependencyInfo> info;
-        if (!LoadDependencyInfo(&filesystem, input.second, input.first, &info)) {
+        if (!dependency::DependencyInfo::Load(&filesystem, input.second, input.first, &info)) {
             return -1;
         }
 
@@ -18,6 +18,7 @@ class DefaultFilesystem : public Filesystem {
 public:
     virtual bool exists(std::string const &path) const;
     virtual ext::optional<Type> type(std::string const &path) const;
+    virtual bool readInfo(std::string const &path, uint64_t *size, uint64_t *modificationTime) const;
 
 public:
     virtual bool isReadable(std::string const &path) const;
@@ -30,7 +31,9 @@ public:
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool writeChunks(std::function<bool(std::function<bool(std::vector<uint8_t> const &)> const &)> const &chunks, std::string const &path);
     virtual bool copyFile(std::string const &from, std::string const &to);
+    virtual bool moveFile(std::string const &from, std::string const &to);
     virtual bool removeFile(std::string const &path);
 
 public:
@@ -50,6 +50,13 @@ public:
      */
     virtual ext::optional<Type> type(std::string const &path) const = 0;
 
+    /*
+     * Get the size and modification time of a filesystem entry. The time
+     * is in nanoseconds since an arbitrary epoch, and is only meaningful
+     * when compared to other times from the same filesystem.
+     */
+    virtual bool readInfo(std::string const &path, uint64_t *size, uint64_t *modificationTime) const = 0;
+
 public:
     /*
      * Test if a file is readable.
@@ -93,11 +100,25 @@ public:
      */
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path) = 0;
 
+    /*
+     * Write to a file in chunks, through one open handle. The callback is
+     * given a function to write each chunk with, and fails the write by
+     * returning false.
+     */
+    virtual bool writeChunks(std::function<bool(std::function<bool(std::vector<uint8_t> const &)> const &)> const &chunks, std::string const &path) = 0;
+
     /*
      * Copy a file to a new path.
      */
     virtual bool copyFile(std::string const &from, std::string const &to);
 
+    /*
+     * Move a file to a new path, replacing any file already there. Where
+     * possible, the file is replaced atomically, so it is never seen with
+     * partial contents.
+     */
+    virtual bool moveFile(std::string const &from, std::string const &to);
+
     /*
      * Delete a file.
      */
@@ -24,6 +24,7 @@ public:
         Type                 _type;
         std::vector<uint8_t> _contents;
         std::vector<Entry>   _children;
+        uint64_t             _modificationTime;
 
     private:
         Entry(std::string const &name, Type type);
@@ -45,6 +46,10 @@ public:
         { return _children; }
         std::vector<Entry> const &children() const
         { return _children; }
+        uint64_t &modificationTime()
+        { return _modificationTime; }
+        uint64_t modificationTime() const
+        { return _modificationTime; }
 
     public:
         MemoryFilesystem::Entry *child(std::string const &name);
@@ -56,7 +61,8 @@ public:
     };
 
 private:
-    Entry _root;
+    Entry    _root;
+    uint64_t _clock;
 
 public:
     MemoryFilesystem(std::vector<Entry> const &entries);
@@ -70,6 +76,7 @@ public:
 public:
     virtual bool exists(std::string const &path) const;
     virtual ext::optional<Type> type(std::string const &path) const;
+    virtual bool readInfo(std::string const &path, uint64_t *size, uint64_t *modificationTime) const;
 
 public:
     virtual bool isReadable(std::string const &path) const;
@@ -82,6 +89,7 @@ public:
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool writeChunks(std::function<bool(std::function<bool(std::vector<uint8_t> const &)> const &)> const &chunks, std::string const &path);
     virtual bool copyFile(std::string const &from, std::string const &to);
     virtual bool removeFile(std::string const &path);
 
@@ -11,10 +11,99 @@
 #define __libutil_Wildcard_h
 
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
 
 namespace libutil {
 
-struct Wildcard {
+/*
+ * A shell-style wildcard pattern. A `*` matches any number of characters,
+ * and `[abc]` matches any one of the characters listed. Anything else,
+ * including a `[` without a closing `]`, matches itself.
+ *
+ * Patterns are compiled once so they can be matched against many strings.
+ * The common forms, like `*.m` or `iphoneos*`, match with a single string
+ * comparison.
+ */
+class Wildcard {
+public:
+    /*
+     * A set of patterns, to find the first that matches a string without
+     * trying each in turn. Patterns that can only match strings with a
+     * specific extension are only tried on strings with that extension.
+     */
+    class Set {
+    private:
+        std::vector<Wildcard>                                _wildcards;
+        std::unordered_map<std::string, std::vector<size_t>> _extensions;
+        std::vector<size_t>                                  _general;
+
+    public:
+        explicit Set(std::vector<std::string> const &patterns);
+
+    public:
+        /*
+         * The compiled patterns, in the order given.
+         */
+        std::vector<Wildcard> const &wildcards() const
+        { return _wildcards; }
+
+    public:
+        /*
+         * The index of the first pattern matching the string, if any.
+         */
+        ext::optional<size_t> match(std::string const &string) const;
+    };
+
+private:
+    enum class Kind {
+        Literal,
+        Prefix,
+        Suffix,
+        Any,
+        General,
+    };
+
+    /*
+     * The characters allowed at each position between two stars.
+     */
+    typedef std::vector<std::string> Segment;
+
+private:
+    std::string          _pattern;
+    Kind                 _kind;
+    std::string          _literal;
+    std::vector<Segment> _segments;
+
+public:
+    explicit Wildcard(std::string const &pattern);
+
+public:
+    /*
+     * The pattern this was compiled from.
+     */
+    std::string const &pattern() const
+    { return _pattern; }
+
+public:
+    /*
+     * If the string matches the pattern.
+     */
+    bool match(std::string const &string) const;
+
+    /*
+     * The extension, including the dot, that every string matching the
+     * pattern ends with. For example, `.m` for `*.m`. None if a matching
+     * string could have any extension.
+     */
+    ext::optional<std::string> extension() const;
+
+public:
+    /*
+     * Match a pattern against a string without compiling it. Prefer
+     * compiling patterns used more than once.
+     */
     static bool Match(std::string const &pattern, std::string const &string);
 };
 
@@ -55,6 +55,23 @@ type(std::string const &path) const
     }
 }
 
+bool DefaultFilesystem::
+readInfo(std::string const &path, uint64_t *size, uint64_t *modificationTime) const
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0) {
+        return false;
+    }
+
+    *size = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    *modificationTime = static_cast<uint64_t>(st.st_mtimespec.tv_sec) * 1000000000ull + static_cast<uint64_t>(st.st_mtimespec.tv_nsec);
+#else
+    *modificationTime = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+#endif
+    return true;
+}
+
 bool DefaultFilesystem::
 isReadable(std::string const &path) const
 {
@@ -327,6 +344,26 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     return true;
 }
 
+bool DefaultFilesystem::
+writeChunks(std::function<bool(std::function<bool(std::vector<uint8_t> const &)> const &)> const &chunks, std::string const &path)
+{
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    bool success = chunks([&](std::vector<uint8_t> const &contents) -> bool {
+        return (contents.empty() || std::fwrite(contents.data(), contents.size(), 1, fp) == 1);
+    });
+
+    /* Closing flushes what's left, which can fail too. */
+    if (std::fclose(fp) != 0) {
+        return false;
+    }
+
+    return success;
+}
+
 bool DefaultFilesystem::
 copyFile(std::string const &from, std::string const &to)
 {
@@ -367,6 +404,21 @@ copyFile(std::string const &from, std::string const &to)
 #endif
 }
 
+bool DefaultFilesystem::
+moveFile(std::string const &from, std::string const &to)
+{
+    if (::rename(from.c_str(), to.c_str()) == 0) {
+        return true;
+    }
+
+    /* Renaming can't cross filesystems. */
+    if (errno == EXDEV) {
+        return Filesystem::moveFile(from, to);
+    }
+
+    return false;
+}
+
 bool DefaultFilesystem::
 removeFile(std::string const &path)
 {
@@ -453,7 +505,7 @@ createDirectory(std::string const &path, bool recursive)
         std::stack<std::string> create;
 
         /* Build up list of directories to create. */
-        while (this->type(path) != Type::Directory) {
+        while (this->type(current) != Type::Directory) {
             create.push(current);
             current = FSUtil::GetDirectoryName(current);
         }
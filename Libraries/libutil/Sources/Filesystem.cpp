@@ -32,6 +32,16 @@ copyFile(std::string const &from, std::string const &to)
     return true;
 }
 
+bool Filesystem::
+moveFile(std::string const &from, std::string const &to)
+{
+    if (!this->copyFile(from, to)) {
+        return false;
+    }
+
+    return this->removeFile(from);
+}
+
 bool Filesystem::
 copySymbolicLink(std::string const &from, std::string const &to)
 {
@@ -21,8 +21,9 @@ using libutil::FSUtil;
 
 MemoryFilesystem::Entry::
 Entry(std::string const &name, Type type) :
-    _name(name),
-    _type(type)
+    _name            (name),
+    _type            (type),
+    _modificationTime(0)
 {
 }
 
@@ -72,7 +73,8 @@ Directory(std::string const &name, std::vector<Entry> const &children)
 
 MemoryFilesystem::
 MemoryFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
-    _root(MemoryFilesystem::Entry::Directory("/", entries))
+    _root (MemoryFilesystem::Entry::Directory("/", entries)),
+    _clock(0)
 {
 }
 
@@ -160,6 +162,19 @@ type(std::string const &path) const
     return type;
 }
 
+bool MemoryFilesystem::
+readInfo(std::string const &path, uint64_t *size, uint64_t *modificationTime) const
+{
+    return WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
+        if (entry != nullptr) {
+            *size = entry->contents().size();
+            *modificationTime = entry->modificationTime();
+        }
+
+        return entry;
+    });
+}
+
 bool MemoryFilesystem::
 isReadable(std::string const &path) const
 {
@@ -234,7 +249,7 @@ writeDirectoryPermissions(std::string const &path, Permissions::Operation operat
 bool MemoryFilesystem::
 createFile(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::File) {
                 /* Exists as a file. */
@@ -246,6 +261,7 @@ createFile(std::string const &path)
         } else {
             /* Add empty file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>());
+            file.modificationTime() = ++_clock;
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -281,6 +297,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
             if (entry->type() == Type::File) {
                 /* Exists as a file, replace contents. */
                 entry->contents() = contents;
+                entry->modificationTime() = ++_clock;
                 return entry;
             } else {
                 /* Exists already, but not as a file. */
@@ -289,6 +306,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
         } else {
             /* Add file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, contents);
+            file.modificationTime() = ++_clock;
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -296,6 +314,22 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     });
 }
 
+bool MemoryFilesystem::
+writeChunks(std::function<bool(std::function<bool(std::vector<uint8_t> const &)> const &)> const &chunks, std::string const &path)
+{
+    /* Collected first, so a failed write leaves the file as it was. */
+    std::vector<uint8_t> contents;
+    bool success = chunks([&](std::vector<uint8_t> const &chunk) -> bool {
+        contents.insert(contents.end(), chunk.begin(), chunk.end());
+        return true;
+    });
+    if (!success) {
+        return false;
+    }
+
+    return write(contents, path);
+}
+
 bool MemoryFilesystem::
 copyFile(std::string const &from, std::string const &to)
 {
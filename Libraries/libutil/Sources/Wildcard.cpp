@@ -13,33 +13,255 @@
 
 using libutil::Wildcard;
 
+Wildcard::
+Wildcard(std::string const &pattern) :
+    _pattern (pattern),
+    _kind    (Kind::General),
+    _segments(1)
+{
+    /*
+     * Split the pattern at each star, and each part into the characters
+     * allowed at each position.
+     */
+    bool literal = true;
+    for (std::string::const_iterator it = pattern.begin(); it != pattern.end(); ++it) {
+        std::string::const_iterator end;
+        if (*it == '*') {
+            _segments.push_back(Segment());
+        } else if (*it == '[' && (end = std::find(it, pattern.end(), ']')) != pattern.end()) {
+            _segments.back().push_back(std::string(std::next(it), end));
+            literal = literal && (end - it == 2);
+            it = end;
+        } else {
+            _segments.back().push_back(std::string(1, *it));
+        }
+    }
+
+    if (!literal || _segments.size() > 2) {
+        return;
+    }
+
+    std::string first;
+    for (std::string const &characters : _segments.front()) {
+        first += characters;
+    }
+
+    if (_segments.size() == 1) {
+        _kind = Kind::Literal;
+        _literal = first;
+    } else if (_segments.back().empty()) {
+        _kind = (first.empty() ? Kind::Any : Kind::Prefix);
+        _literal = first;
+    } else if (first.empty()) {
+        _kind = Kind::Suffix;
+        for (std::string const &characters : _segments.back()) {
+            _literal += characters;
+        }
+    }
+}
+
+static bool
+SegmentMatch(std::vector<std::string> const &segment, std::string const &string, size_t offset)
+{
+    for (size_t n = 0; n < segment.size(); ++n) {
+        if (segment[n].find(string[offset + n]) == std::string::npos) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool Wildcard::
-Match(std::string const &pattern, std::string const &string)
+match(std::string const &string) const
 {
-    std::string::const_iterator sit = string.begin();
-    for (std::string::const_iterator fit = pattern.begin(); fit != pattern.end(); ++fit) {
-        std::string::const_iterator fend;
-        if (*fit == '*') {
-            if (++fit == pattern.end() || sit == string.end()) {
-                return true;
+    switch (_kind) {
+        case Kind::Literal:
+            return (string == _literal);
+        case Kind::Prefix:
+            return (string.size() >= _literal.size() && string.compare(0, _literal.size(), _literal) == 0);
+        case Kind::Suffix:
+            return (string.size() >= _literal.size() && string.compare(string.size() - _literal.size(), _literal.size(), _literal) == 0);
+        case Kind::Any:
+            return true;
+        case Kind::General:
+            break;
+    }
+
+    Segment const &first = _segments.front();
+    if (_segments.size() == 1) {
+        return (string.size() == first.size() && SegmentMatch(first, string, 0));
+    }
+
+    /*
+     * The first and last parts are anchored to the ends of the string.
+     */
+    Segment const &last = _segments.back();
+    if (string.size() < first.size() + last.size()) {
+        return false;
+    }
+    if (!SegmentMatch(first, string, 0) || !SegmentMatch(last, string, string.size() - last.size())) {
+        return false;
+    }
+
+    /*
+     * Each part in between can match anywhere after the one before it;
+     * the earliest match always leaves the most room for the rest.
+     */
+    size_t offset = first.size();
+    size_t end = string.size() - last.size();
+    for (auto it = std::next(_segments.begin()); it != std::prev(_segments.end()); ++it) {
+        while (true) {
+            if (offset + it->size() > end) {
+                return false;
+            }
+            if (SegmentMatch(*it, string, offset)) {
+                break;
             }
+            offset++;
+        }
+
+        offset += it->size();
+    }
+
+    return true;
+}
 
-            while (*sit++ != *fit) {
-                if (sit == string.end()) {
-                    return false;
-                }
+ext::optional<std::string> Wildcard::
+extension() const
+{
+    /*
+     * Look for a literal dot in the part after the last star, with only
+     * literal characters after it.
+     */
+    Segment const &last = _segments.back();
+    for (size_t n = last.size(); n > 0; --n) {
+        std::string const &characters = last[n - 1];
+        if (characters.size() != 1) {
+            return ext::nullopt;
+        }
+
+        if (characters == ".") {
+            std::string extension;
+            for (size_t m = n - 1; m < last.size(); ++m) {
+                extension += last[m];
             }
-        } else if (*fit == '[' && (fend = std::find(fit, pattern.end(), ']')) != pattern.end()) {
-            std::string allowed = std::string(std::next(fit), fend);
-            if (allowed.find(*sit++) == std::string::npos) {
-                return false;
+            return extension;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+/*
+ * Match one character of a pattern, other than a star. Returns where the
+ * next part of the pattern starts, if the character matches.
+ */
+static ext::optional<size_t>
+MatchOne(std::string const &pattern, size_t offset, char c)
+{
+    if (pattern[offset] == '[') {
+        size_t end = pattern.find(']', offset);
+        if (end != std::string::npos) {
+            if (std::find(pattern.begin() + offset + 1, pattern.begin() + end, c) == pattern.begin() + end) {
+                return ext::nullopt;
             }
-            fit = fend;
-        } else if (*fit != *sit++) {
+            return end + 1;
+        }
+    }
+
+    if (pattern[offset] != c) {
+        return ext::nullopt;
+    }
+    return offset + 1;
+}
+
+bool Wildcard::
+Match(std::string const &pattern, std::string const &string)
+{
+    /*
+     * On a mismatch, let the most recent star match one more character
+     * and try again from after it. Earlier stars never need to match more.
+     */
+    size_t p = 0;
+    size_t s = 0;
+    ext::optional<size_t> starPattern;
+    size_t starString = 0;
+
+    while (s < string.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = ++p;
+            starString = s;
+            continue;
+        }
+
+        ext::optional<size_t> next = (p < pattern.size() ? MatchOne(pattern, p, string[s]) : ext::nullopt);
+        if (next) {
+            p = *next;
+            s++;
+        } else if (starPattern) {
+            p = *starPattern;
+            s = ++starString;
+        } else {
             return false;
         }
     }
 
-    return (sit == string.end());
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+
+    return (p == pattern.size());
+}
+
+Wildcard::Set::
+Set(std::vector<std::string> const &patterns)
+{
+    for (std::string const &pattern : patterns) {
+        size_t index = _wildcards.size();
+        _wildcards.push_back(Wildcard(pattern));
+
+        ext::optional<std::string> extension = _wildcards.back().extension();
+        if (extension) {
+            _extensions[*extension].push_back(index);
+        } else {
+            _general.push_back(index);
+        }
+    }
 }
 
+ext::optional<size_t> Wildcard::Set::
+match(std::string const &string) const
+{
+    static std::vector<size_t> const none;
+
+    std::vector<size_t> const *extension = &none;
+    std::string::size_type dot = string.rfind('.');
+    if (dot != std::string::npos) {
+        auto it = _extensions.find(string.substr(dot));
+        if (it != _extensions.end()) {
+            extension = &it->second;
+        }
+    }
+
+    /*
+     * Try the candidates with a matching extension and those that could
+     * match any extension, in their original order.
+     */
+    auto eit = extension->begin();
+    auto git = _general.begin();
+    while (eit != extension->end() || git != _general.end()) {
+        size_t index;
+        if (git == _general.end() || (eit != extension->end() && *eit < *git)) {
+            index = *eit++;
+        } else {
+            index = *git++;
+        }
+
+        if (_wildcards[index].match(string)) {
+            return index;
+        }
+    }
+
+    return ext::nullopt;
+}
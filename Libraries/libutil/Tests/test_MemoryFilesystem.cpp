@@ -196,6 +196,34 @@ TEST(MemoryFilesystem, Write)
     EXPECT_FALSE(filesystem.exists("/invalid/new"));
 }
 
+TEST(MemoryFilesystem, WriteChunks)
+{
+    auto filesystem = BasicFilesystem();
+    std::vector<uint8_t> contents;
+
+    /* Chunks are written in order, replacing the contents. */
+    EXPECT_TRUE(filesystem.writeChunks([](std::function<bool(std::vector<uint8_t> const &)> const &write) -> bool {
+        return write(Contents("new")) && write(Contents("")) && write(Contents("two"));
+    }, "/file1"));
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/file1"));
+    EXPECT_EQ(contents, Contents("newtwo"));
+
+    /* A failed write leaves the file alone. */
+    EXPECT_FALSE(filesystem.writeChunks([](std::function<bool(std::vector<uint8_t> const &)> const &write) -> bool {
+        return write(Contents("partial")) && false;
+    }, "/file1"));
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/file1"));
+    EXPECT_EQ(contents, Contents("newtwo"));
+
+    /* Can't write over a directory. */
+    EXPECT_FALSE(filesystem.writeChunks([](std::function<bool(std::vector<uint8_t> const &)> const &write) -> bool {
+        return write(Contents("new"));
+    }, "/dir1"));
+    EXPECT_EQ(filesystem.type("/dir1"), Filesystem::Type::Directory);
+}
+
 TEST(MemoryFilesystem, CopyFile)
 {
     std::vector<uint8_t> contents;
@@ -221,6 +249,22 @@ TEST(MemoryFilesystem, CopyFile)
     EXPECT_EQ(contents, Contents("one"));
 }
 
+TEST(MemoryFilesystem, MoveFile)
+{
+    std::vector<uint8_t> contents;
+    auto filesystem = BasicFilesystem();
+
+    /* Can't move over a directory. */
+    EXPECT_FALSE(filesystem.moveFile("/file1", "/dir1"));
+    EXPECT_TRUE(filesystem.exists("/file1"));
+
+    /* Can move over an existing file. */
+    EXPECT_TRUE(filesystem.moveFile("/file1", "/dir1/file2"));
+    EXPECT_FALSE(filesystem.exists("/file1"));
+    EXPECT_TRUE(filesystem.read(&contents, "/dir1/file2"));
+    EXPECT_EQ(contents, Contents("one"));
+}
+
 TEST(MemoryFilesystem, RemoveFile)
 {
     auto filesystem = BasicFilesystem();
@@ -10,6 +10,8 @@
 #include <gtest/gtest.h>
 #include <libutil/Wildcard.h>
 
+#include <vector>
+
 using libutil::Wildcard;
 
 TEST(Wildcard, Basic)
@@ -49,3 +51,66 @@ TEST(Wildcard, One)
     EXPECT_FALSE(Wildcard::Match("[aA]", "b"));
 }
 
+
+TEST(Wildcard, Backtrack)
+{
+    /* A star can match past an earlier occurrence of what follows it. */
+    EXPECT_TRUE(Wildcard::Match("*.c", "main.test.c"));
+    EXPECT_TRUE(Wildcard::Match("a*b*c", "aXbYbZc"));
+    EXPECT_TRUE(Wildcard::Match("*ab", "aab"));
+    EXPECT_FALSE(Wildcard::Match("a*b", "a"));
+    EXPECT_FALSE(Wildcard::Match("*a*b", "ba"));
+}
+
+TEST(Wildcard, Compiled)
+{
+    std::vector<std::string> patterns = {
+        "", "a", "abcd", "*", "**", "a*", "*a", "*a*", "a*de", "a*d", "a*dce",
+        "*.c", "a*b*c", "*ab", "[", "[a]", "[aA]", "b[aA]d", "b[aei][dn]", "[]",
+        "*[.]m", "iphone*", "*simulator", "x[yz]*[.]cpp",
+    };
+    std::vector<std::string> strings = {
+        "", "a", "A", "aA", "b", "[", "ab", "aab", "ba", "abcd", "bcd", "abcde",
+        "main.c", "main.test.c", "aXbYbZc", "bAd", "bad", "ban", "bid", "file.m",
+        "iphoneos", "iphonesimulator", "xz.cpp", "xyw.cpp", "xy.c",
+    };
+
+    /* Compiled patterns match exactly the same strings. */
+    for (std::string const &pattern : patterns) {
+        Wildcard wildcard = Wildcard(pattern);
+        EXPECT_EQ(pattern, wildcard.pattern());
+        for (std::string const &string : strings) {
+            EXPECT_EQ(Wildcard::Match(pattern, string), wildcard.match(string)) << pattern << " " << string;
+        }
+    }
+}
+
+TEST(Wildcard, Extension)
+{
+    EXPECT_EQ(std::string(".m"), Wildcard("*.m").extension());
+    EXPECT_EQ(std::string(".cpp"), Wildcard("x*[.]cpp").extension());
+    EXPECT_EQ(std::string(".h"), Wildcard("Info.h").extension());
+    EXPECT_EQ(std::string(".tar"), Wildcard("*.gz*.tar").extension());
+    EXPECT_FALSE(Wildcard("*").extension());
+    EXPECT_FALSE(Wildcard("*.m*").extension());
+    EXPECT_FALSE(Wildcard("*.[mc]").extension());
+    EXPECT_FALSE(Wildcard("Makefile").extension());
+}
+
+TEST(Wildcard, Set)
+{
+    Wildcard::Set set = Wildcard::Set({ "*.c", "main*", "*.m", "*", "test.c" });
+    EXPECT_EQ(5, set.wildcards().size());
+
+    /* The first matching pattern wins, whatever its extension. */
+    EXPECT_EQ(ext::optional<size_t>(0), set.match("test.c"));
+    EXPECT_EQ(ext::optional<size_t>(1), set.match("main.m"));
+    EXPECT_EQ(ext::optional<size_t>(2), set.match("file.m"));
+    EXPECT_EQ(ext::optional<size_t>(3), set.match("file.h"));
+    EXPECT_EQ(ext::optional<size_t>(3), set.match("Makefile"));
+
+    Wildcard::Set sources = Wildcard::Set({ "*.c", "*.m" });
+    EXPECT_EQ(ext::optional<size_t>(1), sources.match("a.c.m"));
+    EXPECT_FALSE(sources.match("a.m.h"));
+    EXPECT_FALSE(sources.match(""));
+}
@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __ninja_Log_h
+#define __ninja_Log_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ninja {
+
+/*
+ * Reads the `.ninja_log` file Ninja writes into its build directory, which
+ * records when each output was last built.
+ */
+class Log {
+public:
+    /*
+     * One output of a build edge. Edges with several outputs have an entry
+     * for each, all with the same times and command hash.
+     */
+    class Entry {
+    private:
+        uint64_t    _start;
+        uint64_t    _end;
+        uint64_t    _modificationTime;
+        std::string _output;
+        std::string _commandHash;
+
+    public:
+        Entry(uint64_t start, uint64_t end, uint64_t modificationTime, std::string const &output, std::string const &commandHash);
+
+    public:
+        /*
+         * When the command started and finished, in milliseconds since
+         * the start of the Ninja run that built it.
+         */
+        uint64_t start() const
+        { return _start; }
+        uint64_t end() const
+        { return _end; }
+
+    public:
+        /*
+         * The modification time of the output after it was built.
+         */
+        uint64_t modificationTime() const
+        { return _modificationTime; }
+
+        /*
+         * The path of the output, as written in the Ninja file.
+         */
+        std::string const &output() const
+        { return _output; }
+
+        /*
+         * The hash of the command that built the output.
+         */
+        std::string const &commandHash() const
+        { return _commandHash; }
+    };
+
+public:
+    /*
+     * Parse the entries in a log, in the order Ninja wrote them. The
+     * contents do not have to start at the beginning of the file, so
+     * only the entries appended by one run can be parsed.
+     */
+    static bool
+    Parse(std::string const &contents, std::vector<Entry> *entries);
+};
+
+}
+
+#endif // !__ninja_Log_h
@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <ninja/Log.h>
+
+#include <cstdlib>
+
+using ninja::Log;
+
+Log::Entry::
+Entry(uint64_t start, uint64_t end, uint64_t modificationTime, std::string const &output, std::string const &commandHash) :
+    _start           (start),
+    _end             (end),
+    _modificationTime(modificationTime),
+    _output          (output),
+    _commandHash     (commandHash)
+{
+}
+
+static bool
+ParseNumber(std::string const &field, uint64_t *value)
+{
+    if (field.empty()) {
+        return false;
+    }
+
+    char *end = nullptr;
+    *value = std::strtoull(field.c_str(), &end, 10);
+    return (*end == '\0');
+}
+
+bool Log::
+Parse(std::string const &contents, std::vector<Entry> *entries)
+{
+    std::string::size_type offset = 0;
+    while (offset < contents.size()) {
+        std::string::size_type end = contents.find('\n', offset);
+        if (end == std::string::npos) {
+            /* A partial line is an entry still being written. */
+            break;
+        }
+
+        std::string line = contents.substr(offset, end - offset);
+        offset = end + 1;
+
+        /* Skip the version header and any blank lines. */
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        /*
+         * Each entry is: start, end, modification time, output, command hash.
+         */
+        std::vector<std::string> fields;
+        std::string::size_type fieldOffset = 0;
+        while (fields.size() < 4) {
+            std::string::size_type tab = line.find('\t', fieldOffset);
+            if (tab == std::string::npos) {
+                return false;
+            }
+
+            fields.push_back(line.substr(fieldOffset, tab - fieldOffset));
+            fieldOffset = tab + 1;
+        }
+        fields.push_back(line.substr(fieldOffset));
+
+        uint64_t start;
+        uint64_t finish;
+        uint64_t modificationTime;
+        if (!ParseNumber(fields[0], &start) || !ParseNumber(fields[1], &finish) || !ParseNumber(fields[2], &modificationTime)) {
+            return false;
+        }
+
+        entries->push_back(Entry(start, finish, modificationTime, fields[3], fields[4]));
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <ninja/Log.h>
+
+using ninja::Log;
+
+TEST(Log, Parse)
+{
+    std::string contents =
+        "# ninja log v5\n"
+        "0\t120\t1465000000\tbuild/main.o\t5a1d2b3c4d5e6f70\n"
+        "3\t250\t1465000001\tbuild/other file.o\t0123456789abcdef\n";
+
+    std::vector<Log::Entry> entries;
+    ASSERT_TRUE(Log::Parse(contents, &entries));
+    ASSERT_EQ(2, entries.size());
+
+    EXPECT_EQ(0, entries[0].start());
+    EXPECT_EQ(120, entries[0].end());
+    EXPECT_EQ(1465000000, entries[0].modificationTime());
+    EXPECT_EQ("build/main.o", entries[0].output());
+    EXPECT_EQ("5a1d2b3c4d5e6f70", entries[0].commandHash());
+
+    EXPECT_EQ(3, entries[1].start());
+    EXPECT_EQ("build/other file.o", entries[1].output());
+}
+
+TEST(Log, PartialContents)
+{
+    /* Appended entries have no header, and the last line may be incomplete. */
+    std::string contents =
+        "10\t20\t1465000000\ta.o\tabc\n"
+        "15\t3";
+
+    std::vector<Log::Entry> entries;
+    ASSERT_TRUE(Log::Parse(contents, &entries));
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ("a.o", entries[0].output());
+}
+
+TEST(Log, Invalid)
+{
+    std::vector<Log::Entry> entries;
+    EXPECT_FALSE(Log::Parse("10\t20\ta.o\n", &entries));
+    EXPECT_FALSE(Log::Parse("ten\t20\t0\ta.o\tabc\n", &entries));
+}
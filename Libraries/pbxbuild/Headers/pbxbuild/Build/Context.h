@@ -15,6 +15,7 @@
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/Target/Environment.h>
 
+#include <mutex>
 #include <ext/optional>
 
 namespace pbxbuild {
@@ -37,6 +38,7 @@ private:
 
 private:
     std::shared_ptr<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>> _targetEnvironments;
+    std::shared_ptr<std::mutex>                                                                 _targetEnvironmentsMutex;
 
 public:
     Context(
@@ -107,7 +109,8 @@ public:
 
 public:
     /*
-     * Create or fetch a target's computed environment.
+     * Create or fetch a target's computed environment. Safe to call from
+     * multiple threads, for targets building in parallel.
      */
     ext::optional<Target::Environment>
     targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const;
@@ -11,6 +11,7 @@
 #define __pbxbuild_Target_BuildRules_h
 
 #include <pbxbuild/Base.h>
+#include <libutil/Wildcard.h>
 
 namespace pbxbuild {
 namespace Target {
@@ -53,7 +54,9 @@ public:
     };
 
 private:
-    BuildRule::vector _buildRules;
+    BuildRule::vector      _buildRules;
+    std::vector<size_t>    _filePatternRules;
+    libutil::Wildcard::Set _filePatterns;
 
 private:
     BuildRules(BuildRule::vector const &buildRules);
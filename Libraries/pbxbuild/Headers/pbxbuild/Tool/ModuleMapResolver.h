@@ -30,6 +30,14 @@ public:
         pbxsetting::Environment const &environment,
         pbxproj::PBX::Target::shared_ptr const &target) const;
 
+public:
+    /*
+     * Module maps are written as auxiliary files; there is no specification
+     * for this tool, so this only identifies their invocations.
+     */
+    static std::string ToolIdentifier()
+    { return "com.apple.build-tasks.module-map"; }
+
 public:
     static std::unique_ptr<ModuleMapResolver>
     Create();
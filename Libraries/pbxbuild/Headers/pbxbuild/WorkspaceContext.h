@@ -15,6 +15,7 @@
 #include <pbxsetting/XC/Config.h>
 
 namespace pbxsetting { class Environment; }
+namespace pbxsetting { namespace XC { class ConfigCache; } }
 namespace libutil { class Filesystem; }
 
 namespace pbxbuild {
@@ -119,16 +120,17 @@ public:
 
 public:
     /*
-     * Creates a workspace context from a real workspace.
+     * Creates a workspace context from a real workspace. Configuration files
+     * are loaded through the config cache, if one is provided.
      */
     static WorkspaceContext
-    Workspace(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace);
+    Workspace(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace, pbxsetting::XC::ConfigCache *configCache);
 
     /*
      * Creates a workspace context for a legacy project-only build.
      */
     static WorkspaceContext
-    Project(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project);
+    Project(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project, pbxsetting::XC::ConfigCache *configCache);
 };
 
 }
@@ -42,6 +42,7 @@ ProcessModuleMap(
     /* Define source module map. */
     // TODO: it would be nicer to attach this to the copy invocation created below
     Tool::Invocation invocation;
+    invocation.toolIdentifier() = Tool::ModuleMapResolver::ToolIdentifier();
     invocation.auxiliaryFiles().push_back(auxiliaryFile);
     toolContext->invocations().push_back(invocation);
 
@@ -9,11 +9,9 @@
 
 #include <pbxbuild/Target/BuildRules.h>
 #include <libutil/FSUtil.h>
-#include <libutil/Wildcard.h>
 
 namespace Target = pbxbuild::Target;
 using libutil::FSUtil;
-using libutil::Wildcard;
 
 Target::BuildRules::BuildRule::
 BuildRule(std::string const &filePatterns, pbxspec::PBX::FileType::vector const &fileTypes, pbxspec::PBX::Tool::shared_ptr const &tool, std::string const &script, std::vector<pbxsetting::Value> const &outputFiles) :
@@ -25,21 +23,41 @@ BuildRule(std::string const &filePatterns, pbxspec::PBX::FileType::vector const
 {
 }
 
+static std::vector<std::string>
+FilePatterns(Target::BuildRules::BuildRule::vector const &buildRules, std::vector<size_t> *filePatternRules)
+{
+    std::vector<std::string> filePatterns;
+    for (size_t n = 0; n < buildRules.size(); ++n) {
+        if (!buildRules[n]->filePatterns().empty()) {
+            filePatterns.push_back(buildRules[n]->filePatterns());
+            filePatternRules->push_back(n);
+        }
+    }
+    return filePatterns;
+}
+
 Target::BuildRules::
 BuildRules(Target::BuildRules::BuildRule::vector const &buildRules) :
-    _buildRules(buildRules)
+    _buildRules  (buildRules),
+    _filePatterns(FilePatterns(buildRules, &_filePatternRules))
 {
 }
 
 Target::BuildRules::BuildRule::shared_ptr Target::BuildRules::
 resolve(pbxspec::PBX::FileType::shared_ptr const &fileType, std::string const &filePath) const
 {
-    for (BuildRule::shared_ptr const &buildRule : _buildRules) {
-        if (!buildRule->filePatterns().empty()) {
-            if (Wildcard::Match(buildRule->filePatterns(), FSUtil::GetBaseName(filePath))) {
-                return buildRule;
-            }
-        } else {
+    /*
+     * Find the first rule matching by file pattern, then check if any rule
+     * before it matches by file type.
+     */
+    size_t count = _buildRules.size();
+    if (ext::optional<size_t> filePattern = _filePatterns.match(FSUtil::GetBaseName(filePath))) {
+        count = _filePatternRules[*filePattern];
+    }
+
+    for (size_t n = 0; n < count; ++n) {
+        BuildRule::shared_ptr const &buildRule = _buildRules[n];
+        if (buildRule->filePatterns().empty()) {
             pbxspec::PBX::FileType::vector const &fileTypes = buildRule->fileTypes();
             for (pbxspec::PBX::FileType::shared_ptr FT = fileType; FT != nullptr; FT = FT->base()) {
                 if (std::find(fileTypes.begin(), fileTypes.end(), FT) != fileTypes.end()) {
@@ -49,7 +67,7 @@ resolve(pbxspec::PBX::FileType::shared_ptr const &fileType, std::string const &f
         }
     }
 
-    return nullptr;
+    return (count < _buildRules.size() ? _buildRules[count] : nullptr);
 }
 
 static Target::BuildRules::BuildRule::shared_ptr
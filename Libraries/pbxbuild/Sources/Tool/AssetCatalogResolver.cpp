@@ -102,6 +102,7 @@ resolve(
      */
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = arguments;
     invocation.environment() = environmentVariables;
     invocation.workingDirectory() = toolContext->workingDirectory();
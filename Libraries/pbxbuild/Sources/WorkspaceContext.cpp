@@ -9,6 +9,7 @@
 
 #include <pbxbuild/WorkspaceContext.h>
 #include <pbxsetting/Environment.h>
+#include <pbxsetting/XC/ConfigCache.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
@@ -155,6 +156,7 @@ static void
 LoadConfigurationFiles(
     Filesystem const *filesystem,
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
+    pbxsetting::XC::ConfigCache *configCache,
     pbxsetting::Environment const &environment,
     pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
 {
@@ -169,8 +171,11 @@ LoadConfigurationFiles(
         if (pbxproj::PBX::FileReference::shared_ptr const &configurationReference = buildConfiguration->baseConfigurationReference()) {
             std::string configurationPath = environment.expand(configurationReference->resolve());
 
-            /* Load the configuration file. */
-            if (ext::optional<pbxsetting::XC::Config> configuration = pbxsetting::XC::Config::Load(filesystem, environment, configurationPath)) {
+            /* Load the configuration file, using the cache if possible. */
+            ext::optional<pbxsetting::XC::Config> configuration = (configCache != nullptr
+                ? configCache->load(filesystem, environment, configurationPath)
+                : pbxsetting::XC::Config::Load(filesystem, environment, configurationPath));
+            if (configuration) {
                 configs->insert({ buildConfiguration, *configuration });
             }
         }
@@ -182,6 +187,7 @@ LoadNestedProjects(
     Filesystem const *filesystem,
     std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
+    pbxsetting::XC::ConfigCache *configCache,
     pbxsetting::Environment const &baseEnvironment,
     std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
 {
@@ -202,9 +208,9 @@ LoadNestedProjects(
         /*
          * Load project and target configurations.
          */
-        LoadConfigurationFiles(filesystem, configs, environment, project->buildConfigurationList());
+        LoadConfigurationFiles(filesystem, configs, configCache, environment, project->buildConfigurationList());
         for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-            LoadConfigurationFiles(filesystem, configs, environment, target->buildConfigurationList());
+            LoadConfigurationFiles(filesystem, configs, configCache, environment, target->buildConfigurationList());
         }
 
         /*
@@ -233,7 +239,7 @@ LoadNestedProjects(
         /*
          * Load nested projects of the nested projects.
          */
-        LoadNestedProjects(filesystem, projects, configs, baseEnvironment, nestedProjects);
+        LoadNestedProjects(filesystem, projects, configs, configCache, baseEnvironment, nestedProjects);
     }
 }
 
@@ -266,7 +272,7 @@ CreateProjectMap(std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
 }
 
 WorkspaceContext WorkspaceContext::
-Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace, pbxsetting::XC::ConfigCache *configCache)
 {
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
@@ -288,7 +294,7 @@ Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting:
     /*
      * Recursively load nested projects within those projects.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, &projects, &configs, configCache, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including nested projects.
@@ -304,7 +310,7 @@ Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting:
 }
 
 WorkspaceContext WorkspaceContext::
-Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
+Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project, pbxsetting::XC::ConfigCache *configCache)
 {
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
@@ -318,7 +324,7 @@ Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::E
     /*
      * Recursively load nested projects within the project.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, &projects, &configs, configCache, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including the root and nested projects.
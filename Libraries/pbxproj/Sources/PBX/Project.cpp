@@ -16,6 +16,7 @@
 #include <plist/Boolean.h>
 #include <plist/Integer.h>
 #include <plist/String.h>
+#include <plist/Arena.h>
 #include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
@@ -210,9 +211,11 @@ Open(Filesystem const *filesystem, std::string const &path)
     }
 
     //
-    // Parse property list
+    // Parse property list. It's only used while parsing the project, so
+    // allocate it in an arena that is released all at once.
     //
-    auto result = plist::Format::Any::Deserialize(contents);
+    plist::Arena arena;
+    auto result = plist::Format::Any::Deserialize(contents, &arena);
     if (result.first == nullptr) {
         fprintf(stderr, "error: project file %s is not parseable: %s\n", projectFileName.c_str(), result.second.c_str());
         return nullptr;
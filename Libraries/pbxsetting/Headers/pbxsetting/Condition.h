@@ -10,15 +10,19 @@
 #ifndef __pbxsetting_Condition_h
 #define __pbxsetting_Condition_h
 
+#include <libutil/Wildcard.h>
+
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
 class Condition {
 public:
 private:
-    std::unordered_map<std::string, std::string> _values;
+    std::unordered_map<std::string, std::string>           _values;
+    std::vector<std::pair<std::string, libutil::Wildcard>> _patterns;
 
 public:
     Condition(std::unordered_map<std::string, std::string> const &values);
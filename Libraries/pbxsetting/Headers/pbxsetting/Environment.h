@@ -13,27 +13,40 @@
 #include <pbxsetting/Condition.h>
 #include <pbxsetting/Level.h>
 
-#include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
 /*
  * Represents a hierarchical list of build settings (an ordered list of build
  * setting levels). Can use those levels to evaluate build setting values.
+ *
+ * Levels are kept in immutable linked lists shared with copies, so copying
+ * an environment and inserting a level at the front doesn't copy any of the
+ * existing levels. Resolved settings are cached until a level is inserted;
+ * copies share the cache until either is changed. Resolving is safe from
+ * multiple threads.
  */
 class Environment {
 private:
-    std::list<Level> _levels;
-    size_t           _offset;
+    struct LevelNode;
+    std::shared_ptr<LevelNode const> _levels;
+    std::shared_ptr<LevelNode const> _defaultLevels;
+
+private:
+    struct ConditionCache;
+    struct ResolutionCache;
+    std::shared_ptr<ResolutionCache> _cache;
 
 public:
     explicit Environment();
     explicit Environment(Environment const &) = default;
     Environment const &operator=(Environment const &) = delete;
-    Environment(Environment &&) = default;
-    Environment &operator=(Environment &&) = default;
+    Environment(Environment &&environment);
+    Environment &operator=(Environment &&environment);
 
 public:
     /*
@@ -56,6 +69,8 @@ public:
 public:
     /*
      * Computes all values for all settings present in the environment.
+     * Each setting is resolved once per condition, after the settings it
+     * references. Safe to call for environments on different threads.
      */
     std::unordered_map<std::string, std::string>
     computeValues(Condition const &condition) const;
@@ -75,6 +90,13 @@ public:
      */
     void insertBack(Level const &level, bool isDefault);
 
+public:
+    /*
+     * All levels in the environment, front to back, with the default levels
+     * last. Together with a condition, these determine every resolved value.
+     */
+    std::vector<Level> const &levels() const;
+
 public:
     /*
      * For debugging: print out the contents of all levels.
@@ -85,11 +107,13 @@ private:
     struct InheritanceContext {
         bool valid;
         std::string setting;
-        std::list<Level>::const_iterator it;
+        size_t index;
     };
-    std::string resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const;
-    std::string resolveInheritance(Condition const &condition, InheritanceContext const &context) const;
-    std::string resolveAssignment(Condition const &condition, std::string const &setting) const;
+    ConditionCache *conditionCache(Condition const &condition) const;
+    std::string resolveValue(Condition const &condition, ConditionCache *cache, Value const &value, InheritanceContext const &context) const;
+    std::string resolveReference(Condition const &condition, ConditionCache *cache, Value::Reference const &reference, InheritanceContext const &context) const;
+    std::string resolveInheritance(Condition const &condition, ConditionCache *cache, InheritanceContext const &context) const;
+    std::string resolveAssignment(Condition const &condition, ConditionCache *cache, std::string const &setting) const;
 };
 
 }
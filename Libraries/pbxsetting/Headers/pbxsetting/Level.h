@@ -15,6 +15,7 @@
 #include <pbxsetting/Value.h>
 
 #include <vector>
+#include <unordered_map>
 #include <utility>
 #include <memory>
 
@@ -29,6 +30,14 @@ class Level {
 private:
     std::shared_ptr<std::vector<Setting>> _settings;
 
+private:
+    /*
+     * The settings with each name, as indexes into the settings, with
+     * the last setting (which takes priority) first. Levels can hold
+     * hundreds of settings, but only a few share a name.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::vector<size_t>>> _index;
+
 public:
     /*
      * Creates a level with the given settings.
@@ -27,9 +27,116 @@ namespace pbxsetting {
  *
  *     $(SUFFIX_$(INDEX))_VALUE
  *
- * This class stores, not resolves, build setting value.
+ * This class stores, not resolves, build setting value. Values are
+ * immutable, and copies share their contents.
  */
 class Value {
+public:
+    /*
+     * An operation applied to the value of a setting reference, as in
+     * `$(SETTING:operation)`.
+     */
+    enum class Operation {
+        Identifier,
+        C99ExtIdentifier,
+        RFC1034Identifier,
+        Quote,
+        Lower,
+        Upper,
+        StandardizePath,
+        Base,
+        Dir,
+        File,
+        Suffix,
+        /*
+         * Operations not known when the value was created. These leave
+         * the value unchanged, with a warning.
+         */
+        Unknown,
+    };
+
+    /*
+     * A setting reference split into the setting and the operations on
+     * its value. The name is the full reference, including operations.
+     */
+    class Reference {
+    private:
+        std::string            _name;
+        std::string            _setting;
+        std::vector<Operation> _operations;
+
+    public:
+        Reference(std::string const &name, std::string const &setting, std::vector<Operation> const &operations);
+
+    public:
+        std::string const &name() const
+        { return _name; }
+        std::string const &setting() const
+        { return _setting; }
+        std::vector<Operation> const &operations() const
+        { return _operations; }
+
+    public:
+        /*
+         * Splits a reference name on `:` into the setting and operations.
+         */
+        static Reference
+        Parse(std::string const &name);
+    };
+
+    /*
+     * An instruction to expand the value. Values are compiled into a flat
+     * list of instructions when created, so expanding doesn't walk the AST
+     * or parse reference names. Only references with names that themselves
+     * contain references are split when expanded:
+     *
+     *     $(SUFFIX_$(INDEX):upper)
+     *
+     * compiles to: BeginReference, String "SUFFIX_", Reference INDEX,
+     * String ":upper", EndReference. The instructions between BeginReference and its
+     * EndReference expand to the name of the reference.
+     */
+    class Instruction {
+    public:
+        enum class Type {
+            /*
+             * Appends a literal string.
+             */
+            String,
+            /*
+             * Appends the value of a reference with a known name.
+             */
+            Reference,
+            /*
+             * Starts expanding the name of a reference.
+             */
+            BeginReference,
+            /*
+             * Appends the value of the reference whose name was expanded
+             * since the matching BeginReference.
+             */
+            EndReference,
+        };
+
+    private:
+        Type                     _type;
+        std::string              _string;
+        ext::optional<Reference> _reference;
+
+    public:
+        explicit Instruction(Type type);
+        explicit Instruction(std::string const &string);
+        explicit Instruction(Reference const &reference);
+
+    public:
+        Type type() const
+        { return _type; }
+        std::string const &string() const
+        { return _string; }
+        ext::optional<Reference> const &reference() const
+        { return _reference; }
+    };
+
 public:
     /*
      * A node in the AST describing the value. Can be a literal
@@ -66,7 +173,8 @@ public:
     };
 
 private:
-    std::vector<Entry> _entries;
+    struct Contents;
+    std::shared_ptr<Contents const> _contents;
 
 public:
     Value(std::vector<Entry> const &entries);
@@ -81,8 +189,12 @@ public:
     /*
      * The top level of the AST that makes up this value.
      */
-    std::vector<Entry> const &entries() const
-    { return _entries; }
+    std::vector<Entry> const &entries() const;
+
+    /*
+     * The value compiled for expansion.
+     */
+    std::vector<Instruction> const &instructions() const;
 
 public:
     /*
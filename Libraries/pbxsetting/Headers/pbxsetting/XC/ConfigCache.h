@@ -0,0 +1,110 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxsetting_XC_ConfigCache_h
+#define __pbxsetting_XC_ConfigCache_h
+
+#include <pbxsetting/XC/Config.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace pbxsetting { namespace XC {
+
+/*
+ * Parsed config files, stored on disk between builds. A cached config is
+ * used if it and every config it includes are the same size and have the
+ * same modification time as when they were parsed, and its includes still
+ * resolve to the same paths.
+ *
+ * Configs are stored in a compact binary form, and only decoded when used.
+ * Each config is stored once, however many configs include it.
+ */
+class ConfigCache {
+private:
+    /*
+     * A config stored in the cache file. The contents are decoded on use.
+     */
+    struct Record {
+        uint64_t size;
+        uint64_t modificationTime;
+        size_t   offset;
+        size_t   length;
+    };
+
+    /*
+     * A config parsed or decoded during this build.
+     */
+    struct Loaded {
+        uint64_t                size;
+        uint64_t                modificationTime;
+        std::shared_ptr<Config> config;
+    };
+
+private:
+    std::vector<uint8_t>                     _contents;
+    std::unordered_map<std::string, Record>  _records;
+
+private:
+    std::unordered_map<std::string, Loaded>  _loaded;
+    std::vector<std::string>                 _order;
+    bool                                     _modified;
+
+public:
+    ConfigCache();
+    ~ConfigCache();
+
+public:
+    /*
+     * Load a config, from the cache if it is up to date or from the file
+     * system if not. Arguments are as for `Config::Load()`.
+     */
+    ext::optional<Config>
+    load(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path);
+
+    /*
+     * If any config was loaded that was not already in the cache.
+     */
+    bool modified() const
+    { return _modified; }
+
+public:
+    /*
+     * Write the configs loaded so far to a cache file. Configs not
+     * loaded since the cache was read are dropped.
+     */
+    bool write(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Read a cache file. An empty cache is used if the file is missing,
+     * invalid, or written by a different version.
+     */
+    static std::unique_ptr<ConfigCache>
+    Read(libutil::Filesystem const *filesystem, std::string const &path);
+
+private:
+    std::shared_ptr<Config>
+    cached(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path);
+
+    std::shared_ptr<Config>
+    decode(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path, Record const &record);
+
+    bool
+    insert(libutil::Filesystem const *filesystem, std::shared_ptr<Config> const &config);
+};
+
+} }
+
+#endif  // !__pbxsetting_XC_ConfigCache_h
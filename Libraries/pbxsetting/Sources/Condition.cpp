@@ -17,6 +17,10 @@ Condition::
 Condition(std::unordered_map<std::string, std::string> const &values) :
     _values(values)
 {
+    /* Conditions are matched far more often than they are created. */
+    for (auto const &entry : _values) {
+        _patterns.push_back({ entry.first, Wildcard(entry.second) });
+    }
 }
 
 Condition::
@@ -27,14 +31,14 @@ Condition::
 bool Condition::
 match(Condition const &condition) const
 {
-    auto OV = condition._values;
-    for (auto const &TE : _values) {
+    auto const &OV = condition._values;
+    for (auto const &TE : _patterns) {
         auto OE = OV.find(TE.first);
         if (OE == OV.end()) {
             return false;
         }
 
-        if (!Wildcard::Match(TE.second, OE->second)) {
+        if (!TE.second.match(OE->second)) {
             return false;
         }
     }
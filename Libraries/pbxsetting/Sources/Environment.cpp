@@ -11,7 +11,10 @@
 #include <libutil/FSUtil.h>
 
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <ext/optional>
 
 using pbxsetting::Environment;
 using pbxsetting::Level;
@@ -20,19 +23,127 @@ using pbxsetting::Setting;
 using pbxsetting::Value;
 using libutil::FSUtil;
 
+/*
+ * A level and the levels behind it. Nodes are never changed once created,
+ * so they can be shared between environments.
+ */
+struct Environment::LevelNode {
+    Level                            level;
+    std::shared_ptr<LevelNode const> next;
+};
+
+/*
+ * Resolved settings for one condition. Assignments are keyed by setting;
+ * inheritance, by setting and the index of the level inherited from.
+ */
+struct Environment::ConditionCache {
+    std::mutex                                   mutex;
+    std::unordered_map<std::string, std::string> assignments;
+    std::unordered_map<std::string, std::string> inheritance;
+};
+
+/*
+ * Resolving walks the levels in order, so they are flattened into a vector
+ * the first time they are needed rather than each time one is inserted.
+ */
+struct Environment::ResolutionCache {
+    std::once_flag                                  flattened;
+    std::vector<Level>                              levels;
+
+    std::mutex                                      mutex;
+    std::unordered_map<std::string, ConditionCache> conditions;
+};
+
 Environment::
 Environment() :
-    _offset(0)
+    _cache(std::make_shared<ResolutionCache>())
 {
 }
 
+/*
+ * Copying is cheap, so moving copies: that leaves the moved from
+ * environment usable, with the same levels and cache.
+ */
+Environment::
+Environment(Environment &&environment) :
+    _levels       (environment._levels),
+    _defaultLevels(environment._defaultLevels),
+    _cache        (environment._cache)
+{
+}
+
+Environment &Environment::
+operator=(Environment &&environment)
+{
+    _levels = environment._levels;
+    _defaultLevels = environment._defaultLevels;
+    _cache = environment._cache;
+    return *this;
+}
+
+std::vector<Level> const &Environment::
+levels() const
+{
+    std::call_once(_cache->flattened, [this] {
+        for (LevelNode const *node : { _levels.get(), _defaultLevels.get() }) {
+            for (; node != nullptr; node = node->next.get()) {
+                _cache->levels.push_back(node->level);
+            }
+        }
+    });
+
+    return _cache->levels;
+}
+
 static std::string
-ProcessOperation(std::string const &value, std::string const &operation)
+ConditionKey(Condition const &condition)
+{
+    std::map<std::string, std::string> ordered = std::map<std::string, std::string>(condition.values().begin(), condition.values().end());
+
+    std::string key;
+    for (auto const &entry : ordered) {
+        key += entry.first + "=" + entry.second;
+        key += '\0';
+    }
+    return key;
+}
+
+static ext::optional<std::string>
+CacheFind(std::mutex *mutex, std::unordered_map<std::string, std::string> const &entries, std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return ext::nullopt;
+    }
+
+    return it->second;
+}
+
+static void
+CacheInsert(std::mutex *mutex, std::unordered_map<std::string, std::string> *entries, std::string const &key, std::string const &value)
+{
+    std::lock_guard<std::mutex> lock(*mutex);
+    entries->insert({ key, value });
+}
+
+Environment::ConditionCache *Environment::
+conditionCache(Condition const &condition) const
+{
+    std::string key = ConditionKey(condition);
+
+    std::lock_guard<std::mutex> lock(_cache->mutex);
+    return &_cache->conditions[key];
+}
+
+static std::string
+ProcessOperation(std::string const &value, Value::Operation operation, std::string const &name, size_t index)
 {
     const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
     const std::string digits = "0123456789";
 
-    if (operation == "identifier" || operation == "c99extidentifier") {
+    if (operation == Value::Operation::Identifier || operation == Value::Operation::C99ExtIdentifier) {
         // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
 
         const std::string begin = alphabet + "_";
@@ -46,7 +157,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "rfc1034identifier") {
+    } else if (operation == Value::Operation::RFC1034Identifier) {
         const std::string begin = alphabet;
         const std::string subsequent = alphabet + digits + "-";
         const std::string end = alphabet + digits;
@@ -77,7 +188,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "quote") {
+    } else if (operation == Value::Operation::Quote) {
         // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
         if (value.find_first_not_of(alphabet + digits + "@%_-+=:,./") == std::string::npos) {
             return value;
@@ -90,110 +201,150 @@ ProcessOperation(std::string const &value, std::string const &operation)
             }
             return "'" + result + "'";
         }
-    } else if (operation == "lower") {
+    } else if (operation == Value::Operation::Lower) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::tolower);
         return result;
-    } else if (operation == "upper") {
+    } else if (operation == Value::Operation::Upper) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::toupper);
         return result;
-    } else if (operation == "standardizepath") {
+    } else if (operation == Value::Operation::StandardizePath) {
         return FSUtil::NormalizePath(value);
-    } else if (operation == "base") {
+    } else if (operation == Value::Operation::Base) {
         return FSUtil::GetBaseNameWithoutExtension(value);
-    } else if (operation == "dir") {
+    } else if (operation == Value::Operation::Dir) {
         return FSUtil::GetDirectoryName(value);
-    } else if (operation == "file") {
+    } else if (operation == Value::Operation::File) {
         return FSUtil::GetBaseName(value);
-    } else if (operation == "suffix") {
+    } else if (operation == Value::Operation::Suffix) {
         return "." + FSUtil::GetFileExtension(value);
     } else {
-        fprintf(stderr, "warning: unknown build setting operation '%s'\n", operation.c_str());
+        /* Find the operation's name in the reference for the warning. */
+        std::string::size_type colon = name.find(':');
+        for (size_t n = 0; n < index; ++n) {
+            colon = name.find(':', colon + 1);
+        }
+        std::string::size_type next = name.find(':', colon + 1);
+        std::string unknown = name.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+
+        fprintf(stderr, "warning: unknown build setting operation '%s'\n", unknown.c_str());
         return value;
     }
 }
 
 std::string Environment::
-resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const
+resolveReference(Condition const &condition, ConditionCache *cache, Value::Reference const &reference, InheritanceContext const &context) const
 {
-    std::string result;
-    for (auto const &entry : value.entries()) {
-        switch (entry.type()) {
-            case Value::Entry::Type::String: {
-                result += *entry.string();
-                break;
-            }
-            case Value::Entry::Type::Value: {
-                std::string resolved = resolveValue(condition, *entry.value(), context);
-                if (context.valid && (resolved == context.setting || resolved == "inherited")) {
-                    result += resolveInheritance(condition, context);
-                } else {
-                    std::string setting = resolved;
-
-                    std::string::size_type colon = resolved.find(':');
-                    if (colon != std::string::npos) {
-                        setting = resolved.substr(0, colon);
-                    }
-
-                    std::string value = resolveAssignment(condition, setting);
+    if (context.valid && (reference.name() == context.setting || reference.name() == "inherited")) {
+        return resolveInheritance(condition, cache, context);
+    }
 
-                    while (colon != std::string::npos) {
-                        std::string::size_type next = resolved.find(':', colon + 1);
+    std::string value = resolveAssignment(condition, cache, reference.setting());
+    for (size_t n = 0; n < reference.operations().size(); ++n) {
+        value = ProcessOperation(value, reference.operations()[n], reference.name(), n);
+    }
+    return value;
+}
 
-                        std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
-                        value = ProcessOperation(value, operation);
+std::string Environment::
+resolveValue(Condition const &condition, ConditionCache *cache, Value const &value, InheritanceContext const &context) const
+{
+    std::string result;
 
-                        colon = next;
-                    }
+    /*
+     * Names of references being expanded, innermost last. Output goes to
+     * the innermost name, or the result if there is none.
+     */
+    std::vector<std::string> names;
+    std::string *output = &result;
+
+    for (Value::Instruction const &instruction : value.instructions()) {
+        switch (instruction.type()) {
+            case Value::Instruction::Type::String: {
+                output->append(instruction.string());
+                break;
+            }
+            case Value::Instruction::Type::Reference: {
+                output->append(resolveReference(condition, cache, *instruction.reference(), context));
+                break;
+            }
+            case Value::Instruction::Type::BeginReference: {
+                names.emplace_back();
+                output = &names.back();
+                break;
+            }
+            case Value::Instruction::Type::EndReference: {
+                Value::Reference reference = Value::Reference::Parse(names.back());
+                names.pop_back();
+                output = (names.empty() ? &result : &names.back());
 
-                    result += value;
-                }
+                output->append(resolveReference(condition, cache, reference, context));
                 break;
             }
         }
     }
+
     return result;
 }
 
 std::string Environment::
-resolveInheritance(Condition const &condition, InheritanceContext const &context) const
+resolveInheritance(Condition const &condition, ConditionCache *cache, InheritanceContext const &context) const
 {
+    std::string key = context.setting + '\0' + std::to_string(context.index);
+    if (ext::optional<std::string> cached = CacheFind(&cache->mutex, cache->inheritance, key)) {
+        return *cached;
+    }
+
+    std::string value;
+
+    std::vector<Level> const &levels = this->levels();
     InheritanceContext ctx = context;
-    for (++ctx.it; ctx.it != _levels.end(); ++ctx.it) {
-        auto result = ctx.it->get(ctx.setting, condition);
+    for (++ctx.index; ctx.index < levels.size(); ++ctx.index) {
+        auto result = levels[ctx.index].get(ctx.setting, condition);
         if (result.first) {
-            return resolveValue(condition, result.second, ctx);
+            value = resolveValue(condition, cache, result.second, ctx);
+            break;
         }
     }
 
-    return "";
+    CacheInsert(&cache->mutex, &cache->inheritance, key, value);
+    return value;
 }
 
 std::string Environment::
-resolveAssignment(Condition const &condition, std::string const &setting) const
+resolveAssignment(Condition const &condition, ConditionCache *cache, std::string const &setting) const
 {
-    InheritanceContext context = { .valid = true, .setting = setting };
+    if (ext::optional<std::string> cached = CacheFind(&cache->mutex, cache->assignments, setting)) {
+        return *cached;
+    }
+
+    std::string value;
+    bool found = false;
 
-    for (context.it = _levels.begin(); context.it != _levels.end(); ++context.it) {
-        Level const &level = *context.it;
-        auto result = level.get(setting, condition);
+    std::vector<Level> const &levels = this->levels();
+    InheritanceContext context = { .valid = true, .setting = setting, .index = 0 };
+    for (; context.index < levels.size(); ++context.index) {
+        auto result = levels[context.index].get(setting, condition);
         if (result.first) {
-            return resolveValue(condition, result.second, context);
+            value = resolveValue(condition, cache, result.second, context);
+            found = true;
+            break;
         }
     }
 
-    if (condition.values().empty()) {
-        return "";
-    } else {
-        return resolveAssignment(Condition::Empty(), setting);
+    if (!found && !condition.values().empty()) {
+        value = resolveAssignment(Condition::Empty(), conditionCache(Condition::Empty()), setting);
     }
+
+    CacheInsert(&cache->mutex, &cache->assignments, setting, value);
+    return value;
 }
 
 std::string Environment::
 expand(Value const &value, Condition const &condition) const
 {
-    return resolveValue(condition, value, { .valid = false });
+    return resolveValue(condition, conditionCache(condition), value, { .valid = false });
 }
 
 std::string Environment::
@@ -205,7 +356,7 @@ expand(Value const &value) const
 std::string Environment::
 resolve(std::string const &setting, Condition const &condition) const
 {
-    return resolveAssignment(condition, setting);
+    return resolveAssignment(condition, conditionCache(condition), setting);
 }
 
 std::string Environment::
@@ -218,11 +369,12 @@ std::unordered_map<std::string, std::string> Environment::
 computeValues(Condition const &condition) const
 {
     std::unordered_map<std::string, std::string> values;
+    ConditionCache *cache = conditionCache(condition);
 
-    for (Level const &level : _levels) {
+    for (Level const &level : levels()) {
         for (Setting const &setting : level.settings()) {
             if (values.find(setting.name()) == values.end()) {
-                values[setting.name()] = resolve(setting.name(), condition);
+                values[setting.name()] = resolveAssignment(condition, cache, setting.name());
             }
         }
     }
@@ -233,44 +385,50 @@ computeValues(Condition const &condition) const
 void Environment::
 insertFront(Level const &level, bool isDefault)
 {
-    if (!isDefault) {
-        _levels.push_front(level);
-        ++_offset;
-    } else {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
-    }
+    std::shared_ptr<LevelNode const> *levels = (isDefault ? &_defaultLevels : &_levels);
+    *levels = std::make_shared<LevelNode const>(LevelNode { level, *levels });
+
+    /* Don't change the cache shared with copies. */
+    _cache = std::make_shared<ResolutionCache>();
 }
 
 void Environment::
 insertBack(Level const &level, bool isDefault)
 {
-    if (!isDefault) {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
-        ++_offset;
-    } else {
-        _levels.push_back(level);
+    std::shared_ptr<LevelNode const> *levels = (isDefault ? &_defaultLevels : &_levels);
+
+    /* Nodes are shared, so the ones in front of the new level are copied. */
+    std::vector<Level> front;
+    for (LevelNode const *node = levels->get(); node != nullptr; node = node->next.get()) {
+        front.push_back(node->level);
     }
+
+    std::shared_ptr<LevelNode const> node = std::make_shared<LevelNode const>(LevelNode { level, nullptr });
+    for (auto it = front.rbegin(); it != front.rend(); ++it) {
+        node = std::make_shared<LevelNode const>(LevelNode { *it, node });
+    }
+    *levels = node;
+
+    _cache = std::make_shared<ResolutionCache>();
 }
 
 void Environment::
 dump() const
 {
-    size_t offset = 0;
-
-    for (Level const &level : _levels) {
-        if (offset == _offset) {
-            printf("=== Default Levels ===\n");
-        } else if (offset == 0) {
-            printf("=== Remaining Levels ===\n");
-        }
-
-        printf("Level:\n");
-        for (Setting const &setting : level.settings()) {
-            printf("    %s = %s\n", setting.name().c_str(), setting.value().raw().c_str());
+    std::pair<char const *, LevelNode const *> groups[] = {
+        { "Remaining", _levels.get() },
+        { "Default", _defaultLevels.get() },
+    };
+
+    for (auto const &group : groups) {
+        printf("=== %s Levels ===\n", group.first);
+
+        for (LevelNode const *node = group.second; node != nullptr; node = node->next.get()) {
+            printf("Level:\n");
+            for (Setting const &setting : node->level.settings()) {
+                printf("    %s = %s\n", setting.name().c_str(), setting.value().raw().c_str());
+            }
+            printf("\n");
         }
-        printf("\n");
-
-        ++offset;
     }
 }
-
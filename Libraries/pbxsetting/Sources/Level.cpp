@@ -16,8 +16,12 @@ using pbxsetting::Value;
 
 Level::
 Level(std::vector<Setting> const &settings) :
-    _settings(std::make_shared<std::vector<Setting>>(settings))
+    _settings(std::make_shared<std::vector<Setting>>(settings)),
+    _index   (std::make_shared<std::unordered_map<std::string, std::vector<size_t>>>())
 {
+    for (size_t n = _settings->size(); n > 0; --n) {
+        (*_index)[(*_settings)[n - 1].name()].push_back(n - 1);
+    }
 }
 
 Level::
@@ -28,9 +32,15 @@ Level::
 std::pair<bool, Value> Level::
 get(std::string const &setting, Condition const &condition) const
 {
-    for (auto it = _settings->rbegin(); it != _settings->rend(); ++it) {
-        if (it->match(setting, condition)) {
-            return std::make_pair(true, it->value());
+    auto it = _index->find(setting);
+    if (it == _index->end()) {
+        return std::make_pair(false, Value::Empty());
+    }
+
+    for (size_t index : it->second) {
+        Setting const &entry = (*_settings)[index];
+        if (entry.condition().match(condition)) {
+            return std::make_pair(true, entry.value());
         }
     }
 
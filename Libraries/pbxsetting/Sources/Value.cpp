@@ -15,10 +15,85 @@
 #include <plist/Real.h>
 #include <plist/String.h>
 
+#include <algorithm>
 #include <cassert>
 
 using pbxsetting::Value;
 
+Value::Reference::
+Reference(std::string const &name, std::string const &setting, std::vector<Operation> const &operations) :
+    _name      (name),
+    _setting   (setting),
+    _operations(operations)
+{
+}
+
+static Value::Operation
+ParseOperation(std::string const &operation)
+{
+    if (operation == "identifier") {
+        return Value::Operation::Identifier;
+    } else if (operation == "c99extidentifier") {
+        return Value::Operation::C99ExtIdentifier;
+    } else if (operation == "rfc1034identifier") {
+        return Value::Operation::RFC1034Identifier;
+    } else if (operation == "quote") {
+        return Value::Operation::Quote;
+    } else if (operation == "lower") {
+        return Value::Operation::Lower;
+    } else if (operation == "upper") {
+        return Value::Operation::Upper;
+    } else if (operation == "standardizepath") {
+        return Value::Operation::StandardizePath;
+    } else if (operation == "base") {
+        return Value::Operation::Base;
+    } else if (operation == "dir") {
+        return Value::Operation::Dir;
+    } else if (operation == "file") {
+        return Value::Operation::File;
+    } else if (operation == "suffix") {
+        return Value::Operation::Suffix;
+    } else {
+        return Value::Operation::Unknown;
+    }
+}
+
+Value::Reference Value::Reference::
+Parse(std::string const &name)
+{
+    std::string::size_type colon = name.find(':');
+    std::string setting = name.substr(0, colon);
+
+    std::vector<Operation> operations;
+    while (colon != std::string::npos) {
+        std::string::size_type next = name.find(':', colon + 1);
+        operations.push_back(ParseOperation(name.substr(colon + 1, next == std::string::npos ? next : next - colon - 1)));
+        colon = next;
+    }
+
+    return Reference(name, setting, operations);
+}
+
+Value::Instruction::
+Instruction(Type type) :
+    _type(type)
+{
+}
+
+Value::Instruction::
+Instruction(std::string const &string) :
+    _type  (Type::String),
+    _string(string)
+{
+}
+
+Value::Instruction::
+Instruction(Reference const &reference) :
+    _type     (Type::Reference),
+    _reference(reference)
+{
+}
+
 Value::Entry::
 Entry(std::string const &string) :
     _type  (Type::String),
@@ -54,10 +129,47 @@ operator!=(Entry const &entry) const
     return !(*this == entry);
 }
 
+struct Value::Contents {
+    std::vector<Entry>       entries;
+    std::vector<Instruction> instructions;
+};
+
+static void
+Compile(std::vector<Value::Entry> const &entries, std::vector<Value::Instruction> *instructions)
+{
+    for (Value::Entry const &entry : entries) {
+        switch (entry.type()) {
+            case Value::Entry::Type::String: {
+                instructions->push_back(Value::Instruction(*entry.string()));
+                break;
+            }
+            case Value::Entry::Type::Value: {
+                std::vector<Value::Entry> const &name = entry.value()->entries();
+                bool literal = std::all_of(name.begin(), name.end(), [](Value::Entry const &entry) {
+                    return entry.type() == Value::Entry::Type::String;
+                });
+
+                if (literal) {
+                    /* The name is known, so split it now. */
+                    instructions->push_back(Value::Instruction(Value::Reference::Parse(entry.value()->raw())));
+                } else {
+                    instructions->push_back(Value::Instruction(Value::Instruction::Type::BeginReference));
+                    Compile(name, instructions);
+                    instructions->push_back(Value::Instruction(Value::Instruction::Type::EndReference));
+                }
+                break;
+            }
+        }
+    }
+}
+
 Value::
-Value(std::vector<Entry> const &entries) :
-    _entries(entries)
+Value(std::vector<Entry> const &entries)
 {
+    auto contents = std::make_shared<Contents>();
+    contents->entries = entries;
+    Compile(contents->entries, &contents->instructions);
+    _contents = contents;
 }
 
 Value::
@@ -65,11 +177,23 @@ Value::
 {
 }
 
+std::vector<Value::Entry> const &Value::
+entries() const
+{
+    return _contents->entries;
+}
+
+std::vector<Value::Instruction> const &Value::
+instructions() const
+{
+    return _contents->instructions;
+}
+
 std::string Value::
 raw() const
 {
     std::string out;
-    for (Value::Entry const &entry : _entries) {
+    for (Value::Entry const &entry : _contents->entries) {
         switch (entry.type()) {
             case Value::Entry::Type::String: {
                 out += *entry.string();
@@ -87,7 +211,7 @@ raw() const
 bool Value::
 operator==(Value const &rhs) const
 {
-    return _entries == rhs._entries;
+    return _contents == rhs._contents || _contents->entries == rhs._contents->entries;
 }
 
 bool Value::
@@ -100,7 +224,7 @@ Value Value::
 operator+(Value const &rhs) const
 {
     std::vector<Value::Entry> entries;
-    entries.insert(entries.end(), _entries.begin(), _entries.end());
+    entries.insert(entries.end(), _contents->entries.begin(), _contents->entries.end());
 
     auto it = rhs.entries().begin();
     if (!entries.empty() && !rhs.entries().empty()) {
@@ -0,0 +1,449 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxsetting/XC/ConfigCache.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <cstring>
+
+using pbxsetting::XC::Config;
+using pbxsetting::XC::ConfigCache;
+using pbxsetting::Condition;
+using pbxsetting::Environment;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+static char const ConfigCacheMagic[8] = { 'x', 'c', 'c', 'o', 'n', 'f', 'i', 'g' };
+
+/*
+ * Bump when the format of the cache file changes.
+ */
+static uint32_t const ConfigCacheVersion = 1;
+
+/*
+ * Cache files are a header, then a record for each config:
+ *
+ *     path, size, modification time, length, entries
+ *
+ * Entries are settings (name, conditions, value) or includes (value, path
+ * of the included config). Values are a list of strings and nested values.
+ * Integers are little endian; strings have a 32-bit length prefix.
+ */
+enum class EntryType : uint8_t {
+    Setting = 0,
+    Include = 1,
+};
+
+static void
+WriteInteger(std::vector<uint8_t> *contents, uint64_t value, size_t bytes)
+{
+    for (size_t n = 0; n < bytes; ++n) {
+        contents->push_back(static_cast<uint8_t>(value >> (n * 8)));
+    }
+}
+
+static void
+WriteString(std::vector<uint8_t> *contents, std::string const &value)
+{
+    WriteInteger(contents, value.size(), 4);
+    contents->insert(contents->end(), value.begin(), value.end());
+}
+
+static void
+WriteValue(std::vector<uint8_t> *contents, Value const &value)
+{
+    WriteInteger(contents, value.entries().size(), 4);
+    for (Value::Entry const &entry : value.entries()) {
+        switch (entry.type()) {
+            case Value::Entry::Type::String:
+                WriteInteger(contents, 0, 1);
+                WriteString(contents, *entry.string());
+                break;
+            case Value::Entry::Type::Value:
+                WriteInteger(contents, 1, 1);
+                WriteValue(contents, *entry.value());
+                break;
+        }
+    }
+}
+
+static void
+WriteConfig(std::vector<uint8_t> *contents, Config const &config)
+{
+    for (Config::Entry const &entry : config.contents()) {
+        switch (entry.type()) {
+            case Config::Entry::Type::Setting: {
+                Setting const &setting = *entry.setting();
+                WriteInteger(contents, static_cast<uint8_t>(EntryType::Setting), 1);
+                WriteString(contents, setting.name());
+                WriteInteger(contents, setting.condition().values().size(), 4);
+                for (auto const &condition : setting.condition().values()) {
+                    WriteString(contents, condition.first);
+                    WriteString(contents, condition.second);
+                }
+                WriteValue(contents, setting.value());
+                break;
+            }
+            case Config::Entry::Type::Include:
+                WriteInteger(contents, static_cast<uint8_t>(EntryType::Include), 1);
+                WriteValue(contents, *entry.path());
+                WriteString(contents, entry.config()->path());
+                break;
+        }
+    }
+}
+
+static bool
+ReadInteger(std::vector<uint8_t> const &contents, size_t *offset, size_t end, size_t bytes, uint64_t *value)
+{
+    if (end - *offset < bytes) {
+        return false;
+    }
+
+    *value = 0;
+    for (size_t n = 0; n < bytes; ++n) {
+        *value |= static_cast<uint64_t>(contents[*offset + n]) << (n * 8);
+    }
+
+    *offset += bytes;
+    return true;
+}
+
+static bool
+ReadSize(std::vector<uint8_t> const &contents, size_t *offset, size_t end, size_t *value)
+{
+    uint64_t integer;
+    if (!ReadInteger(contents, offset, end, 4, &integer)) {
+        return false;
+    }
+
+    *value = static_cast<size_t>(integer);
+    return true;
+}
+
+static bool
+ReadString(std::vector<uint8_t> const &contents, size_t *offset, size_t end, std::string *value)
+{
+    size_t size;
+    if (!ReadSize(contents, offset, end, &size) || end - *offset < size) {
+        return false;
+    }
+
+    value->assign(reinterpret_cast<char const *>(contents.data()) + *offset, size);
+    *offset += size;
+    return true;
+}
+
+static ext::optional<Value>
+ReadValue(std::vector<uint8_t> const &contents, size_t *offset, size_t end)
+{
+    size_t count;
+    if (!ReadSize(contents, offset, end, &count)) {
+        return ext::nullopt;
+    }
+
+    std::vector<Value::Entry> entries;
+    entries.reserve(std::min(count, end - *offset));
+    for (size_t n = 0; n < count; ++n) {
+        uint64_t type;
+        if (!ReadInteger(contents, offset, end, 1, &type)) {
+            return ext::nullopt;
+        }
+
+        if (type == 0) {
+            std::string string;
+            if (!ReadString(contents, offset, end, &string)) {
+                return ext::nullopt;
+            }
+            entries.push_back(Value::Entry(string));
+        } else if (type == 1) {
+            ext::optional<Value> value = ReadValue(contents, offset, end);
+            if (!value) {
+                return ext::nullopt;
+            }
+            entries.push_back(Value::Entry(std::make_shared<Value>(*value)));
+        } else {
+            return ext::nullopt;
+        }
+    }
+
+    return Value(entries);
+}
+
+/*
+ * The path an include resolves to. Matches `Config::Load()`.
+ */
+static std::string
+IncludePath(Environment const &environment, std::string const &directory, Value const &path)
+{
+    return FSUtil::ResolveRelativePath(environment.expand(path), directory);
+}
+
+/*
+ * Includes can use build settings, so need checking each time they are
+ * used in case they now resolve to another file.
+ */
+static bool
+IncludesResolve(Environment const &environment, Config const &config)
+{
+    for (Config::Entry const &entry : config.contents()) {
+        if (entry.type() == Config::Entry::Type::Include) {
+            if (IncludePath(environment, FSUtil::GetDirectoryName(config.path()), *entry.path()) != entry.config()->path()) {
+                return false;
+            }
+
+            if (!IncludesResolve(environment, *entry.config())) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+ConfigCache::
+ConfigCache() :
+    _modified(false)
+{
+}
+
+ConfigCache::
+~ConfigCache()
+{
+}
+
+std::shared_ptr<Config> ConfigCache::
+decode(Filesystem const *filesystem, Environment const &environment, std::string const &path, Record const &record)
+{
+    std::string directory = FSUtil::GetDirectoryName(path);
+
+    std::vector<Config::Entry> entries;
+    size_t offset = record.offset;
+    size_t end = record.offset + record.length;
+    while (offset < end) {
+        uint64_t type;
+        if (!ReadInteger(_contents, &offset, end, 1, &type)) {
+            return nullptr;
+        }
+
+        if (type == static_cast<uint8_t>(EntryType::Setting)) {
+            std::string name;
+            size_t count;
+            if (!ReadString(_contents, &offset, end, &name) || !ReadSize(_contents, &offset, end, &count)) {
+                return nullptr;
+            }
+
+            std::unordered_map<std::string, std::string> conditions;
+            for (size_t n = 0; n < count; ++n) {
+                std::string key;
+                std::string value;
+                if (!ReadString(_contents, &offset, end, &key) || !ReadString(_contents, &offset, end, &value)) {
+                    return nullptr;
+                }
+                conditions.insert({ key, value });
+            }
+
+            ext::optional<Value> value = ReadValue(_contents, &offset, end);
+            if (!value) {
+                return nullptr;
+            }
+
+            entries.push_back(Config::Entry(Setting(name, Condition(conditions), *value)));
+        } else if (type == static_cast<uint8_t>(EntryType::Include)) {
+            ext::optional<Value> value = ReadValue(_contents, &offset, end);
+            std::string includePath;
+            if (!value || !ReadString(_contents, &offset, end, &includePath)) {
+                return nullptr;
+            }
+
+            if (IncludePath(environment, directory, *value) != includePath) {
+                return nullptr;
+            }
+
+            std::shared_ptr<Config> config = cached(filesystem, environment, includePath);
+            if (config == nullptr) {
+                return nullptr;
+            }
+
+            entries.push_back(Config::Entry(*value, config));
+        } else {
+            return nullptr;
+        }
+    }
+
+    std::shared_ptr<Config> config = std::make_shared<Config>(path, entries);
+    _loaded.insert({ path, Loaded { record.size, record.modificationTime, config } });
+    _order.push_back(path);
+    return config;
+}
+
+std::shared_ptr<Config> ConfigCache::
+cached(Filesystem const *filesystem, Environment const &environment, std::string const &path)
+{
+    /*
+     * Use a config already loaded during this build.
+     */
+    auto LI = _loaded.find(path);
+    if (LI != _loaded.end()) {
+        if (!IncludesResolve(environment, *LI->second.config)) {
+            return nullptr;
+        }
+
+        return LI->second.config;
+    }
+
+    /*
+     * Decode a stored config, if the file hasn't changed.
+     */
+    auto RI = _records.find(path);
+    if (RI == _records.end()) {
+        return nullptr;
+    }
+
+    uint64_t size;
+    uint64_t modificationTime;
+    if (!filesystem->readInfo(path, &size, &modificationTime)) {
+        return nullptr;
+    }
+
+    if (size != RI->second.size || modificationTime != RI->second.modificationTime) {
+        return nullptr;
+    }
+
+    return decode(filesystem, environment, path, RI->second);
+}
+
+bool ConfigCache::
+insert(Filesystem const *filesystem, std::shared_ptr<Config> const &config)
+{
+    if (_loaded.find(config->path()) != _loaded.end()) {
+        return true;
+    }
+
+    /* Included configs are stored first. */
+    for (Config::Entry const &entry : config->contents()) {
+        if (entry.type() == Config::Entry::Type::Include) {
+            if (!insert(filesystem, entry.config())) {
+                return false;
+            }
+        }
+    }
+
+    uint64_t size;
+    uint64_t modificationTime;
+    if (!filesystem->readInfo(config->path(), &size, &modificationTime)) {
+        return false;
+    }
+
+    _loaded.insert({ config->path(), Loaded { size, modificationTime, config } });
+    _order.push_back(config->path());
+    _modified = true;
+    return true;
+}
+
+ext::optional<Config> ConfigCache::
+load(Filesystem const *filesystem, Environment const &environment, std::string const &path)
+{
+    if (std::shared_ptr<Config> config = cached(filesystem, environment, path)) {
+        return *config;
+    }
+
+    ext::optional<Config> config = Config::Load(filesystem, environment, path);
+    if (config) {
+        /* A config that can't be stored is still usable. */
+        insert(filesystem, std::make_shared<Config>(*config));
+    }
+
+    return config;
+}
+
+bool ConfigCache::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    std::vector<uint8_t> contents;
+    contents.insert(contents.end(), std::begin(ConfigCacheMagic), std::end(ConfigCacheMagic));
+    WriteInteger(&contents, ConfigCacheVersion, 4);
+    WriteInteger(&contents, _order.size(), 4);
+
+    for (std::string const &configPath : _order) {
+        Loaded const &loaded = _loaded.at(configPath);
+        WriteString(&contents, configPath);
+        WriteInteger(&contents, loaded.size, 8);
+        WriteInteger(&contents, loaded.modificationTime, 8);
+
+        /* Fill in the length once the entries are written. */
+        size_t lengthOffset = contents.size();
+        WriteInteger(&contents, 0, 4);
+        WriteConfig(&contents, *loaded.config);
+
+        size_t length = contents.size() - lengthOffset - 4;
+        for (size_t n = 0; n < 4; ++n) {
+            contents[lengthOffset + n] = static_cast<uint8_t>(length >> (n * 8));
+        }
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    return filesystem->write(contents, path);
+}
+
+std::unique_ptr<ConfigCache> ConfigCache::
+Read(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<ConfigCache> cache = std::unique_ptr<ConfigCache>(new ConfigCache());
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->exists(path) || !filesystem->read(&contents, path)) {
+        return cache;
+    }
+
+    if (contents.size() < sizeof(ConfigCacheMagic) || memcmp(contents.data(), ConfigCacheMagic, sizeof(ConfigCacheMagic)) != 0) {
+        return cache;
+    }
+
+    size_t offset = sizeof(ConfigCacheMagic);
+    uint64_t version;
+    size_t count;
+    if (!ReadInteger(contents, &offset, contents.size(), 4, &version) || version != ConfigCacheVersion) {
+        return cache;
+    }
+    if (!ReadSize(contents, &offset, contents.size(), &count)) {
+        return cache;
+    }
+
+    /*
+     * Only find where each config is; they are decoded when used.
+     */
+    std::unordered_map<std::string, Record> records;
+    for (size_t n = 0; n < count; ++n) {
+        std::string configPath;
+        Record record;
+        if (!ReadString(contents, &offset, contents.size(), &configPath) ||
+            !ReadInteger(contents, &offset, contents.size(), 8, &record.size) ||
+            !ReadInteger(contents, &offset, contents.size(), 8, &record.modificationTime) ||
+            !ReadSize(contents, &offset, contents.size(), &record.length) ||
+            contents.size() - offset < record.length) {
+            return cache;
+        }
+
+        record.offset = offset;
+        offset += record.length;
+        records.insert({ configPath, record });
+    }
+
+    cache->_contents = std::move(contents);
+    cache->_records = std::move(records);
+    return cache;
+}
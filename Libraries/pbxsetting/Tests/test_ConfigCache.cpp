@@ -0,0 +1,151 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/XC/ConfigCache.h>
+#include <libutil/Filesystem.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxsetting::XC::Config;
+using pbxsetting::XC::ConfigCache;
+using pbxsetting::Environment;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static void
+ExpectSameLevel(Level const &expected, Level const &actual)
+{
+    ASSERT_EQ(expected.settings().size(), actual.settings().size());
+    for (size_t n = 0; n < expected.settings().size(); ++n) {
+        EXPECT_EQ(expected.settings()[n].name(), actual.settings()[n].name());
+        EXPECT_EQ(expected.settings()[n].condition().values(), actual.settings()[n].condition().values());
+        EXPECT_EQ(expected.settings()[n].value(), actual.settings()[n].value());
+    }
+}
+
+TEST(ConfigCache, RoundTrip)
+{
+    Environment environment = Environment();
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("common.xcconfig", Contents(
+            "NAME = VALUE\n"
+            "FLAGS[sdk=iphoneos*][arch=arm64] = $(inherited) -D$(NAME:upper)_$(SUFFIX_$(INDEX))\n")),
+        MemoryFilesystem::Entry::File("first.xcconfig", Contents("#include \"common.xcconfig\"\nFIRST = 1")),
+        MemoryFilesystem::Entry::File("second.xcconfig", Contents("#include \"common.xcconfig\"\nSECOND = 2")),
+    });
+
+    auto cache = ConfigCache::Read(&filesystem, "/cache/xcconfig.cache");
+    auto first = cache->load(&filesystem, environment, "/first.xcconfig");
+    auto second = cache->load(&filesystem, environment, "/second.xcconfig");
+    ASSERT_NE(ext::nullopt, first);
+    ASSERT_NE(ext::nullopt, second);
+    EXPECT_TRUE(cache->modified());
+    ASSERT_TRUE(cache->write(&filesystem, "/cache/xcconfig.cache"));
+
+    /* Loading again uses the cache, and gives the same configs. */
+    auto cached = ConfigCache::Read(&filesystem, "/cache/xcconfig.cache");
+    auto cachedFirst = cached->load(&filesystem, environment, "/first.xcconfig");
+    auto cachedSecond = cached->load(&filesystem, environment, "/second.xcconfig");
+    ASSERT_NE(ext::nullopt, cachedFirst);
+    ASSERT_NE(ext::nullopt, cachedSecond);
+    EXPECT_FALSE(cached->modified());
+
+    EXPECT_EQ("/first.xcconfig", cachedFirst->path());
+    ASSERT_EQ(2, cachedFirst->contents().size());
+    EXPECT_EQ(Config::Entry::Type::Include, cachedFirst->contents()[0].type());
+    EXPECT_EQ(Value::String("common.xcconfig"), *cachedFirst->contents()[0].path());
+    ExpectSameLevel(first->level(), cachedFirst->level());
+    ExpectSameLevel(second->level(), cachedSecond->level());
+
+    /* Shared includes are only decoded once. */
+    EXPECT_EQ(cachedFirst->contents()[0].config(), cachedSecond->contents()[0].config());
+}
+
+TEST(ConfigCache, Modified)
+{
+    Environment environment = Environment();
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("common.xcconfig", Contents("NAME = VALUE")),
+        MemoryFilesystem::Entry::File("include.xcconfig", Contents("#include \"common.xcconfig\"")),
+    });
+
+    auto cache = ConfigCache::Read(&filesystem, "/xcconfig.cache");
+    ASSERT_NE(ext::nullopt, cache->load(&filesystem, environment, "/include.xcconfig"));
+    ASSERT_TRUE(cache->write(&filesystem, "/xcconfig.cache"));
+
+    /* Changing an included file changes the config that includes it. */
+    ASSERT_TRUE(filesystem.write(Contents("NAME = CHANGED"), "/common.xcconfig"));
+
+    auto cached = ConfigCache::Read(&filesystem, "/xcconfig.cache");
+    auto config = cached->load(&filesystem, environment, "/include.xcconfig");
+    ASSERT_NE(ext::nullopt, config);
+    EXPECT_TRUE(cached->modified());
+    ASSERT_EQ(1, config->level().settings().size());
+    EXPECT_EQ(Value::String("CHANGED"), config->level().settings()[0].value());
+}
+
+TEST(ConfigCache, IncludeSettings)
+{
+    Environment first = Environment();
+    first.insertBack(Level({ Setting::Create("DEVELOPER_DIR", "/first") }), false);
+    Environment second = Environment();
+    second.insertBack(Level({ Setting::Create("DEVELOPER_DIR", "/second") }), false);
+
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("first", {
+            MemoryFilesystem::Entry::File("common.xcconfig", Contents("NAME = FIRST")),
+        }),
+        MemoryFilesystem::Entry::Directory("second", {
+            MemoryFilesystem::Entry::File("common.xcconfig", Contents("NAME = SECOND")),
+        }),
+        MemoryFilesystem::Entry::File("include.xcconfig", Contents("#include \"<DEVELOPER_DIR>/common.xcconfig\"")),
+    });
+
+    auto cache = ConfigCache::Read(&filesystem, "/xcconfig.cache");
+    ASSERT_NE(ext::nullopt, cache->load(&filesystem, first, "/include.xcconfig"));
+    ASSERT_TRUE(cache->write(&filesystem, "/xcconfig.cache"));
+
+    /* Includes that now resolve to another file aren't used from the cache. */
+    auto cached = ConfigCache::Read(&filesystem, "/xcconfig.cache");
+    auto config = cached->load(&filesystem, second, "/include.xcconfig");
+    ASSERT_NE(ext::nullopt, config);
+    ASSERT_EQ(1, config->level().settings().size());
+    EXPECT_EQ(Value::String("SECOND"), config->level().settings()[0].value());
+
+    config = cached->load(&filesystem, first, "/include.xcconfig");
+    ASSERT_NE(ext::nullopt, config);
+    ASSERT_EQ(1, config->level().settings().size());
+    EXPECT_EQ(Value::String("FIRST"), config->level().settings()[0].value());
+}
+
+TEST(ConfigCache, Invalid)
+{
+    Environment environment = Environment();
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("settings.xcconfig", Contents("NAME = VALUE")),
+        MemoryFilesystem::Entry::File("xcconfig.cache", Contents("xcconfig, but damaged")),
+    });
+
+    /* A damaged cache is ignored. */
+    auto cache = ConfigCache::Read(&filesystem, "/xcconfig.cache");
+    auto config = cache->load(&filesystem, environment, "/settings.xcconfig");
+    ASSERT_NE(ext::nullopt, config);
+    EXPECT_TRUE(cache->modified());
+    ASSERT_EQ(1, config->level().settings().size());
+    EXPECT_EQ("NAME", config->level().settings()[0].name());
+}
@@ -2,6 +2,9 @@
 #include <gtest/gtest.h>
 #include <pbxsetting/Environment.h>
 
+#include <thread>
+
+using pbxsetting::Condition;
 using pbxsetting::Environment;
 using pbxsetting::Level;
 using pbxsetting::Setting;
@@ -172,3 +175,191 @@ TEST(Environment, Default)
     EXPECT_EQ(env.resolve("THREE"), "3");
 }
 
+
+TEST(Environment, CacheInsertFront)
+{
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("FLAGS", "-O0"),
+        Setting::Parse("OTHER_FLAGS", "$(FLAGS) -g"),
+    }), false);
+    EXPECT_EQ("-O0 -g", environment.resolve("OTHER_FLAGS"));
+
+    /* Inserting a level must not use values resolved before it. */
+    environment.insertFront(Level({
+        Setting::Parse("FLAGS", "-Os $(inherited)"),
+    }), false);
+    EXPECT_EQ("-Os -O0 -g", environment.resolve("OTHER_FLAGS"));
+
+    environment.insertBack(Level({
+        Setting::Parse("MISSING", "found"),
+    }), true);
+    EXPECT_EQ("found", environment.resolve("MISSING"));
+}
+
+TEST(Environment, CacheCopy)
+{
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("NAME", "original"),
+    }), false);
+    EXPECT_EQ("original", environment.resolve("NAME"));
+
+    /* Changing a copy doesn't change the original. */
+    Environment copy = Environment(environment);
+    copy.insertFront(Level({
+        Setting::Parse("NAME", "copy"),
+    }), false);
+    EXPECT_EQ("copy", copy.resolve("NAME"));
+    EXPECT_EQ("original", environment.resolve("NAME"));
+}
+
+TEST(Environment, CacheCondition)
+{
+    std::unordered_map<std::string, std::string> arm64 = { { "arch", "arm64" } };
+    std::unordered_map<std::string, std::string> x86_64 = { { "arch", "x86_64" } };
+
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("ARCH_FLAGS", "generic"),
+        Setting(std::string("ARCH_FLAGS"), Condition(arm64), Value::String("arm")),
+        Setting::Parse("FLAGS", "$(ARCH_FLAGS)"),
+    }), false);
+
+    /* Values resolved for one condition aren't used for another. */
+    EXPECT_EQ("arm", environment.resolve("FLAGS", Condition(arm64)));
+    EXPECT_EQ("generic", environment.resolve("FLAGS", Condition(x86_64)));
+    EXPECT_EQ("generic", environment.resolve("FLAGS"));
+    EXPECT_EQ("arm", environment.resolve("FLAGS", Condition(arm64)));
+}
+
+TEST(Environment, CacheThreads)
+{
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("A", "a"),
+        Setting::Parse("B", "$(A)b"),
+        Setting::Parse("C", "$(B)c $(inherited)"),
+    }), false);
+    environment.insertBack(Level({
+        Setting::Parse("C", "base"),
+    }), false);
+
+    std::vector<std::thread> threads;
+    std::vector<std::string> results = std::vector<std::string>(8);
+    for (size_t n = 0; n < results.size(); ++n) {
+        threads.push_back(std::thread([&environment, &results, n] {
+            for (int i = 0; i < 100; ++i) {
+                results[n] = environment.resolve("C");
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (std::string const &result : results) {
+        EXPECT_EQ("abc base", result);
+    }
+}
+
+TEST(Environment, ComputeValuesThreads)
+{
+    Environment base;
+    base.insertBack(Level({
+        Setting::Parse("PRODUCT_NAME", "$(TARGET_NAME)"),
+        Setting::Parse("WRAPPER_NAME", "$(PRODUCT_NAME).$(WRAPPER_EXTENSION)"),
+        Setting::Parse("FLAGS", "$(inherited) -D$(PRODUCT_NAME:upper)"),
+    }), false);
+    base.insertBack(Level({
+        Setting::Parse("WRAPPER_EXTENSION", "app"),
+        Setting::Parse("FLAGS", "-O0"),
+    }), true);
+
+    /* Each thread derives its own environment from the shared one. */
+    auto compute = [&base](size_t n) {
+        Environment environment = Environment(base);
+        environment.insertFront(Level({
+            Setting::Parse("TARGET_NAME", "Target" + std::to_string(n)),
+        }), false);
+        return environment.computeValues(Condition::Empty());
+    };
+
+    std::vector<std::unordered_map<std::string, std::string>> expected;
+    for (size_t n = 0; n < 8; ++n) {
+        expected.push_back(compute(n));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::unordered_map<std::string, std::string>> results = std::vector<std::unordered_map<std::string, std::string>>(expected.size());
+    for (size_t n = 0; n < results.size(); ++n) {
+        threads.push_back(std::thread([&compute, &results, n] {
+            results[n] = compute(n);
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(expected, results);
+    EXPECT_EQ("Target3.app", results[3].at("WRAPPER_NAME"));
+    EXPECT_EQ("-O0 -DTARGET3", results[3].at("FLAGS"));
+}
+
+TEST(Environment, Derived)
+{
+    Environment base;
+    base.insertBack(Level({
+        Setting::Parse("NAME", "base"),
+        Setting::Parse("DEFAULTED", "base"),
+    }), false);
+    base.insertBack(Level({
+        Setting::Parse("DEFAULTED", "default"),
+        Setting::Parse("DEFAULT_ONLY", "default"),
+    }), true);
+
+    /* Children share the levels behind the ones they add. */
+    Environment first = Environment(base);
+    first.insertFront(Level({
+        Setting::Parse("NAME", "first, $(inherited)"),
+    }), false);
+    Environment second = Environment(base);
+    second.insertFront(Level({
+        Setting::Parse("NAME", "second, $(inherited)"),
+    }), false);
+    second.insertBack(Level({
+        Setting::Parse("DEFAULT_ONLY", "later default"),
+        Setting::Parse("LAST", "last"),
+    }), true);
+    second.insertFront(Level({
+        Setting::Parse("DEFAULT_ONLY", "earlier default"),
+    }), true);
+
+    EXPECT_EQ("base", base.resolve("NAME"));
+    EXPECT_EQ("first, base", first.resolve("NAME"));
+    EXPECT_EQ("second, base", second.resolve("NAME"));
+
+    /* Default levels are behind the others, whichever end they're added to. */
+    EXPECT_EQ("base", second.resolve("DEFAULTED"));
+    EXPECT_EQ("earlier default", second.resolve("DEFAULT_ONLY"));
+    EXPECT_EQ("last", second.resolve("LAST"));
+    EXPECT_EQ("default", base.resolve("DEFAULT_ONLY"));
+    EXPECT_EQ("", base.resolve("LAST"));
+}
+
+TEST(Environment, NestedReferenceOperations)
+{
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("INDEX", "one"),
+        Setting::Parse("OPERATION", "upper"),
+        Setting::Parse("NAME_one", "value"),
+        Setting::Parse("STATIC", "$(NAME_one:upper)"),
+        Setting::Parse("NESTED", "$(NAME_$(INDEX):upper)"),
+        Setting::Parse("NESTED_OPERATION", "$(NAME_$(INDEX):$(OPERATION))"),
+    }), false);
+
+    EXPECT_EQ("VALUE", environment.resolve("STATIC"));
+    EXPECT_EQ("VALUE", environment.resolve("NESTED"));
+    EXPECT_EQ("VALUE", environment.resolve("NESTED_OPERATION"));
+}
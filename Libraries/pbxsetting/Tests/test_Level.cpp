@@ -0,0 +1,65 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/Level.h>
+
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Condition;
+using pbxsetting::Value;
+
+static Condition
+Conditions(std::unordered_map<std::string, std::string> const &values)
+{
+    return Condition(values);
+}
+
+TEST(Level, Get)
+{
+    Level level = Level({
+        Setting::Create("ONE", "1"),
+        Setting::Create("TWO", "2"),
+    });
+
+    auto one = level.get("ONE", Condition::Empty());
+    EXPECT_TRUE(one.first);
+    EXPECT_EQ(Value::String("1"), one.second);
+
+    auto missing = level.get("THREE", Condition::Empty());
+    EXPECT_FALSE(missing.first);
+}
+
+TEST(Level, LaterOverrides)
+{
+    Level level = Level({
+        Setting::Create("NAME", "first"),
+        Setting::Create("OTHER", "other"),
+        Setting::Create("NAME", "second"),
+    });
+
+    EXPECT_EQ(Value::String("second"), level.get("NAME", Condition::Empty()).second);
+}
+
+TEST(Level, Conditions)
+{
+    Level level = Level({
+        Setting::Create("FLAGS", "default"),
+        Setting(std::string("FLAGS"), Conditions({ { "arch", "x86_64" } }), Value::String("x86_64")),
+        Setting(std::string("FLAGS"), Conditions({ { "sdk", "iphone*" } }), Value::String("iphone")),
+    });
+
+    /* The last matching setting wins. */
+    EXPECT_EQ(Value::String("iphone"), level.get("FLAGS", Conditions({ { "arch", "x86_64" }, { "sdk", "iphoneos9.0" } })).second);
+    EXPECT_EQ(Value::String("x86_64"), level.get("FLAGS", Conditions({ { "arch", "x86_64" }, { "sdk", "macosx10.11" } })).second);
+    EXPECT_EQ(Value::String("default"), level.get("FLAGS", Conditions({ { "arch", "arm64" } })).second);
+
+    /* Conditional settings don't match without the condition. */
+    EXPECT_EQ(Value::String("default"), level.get("FLAGS", Condition::Empty()).second);
+}
@@ -209,3 +209,37 @@ TEST(Value, Add)
     ASSERT_EQ(string_string.entries().at(0).type(), Value::Entry::Type::String);
     EXPECT_EQ(*string_string.entries().at(0).string(), "teststring");
 }
+
+TEST(Value, Instructions)
+{
+    Value known = Value::Parse("-I$(SRCROOT:standardizepath:quote)/include");
+    ASSERT_EQ(3, known.instructions().size());
+    EXPECT_EQ(Value::Instruction::Type::String, known.instructions()[0].type());
+    EXPECT_EQ("-I", known.instructions()[0].string());
+    ASSERT_EQ(Value::Instruction::Type::Reference, known.instructions()[1].type());
+    EXPECT_EQ("SRCROOT:standardizepath:quote", known.instructions()[1].reference()->name());
+    EXPECT_EQ("SRCROOT", known.instructions()[1].reference()->setting());
+    std::vector<Value::Operation> operations = { Value::Operation::StandardizePath, Value::Operation::Quote };
+    EXPECT_EQ(operations, known.instructions()[1].reference()->operations());
+    EXPECT_EQ("/include", known.instructions()[2].string());
+
+    /* Names with references are only known once expanded. */
+    Value nested = Value::Parse("$(SUFFIX_$(INDEX):upper)");
+    ASSERT_EQ(5, nested.instructions().size());
+    EXPECT_EQ(Value::Instruction::Type::BeginReference, nested.instructions()[0].type());
+    EXPECT_EQ("SUFFIX_", nested.instructions()[1].string());
+    EXPECT_EQ("INDEX", nested.instructions()[2].reference()->setting());
+    EXPECT_EQ(":upper", nested.instructions()[3].string());
+    EXPECT_EQ(Value::Instruction::Type::EndReference, nested.instructions()[4].type());
+}
+
+TEST(Value, ReferenceParse)
+{
+    Value::Reference reference = Value::Reference::Parse("NAME:lower:unknown");
+    EXPECT_EQ("NAME", reference.setting());
+    std::vector<Value::Operation> operations = { Value::Operation::Lower, Value::Operation::Unknown };
+    EXPECT_EQ(operations, reference.operations());
+
+    EXPECT_EQ("NAME", Value::Reference::Parse("NAME").setting());
+    EXPECT_TRUE(Value::Reference::Parse("NAME").operations().empty());
+}
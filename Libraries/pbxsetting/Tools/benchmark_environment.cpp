@@ -0,0 +1,157 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxsetting/DefaultSettings.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+#include <pbxsetting/Value.h>
+#include <process/DefaultContext.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+using pbxsetting::Condition;
+using pbxsetting::DefaultSettings;
+using pbxsetting::Environment;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+/*
+ * Creates an environment shaped like a target's: the default levels, then
+ * large platform, SDK and specification levels, then a project, an xcconfig
+ * and a target level that build up flags from the levels behind them.
+ */
+static Environment
+CreateTargetEnvironment(process::Context const *processContext)
+{
+    Environment environment;
+    for (Level const &level : DefaultSettings::Levels(processContext)) {
+        environment.insertFront(level, false);
+    }
+
+    std::vector<Setting> platform = {
+        Setting::Parse("PLATFORM_NAME", "iphoneos"),
+        Setting::Parse("PLATFORM_DIR", "/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform"),
+        Setting::Parse("PLATFORM_DEVELOPER_USR_DIR", "$(PLATFORM_DIR)/Developer/usr"),
+    };
+    std::vector<Setting> sdk = {
+        Setting::Parse("SDKROOT", "$(PLATFORM_DIR)/Developer/SDKs/iPhoneOS9.3.sdk"),
+        Setting::Parse("SDK_NAME", "iphoneos9.3"),
+        Setting::Parse("IPHONEOS_DEPLOYMENT_TARGET", "9.3"),
+    };
+    std::vector<Setting> specifications;
+    for (int n = 0; n < 500; ++n) {
+        /* Tool specifications define hundreds of settings, most unused. */
+        std::string name = "SPECIFICATION_OPTION_" + std::to_string(n);
+        platform.push_back(Setting::Parse("PLATFORM_OPTION_" + std::to_string(n), "$(PLATFORM_NAME)-" + std::to_string(n)));
+        sdk.push_back(Setting::Parse("SDK_OPTION_" + std::to_string(n), "$(SDK_NAME)-" + std::to_string(n)));
+        specifications.push_back(Setting::Parse(name, "$(" + name + "_DEFAULT:quote)"));
+        specifications.push_back(Setting::Parse(name + "_DEFAULT", "$(PRODUCT_NAME:rfc1034identifier).option" + std::to_string(n)));
+    }
+    specifications.push_back(Setting::Parse("OTHER_CFLAGS", "-fmodules"));
+    specifications.push_back(Setting::Parse("HEADER_SEARCH_PATHS", "$(SDKROOT)/usr/include"));
+    environment.insertFront(Level(specifications), false);
+    environment.insertFront(Level(platform), false);
+    environment.insertFront(Level(sdk), false);
+
+    environment.insertFront(Level({
+        Setting::Parse("PROJECT_NAME", "Benchmark"),
+        Setting::Parse("SRCROOT", "/src/$(PROJECT_NAME)"),
+        Setting::Parse("OTHER_CFLAGS", "$(inherited) -DPROJECT=$(PROJECT_NAME:upper)"),
+        Setting::Parse("HEADER_SEARCH_PATHS", "$(inherited) $(SRCROOT)/include"),
+    }), false);
+    environment.insertFront(Level({
+        Setting::Parse("OTHER_CFLAGS", "$(inherited) -Wall -Wextra $(WARNING_CFLAGS)"),
+        Setting::Parse("WARNING_CFLAGS", "-Wno-unused-parameter"),
+        Setting::Parse("HEADER_SEARCH_PATHS", "$(inherited) $(SRCROOT)/Vendor/include $(BUILT_PRODUCTS_DIR)/include"),
+    }), false);
+    environment.insertFront(Level({
+        Setting::Parse("PRODUCT_NAME", "Benchmark App"),
+        Setting::Parse("TARGET_NAME", "$(PRODUCT_NAME)"),
+        Setting::Parse("OTHER_CFLAGS", "$(inherited) -DTARGET=$(TARGET_NAME:identifier)"),
+        Setting::Parse("HEADER_SEARCH_PATHS", "$(inherited) $(SRCROOT)/$(TARGET_NAME:identifier)"),
+    }), false);
+
+    return environment;
+}
+
+static double
+Measure(std::function<void()> const &function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+int
+main(int argc, char **argv)
+{
+    int iterations = (argc > 1 ? std::atoi(argv[1]) : 1000);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return -1;
+    }
+
+    process::DefaultContext processContext = process::DefaultContext();
+    Environment environment = CreateTargetEnvironment(&processContext);
+
+    std::unordered_map<std::string, std::string> values = { { "arch", "arm64" }, { "sdk", "iphoneos9.3" }, { "variant", "normal" } };
+    Condition condition = Condition(values);
+    Value flags = Value::Parse("$(OTHER_CFLAGS) $(HEADER_SEARCH_PATHS) -isysroot $(SDKROOT:quote) -miphoneos-version-min=$(IPHONEOS_DEPLOYMENT_TARGET)");
+
+    size_t count = 0;
+    double compute = Measure([&] {
+        count = environment.computeValues(condition).size();
+    });
+    fprintf(stdout, "computeValues: %zu settings in %.3f ms\n", count, compute);
+
+    double expand = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            environment.expand(flags, condition);
+        }
+    });
+    fprintf(stdout, "expand: %d iterations in %.3f ms (%.3f us each)\n", iterations, expand, expand * 1000.0 / iterations);
+
+    double resolve = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            environment.resolve("SPECIFICATION_OPTION_" + std::to_string(n % 500), condition);
+        }
+    });
+    fprintf(stdout, "resolve: %d iterations in %.3f ms (%.3f us each)\n", iterations, resolve, resolve * 1000.0 / iterations);
+
+    Level fileLevel = Level({
+        Setting::Parse("INPUT_FILE_PATH", "$(SRCROOT)/main.m"),
+        Setting::Parse("INPUT_FILE_BASE", "$(INPUT_FILE_PATH:base)"),
+    });
+    double derive = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            Environment fileEnvironment = Environment(environment);
+            fileEnvironment.insertFront(fileLevel, false);
+        }
+    });
+    fprintf(stdout, "derive: %d iterations in %.3f ms (%.3f us each)\n", iterations, derive, derive * 1000.0 / iterations);
+
+    /* Each file gets a new environment, so nothing is cached yet. */
+    Value fileFlags = Value::Parse("-c $(INPUT_FILE_PATH:quote) -o $(INPUT_FILE_BASE).o $(OTHER_CFLAGS) $(HEADER_SEARCH_PATHS)");
+    double file = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            Environment fileEnvironment = Environment(environment);
+            fileEnvironment.insertFront(fileLevel, false);
+            fileEnvironment.expand(fileFlags, condition);
+        }
+    });
+    fprintf(stdout, "derive and expand: %d iterations in %.3f ms (%.3f us each)\n", iterations, file, file * 1000.0 / iterations);
+
+    return 0;
+}
@@ -43,6 +43,7 @@ private:
     std::unordered_set<std::string>                                           _domains;
     std::map<std::string, std::map<char const *, PBX::Specification::vector>> _specifications;
     PBX::BuildRule::vector                                                    _buildRules;
+    std::vector<std::string>                                                  _loadedFilePaths;
 
 public:
     Manager();
@@ -129,6 +130,14 @@ public:
     void registerDomains(libutil::Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains);
     bool registerBuildRules(libutil::Filesystem const *filesystem, std::string const &path);
 
+public:
+    /*
+     * The specification and build rule files loaded, so changes to them can
+     * be detected.
+     */
+    std::vector<std::string> const &loadedFilePaths() const
+    { return _loadedFilePaths; }
+
 private:
     void addSpecification(PBX::Specification::shared_ptr const &specification);
     bool inheritSpecification(PBX::Specification::shared_ptr const &specification);
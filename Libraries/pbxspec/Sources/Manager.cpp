@@ -9,6 +9,7 @@
 
 #include <pbxspec/Manager.h>
 #include <pbxspec/Context.h>
+#include <plist/Arena.h>
 #include <plist/Array.h>
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
@@ -389,6 +390,7 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
                         fprintf(stderr, "importing specification '%s'\n", path.c_str());
 #endif
 
+                        _loadedFilePaths.push_back(path);
                         ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, path);
                         if (fileSpecifications) {
                             specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
@@ -405,6 +407,7 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 #if 0
                 fprintf(stderr, "importing specification '%s'\n", realPath.c_str());
 #endif
+                _loadedFilePaths.push_back(realPath);
                 ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, realPath);
                 if (fileSpecifications) {
                     specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
@@ -447,12 +450,15 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 bool Manager::
 registerBuildRules(Filesystem const *filesystem, std::string const &path)
 {
+    _loadedFilePaths.push_back(path);
+
     std::vector<uint8_t> contents;
     if (!filesystem->read(&contents, path)) {
         return false;
     }
 
-    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    plist::Arena arena;
+    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents, &arena).first;
     if (plist == nullptr) {
         return false;
     }
@@ -19,6 +19,7 @@
 #include <pbxspec/Context.h>
 #include <pbxspec/Inherit.h>
 #include <pbxspec/Manager.h>
+#include <plist/Arena.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
 #include <plist/Dictionary.h>
@@ -210,9 +211,11 @@ Open(Filesystem const *filesystem, Context *context, std::string const &filename
     }
 
     //
-    // Parse property list
+    // Parse property list. Specifications copy what they keep, so it can
+    // be allocated in an arena and borrow strings from the contents.
     //
-    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    plist::Arena arena;
+    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents, &arena).first;
     if (plist == nullptr) {
         fprintf(stderr, "error: unable to parse specification plist\n");
         return ext::nullopt;
@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Arena_h
+#define __plist_Arena_h
+
+#include <plist/Base.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace plist {
+
+/*
+ * Memory for a tree of objects, allocated in large blocks. Deleting an
+ * object in an arena runs its destructor but doesn't free its memory;
+ * all of it is freed at once with the arena.
+ *
+ * Objects are allocated in an arena while it is in scope on the current
+ * thread (see `Arena::Scope`), which is how deserializers given an arena
+ * use it. The arena must outlive every object allocated in it.
+ *
+ * An arena can also retain input buffers, which strings deserialized
+ * into it borrow from instead of copying.
+ */
+class Arena {
+public:
+    /*
+     * Allocates objects created on the current thread in an arena, until
+     * the scope ends. Scopes can nest; a null arena allocates normally.
+     */
+    class Scope {
+    private:
+        Arena *_previous;
+
+    public:
+        explicit Scope(Arena *arena);
+        ~Scope();
+
+    public:
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+
+    public:
+        /*
+         * The arena objects are currently allocated in, if any.
+         */
+        static Arena *Current();
+    };
+
+private:
+    size_t                                  _blockSize;
+    std::vector<std::unique_ptr<uint8_t[]>> _blocks;
+    uint8_t                                *_next;
+    uint8_t                                *_end;
+    size_t                                  _size;
+
+private:
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> _retained;
+
+public:
+    explicit Arena(size_t blockSize = 256 * 1024);
+    ~Arena();
+
+public:
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+public:
+    /*
+     * Allocate memory aligned for any type. It is freed with the arena.
+     */
+    void *allocate(size_t size);
+
+public:
+    /*
+     * Keep a buffer alive until the arena is freed, so objects in the
+     * arena can refer to it. Returns the retained buffer.
+     */
+    std::vector<uint8_t> const &retain(std::vector<uint8_t> &&buffer);
+
+    /*
+     * If a pointer is into a buffer retained by the arena.
+     */
+    bool retains(void const *pointer) const;
+
+public:
+    /*
+     * The number of bytes allocated from the arena.
+     */
+    size_t size() const
+    { return _size; }
+};
+
+}
+
+#endif  // !__plist_Arena_h
@@ -14,15 +14,49 @@
 #include <plist/Object.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
 namespace plist {
 
 class Dictionary : public Object {
+public:
+    /*
+     * Iterates the keys of a dictionary, in order.
+     */
+    class const_iterator {
+    private:
+        typedef std::vector<std::pair<std::string, std::unique_ptr<Object>>>::const_iterator Base;
+        Base _it;
+
+    public:
+        explicit const_iterator(Base it) :
+            _it(it)
+        {
+        }
+
+    public:
+        inline std::string const &operator*() const
+        { return _it->first; }
+        inline std::string const *operator->() const
+        { return &_it->first; }
+        inline const_iterator &operator++()
+        { ++_it; return *this; }
+        inline bool operator==(const_iterator const &rhs) const
+        { return _it == rhs._it; }
+        inline bool operator!=(const_iterator const &rhs) const
+        { return _it != rhs._it; }
+    };
+
 private:
-    std::vector<std::string>                                 _keys;
-    std::unordered_map<std::string, std::unique_ptr<Object>> _map;
+    /*
+     * Keys are stored once, with their values, in order. Larger
+     * dictionaries also have a hash table of entry indexes.
+     */
+    std::vector<std::pair<std::string, std::unique_ptr<Object>>> _entries;
+    std::vector<uint32_t>                                        _index;
 
 public:
     Dictionary()
@@ -40,27 +74,27 @@ public:
 public:
     inline bool empty() const
     {
-        return _map.empty();
+        return _entries.empty();
     }
 
     inline size_t count() const
     {
-        return _map.size();
+        return _entries.size();
     }
 
     inline std::string const &key(size_t index) const
     {
-        return _keys[index];
+        return _entries[index].first;
     }
 
     inline Object const *value(size_t index) const
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     inline Object *value(size_t index)
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     template <typename T>
@@ -77,14 +111,14 @@ public:
 
     inline Object const *value(std::string const &key) const
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        size_t index = find(key);
+        return (index != npos ? _entries[index].second.get() : nullptr);
     }
 
     inline Object *value(std::string const &key)
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        size_t index = find(key);
+        return (index != npos ? _entries[index].second.get() : nullptr);
     }
 
     template <typename T>
@@ -102,39 +136,32 @@ public:
 public:
     inline void clear()
     {
-        _keys.clear();
-        _map.clear();
+        _entries.clear();
+        _index.clear();
     }
 
 public:
-    inline void set(std::string const &key, std::unique_ptr<Object> obj)
-    {
-        remove(key);
-        _keys.push_back(key);
-        _map.insert(std::make_pair(key, std::move(obj)));
-    }
-
-    inline void remove(std::string const &key)
-    {
-        auto it = _map.find(key);
-
-        if (it != _map.end()) {
-            _map.erase(it);
-            _keys.erase(std::find(_keys.begin(), _keys.end(), key));
-        }
-    }
+    void set(std::string const &key, std::unique_ptr<Object> obj);
+    void set(std::string &&key, std::unique_ptr<Object> obj);
+    void remove(std::string const &key);
 
 public:
-    inline std::vector<std::string>::const_iterator begin() const
+    inline const_iterator begin() const
     {
-        return _keys.begin();
+        return const_iterator(_entries.begin());
     }
 
-    inline std::vector<std::string>::const_iterator end() const
+    inline const_iterator end() const
     {
-        return _keys.end();
+        return const_iterator(_entries.end());
     }
 
+private:
+    static size_t const npos = static_cast<size_t>(-1);
+
+    size_t find(std::string const &key) const;
+    void reindex();
+
 public:
     static std::unique_ptr<Dictionary> Coerce(Object const *obj);
 
@@ -174,8 +201,8 @@ public:
         if (count() != obj->count())
             return false;
 
-        for (auto const &it : _map) {
-            if (!value(it.first)->equals(obj->value(it.first)))
+        for (auto const &it : _entries) {
+            if (!it.second->equals(obj->value(it.first)))
                 return false;
         }
 
@@ -0,0 +1,141 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryDocument_h
+#define __plist_Format_BinaryDocument_h
+
+#include <plist/Format/Handler.h>
+#include <plist/ObjectType.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+class BinaryReader;
+
+/*
+ * A binary property list that is read lazily. The file is mapped rather
+ * than read, and objects are only decoded when they're accessed, through
+ * the offset table; looking up a few keys in a large file only touches
+ * the parts of it needed to find them.
+ */
+class BinaryDocument {
+public:
+    /*
+     * An object in the document. Values are cheap to copy, and are only
+     * valid while the document is. Accessing a missing or corrupted value
+     * gives an invalid value, and the reason is available from the document.
+     */
+    class Value {
+    private:
+        BinaryDocument const *_document;
+        uint64_t              _reference;
+
+    public:
+        Value();
+        Value(BinaryDocument const *document, uint64_t reference);
+
+    public:
+        bool valid() const
+        { return _document != nullptr; }
+
+    public:
+        /*
+         * The type of the object, without decoding it.
+         */
+        ObjectType type() const;
+
+        /*
+         * The number of elements in an array or entries in a dictionary.
+         */
+        size_t count() const;
+
+    public:
+        /*
+         * An element of an array.
+         */
+        Value value(size_t index) const;
+
+        /*
+         * The value for a key in a dictionary.
+         */
+        Value value(std::string const &key) const;
+
+        /*
+         * The key of an entry in a dictionary, by index.
+         */
+        std::string key(size_t index) const;
+
+        /*
+         * Follow a key path. Each component is a dictionary key or, for
+         * arrays, an index.
+         */
+        Value find(std::vector<std::string> const &path) const;
+
+    public:
+        /*
+         * Decode the object and everything in it.
+         */
+        std::unique_ptr<Object> object() const;
+
+        /*
+         * Read the object and everything in it as events.
+         */
+        std::pair<bool, std::string> read(Handler *handler) const;
+    };
+
+private:
+    std::vector<uint8_t>          _contents;
+    void                         *_mapping;
+    size_t                        _mappingSize;
+    std::unique_ptr<BinaryReader> _reader;
+
+private:
+    BinaryDocument();
+
+public:
+    ~BinaryDocument();
+
+public:
+    /*
+     * The root object.
+     */
+    Value root() const;
+
+    /*
+     * The last problem found in the document. Keys or indexes that are
+     * just not present don't set an error.
+     */
+    std::string const &error() const;
+
+public:
+    /*
+     * Map a binary property list file.
+     */
+    static std::pair<std::unique_ptr<BinaryDocument>, std::string>
+    Open(std::string const &path);
+
+    /*
+     * Use a binary property list already in memory.
+     */
+    static std::pair<std::unique_ptr<BinaryDocument>, std::string>
+    Create(std::vector<uint8_t> contents);
+
+private:
+    static std::pair<std::unique_ptr<BinaryDocument>, std::string>
+    Load(std::unique_ptr<BinaryDocument> document, uint8_t const *data, size_t size);
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryDocument_h
@@ -12,6 +12,10 @@
 
 #include <plist/Base.h>
 #include <plist/Object.h>
+#include <plist/Arena.h>
+#include <plist/Format/Handler.h>
+#include <plist/Format/Query.h>
+#include <plist/Format/Sink.h>
 
 #include <vector>
 
@@ -43,9 +47,56 @@ public:
         return Deserialize(contents, *format);
     }
 
+    /*
+     * Deserialize into an arena. The arena must outlive the result.
+     */
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents, T const &format, Arena *arena)
+    {
+        Arena::Scope scope(arena);
+        return Deserialize(contents, format);
+    }
+
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents, Arena *arena)
+    {
+        Arena::Scope scope(arena);
+        return Deserialize(contents);
+    }
+
+public:
+    /*
+     * Read as events, without building objects for the containers. The
+     * result is successful if the input was read through, or if the
+     * handler stopped reading early.
+     */
+    static std::pair<bool, std::string>
+    Read(std::vector<uint8_t> const &contents, T const &format, Handler *handler);
+
+    /*
+     * Deserialize only the value at a key path, reading no further than
+     * needed to find it. By default the first of duplicate keys is used,
+     * unlike when deserializing. If it's not found, the result is null
+     * with no error.
+     */
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Extract(std::vector<uint8_t> const &contents, T const &format, std::vector<std::string> const &path, Query::Duplicates duplicates = Query::Duplicates::First)
+    {
+        Query query(path, duplicates);
+        return query.finish(Read(contents, format, &query));
+    }
+
 public:
     static std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string>
     Serialize(Object const *object, T const &format);
+
+    /*
+     * Serialize to a sink as the output is produced, rather than building
+     * all of it in memory first. If this fails, part of the output may
+     * have been written already.
+     */
+    static std::pair<bool, std::string>
+    Serialize(Object const *object, T const &format, Sink *sink);
 };
 
 }
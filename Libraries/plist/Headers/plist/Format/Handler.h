@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Handler_h
+#define __plist_Format_Handler_h
+
+#include <plist/Base.h>
+#include <plist/Object.h>
+
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Receives a property list as it is read, one event at a time. Containers
+ * are reported by their beginning and end, with each dictionary value
+ * preceded by its key; everything else is reported as a scalar.
+ *
+ * Returning false from any event stops reading. Stopping is not an
+ * error, so a handler that needs only part of the input can stop as
+ * soon as it has it.
+ */
+class Handler {
+public:
+    virtual ~Handler();
+
+public:
+    virtual bool beginDictionary() = 0;
+    virtual bool endDictionary() = 0;
+
+public:
+    virtual bool beginArray() = 0;
+    virtual bool endArray() = 0;
+
+public:
+    /*
+     * The key of the next value in the current dictionary. The key is
+     * only valid for the duration of the call.
+     */
+    virtual bool key(char const *data, size_t size) = 0;
+
+public:
+    /*
+     * Any value other than a dictionary or array.
+     */
+    virtual bool scalar(std::unique_ptr<Object> value) = 0;
+};
+
+/*
+ * Builds the object tree from the events read. This is how property
+ * lists are deserialized.
+ */
+class Builder : public Handler {
+private:
+    struct Level {
+        std::unique_ptr<Object> container;
+        std::string             key;
+    };
+
+private:
+    std::unique_ptr<Object> _root;
+    std::vector<Level>      _levels;
+    std::string             _error;
+
+public:
+    Builder();
+    ~Builder();
+
+public:
+    virtual bool beginDictionary();
+    virtual bool endDictionary();
+    virtual bool beginArray();
+    virtual bool endArray();
+    virtual bool key(char const *data, size_t size);
+    virtual bool scalar(std::unique_ptr<Object> value);
+
+public:
+    /*
+     * Take the object built, given the result of reading. Returns the
+     * error instead if either reading or building failed.
+     */
+    std::pair<std::unique_ptr<Object>, std::string>
+    finish(std::pair<bool, std::string> const &read);
+
+private:
+    bool begin(std::unique_ptr<Object> container);
+    bool end(ObjectType type);
+    bool store(std::unique_ptr<Object> value);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Handler_h
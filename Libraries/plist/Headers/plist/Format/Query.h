@@ -0,0 +1,96 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Query_h
+#define __plist_Format_Query_h
+
+#include <plist/Format/Handler.h>
+
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Finds the value at a key path while a property list is read. Each
+ * component of the path is either a dictionary key or an array index.
+ * Reading stops as soon as no later key could change the result; only the
+ * values found are built into objects.
+ */
+class Query : public Handler {
+public:
+    /*
+     * Which of duplicate dictionary keys is used. With the first, reading
+     * stops as soon as the value is read. With the last, as when
+     * deserializing, any dictionary on the path has to be read through.
+     */
+    enum class Duplicates {
+        First,
+        Last,
+    };
+
+private:
+    enum class Action {
+        Capture,
+        Descend,
+        Skip,
+    };
+
+    struct Level {
+        bool   dictionary;
+        bool   matched;
+        size_t index;
+    };
+
+private:
+    std::vector<std::string> _path;
+    std::vector<size_t>      _indexes;
+    Duplicates               _duplicates;
+
+private:
+    std::vector<Level>       _levels;
+    size_t                   _skip;
+
+private:
+    std::unique_ptr<Builder> _builder;
+    size_t                   _capture;
+    std::unique_ptr<Builder> _found;
+
+public:
+    explicit Query(std::vector<std::string> const &path, Duplicates duplicates = Duplicates::First);
+    ~Query();
+
+public:
+    virtual bool beginDictionary();
+    virtual bool endDictionary();
+    virtual bool beginArray();
+    virtual bool endArray();
+    virtual bool key(char const *data, size_t size);
+    virtual bool scalar(std::unique_ptr<Object> value);
+
+public:
+    /*
+     * Take the value found, given the result of reading. If the path
+     * was not found, the value is null but there is no error.
+     */
+    std::pair<std::unique_ptr<Object>, std::string>
+    finish(std::pair<bool, std::string> const &read);
+
+private:
+    Action next();
+    bool pending() const;
+    bool begin(bool dictionary);
+    bool end(bool dictionary);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Query_h
@@ -0,0 +1,81 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Sink_h
+#define __plist_Format_Sink_h
+
+#include <plist/Base.h>
+
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Where serialized output goes. Writers pass output on in pieces as it's
+ * produced, so the whole output is never held in memory at once.
+ */
+class Sink {
+public:
+    virtual ~Sink();
+
+public:
+    /*
+     * Write the next piece of output. Returns false if it couldn't be
+     * written; the output is then incomplete.
+     */
+    virtual bool write(uint8_t const *data, size_t size) = 0;
+
+    /*
+     * The total size of the output, if known before writing it.
+     */
+    virtual void reserve(size_t size);
+};
+
+/*
+ * Collects output in memory.
+ */
+class BufferSink : public Sink {
+private:
+    std::vector<uint8_t> _contents;
+
+public:
+    BufferSink();
+    ~BufferSink();
+
+public:
+    std::vector<uint8_t> &contents()
+    { return _contents; }
+    std::vector<uint8_t> const &contents() const
+    { return _contents; }
+
+public:
+    virtual bool write(uint8_t const *data, size_t size);
+    virtual void reserve(size_t size);
+};
+
+/*
+ * Writes output to a file descriptor, which stays open afterwards.
+ */
+class FileSink : public Sink {
+private:
+    int _fd;
+
+public:
+    explicit FileSink(int fd);
+    ~FileSink();
+
+public:
+    virtual bool write(uint8_t const *data, size_t size);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Sink_h
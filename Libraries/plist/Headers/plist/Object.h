@@ -38,6 +38,14 @@ public:
         delete this;
     }
 
+public:
+    /*
+     * Objects are allocated in the current arena, if there is one. See
+     * `Arena::Scope`.
+     */
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer);
+
 protected:
     virtual std::unique_ptr<Object> _copy() const = 0;
 
@@ -13,43 +13,105 @@
 #include <plist/Base.h>
 #include <plist/Object.h>
 
+#include <algorithm>
+#include <mutex>
+
 namespace plist {
 
 class String : public Object {
 private:
-    std::string _value;
+    mutable std::string    _value;
+
+private:
+    char const            *_borrowed;
+    size_t                 _borrowedSize;
+    mutable std::once_flag _materialized;
 
 public:
     String(std::string const &value = std::string()) :
-        _value(value)
+        _value       (value),
+        _borrowed    (nullptr),
+        _borrowedSize(0)
     {
     }
 
     String(std::string &&value) :
-        _value(std::move(value))
+        _value       (std::move(value)),
+        _borrowed    (nullptr),
+        _borrowedSize(0)
+    {
+    }
+
+private:
+    String(char const *borrowed, size_t size) :
+        _borrowed    (borrowed),
+        _borrowedSize(size)
     {
     }
 
 public:
+    /*
+     * The string value. A borrowed string is copied into an owned value
+     * the first time this is called; prefer `data()` and `size()` where
+     * a copy isn't needed.
+     */
     inline std::string const &value() const
     {
+        if (_borrowed != nullptr) {
+            std::call_once(_materialized, [this] { _value.assign(_borrowed, _borrowedSize); });
+        }
         return _value;
     }
 
     inline void setValue(std::string const &value)
     {
         _value = value;
+        _borrowed = nullptr;
     }
 
     inline void setValue(std::string &&value)
     {
         _value = std::move(value);
+        _borrowed = nullptr;
+    }
+
+public:
+    /*
+     * The characters of the string, without copying a borrowed string.
+     * Not null terminated.
+     */
+    inline char const *data() const
+    {
+        return (_borrowed != nullptr ? _borrowed : _value.data());
+    }
+
+    inline size_t size() const
+    {
+        return (_borrowed != nullptr ? _borrowedSize : _value.size());
+    }
+
+    /*
+     * If the string refers to characters it doesn't own.
+     */
+    inline bool borrowed() const
+    {
+        return (_borrowed != nullptr);
     }
 
 public:
     static std::unique_ptr<String> New(std::string const &value = std::string());
     static std::unique_ptr<String> New(std::string &&value);
 
+    /*
+     * Create a string that refers to characters owned elsewhere, which
+     * must outlive it. Deserializers borrow strings from their input when
+     * deserializing into an arena, which retains the input for them.
+     *
+     * Copies also borrow if they are allocated in an arena retaining the
+     * characters; otherwise they own a copy.
+     */
+    static std::unique_ptr<String> Borrow(char const *data, size_t size);
+
 public:
     static std::unique_ptr<String> Coerce(Object const *obj);
 
@@ -83,7 +145,7 @@ public:
 
     virtual bool equals(String const *obj) const
     {
-        return (obj != nullptr && (obj == this || value() == obj->value()));
+        return (obj != nullptr && (obj == this || (size() == obj->size() && std::equal(data(), data() + size(), obj->data()))));
     }
 };
 
@@ -11,6 +11,7 @@
 #define __plist_Format_ASCIIParser_h
 
 #include <plist/Format/ASCIIPListLexer.h>
+#include <plist/Format/Handler.h>
 #include <plist/Object.h>
 #include <plist/String.h>
 
@@ -37,35 +38,31 @@ private:
     };
 
 private:
-    std::unique_ptr<plist::Object> _root;
+    Handler                       *_handler;
+    bool                           _stopped;
     int                            _level;
 
 private:
     ValueState                     _state;
     std::stack<ValueState>         _stateStack;
 
-private:
-    std::unique_ptr<plist::Object> _container;
-    std::stack<std::unique_ptr<plist::Object>> _containerStack;
-
-private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
-
 private:
     ContextState                _contextState;
     std::string                 _error;
 
 public:
-    ASCIIParser();
+    explicit ASCIIParser(Handler *handler);
     ~ASCIIParser();
 
 public:
     bool parse(ASCIIPListLexer *lexer, bool strings);
 
 public:
-    std::unique_ptr<plist::Object> &root()
-    { return _root; }
+    /*
+     * If parsing ended because the handler stopped it.
+     */
+    bool stopped() const
+    { return _stopped; }
     std::string error() const
     { return _error; }
 
@@ -83,12 +80,12 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state);
     bool pop();
+    bool emit(bool result);
 
 private:
-    bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool beginContainer(bool isArray);
     bool endContainer(bool isArray);
 
 private:
@@ -10,6 +10,7 @@
 #ifndef __plist_Format_ASCIIWriter_h
 #define __plist_Format_ASCIIWriter_h
 
+#include <plist/Format/OutputBuffer.h>
 #include <plist/Objects.h>
 
 namespace plist {
@@ -19,18 +20,14 @@ class ASCIIWriter {
 private:
     Object const         *_root;
     bool                  _strings;
-    std::vector<uint8_t>  _contents;
+    OutputBuffer          _output;
     int                   _indent;
     bool                  _lastKey;
 
 public:
-    ASCIIWriter(Object const *root, bool strings);
+    ASCIIWriter(Object const *root, bool strings, Sink *sink);
     ~ASCIIWriter();
 
-public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
-
 public:
     bool write();
 
@@ -21,10 +21,27 @@
 namespace plist {
 namespace Format {
 
+/*
+ * Parses XML as a series of events. Documents in UTF-8 without an internal
+ * DTD subset, which covers property lists and other simple XML, are read
+ * directly from the input; others are read through libxml2.
+ */
 class BaseXMLParser {
 private:
     ::xmlTextReaderPtr _parser;
     size_t             _depth;
+    bool               _stopped;
+    bool               _failed;
+    bool               _libxml;
+
+private:
+    char const        *_input;
+    size_t             _size;
+    size_t             _offset;
+    std::string        _name;
+    std::string        _text;
+    std::unordered_map<std::string, std::string> _attributes;
+    std::vector<std::pair<size_t, size_t>>       _elements;
 
 private:
     size_t             _line;
@@ -42,12 +59,21 @@ public:
     std::string const &error() const
     { return _error; }
 
+public:
+    /*
+     * Always read through libxml2, even if the document doesn't need it.
+     */
+    void setLibXML(bool libxml)
+    { _libxml = libxml; }
+
 protected:
     bool parse(std::vector<uint8_t> const &contents);
 
 protected:
     inline size_t depth() const
     { return _depth; }
+    inline bool stopped() const
+    { return _stopped; }
 
 protected:
     virtual void onBeginParse();
@@ -60,6 +86,30 @@ protected:
 
 protected:
     void error(std::string format, ...);
+
+protected:
+    /*
+     * End parsing early, successfully.
+     */
+    void stop();
+
+private:
+    bool halted() const
+    { return _failed || _stopped; }
+
+private:
+    bool parseLibXML(std::vector<uint8_t> const &contents);
+    bool parseDirect(std::vector<uint8_t> const &contents, bool *supported);
+
+private:
+    bool prolog(bool *supported);
+    bool content();
+    bool startElement();
+    bool endElement();
+    bool characters();
+    bool reference(std::string *out);
+    bool attributeValue(std::string *out);
+    void flush();
 };
 
 }
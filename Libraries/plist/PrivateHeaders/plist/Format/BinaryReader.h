@@ -0,0 +1,117 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryReader_h
+#define __plist_Format_BinaryReader_h
+
+#include <plist/Format/ABPCoder.h>
+#include <plist/Format/Handler.h>
+
+#include <string>
+#include <unordered_set>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Reads a binary property list in memory directly, finding each object
+ * through the offset table as it's needed. Every offset and length is
+ * checked against the input before it is used.
+ */
+class BinaryReader {
+public:
+    /*
+     * Where an object is, once its marker has been read. The length is
+     * the number of bytes, characters, or entries, and the offset is the
+     * start of the contents after the marker.
+     */
+    struct Record {
+        ABPRecordType type;
+        uint64_t      length;
+        size_t        offset;
+    };
+
+private:
+    uint8_t const    *_data;
+    size_t            _size;
+    bool              _borrow;
+
+private:
+    size_t            _offsetSize;
+    size_t            _referenceSize;
+    uint64_t          _count;
+    uint64_t          _top;
+    size_t            _table;
+
+private:
+    std::unordered_set<uint64_t> _visiting;
+    bool                         _stopped;
+    std::string                  _error;
+
+public:
+    /*
+     * Read from the data given, which must outlive the reader. If borrow
+     * is set, it must also outlive the strings read, as ASCII strings are
+     * borrowed from it rather than copied.
+     */
+    BinaryReader(uint8_t const *data, size_t size, bool borrow);
+
+public:
+    /*
+     * Check the header and trailer. This must succeed before reading.
+     */
+    bool open();
+
+public:
+    uint64_t top() const
+    { return _top; }
+    bool stopped() const
+    { return _stopped; }
+    std::string const &error() const
+    { return _error; }
+
+public:
+    /*
+     * Find an object and read its marker.
+     */
+    bool record(uint64_t reference, Record *record);
+
+    /*
+     * The reference to an element of an array, or to a key or value of a
+     * dictionary. The keys are first, then the values.
+     */
+    uint64_t reference(Record const &record, uint64_t index) const;
+
+    /*
+     * Create an object that isn't an array or dictionary.
+     */
+    std::unique_ptr<Object> scalar(Record const &record);
+
+    /*
+     * The contents of a string object as UTF-8. ASCII strings point into
+     * the input; others are converted into the buffer.
+     */
+    bool string(uint64_t reference, char const **data, size_t *size, std::string *buffer);
+
+public:
+    /*
+     * Read an object and everything in it as events. Returns false on
+     * an error, or if the handler stopped reading.
+     */
+    bool read(uint64_t reference, Handler *handler);
+
+private:
+    bool emit(bool result);
+    bool readObject(uint64_t reference, Handler *handler);
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryReader_h
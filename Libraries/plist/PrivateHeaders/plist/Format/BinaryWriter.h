@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryWriter_h
+#define __plist_Format_BinaryWriter_h
+
+#include <plist/Format/ABPCoder.h>
+#include <plist/Format/Sink.h>
+#include <plist/Object.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Writes a binary property list into a single buffer. Objects are laid
+ * out first: each is given a reference, and equal strings, numbers, dates
+ * and data share one object through a hash table. As the size of every
+ * object is known then, the output is written in order, and a buffer for
+ * it is allocated once.
+ */
+class BinaryWriter {
+private:
+    /*
+     * An object to write. The length is what's stored in the marker: the
+     * number of characters, bytes or entries, or the size of a number.
+     * The value is the contents of a number, or where a container's
+     * references start; data and strings point to their contents.
+     */
+    struct Entry {
+        ABPRecordType type;
+        uint64_t      length;
+        uint64_t      value;
+        char const   *data;
+        size_t        size;
+        uint64_t      hash;
+    };
+
+private:
+    std::vector<Entry>                _objects;
+    std::vector<uint64_t>             _references;
+    std::vector<std::vector<uint8_t>> _unicode;
+    size_t                            _size;
+
+private:
+    std::vector<uint64_t>             _table;
+    size_t                            _unique;
+
+private:
+    std::string                       _error;
+
+public:
+    BinaryWriter();
+
+public:
+    /*
+     * Write an object and everything in it. Returns null on failure.
+     */
+    std::unique_ptr<std::vector<uint8_t>> write(Object const *object);
+
+    /*
+     * Write an object and everything in it to a sink, in pieces.
+     */
+    bool write(Object const *object, Sink *sink);
+
+public:
+    std::string const &error() const
+    { return _error; }
+
+private:
+    bool add(Object const *object, uint64_t *reference);
+    uint64_t push(Entry const &entry);
+    uint64_t scalar(Entry entry);
+    uint64_t string(char const *data, size_t size);
+    void grow();
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryWriter_h
@@ -10,6 +10,7 @@
 #ifndef __plist_Format_JSONWriter_h
 #define __plist_Format_JSONWriter_h
 
+#include <plist/Format/OutputBuffer.h>
 #include <plist/Objects.h>
 
 namespace plist {
@@ -18,18 +19,14 @@ namespace Format {
 class JSONWriter {
 private:
     Object const         *_root;
-    std::vector<uint8_t>  _contents;
+    OutputBuffer          _output;
     int                   _indent;
     bool                  _lastKey;
 
 public:
-    JSONWriter(Object const *root);
+    JSONWriter(Object const *root, Sink *sink);
     ~JSONWriter();
 
-public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
-
 public:
     bool write();
 
@@ -0,0 +1,85 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_OutputBuffer_h
+#define __plist_Format_OutputBuffer_h
+
+#include <plist/Format/Sink.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Gathers small writes into fixed size pieces before passing them to a
+ * sink, so writers can append a character at a time without the output
+ * growing without bound. Once writing to the sink fails, it stays failed.
+ */
+class OutputBuffer {
+private:
+    static size_t const Capacity = 64 * 1024;
+
+private:
+    Sink                 *_sink;
+    std::vector<uint8_t>  _buffer;
+    size_t                _used;
+    bool                  _failed;
+
+public:
+    explicit OutputBuffer(Sink *sink);
+
+public:
+    inline bool append(char const *data, size_t size)
+    {
+        if (size > Capacity - _used) {
+            return spill(reinterpret_cast<uint8_t const *>(data), size);
+        }
+
+        ::memcpy(_buffer.data() + _used, data, size);
+        _used += size;
+        return !_failed;
+    }
+
+    inline bool append(uint8_t const *data, size_t size)
+    {
+        return append(reinterpret_cast<char const *>(data), size);
+    }
+
+    inline bool append(std::string const &string)
+    {
+        return append(string.data(), string.size());
+    }
+
+    inline bool append(char c)
+    {
+        if (_used == Capacity) {
+            return spill(reinterpret_cast<uint8_t const *>(&c), 1);
+        }
+
+        _buffer[_used++] = static_cast<uint8_t>(c);
+        return !_failed;
+    }
+
+public:
+    /*
+     * Pass on everything written so far.
+     */
+    bool flush();
+
+private:
+    bool spill(uint8_t const *data, size_t size);
+};
+
+}
+}
+
+#endif  // !__plist_Format_OutputBuffer_h
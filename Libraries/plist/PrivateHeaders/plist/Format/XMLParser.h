@@ -11,6 +11,7 @@
 #define __plist_Format_XMLParser_h
 
 #include <plist/Format/BaseXMLParser.h>
+#include <plist/Format/Handler.h>
 #include <plist/Object.h>
 
 namespace plist {
@@ -18,34 +19,53 @@ namespace Format {
 
 class XMLParser : public BaseXMLParser {
 private:
-    struct Key {
-        std::string value;
-        bool        valid;
-        bool        active;
+    enum class Element {
+        None,
+        Key,
+        String,
+        Integer,
+        Real,
+        Boolean,
+        Null,
+        Data,
+        Date,
     };
 
-    struct State {
-        typedef std::vector <State> vector;
+    struct Level {
+        bool dictionary;
+        bool keyed;
+    };
 
-        Object *current;
-        Key     key;
+    /*
+     * Dictionaries with only a CF$UID integer are UIDs, so the start of
+     * each dictionary is held back until it's known not to be one.
+     */
+    enum class Pending {
+        None,
+        Dictionary,
+        Key,
+        Value,
     };
 
 private:
-    Object        *_root;
-    State::vector  _stack;
-    State          _state;
-    std::string    _cdata;
+    Handler                *_handler;
+    bool                    _root;
+    std::vector<Level>      _levels;
 
-public:
-    XMLParser();
+private:
+    Element                 _element;
+    bool                    _boolean;
+    std::string             _cdata;
+
+private:
+    Pending                 _pending;
+    std::unique_ptr<Object> _pendingValue;
 
 public:
-    Object *parse(std::vector<uint8_t> const &contents);
+    explicit XMLParser(Handler *handler);
 
-private:
-    virtual void onBeginParse();
-    virtual void onEndParse(bool success);
+public:
+    bool parse(std::vector<uint8_t> const &contents);
 
 private:
     void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth);
@@ -53,41 +73,25 @@ private:
     void onCharacterData(std::string const &cdata, size_t depth);
 
 private:
-    void push(Object *object);
-    void pop();
-
-private:
-    inline bool inArray() const;
     inline bool inDictionary() const;
-    inline bool inContainer() const;
     inline bool isExpectingKey() const;
     inline bool isExpectingCDATA() const;
 
+private:
+    bool emit(bool result);
+    bool flush();
+    bool value();
+
 private:
     bool beginObject(std::string const &name);
-    bool beginArray();
-    bool beginDictionary();
-    bool beginString();
-    bool beginInteger();
-    bool beginReal();
-    bool beginBoolean(bool value);
-    bool beginNull();
-    bool beginData();
-    bool beginDate();
-    bool beginKey();
+    bool beginContainer(bool dictionary);
+    bool beginScalar(Element element);
 
 private:
     bool endObject(std::string const &name);
-    bool endArray();
-    bool endDictionary();
-    bool endString();
-    bool endInteger();
-    bool endReal();
-    bool endBoolean();
-    bool endNull();
-    bool endData();
-    bool endDate();
+    bool endContainer(bool dictionary);
     bool endKey();
+    bool endScalar();
 };
 
 }
@@ -11,6 +11,7 @@
 #define __plist_Format_XMLWriter_h
 
 #include <plist/Format/BaseXMLParser.h>
+#include <plist/Format/OutputBuffer.h>
 #include <plist/Objects.h>
 
 namespace plist {
@@ -19,17 +20,13 @@ namespace Format {
 class XMLWriter {
 private:
     Object const         *_root;
-    std::vector<uint8_t>  _contents;
+    OutputBuffer          _output;
     int                   _indent;
 
 public:
-    XMLWriter(Object const *root);
+    XMLWriter(Object const *root, Sink *sink);
     ~XMLWriter();
 
-public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
-
 public:
     bool write();
 
@@ -0,0 +1,96 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Arena.h>
+
+using plist::Arena;
+
+/*
+ * Enough for any fundamental type.
+ */
+static size_t const ArenaAlignment = 16;
+
+static thread_local Arena *CurrentArena = nullptr;
+
+Arena::Scope::
+Scope(Arena *arena) :
+    _previous(CurrentArena)
+{
+    CurrentArena = arena;
+}
+
+Arena::Scope::
+~Scope()
+{
+    CurrentArena = _previous;
+}
+
+Arena *Arena::Scope::
+Current()
+{
+    return CurrentArena;
+}
+
+Arena::
+Arena(size_t blockSize) :
+    _blockSize(blockSize),
+    _next     (nullptr),
+    _end      (nullptr),
+    _size     (0)
+{
+}
+
+Arena::
+~Arena()
+{
+}
+
+void *Arena::
+allocate(size_t size)
+{
+    size = (size + ArenaAlignment - 1) & ~(ArenaAlignment - 1);
+
+    _size += size;
+
+    if (size > _blockSize / 4) {
+        /* Large allocations get their own block, to not waste the current one. */
+        _blocks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[size]));
+        return _blocks.back().get();
+    }
+
+    if (static_cast<size_t>(_end - _next) < size) {
+        _blocks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[_blockSize]));
+        _next = _blocks.back().get();
+        _end = _next + _blockSize;
+    }
+
+    void *pointer = _next;
+    _next += size;
+    return pointer;
+}
+
+std::vector<uint8_t> const &Arena::
+retain(std::vector<uint8_t> &&buffer)
+{
+    _retained.push_back(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(std::move(buffer))));
+    return *_retained.back();
+}
+
+bool Arena::
+retains(void const *pointer) const
+{
+    uint8_t const *byte = static_cast<uint8_t const *>(pointer);
+    for (std::unique_ptr<std::vector<uint8_t>> const &buffer : _retained) {
+        if (byte >= buffer->data() && byte < buffer->data() + buffer->size()) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -16,9 +16,17 @@ using plist::Base64;
 void Base64::
 Decode(std::string const &in, std::vector<uint8_t> &out)
 {
+    if (in.empty()) {
+        out.clear();
+        return;
+    }
+
     size_t outsize = rfc4648_get_decoded_size(RFC4648_TYPE_BASE64_SAFE, in.size());
     out.resize(outsize);
     rfc4648_decode(RFC4648_TYPE_BASE64_SAFE, &in[0], in.size(), reinterpret_cast<char *>(&out[0]), &outsize, true);
+
+    /* The size before decoding allows for padding and whitespace. */
+    out.resize(outsize);
 }
 
 std::string Base64::
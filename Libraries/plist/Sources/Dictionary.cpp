@@ -9,6 +9,8 @@
 
 #include <plist/Dictionary.h>
 
+#include <functional>
+
 using plist::Object;
 using plist::Dictionary;
 
@@ -18,6 +20,100 @@ New()
     return std::unique_ptr<Dictionary>(new Dictionary());
 }
 
+/*
+ * Small dictionaries are faster to search than to hash.
+ */
+static size_t const IndexThreshold = 8;
+
+size_t const Dictionary::npos;
+
+size_t Dictionary::
+find(std::string const &key) const
+{
+    if (_index.empty()) {
+        for (size_t n = 0; n < _entries.size(); ++n) {
+            if (_entries[n].first == key) {
+                return n;
+            }
+        }
+
+        return npos;
+    }
+
+    size_t mask = _index.size() - 1;
+    for (size_t slot = std::hash<std::string>()(key) & mask; _index[slot] != 0; slot = (slot + 1) & mask) {
+        size_t index = _index[slot] - 1;
+        if (_entries[index].first == key) {
+            return index;
+        }
+    }
+
+    return npos;
+}
+
+void Dictionary::
+reindex()
+{
+    _index.clear();
+    if (_entries.size() <= IndexThreshold) {
+        return;
+    }
+
+    /* Keep the table at most half full. */
+    size_t size = 1;
+    while (size < _entries.size() * 2) {
+        size <<= 1;
+    }
+    _index.resize(size);
+
+    size_t mask = size - 1;
+    for (size_t n = 0; n < _entries.size(); ++n) {
+        size_t slot = std::hash<std::string>()(_entries[n].first) & mask;
+        while (_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _index[slot] = static_cast<uint32_t>(n + 1);
+    }
+}
+
+void Dictionary::
+set(std::string const &key, std::unique_ptr<Object> obj)
+{
+    set(std::string(key), std::move(obj));
+}
+
+void Dictionary::
+set(std::string &&key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+    _entries.push_back(std::make_pair(std::move(key), std::move(obj)));
+
+    if (_entries.size() * 2 > _index.size()) {
+        reindex();
+    } else {
+        size_t mask = _index.size() - 1;
+        size_t slot = std::hash<std::string>()(_entries.back().first) & mask;
+        while (_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _index[slot] = static_cast<uint32_t>(_entries.size());
+    }
+}
+
+void Dictionary::
+remove(std::string const &key)
+{
+    size_t index = find(key);
+    if (index != npos) {
+        _entries.erase(_entries.begin() + index);
+
+        /* Later entries moved, so their indexes changed. */
+        if (!_index.empty()) {
+            reindex();
+        }
+    }
+}
+
 std::unique_ptr<Object> Dictionary::
 _copy() const
 {
@@ -35,7 +131,7 @@ merge(Dictionary const *dict, bool replace)
         return;
 
     for (auto const &key : *dict) {
-        if (replace || _map.find(key) == _map.end()) {
+        if (replace || find(key) == npos) {
             set(key, dict->value(key)->copy());
         }
     }
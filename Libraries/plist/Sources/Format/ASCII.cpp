@@ -15,8 +15,14 @@
 using plist::Format::Type;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
+using plist::Format::BufferSink;
 using plist::Format::ASCII;
+using plist::Format::ASCIIParser;
+using plist::Format::Builder;
+using plist::Format::Handler;
 using plist::Object;
+using plist::Arena;
 
 ASCII::
 ASCII(bool strings, Encoding encoding) :
@@ -219,27 +225,34 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
-Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
+std::pair<bool, std::string> Format<ASCII>::
+Read(std::vector<uint8_t> const &contents, ASCII const &format, Handler *handler)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
+    std::vector<uint8_t> converted = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
 
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    /* When deserializing into an arena, it keeps the input for strings to borrow. */
+    Arena *arena = Arena::Scope::Current();
+    std::vector<uint8_t> const &data = (arena != nullptr ? arena->retain(std::move(converted)) : converted);
 
     /* Create lexer. */
     ASCIIPListLexer lexer;
     ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data.data()), data.size(), kASCIIPListLexerStyleASCII);
 
     /* Parse contents. */
-    ASCIIParser parser;
-    if (parser.parse(&lexer, format.strings())) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    ASCIIParser parser = ASCIIParser(handler);
+    if (!parser.parse(&lexer, format.strings()) && !parser.stopped()) {
+        return std::make_pair(false, parser.error());
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(true, std::string());
+}
+
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
+Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
+{
+    Builder builder;
+    return builder.finish(Read(contents, format, &builder));
 }
 
 template<>
@@ -250,16 +263,47 @@ Serialize(Object const *object, ASCII const &format)
         return std::make_pair(nullptr, "object was null");
     }
 
-    ASCIIWriter writer = ASCIIWriter(object, format.strings());
+    BufferSink sink;
+    ASCIIWriter writer = ASCIIWriter(object, format.strings(), &sink);
     if (!writer.write()) {
         return std::make_pair(nullptr, "serialization failed");
     }
 
-    std::vector<uint8_t> const data = Encodings::Convert(writer.contents(), Encoding::UTF8, format.encoding());
+    std::vector<uint8_t> const data = Encodings::Convert(sink.contents(), Encoding::UTF8, format.encoding());
 
     return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(data.begin(), data.end())), std::string());
 }
 
+template<>
+std::pair<bool, std::string> Format<ASCII>::
+Serialize(Object const *object, ASCII const &format, Sink *sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "object was null");
+    }
+
+    /* Converting to other encodings needs the whole output. */
+    if (format.encoding() != Encoding::UTF8) {
+        auto serialized = Serialize(object, format);
+        if (serialized.first == nullptr) {
+            return std::make_pair(false, serialized.second);
+        }
+
+        if (!sink->write(serialized.first->data(), serialized.first->size())) {
+            return std::make_pair(false, "unable to write output");
+        }
+
+        return std::make_pair(true, std::string());
+    }
+
+    ASCIIWriter writer = ASCIIWriter(object, format.strings(), sink);
+    if (!writer.write()) {
+        return std::make_pair(false, "serialization failed");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
 } }
 
 ASCII ASCII::
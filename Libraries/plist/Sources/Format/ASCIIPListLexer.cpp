@@ -14,6 +14,12 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*
  * Syntax:
  *
@@ -101,13 +107,158 @@ hex2bin(char ch)
         return (ch - '0');
 }
 
+/** Vector scanning **/
+
+/*
+ * Most of a large property list is whitespace, comments, identifiers and
+ * strings. These are skipped a vector at a time until a byte that needs
+ * handling is found, then the scalar code below continues from there.
+ * Vectors are only loaded while they fit before the end of the input.
+ */
+
+#if defined(__AVX2__)
+#define ASCII_PLIST_LEXER_VECTOR 1
+typedef __m256i ASCIIPListVector;
+static size_t const   kASCIIPListVectorSize = 32;
+static uint32_t const kASCIIPListVectorMask = 0xffffffff;
+
+static inline ASCIIPListVector
+VectorLoad(char const *p)
+{ return _mm256_loadu_si256((__m256i const *)p); }
+
+static inline ASCIIPListVector
+VectorEqual(ASCIIPListVector v, char ch)
+{ return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch)); }
+
+static inline ASCIIPListVector
+VectorRange(ASCIIPListVector v, char lo, char hi)
+{ return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v)); }
+
+static inline ASCIIPListVector
+VectorOr(ASCIIPListVector a, ASCIIPListVector b)
+{ return _mm256_or_si256(a, b); }
+
+static inline uint32_t
+VectorMask(ASCIIPListVector v)
+{ return (uint32_t)_mm256_movemask_epi8(v); }
+#elif defined(__SSE2__)
+#define ASCII_PLIST_LEXER_VECTOR 1
+typedef __m128i ASCIIPListVector;
+static size_t const   kASCIIPListVectorSize = 16;
+static uint32_t const kASCIIPListVectorMask = 0xffff;
+
+static inline ASCIIPListVector
+VectorLoad(char const *p)
+{ return _mm_loadu_si128((__m128i const *)p); }
+
+static inline ASCIIPListVector
+VectorEqual(ASCIIPListVector v, char ch)
+{ return _mm_cmpeq_epi8(v, _mm_set1_epi8(ch)); }
+
+static inline ASCIIPListVector
+VectorRange(ASCIIPListVector v, char lo, char hi)
+{ return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v)); }
+
+static inline ASCIIPListVector
+VectorOr(ASCIIPListVector a, ASCIIPListVector b)
+{ return _mm_or_si128(a, b); }
+
+static inline uint32_t
+VectorMask(ASCIIPListVector v)
+{ return (uint32_t)_mm_movemask_epi8(v); }
+#endif
+
+#if ASCII_PLIST_LEXER_VECTOR
+static inline bool
+VectorFits(ASCIIPListLexer const *lexer, char const *p)
+{ return lexer->vectorized && p <= lexer->endBuffer && (size_t)(lexer->endBuffer - p) >= kASCIIPListVectorSize; }
+#endif
+
+/*
+ * Find the first of up to four characters (repeat one to use fewer).
+ */
+static inline char const *
+ASCIIPListLexerFind(ASCIIPListLexer const *lexer, char const *p, char a, char b, char c, char d)
+{
+#if ASCII_PLIST_LEXER_VECTOR
+    while (VectorFits(lexer, p)) {
+        ASCIIPListVector v = VectorLoad(p);
+        uint32_t found = VectorMask(VectorOr(VectorOr(VectorEqual(v, a), VectorEqual(v, b)),
+                                             VectorOr(VectorEqual(v, c), VectorEqual(v, d))));
+        if (found != 0) {
+            return p + __builtin_ctz(found);
+        }
+        p += kASCIIPListVectorSize;
+    }
+#endif
+    return p;
+}
+
+/*
+ * Skip whitespace, counting lines.
+ */
+static inline char const *
+ASCIIPListLexerSkipWhitespace(ASCIIPListLexer *lexer, char const *p)
+{
+#if ASCII_PLIST_LEXER_VECTOR
+    while (VectorFits(lexer, p)) {
+        ASCIIPListVector v = VectorLoad(p);
+        uint32_t newlines = VectorMask(VectorEqual(v, '\n'));
+        uint32_t other = ~(newlines | VectorMask(VectorOr(VectorOr(VectorEqual(v, ' '), VectorEqual(v, '\t')),
+                                                          VectorOr(VectorEqual(v, '\r'), VectorEqual(v, '\f'))))) & kASCIIPListVectorMask;
+
+        size_t count = kASCIIPListVectorSize;
+        if (other != 0) {
+            count = __builtin_ctz(other);
+            newlines &= (1u << count) - 1;
+        }
+
+        if (newlines != 0) {
+            lexer->line += __builtin_popcount(newlines);
+            lexer->lineStart = p + (31 - __builtin_clz(newlines)) + 1;
+        }
+
+        p += count;
+        if (other != 0) {
+            break;
+        }
+    }
+#endif
+    return p;
+}
+
+/*
+ * Skip characters allowed in unquoted strings.
+ */
+static inline char const *
+ASCIIPListLexerSkipUnquoted(ASCIIPListLexer const *lexer, char const *p)
+{
+#if ASCII_PLIST_LEXER_VECTOR
+    while (VectorFits(lexer, p)) {
+        ASCIIPListVector v = VectorLoad(p);
+        /* The range '-' to ':' covers "-./", digits and ':'. */
+        uint32_t allowed = VectorMask(VectorOr(VectorOr(VectorRange(v, 'a', 'z'), VectorRange(v, 'A', 'Z')),
+                                               VectorOr(VectorRange(v, '-', ':'),
+                                                        VectorOr(VectorEqual(v, '_'), VectorEqual(v, '$')))));
+        uint32_t other = ~allowed & kASCIIPListVectorMask;
+        if (other != 0) {
+            return p + __builtin_ctz(other);
+        }
+        p += kASCIIPListVectorSize;
+    }
+#endif
+    return p;
+}
+
 static int
 ASCIIPListLexerReadInlineComment(ASCIIPListLexer *lexer)
 {
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0' && *p != '\n' && *p != '\r'; p++)
+    b = p;
+    p = ASCIIPListLexerFind(lexer, p, '\0', '\n', '\r', '\r');
+    for (; *p != '\0' && *p != '\n' && *p != '\r'; p++)
         ;
     lexer->tokenLength = p - b;
     lexer->pointer = p;
@@ -121,7 +272,7 @@ ASCIIPListLexerReadLongComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\0', '\n', '*', '*')) != '\0'; p++) {
         if (p[0] == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -141,7 +292,7 @@ ASCIIPListLexerReadSingleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\'' && *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\'', '\0', '\n', '\n')) != '\'' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -164,7 +315,7 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\"' && *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\"', '\0', '\n', '\\')) != '\"' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -313,6 +464,7 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
         }
     } else if (lexer->style == kASCIIPListLexerStyleASCII) {
         rc = kASCIIPListLexerTokenUnquotedString;
+        p = ASCIIPListLexerSkipUnquoted(lexer, p);
         /*
             * '$' is encountered in pbxproj files.
             */
@@ -444,10 +596,12 @@ ASCIIPListLexerReadToken(ASCIIPListLexer *lexer)
 
             case ' ': case '\f': case '\t': case '\r':
                  p++;
+                 p = ASCIIPListLexerSkipWhitespace(lexer, p);
                  break;
 
             case '\n':
                  p++, lexer->line++; lexer->lineStart = p;
+                 p = ASCIIPListLexerSkipWhitespace(lexer, p);
                  break;
 
             default:
@@ -481,6 +635,7 @@ ASCIIPListLexerInit(ASCIIPListLexer *lexer, char const *buffer, int length,
     lexer->endBuffer = lexer->inputBuffer + length;
     lexer->style = style;
     lexer->line = 1;
+    lexer->vectorized = 1;
 }
 
 /* Convert sequence \xXX */
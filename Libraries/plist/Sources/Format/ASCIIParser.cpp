@@ -9,23 +9,24 @@
 
 #include <plist/Format/ASCIIParser.h>
 #include <plist/Objects.h>
+#include <plist/Arena.h>
 
 #include <cstdlib>
+#include <cstring>
 
 using plist::Format::ASCIIParser;
+using plist::Format::Handler;
+using plist::Arena;
 using plist::Object;
 using plist::String;
 using plist::Data;
-using plist::Array;
-using plist::Dictionary;
 
 ASCIIParser::
-ASCIIParser() :
-    _root(nullptr),
+ASCIIParser(Handler *handler) :
+    _handler(handler),
+    _stopped(false),
     _level(0),
     _state(ValueState::Init),
-    _container(nullptr),
-    _key(nullptr),
     _contextState(ContextState::Parsing)
 {
 }
@@ -78,7 +79,7 @@ abort(std::string const &error, int line)
 }
 
 bool ASCIIParser::
-push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key)
+push(ValueState state)
 {
     if (isAborted()) {
         return false;
@@ -87,25 +88,10 @@ push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr
     /* If valid state, push, otherwise just set the new state. */
     if (_state != ValueState::Init) {
         /* Push the old state */
-        _containerStack.push(std::move(_container));
-        _keyStack.push(std::move(_key));
         _stateStack.push(_state);
     }
 
     _state = state;
-
-    if (container != nullptr) {
-        _container = std::move(container);
-    } else {
-        _container = nullptr;
-    }
-
-    if (key != nullptr) {
-        _key = std::move(key);
-    } else {
-        _key = nullptr;
-    }
-
     return true;
 }
 
@@ -119,9 +105,6 @@ pop()
             return false; /* Underflow! */
 
         /* Reset current state. */
-        _container = nullptr;
-        _key = nullptr;
-
         _state = ValueState::Init;
         return true;
     }
@@ -130,136 +113,62 @@ pop()
     _state = std::move(_stateStack.top());
     _stateStack.pop();
 
-    _container = std::move(_containerStack.top());
-    _containerStack.pop();
-
-    _key = std::move(_keyStack.top());
-    _keyStack.pop();
-
     return true;
 }
 
 /*
- * Generic container handling.
+ * Pass on the result of an event. If the handler stopped, so does parsing.
  */
 bool ASCIIParser::
-beginContainer(std::unique_ptr<plist::Object> object)
+emit(bool result)
 {
-    ValueState state;
-
-    if (object->type() == Array::Type()) {
-        state = ValueState::Array;
-    } else {
-        state = ValueState::Dictionary;
-    }
-
-    if (!push(state, std::move(object), nullptr)) {
-        abort("Cannot push the current state.");
-        return false;
+    if (!result) {
+        _stopped = true;
     }
 
-    return true;
+    return result;
 }
 
+/*
+ * Generic container handling.
+ */
 bool ASCIIParser::
-storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value)
+beginContainer(bool isArray)
 {
-    if (_container == nullptr) {
-        if (_key != nullptr) {
-            abort("Storing key/value pair with no container.");
-            return false;
-        }
-
-        /* Make current value the root. */
-        if (_root != nullptr) {
-            abort("Double root.");
-            return false;
-        }
-
-        _root = std::move(value);
-        return true;
-    }
-
-    if (key != nullptr) {
-        if (_container->type() != Dictionary::Type()) {
-            abort("Storing key/value with no dictionary container.");
-            return false;
-        }
-
-        plist::Dictionary *dict = static_cast<plist::Dictionary *>(_container.get());
-        dict->set(key->value(), std::move(value));
-
-        _state = ValueState::Dictionary;
-    } else {
-        if (_container->type() != Array::Type()) {
-            abort("Storing value with no array container.");
-            return false;
-        }
-
-        plist::Array *array = static_cast<plist::Array *>(_container.get());
-        array->append(std::move(value));
-
-        _state = ValueState::Array;
+    if (!push(isArray ? ValueState::Array : ValueState::Dictionary)) {
+        abort("Cannot push the current state.");
+        return false;
     }
 
-    return true;
+    return emit(isArray ? _handler->beginArray() : _handler->beginDictionary());
 }
 
 bool ASCIIParser::
 endContainer(bool isArray)
 {
-    std::unique_ptr<plist::String> key;
-    std::unique_ptr<plist::Object> value;
-    bool success;
-
     /* Check state is consistant. */
     if (_state != (isArray ? ValueState::Array : ValueState::Dictionary)) {
         abort("Closing array/dictionary in wrong state.");
         return false;
     }
 
-    if (_container == nullptr) {
-        abort("Closing non-opened container.");
-        return false;
-    }
-
-    value = std::move(_container);
-    if (value == nullptr) {
-        abort("Couldn't copy container.");
-        return false;
-    }
-
-    /* Is this the right type of container? */
-    if (value->type() != (isArray ? Array::Type() : Dictionary::Type())) {
-        abort("Closing wrong kind of container.");
-        return false;
-    }
-
     if (!pop()) {
         abort("Parser stack underflow.");
         return false;
     }
 
-    /* Take ownership of the saved key. */
-    key = std::move(_key);
-    _key = nullptr;
-
-    success = storeKeyValue(std::move(key), std::move(value));
+    /* The container was the value for a key. */
+    if (_state == ValueState::DictionaryValue) {
+        _state = ValueState::Dictionary;
+    }
 
-    return success;
+    return emit(isArray ? _handler->endArray() : _handler->endDictionary());
 }
 
 bool ASCIIParser::
 beginArray()
 {
-    std::unique_ptr<plist::Array> array = Array::New();
-    if (array == nullptr) {
-        abort("Cannot create an array.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(array));
-    return success;
+    return beginContainer(true);
 }
 
 bool ASCIIParser::
@@ -271,14 +180,7 @@ endArray()
 bool ASCIIParser::
 beginDictionary()
 {
-    std::unique_ptr<plist::Dictionary> dict = Dictionary::New();
-    if (dict == nullptr) {
-        abort("Cannot create a dictionary.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(dict));
-    return success;
+    return beginContainer(false);
 }
 
 bool ASCIIParser::
@@ -293,39 +195,33 @@ endDictionary()
 bool ASCIIParser::
 storeKey(std::unique_ptr<plist::String> key)
 {
-    if (key == nullptr) {
-        key = String::New();
-
-        if (key == nullptr) {
-            abort("Cannot create empty key.");
-            return false;
-        }
-    }
-
     if (_state != ValueState::Dictionary) {
         abort("Storing key in wrong state.");
         return false;
     }
 
-    _key = std::move(key);
-
     _state = ValueState::DictionaryValue;
-    return true;
+
+    if (key == nullptr) {
+        return emit(_handler->key("", 0));
+    }
+
+    return emit(_handler->key(key->data(), key->size()));
 }
 
 bool ASCIIParser::
 storeValue(std::unique_ptr<plist::Object> value)
 {
-    bool success;
-
-    success = storeKeyValue(std::move(_key), std::move(value));
-    _key = nullptr;
+    if (_state == ValueState::Dictionary) {
+        abort("Storing value with no key.");
+        return false;
+    }
 
     if (_state == ValueState::DictionaryValue) {
         _state = ValueState::Dictionary;
     }
 
-    return success;
+    return emit(_handler->scalar(std::move(value)));
 }
 
 bool ASCIIParser::
@@ -376,6 +272,30 @@ hex_to_bin(char const *ascii)
     return (hex_to_bin_digit(ascii[0]) << 4) | hex_to_bin_digit(ascii[1]);
 }
 
+/*
+ * Create a string for the current token. Strings without escapes can
+ * borrow from the input, if it outlives them.
+ */
+static std::unique_ptr<String>
+CreateString(ASCIIPListLexer const *lexer, bool borrow)
+{
+    char const *token  = lexer->inputBuffer + lexer->tokenBegin;
+    size_t      length = lexer->tokenLength;
+
+    if (borrow && memchr(token, '\\', length) == NULL && memchr(token, '\0', length) == NULL) {
+        return String::Borrow(token, length);
+    }
+
+    char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
+    if (contents == NULL) {
+        return nullptr;
+    }
+
+    std::unique_ptr<String> string = String::New(std::string(contents));
+    free(contents);
+    return string;
+}
+
 bool ASCIIParser::
 parse(ASCIIPListLexer *lexer, bool strings)
 {
@@ -387,6 +307,10 @@ parse(ASCIIPListLexer *lexer, bool strings)
         kASCIIInvalid = -1
     } ASCIIParseState;
 
+    /* Borrow strings from the input if it's retained by the current arena. */
+    Arena *arena = Arena::Scope::Current();
+    bool borrow = (arena != nullptr && arena->retains(lexer->inputBuffer));
+
     if (strings) {
         /* Begin the root dictionary. */
         if (!beginDictionary()) {
@@ -506,9 +430,7 @@ parse(ASCIIPListLexer *lexer, bool strings)
 
                     if (token == kASCIIPListLexerTokenUnquotedString ||
                         token == kASCIIPListLexerTokenQuotedString) {
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        std::unique_ptr<String> string = String::New(std::string(contents));
-                        free(contents);
+                        std::unique_ptr<String> string = CreateString(lexer, borrow);
 
                         if (string == NULL) {
                             abort("OOM when copying string", lexer->line);
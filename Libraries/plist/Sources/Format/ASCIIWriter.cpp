@@ -26,9 +26,10 @@ using plist::Dictionary;
 using plist::CastTo;
 
 ASCIIWriter::
-ASCIIWriter(Object const *root, bool strings) :
+ASCIIWriter(Object const *root, bool strings, Sink *sink) :
     _root   (root),
     _strings(strings),
+    _output (sink),
     _indent (0),
     _lastKey(false)
 {
@@ -72,7 +73,7 @@ write()
         }
     }
 
-    return true;
+    return _output.flush();
 }
 
 /*
@@ -82,15 +83,12 @@ write()
 bool ASCIIWriter::
 primitiveWriteString(std::string const &string)
 {
-    _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return _output.append(string);
 }
 
 bool ASCIIWriter::
 primitiveWriteEscapedString(std::string const &string)
 {
-    _contents.reserve(_contents.size() + string.size());
-
     if (!primitiveWriteString("\"")) {
         return false;
     }
@@ -145,7 +143,7 @@ primitiveWriteEscapedString(std::string const &string)
                 case '\f': if (!primitiveWriteString("\\f"))  { return false; } break;
                 case '"':  if (!primitiveWriteString("\\\"")) { return false; } break;
                 case '\\': if (!primitiveWriteString("\\"))   { return false; } break;
-                default: _contents.push_back(c); break;
+                default: _output.append(c); break;
             }
         }
     }
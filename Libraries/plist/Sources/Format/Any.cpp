@@ -11,6 +11,8 @@
 
 using plist::Format::Format;
 using plist::Format::Any;
+using plist::Format::Handler;
+using plist::Format::Sink;
 using plist::Format::Type;
 using plist::Object;
 
@@ -88,6 +90,29 @@ Identify(std::vector<uint8_t> const &contents)
     return nullptr;
 }
 
+template<typename T>
+static std::pair<bool, std::string>
+ReadImpl(std::vector<uint8_t> const &contents, Any const &format, Handler *handler)
+{
+    return T::Read(contents, *format.format<T>(), handler);
+}
+
+template<>
+std::pair<bool, std::string> Format<Any>::
+Read(std::vector<uint8_t> const &contents, Any const &format, Handler *handler)
+{
+    switch (format.type()) {
+        case Type::Binary:
+            return ReadImpl<Binary>(contents, format, handler);
+        case Type::XML:
+            return ReadImpl<XML>(contents, format, handler);
+        case Type::ASCII:
+            return ReadImpl<ASCII>(contents, format, handler);
+    }
+
+    abort();
+}
+
 template<typename T>
 static std::pair<std::unique_ptr<Object>, std::string>
 DeserializeImpl(std::vector<uint8_t> const &contents, Any const &format)
@@ -138,4 +163,31 @@ Serialize(Object const *object, Any const &format)
     abort();
 }
 
+template<typename T>
+static std::pair<bool, std::string>
+SerializeImpl(Object const *object, Any const &format, Sink *sink)
+{
+    return T::Serialize(object, *format.format<T>(), sink);
+}
+
+template<>
+std::pair<bool, std::string> Format<Any>::
+Serialize(Object const *object, Any const &format, Sink *sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "invalid object to serialize");
+    }
+
+    switch (format.type()) {
+        case Type::Binary:
+            return SerializeImpl<Binary>(object, format, sink);
+        case Type::XML:
+            return SerializeImpl<XML>(object, format, sink);
+        case Type::ASCII:
+            return SerializeImpl<ASCII>(object, format, sink);
+    }
+
+    abort();
+}
+
 } }
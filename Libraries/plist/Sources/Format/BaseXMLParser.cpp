@@ -9,22 +9,49 @@
 
 #include <plist/Format/BaseXMLParser.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 
 using plist::Format::BaseXMLParser;
 
 BaseXMLParser::BaseXMLParser() :
     _parser (nullptr),
-    _depth  (0)
+    _depth  (0),
+    _stopped(false),
+    _failed (false),
+    _libxml (false),
+    _input  (nullptr),
+    _size   (0),
+    _offset (0),
+    _line   (0),
+    _column (0)
 {
 }
 
 bool BaseXMLParser::
 parse(std::vector<uint8_t> const &contents)
 {
-    _depth  = 0;
-    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
+    _depth   = 0;
+    _stopped = false;
+    _failed  = false;
+
+    if (!_libxml) {
+        bool supported = true;
+        bool success = parseDirect(contents, &supported);
+        if (supported) {
+            return success;
+        }
+    }
+
+    return parseLibXML(contents);
+}
+
+bool BaseXMLParser::
+parseLibXML(std::vector<uint8_t> const &contents)
+{
+    _parser  = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
     if (_parser == nullptr) {
         return false;
     }
@@ -68,21 +95,21 @@ parse(std::vector<uint8_t> const &contents)
             xmlChar const *name = xmlTextReaderConstName(_parser);
             onStartElement(std::string(reinterpret_cast<char const *>(name)), attrs, _depth);
 
-            if (ret == 1) {
+            if (ret == 1 && _parser != nullptr) {
                 /* Empty element. */
                 onEndElement(std::string(reinterpret_cast<char const *>(name)), _depth);
             }
         } else if (type == 15 /* End element. */) {
             xmlChar const *name = xmlTextReaderConstName(_parser);
             onEndElement(std::string(reinterpret_cast<char const *>(name)), _depth);
-        } else if (type == 3 /* Text. */) {
+        } else if (type == 3 /* Text. */ || type == 4 /* CDATA. */ || type == 14 /* Whitespace. */) {
             xmlChar const *value = xmlTextReaderConstValue(_parser);
             onCharacterData(std::string(reinterpret_cast<char const *>(value)), _depth);
         }
 
-        /* Handle error. */
+        /* Handle error, or stopping early. */
         if (_parser == nullptr) {
-            ret = -1;
+            ret = (_stopped ? 0 : -1);
             break;
         }
 
@@ -98,6 +125,503 @@ parse(std::vector<uint8_t> const &contents)
     return (ret == 0);
 }
 
+/*
+ * Reading directly.
+ */
+
+static inline bool
+IsSpace(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+static inline bool
+IsNameEnd(char c)
+{
+    return (IsSpace(c) || c == '/' || c == '>' || c == '=');
+}
+
+static inline bool
+HasPrefix(char const *input, size_t size, size_t offset, char const *prefix)
+{
+    size_t length = ::strlen(prefix);
+    return (size - offset >= length && ::memcmp(input + offset, prefix, length) == 0);
+}
+
+/*
+ * The offset of some text after an offset, or the size if it's not found.
+ */
+static inline size_t
+Find(char const *input, size_t size, size_t offset, char const *text)
+{
+    size_t length = ::strlen(text);
+    char const *found = std::search(input + offset, input + size, text, text + length);
+    return found - input;
+}
+
+/*
+ * Append text, normalizing line endings to a line feed.
+ */
+static void
+AppendText(std::string *out, char const *text, size_t size)
+{
+    char const *end = text + size;
+    while (text < end) {
+        char const *cr = static_cast<char const *>(::memchr(text, '\r', end - text));
+        if (cr == nullptr) {
+            out->append(text, end - text);
+            break;
+        }
+
+        out->append(text, cr - text);
+        out->push_back('\n');
+        text = (cr + 1 < end && cr[1] == '\n' ? cr + 2 : cr + 1);
+    }
+}
+
+static void
+AppendUTF8(std::string *out, uint32_t c)
+{
+    if (c < 0x80) {
+        out->push_back(c);
+    } else if (c < 0x800) {
+        out->push_back(0xc0 | (c >> 6));
+        out->push_back(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+        out->push_back(0xe0 | (c >> 12));
+        out->push_back(0x80 | ((c >> 6) & 0x3f));
+        out->push_back(0x80 | (c & 0x3f));
+    } else {
+        out->push_back(0xf0 | (c >> 18));
+        out->push_back(0x80 | ((c >> 12) & 0x3f));
+        out->push_back(0x80 | ((c >> 6) & 0x3f));
+        out->push_back(0x80 | (c & 0x3f));
+    }
+}
+
+bool BaseXMLParser::
+parseDirect(std::vector<uint8_t> const &contents, bool *supported)
+{
+    _input  = reinterpret_cast<char const *>(contents.data());
+    _size   = contents.size();
+    _offset = 0;
+    _text.clear();
+    _elements.clear();
+
+    /* Nothing has been read if the document needs libxml2. */
+    if (!prolog(supported) || !*supported) {
+        return false;
+    }
+
+    onBeginParse();
+
+    bool success = content();
+    if (_stopped) {
+        success = true;
+    }
+
+    _depth = 0;
+    onEndParse(success);
+
+    return success;
+}
+
+/*
+ * Skip the XML declaration, comments, processing instructions and the
+ * document type, up to the root element. Anything that needs more than
+ * that, including declaring entities and other encodings, is unsupported.
+ */
+bool BaseXMLParser::
+prolog(bool *supported)
+{
+    *supported = false;
+
+    /* UTF-8 byte order mark. */
+    if (HasPrefix(_input, _size, _offset, "\xef\xbb\xbf")) {
+        _offset += 3;
+    }
+
+    if (HasPrefix(_input, _size, _offset, "<?xml") && _offset + 5 < _size && IsSpace(_input[_offset + 5])) {
+        size_t end = Find(_input, _size, _offset, "?>");
+        if (end == _size) {
+            return true;
+        }
+
+        /* Only UTF-8, or its subset ASCII, is read directly. */
+        std::string declaration = std::string(_input + _offset, end - _offset);
+        std::string::size_type encoding = declaration.find("encoding");
+        if (encoding != std::string::npos) {
+            std::string::size_type quote = declaration.find_first_of("\"'", encoding);
+            if (quote == std::string::npos) {
+                return true;
+            }
+            std::string::size_type close = declaration.find(declaration[quote], quote + 1);
+            if (close == std::string::npos) {
+                return true;
+            }
+
+            std::string name = declaration.substr(quote + 1, close - quote - 1);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if (name != "utf-8" && name != "utf8" && name != "us-ascii" && name != "ascii") {
+                return true;
+            }
+        }
+
+        _offset = end + 2;
+    }
+
+    while (_offset < _size) {
+        if (IsSpace(_input[_offset])) {
+            _offset++;
+        } else if (HasPrefix(_input, _size, _offset, "<!--")) {
+            _offset = Find(_input, _size, _offset + 4, "-->") + 3;
+        } else if (HasPrefix(_input, _size, _offset, "<?")) {
+            _offset = Find(_input, _size, _offset + 2, "?>") + 2;
+        } else if (HasPrefix(_input, _size, _offset, "<!DOCTYPE")) {
+            /* Skip the document type, as long as it declares nothing. */
+            char quote = '\0';
+            for (_offset += 9; _offset < _size; _offset++) {
+                char c = _input[_offset];
+                if (quote != '\0') {
+                    quote = (c == quote ? '\0' : quote);
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '[') {
+                    return true;
+                } else if (c == '>') {
+                    break;
+                }
+            }
+            _offset++;
+        } else if (_input[_offset] == '<' && _offset + 1 < _size && !IsNameEnd(_input[_offset + 1]) && _input[_offset + 1] != '!' && _input[_offset + 1] != '?') {
+            *supported = true;
+            return true;
+        } else {
+            /* Let libxml2 report the error. */
+            return true;
+        }
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+content()
+{
+    bool root = false;
+
+    while (_offset < _size) {
+        char c = _input[_offset];
+
+        if (c == '<') {
+            if (HasPrefix(_input, _size, _offset, "</")) {
+                if (!endElement()) {
+                    return false;
+                }
+            } else if (HasPrefix(_input, _size, _offset, "<!--")) {
+                size_t end = Find(_input, _size, _offset + 4, "-->");
+                if (end == _size) {
+                    error("unterminated comment");
+                    return false;
+                }
+                _offset = end + 3;
+            } else if (HasPrefix(_input, _size, _offset, "<![CDATA[")) {
+                size_t end = Find(_input, _size, _offset + 9, "]]>");
+                if (end == _size) {
+                    error("unterminated CDATA section");
+                    return false;
+                } else if (_elements.empty()) {
+                    error("content outside the root element");
+                    return false;
+                }
+                AppendText(&_text, _input + _offset + 9, end - _offset - 9);
+                _offset = end + 3;
+            } else if (HasPrefix(_input, _size, _offset, "<?")) {
+                size_t end = Find(_input, _size, _offset + 2, "?>");
+                if (end == _size) {
+                    error("unterminated processing instruction");
+                    return false;
+                }
+                _offset = end + 2;
+            } else if (HasPrefix(_input, _size, _offset, "<!")) {
+                error("unexpected declaration");
+                return false;
+            } else {
+                if (_elements.empty() && root) {
+                    error("content outside the root element");
+                    return false;
+                }
+                root = true;
+
+                if (!startElement()) {
+                    return false;
+                }
+            }
+        } else if (_elements.empty()) {
+            if (!IsSpace(c)) {
+                error("content outside the root element");
+                return false;
+            }
+            _offset++;
+        } else if (!characters()) {
+            return false;
+        }
+
+        if (halted()) {
+            return false;
+        }
+    }
+
+    if (!_elements.empty()) {
+        error("unexpected end of document in element '%s'", std::string(_input + _elements.back().first, _elements.back().second).c_str());
+        return false;
+    } else if (!root) {
+        error("no root element");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Pass on the text read since the last element started or ended.
+ */
+void BaseXMLParser::
+flush()
+{
+    if (!_text.empty()) {
+        _depth = _elements.size();
+        onCharacterData(_text, _depth);
+        _text.clear();
+    }
+}
+
+bool BaseXMLParser::
+startElement()
+{
+    flush();
+    if (halted()) {
+        return false;
+    }
+
+    size_t start = ++_offset;
+    while (_offset < _size && !IsNameEnd(_input[_offset])) {
+        _offset++;
+    }
+    size_t length = _offset - start;
+    if (length == 0) {
+        error("invalid element name");
+        return false;
+    }
+
+    _attributes.clear();
+    while (true) {
+        while (_offset < _size && IsSpace(_input[_offset])) {
+            _offset++;
+        }
+
+        if (_offset >= _size) {
+            error("unexpected end of document in element");
+            return false;
+        } else if (_input[_offset] == '>' || HasPrefix(_input, _size, _offset, "/>")) {
+            break;
+        }
+
+        size_t nameStart = _offset;
+        while (_offset < _size && !IsNameEnd(_input[_offset])) {
+            _offset++;
+        }
+        _name.assign(_input + nameStart, _offset - nameStart);
+
+        while (_offset < _size && IsSpace(_input[_offset])) {
+            _offset++;
+        }
+        if (_name.empty() || _offset >= _size || _input[_offset] != '=') {
+            error("invalid attribute in element");
+            return false;
+        }
+        _offset++;
+        while (_offset < _size && IsSpace(_input[_offset])) {
+            _offset++;
+        }
+
+        std::string value;
+        if (!attributeValue(&value)) {
+            return false;
+        }
+        if (!_attributes.insert({ _name, std::move(value) }).second) {
+            error("duplicate attribute '%s'", _name.c_str());
+            return false;
+        }
+    }
+
+    bool empty = (_input[_offset] == '/');
+    _offset += (empty ? 2 : 1);
+
+    _name.assign(_input + start, length);
+    _depth = _elements.size();
+    _elements.push_back({ start, length });
+    onStartElement(_name, _attributes, _depth);
+    if (halted()) {
+        return false;
+    }
+
+    if (empty) {
+        _elements.pop_back();
+        onEndElement(_name, _depth);
+    }
+
+    return true;
+}
+
+bool BaseXMLParser::
+endElement()
+{
+    flush();
+    if (halted()) {
+        return false;
+    }
+
+    size_t start = _offset + 2;
+    size_t end = start;
+    while (end < _size && !IsNameEnd(_input[end])) {
+        end++;
+    }
+
+    if (_elements.empty()) {
+        error("unexpected end element");
+        return false;
+    }
+
+    std::pair<size_t, size_t> element = _elements.back();
+    if (end - start != element.second || ::memcmp(_input + start, _input + element.first, element.second) != 0) {
+        error("mismatched end element '%s' for '%s'", std::string(_input + start, end - start).c_str(), std::string(_input + element.first, element.second).c_str());
+        return false;
+    }
+
+    while (end < _size && IsSpace(_input[end])) {
+        end++;
+    }
+    if (end >= _size || _input[end] != '>') {
+        error("invalid end element");
+        return false;
+    }
+    _offset = end + 1;
+
+    _elements.pop_back();
+    _depth = _elements.size();
+    _name.assign(_input + start, element.second);
+    onEndElement(_name, _depth);
+
+    return true;
+}
+
+/*
+ * Read text up to the next markup, with references replaced.
+ */
+bool BaseXMLParser::
+characters()
+{
+    while (_offset < _size) {
+        size_t start = _offset;
+        while (_offset < _size && _input[_offset] != '<' && _input[_offset] != '&') {
+            _offset++;
+        }
+        AppendText(&_text, _input + start, _offset - start);
+
+        if (_offset < _size && _input[_offset] == '&') {
+            if (!reference(&_text)) {
+                return false;
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Replace a character or predefined entity reference.
+ */
+bool BaseXMLParser::
+reference(std::string *out)
+{
+    size_t end = _offset + 1;
+    while (end < _size && end - _offset < 16 && _input[end] != ';') {
+        end++;
+    }
+    if (end >= _size || _input[end] != ';') {
+        error("invalid reference");
+        return false;
+    }
+
+    std::string name = std::string(_input + _offset + 1, end - _offset - 1);
+    if (name == "amp") {
+        out->push_back('&');
+    } else if (name == "lt") {
+        out->push_back('<');
+    } else if (name == "gt") {
+        out->push_back('>');
+    } else if (name == "quot") {
+        out->push_back('"');
+    } else if (name == "apos") {
+        out->push_back('\'');
+    } else if (name.size() > 1 && name[0] == '#') {
+        bool hex = (name[1] == 'x');
+        char const *digits = name.c_str() + (hex ? 2 : 1);
+        char *last = nullptr;
+        unsigned long c = ::strtoul(digits, &last, hex ? 16 : 10);
+        if (*digits == '\0' || *last != '\0' || c == 0 || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) {
+            error("invalid character reference '%s'", name.c_str());
+            return false;
+        }
+        AppendUTF8(out, c);
+    } else {
+        error("undefined entity '%s'", name.c_str());
+        return false;
+    }
+
+    _offset = end + 1;
+    return true;
+}
+
+/*
+ * Read a quoted attribute value. Whitespace characters become spaces.
+ */
+bool BaseXMLParser::
+attributeValue(std::string *out)
+{
+    char quote = (_offset < _size ? _input[_offset] : '\0');
+    if (quote != '"' && quote != '\'') {
+        error("invalid attribute value");
+        return false;
+    }
+
+    for (_offset++; _offset < _size; _offset++) {
+        char c = _input[_offset];
+        if (c == quote) {
+            _offset++;
+            return true;
+        } else if (c == '<') {
+            error("unexpected '<' in attribute value");
+            return false;
+        } else if (c == '&') {
+            if (!reference(out)) {
+                return false;
+            }
+            _offset--;
+        } else if (c == '\r' && _offset + 1 < _size && _input[_offset + 1] == '\n') {
+            continue;
+        } else {
+            out->push_back(IsSpace(c) ? ' ' : c);
+        }
+    }
+
+    error("unterminated attribute value");
+    return false;
+}
+
 void BaseXMLParser::
 onBeginParse()
 {
@@ -137,9 +661,24 @@ error(std::string format, ...)
     }
     va_end(ap);
 
-    _line = ::xmlTextReaderGetParserLineNumber(_parser);
-    _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    if (_parser != nullptr) {
+        _line = ::xmlTextReaderGetParserLineNumber(_parser);
+        _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    } else {
+        /* Reading directly, count lines up to the current position. */
+        char const *end = _input + std::min(_offset, _size);
+        char const *line = _input;
+        _line = 1;
+        for (char const *p = _input; p < end; p++) {
+            if (*p == '\n') {
+                _line++;
+                line = p + 1;
+            }
+        }
+        _column = (end - line) + 1;
+    }
     _error = std::string(buf);
+    _failed = true;
 
     if (buf != sErrorMessage) {
         ::free(buf);
@@ -148,3 +687,12 @@ error(std::string format, ...)
     ::xmlFreeTextReader(_parser);
     _parser = nullptr;
 }
+
+void BaseXMLParser::
+stop()
+{
+    _stopped = true;
+
+    ::xmlFreeTextReader(_parser);
+    _parser = nullptr;
+}
@@ -0,0 +1,313 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/BinaryDocument.h>
+#include <plist/Format/BinaryReader.h>
+#include <plist/Objects.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using plist::Format::BinaryDocument;
+using plist::Format::BinaryReader;
+using plist::Format::Builder;
+using plist::Format::Handler;
+using plist::ObjectType;
+using plist::Object;
+
+BinaryDocument::Value::
+Value() :
+    _document (nullptr),
+    _reference(0)
+{
+}
+
+BinaryDocument::Value::
+Value(BinaryDocument const *document, uint64_t reference) :
+    _document (document),
+    _reference(reference)
+{
+}
+
+/*
+ * The value for a reference, if it refers to an object that can be read.
+ */
+static BinaryDocument::Value
+Resolve(BinaryDocument const *document, BinaryReader *reader, uint64_t reference)
+{
+    BinaryReader::Record record;
+    if (!reader->record(reference, &record)) {
+        return BinaryDocument::Value();
+    }
+
+    return BinaryDocument::Value(document, reference);
+}
+
+ObjectType BinaryDocument::Value::
+type() const
+{
+    BinaryReader::Record record;
+    if (_document == nullptr || !_document->_reader->record(_reference, &record)) {
+        return ObjectType::None;
+    }
+
+    switch (record.type) {
+        case kABPRecordTypeNull:
+            return ObjectType::Null;
+        case kABPRecordTypeBoolTrue:
+        case kABPRecordTypeBoolFalse:
+            return ObjectType::Boolean;
+        case kABPRecordTypeInteger:
+            return ObjectType::Integer;
+        case kABPRecordTypeReal:
+            return ObjectType::Real;
+        case kABPRecordTypeDate:
+            return ObjectType::Date;
+        case kABPRecordTypeData:
+            return ObjectType::Data;
+        case kABPRecordTypeStringASCII:
+        case kABPRecordTypeStringUnicode:
+            return ObjectType::String;
+        case kABPRecordTypeUid:
+            return ObjectType::UID;
+        case kABPRecordTypeArray:
+            return ObjectType::Array;
+        case kABPRecordTypeDictionary:
+            return ObjectType::Dictionary;
+        default:
+            return ObjectType::None;
+    }
+}
+
+size_t BinaryDocument::Value::
+count() const
+{
+    BinaryReader::Record record;
+    if (_document == nullptr || !_document->_reader->record(_reference, &record)) {
+        return 0;
+    }
+
+    if (record.type != kABPRecordTypeArray && record.type != kABPRecordTypeDictionary) {
+        return 0;
+    }
+
+    return record.length;
+}
+
+BinaryDocument::Value BinaryDocument::Value::
+value(size_t index) const
+{
+    BinaryReader::Record record;
+    if (_document == nullptr || !_document->_reader->record(_reference, &record)) {
+        return Value();
+    }
+
+    if (record.type != kABPRecordTypeArray || index >= record.length) {
+        return Value();
+    }
+
+    BinaryReader *reader = _document->_reader.get();
+    return Resolve(_document, reader, reader->reference(record, index));
+}
+
+BinaryDocument::Value BinaryDocument::Value::
+value(std::string const &key) const
+{
+    BinaryReader::Record record;
+    if (_document == nullptr || !_document->_reader->record(_reference, &record)) {
+        return Value();
+    }
+
+    if (record.type != kABPRecordTypeDictionary) {
+        return Value();
+    }
+
+    /* Keys aren't sorted, but ASCII keys can be compared without copying. */
+    BinaryReader *reader = _document->_reader.get();
+    std::string buffer;
+    for (uint64_t n = 0; n < record.length; n++) {
+        char const *data;
+        size_t      size;
+        if (!reader->string(reader->reference(record, n), &data, &size, &buffer)) {
+            return Value();
+        }
+
+        if (size == key.size() && ::memcmp(data, key.data(), size) == 0) {
+            return Resolve(_document, reader, reader->reference(record, record.length + n));
+        }
+    }
+
+    return Value();
+}
+
+std::string BinaryDocument::Value::
+key(size_t index) const
+{
+    BinaryReader::Record record;
+    if (_document == nullptr || !_document->_reader->record(_reference, &record)) {
+        return std::string();
+    }
+
+    if (record.type != kABPRecordTypeDictionary || index >= record.length) {
+        return std::string();
+    }
+
+    BinaryReader *reader = _document->_reader.get();
+    char const *data;
+    size_t      size;
+    std::string buffer;
+    if (!reader->string(reader->reference(record, index), &data, &size, &buffer)) {
+        return std::string();
+    }
+
+    return std::string(data, size);
+}
+
+BinaryDocument::Value BinaryDocument::Value::
+find(std::vector<std::string> const &path) const
+{
+    Value value = *this;
+
+    for (std::string const &component : path) {
+        switch (value.type()) {
+            case ObjectType::Dictionary:
+                value = value.value(component);
+                break;
+            case ObjectType::Array: {
+                char *end = NULL;
+                unsigned long long index = ::strtoull(component.c_str(), &end, 0);
+                if (component.empty() || *end != '\0') {
+                    return Value();
+                }
+
+                value = value.value(static_cast<size_t>(index));
+                break;
+            }
+            default:
+                return Value();
+        }
+    }
+
+    return value;
+}
+
+std::unique_ptr<Object> BinaryDocument::Value::
+object() const
+{
+    Builder builder;
+    return builder.finish(read(&builder)).first;
+}
+
+std::pair<bool, std::string> BinaryDocument::Value::
+read(Handler *handler) const
+{
+    if (_document == nullptr) {
+        return std::make_pair(false, "invalid value");
+    }
+
+    BinaryReader *reader = _document->_reader.get();
+    if (!reader->read(_reference, handler) && !reader->stopped()) {
+        return std::make_pair(false, reader->error());
+    }
+
+    return std::make_pair(true, std::string());
+}
+
+BinaryDocument::
+BinaryDocument() :
+    _mapping    (nullptr),
+    _mappingSize(0)
+{
+}
+
+BinaryDocument::
+~BinaryDocument()
+{
+    if (_mapping != nullptr) {
+        ::munmap(_mapping, _mappingSize);
+    }
+}
+
+BinaryDocument::Value BinaryDocument::
+root() const
+{
+    return Resolve(this, _reader.get(), _reader->top());
+}
+
+std::string const &BinaryDocument::
+error() const
+{
+    return _reader->error();
+}
+
+std::pair<std::unique_ptr<BinaryDocument>, std::string> BinaryDocument::
+Load(std::unique_ptr<BinaryDocument> document, uint8_t const *data, size_t size)
+{
+    /* Objects can outlive the document, so strings are copied. */
+    document->_reader = std::unique_ptr<BinaryReader>(new BinaryReader(data, size, false));
+    if (!document->_reader->open()) {
+        return std::make_pair(nullptr, document->_reader->error());
+    }
+
+    return std::make_pair(std::move(document), std::string());
+}
+
+std::pair<std::unique_ptr<BinaryDocument>, std::string> BinaryDocument::
+Open(std::string const &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::make_pair(nullptr, std::string("unable to open file: ") + ::strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int error = errno;
+        ::close(fd);
+        return std::make_pair(nullptr, std::string("unable to read file: ") + ::strerror(error));
+    }
+
+    /* Empty files can't be mapped, but aren't property lists either. */
+    if (st.st_size == 0) {
+        ::close(fd);
+        return std::make_pair(nullptr, "not a binary property list or corrupted header");
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void *mapping = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::make_pair(nullptr, std::string("unable to map file: ") + ::strerror(errno));
+    }
+
+    /* Objects are found through the offset table, not in order. */
+    ::madvise(mapping, size, MADV_RANDOM);
+
+    std::unique_ptr<BinaryDocument> document = std::unique_ptr<BinaryDocument>(new BinaryDocument());
+    document->_mapping     = mapping;
+    document->_mappingSize = size;
+    return Load(std::move(document), static_cast<uint8_t const *>(mapping), size);
+}
+
+std::pair<std::unique_ptr<BinaryDocument>, std::string> BinaryDocument::
+Create(std::vector<uint8_t> contents)
+{
+    std::unique_ptr<BinaryDocument> document = std::unique_ptr<BinaryDocument>(new BinaryDocument());
+    document->_contents = std::move(contents);
+
+    uint8_t const *data = document->_contents.data();
+    size_t         size = document->_contents.size();
+    return Load(std::move(document), data, size);
+}
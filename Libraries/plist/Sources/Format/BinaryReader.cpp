@@ -0,0 +1,365 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/BinaryReader.h>
+#include <plist/Format/ABPCoderPrivate.h>
+#include <plist/Format/Encoding.h>
+#include <plist/Objects.h>
+
+#include <cstring>
+
+using plist::Format::BinaryReader;
+using plist::Format::Handler;
+using plist::Format::Encoding;
+using plist::Format::Encodings;
+using plist::Object;
+using plist::String;
+using plist::Integer;
+using plist::Real;
+using plist::Boolean;
+using plist::Null;
+using plist::Data;
+using plist::Date;
+using plist::UID;
+
+/* The trailer is the last 32 bytes: sizes, then counts and offsets. */
+static size_t const TrailerSize = 32;
+
+static inline uint64_t
+ReadWord(uint8_t const *p, size_t nbytes)
+{
+    uint64_t value = 0;
+    for (size_t n = 0; n < nbytes; n++) {
+        value = (value << 8) | p[n];
+    }
+    return value;
+}
+
+BinaryReader::
+BinaryReader(uint8_t const *data, size_t size, bool borrow) :
+    _data         (data),
+    _size         (size),
+    _borrow       (borrow),
+    _offsetSize   (0),
+    _referenceSize(0),
+    _count        (0),
+    _top          (0),
+    _table        (0),
+    _stopped      (false)
+{
+}
+
+bool BinaryReader::
+open()
+{
+    size_t header = ABPLIST_MAGIC_LENGTH + strlen(ABPLIST_VERSION);
+    if (_size < header + TrailerSize || ::memcmp(_data, ABPLIST_MAGIC ABPLIST_VERSION, header) != 0) {
+        _error = "not a binary property list or corrupted header";
+        return false;
+    }
+
+    uint8_t const *trailer = _data + _size - TrailerSize;
+    _offsetSize    = trailer[6];
+    _referenceSize = trailer[7];
+    _count         = ReadWord(trailer + 8, 8);
+    _top           = ReadWord(trailer + 16, 8);
+
+    if (_offsetSize < 1 || _offsetSize > 8 || _referenceSize < 1 || _referenceSize > 8 || _top >= _count) {
+        _error = "corrupted trailer";
+        return false;
+    }
+
+    /* The offset table is just before the trailer. */
+    if (_count > (_size - header - TrailerSize) / _offsetSize) {
+        _error = "corrupted offsets table";
+        return false;
+    }
+    _table = _size - TrailerSize - _count * _offsetSize;
+
+    return true;
+}
+
+bool BinaryReader::
+record(uint64_t reference, Record *record)
+{
+    if (reference >= _count) {
+        _error = "reference out of range";
+        return false;
+    }
+
+    uint64_t offset = ReadWord(_data + _table + reference * _offsetSize, _offsetSize);
+    if (offset >= _size) {
+        _error = "object reference's offset out of range";
+        return false;
+    }
+
+    /* Skip any fill bytes. */
+    size_t p = offset;
+    while (p < _size && _data[p] == 0x0f) {
+        p++;
+    }
+    if (p == _size) {
+        _error = "failed to create object";
+        return false;
+    }
+
+    uint8_t  marker = _data[p++];
+    uint64_t length = (marker & 0x0f);
+    uint64_t unit   = 1;
+
+    record->type = __ABPByteToRecordType(marker);
+    switch (record->type) {
+        case kABPRecordTypeNull:
+        case kABPRecordTypeBoolTrue:
+        case kABPRecordTypeBoolFalse:
+            length = 0;
+            break;
+        case kABPRecordTypeDate:
+            length = 8;
+            break;
+        case kABPRecordTypeInteger:
+        case kABPRecordTypeReal:
+            length = (1 << length);
+            if (length > 8) {
+                _error = "unsupported number size";
+                return false;
+            }
+            break;
+        case kABPRecordTypeUid:
+            length = length + 1;
+            if (length > 4) {
+                _error = "too many bytes in UID";
+                return false;
+            }
+            break;
+        case kABPRecordTypeData:
+        case kABPRecordTypeStringASCII:
+        case kABPRecordTypeStringUnicode:
+        case kABPRecordTypeArray:
+        case kABPRecordTypeDictionary:
+            /* Long lengths follow the marker as an integer. */
+            if (length == 0x0f) {
+                uint8_t size = (p < _size ? _data[p++] : 0);
+                size_t nbytes = (1 << (size & 0x0f));
+                if ((size & 0xf0) != 0x10 || nbytes > 8 || nbytes > _size - p) {
+                    _error = "corrupted object length";
+                    return false;
+                }
+
+                length = ReadWord(_data + p, nbytes);
+                p += nbytes;
+            }
+
+            if (record->type == kABPRecordTypeStringUnicode) {
+                unit = sizeof(uint16_t);
+            } else if (record->type == kABPRecordTypeArray) {
+                unit = _referenceSize;
+            } else if (record->type == kABPRecordTypeDictionary) {
+                unit = _referenceSize * 2;
+            }
+            break;
+        default: {
+            char message[64];
+            snprintf(message, sizeof(message), "unsupported type id %x", marker);
+            _error = message;
+            return false;
+        }
+    }
+
+    if (length > (_size - p) / unit) {
+        _error = "object extends past the end";
+        return false;
+    }
+
+    record->length = length;
+    record->offset = p;
+    return true;
+}
+
+uint64_t BinaryReader::
+reference(Record const &record, uint64_t index) const
+{
+    return ReadWord(_data + record.offset + index * _referenceSize, _referenceSize);
+}
+
+std::unique_ptr<Object> BinaryReader::
+scalar(Record const &record)
+{
+    /* Reference time is 2001/1/1 */
+    static int64_t const ReferenceTimestamp = 978307200;
+
+    uint8_t const *p = _data + record.offset;
+
+    switch (record.type) {
+        case kABPRecordTypeNull:
+            return Null::New();
+        case kABPRecordTypeBoolTrue:
+            return Boolean::New(true);
+        case kABPRecordTypeBoolFalse:
+            return Boolean::New(false);
+        case kABPRecordTypeDate: {
+            /* Seconds since the reference time, as a double. */
+            uint64_t bits = ReadWord(p, 8);
+            double seconds;
+            ::memcpy(&seconds, &bits, sizeof(seconds));
+            if (!(seconds > -9.0e18 && seconds < 9.0e18)) {
+                seconds = 0.0;
+            }
+
+            return Date::New(static_cast<uint64_t>(static_cast<int64_t>(seconds) + ReferenceTimestamp));
+        }
+        case kABPRecordTypeInteger:
+            return Integer::New(static_cast<int64_t>(ReadWord(p, record.length)));
+        case kABPRecordTypeReal: {
+            uint64_t bits = ReadWord(p, record.length);
+            if (record.length == 4) {
+                uint32_t bits32 = static_cast<uint32_t>(bits);
+                float real;
+                ::memcpy(&real, &bits32, sizeof(real));
+                return Real::New(real);
+            } else if (record.length == 8) {
+                double real;
+                ::memcpy(&real, &bits, sizeof(real));
+                return Real::New(real);
+            } else {
+                return Real::New(0.0);
+            }
+        }
+        case kABPRecordTypeData:
+            return Data::New(p, record.length);
+        case kABPRecordTypeStringASCII:
+            if (_borrow) {
+                return String::Borrow(reinterpret_cast<char const *>(p), record.length);
+            }
+            return String::New(std::string(reinterpret_cast<char const *>(p), record.length));
+        case kABPRecordTypeStringUnicode: {
+            std::vector<uint8_t> buffer = std::vector<uint8_t>(p, p + record.length * sizeof(uint16_t));
+            buffer = Encodings::Convert(buffer, Encoding::UTF16BE, Encoding::UTF8);
+            return String::New(std::string(buffer.begin(), buffer.end()));
+        }
+        case kABPRecordTypeUid:
+            return UID::New(static_cast<uint32_t>(ReadWord(p, record.length)));
+        default:
+            _error = "failed to create object";
+            return nullptr;
+    }
+}
+
+bool BinaryReader::
+emit(bool result)
+{
+    if (!result) {
+        _stopped = true;
+    }
+
+    return result;
+}
+
+bool BinaryReader::
+string(uint64_t reference, char const **data, size_t *size, std::string *buffer)
+{
+    Record record;
+    if (!this->record(reference, &record)) {
+        return false;
+    }
+
+    if (record.type == kABPRecordTypeStringASCII) {
+        *data = reinterpret_cast<char const *>(_data + record.offset);
+        *size = record.length;
+        return true;
+    } else if (record.type == kABPRecordTypeStringUnicode) {
+        std::vector<uint8_t> converted = std::vector<uint8_t>(_data + record.offset, _data + record.offset + record.length * sizeof(uint16_t));
+        converted = Encodings::Convert(converted, Encoding::UTF16BE, Encoding::UTF8);
+        buffer->assign(converted.begin(), converted.end());
+        *data = buffer->data();
+        *size = buffer->size();
+        return true;
+    }
+
+    _error = "dictionary key is not a string";
+    return false;
+}
+
+bool BinaryReader::
+read(uint64_t reference, Handler *handler)
+{
+    _visiting.clear();
+    _stopped = false;
+    _error.clear();
+
+    return readObject(reference, handler);
+}
+
+bool BinaryReader::
+readObject(uint64_t reference, Handler *handler)
+{
+    Record record;
+    if (!this->record(reference, &record)) {
+        return false;
+    }
+
+    if (record.type != kABPRecordTypeArray && record.type != kABPRecordTypeDictionary) {
+        std::unique_ptr<Object> object = scalar(record);
+        if (object == nullptr) {
+            return false;
+        }
+
+        return emit(handler->scalar(std::move(object)));
+    }
+
+    /* A container can't contain itself. */
+    if (!_visiting.insert(reference).second) {
+        _error = "object contains itself";
+        return false;
+    }
+
+    if (record.type == kABPRecordTypeArray) {
+        if (!emit(handler->beginArray())) {
+            return false;
+        }
+
+        for (uint64_t n = 0; n < record.length; n++) {
+            if (!readObject(this->reference(record, n), handler)) {
+                return false;
+            }
+        }
+
+        if (!emit(handler->endArray())) {
+            return false;
+        }
+    } else {
+        if (!emit(handler->beginDictionary())) {
+            return false;
+        }
+
+        for (uint64_t n = 0; n < record.length; n++) {
+            char const *key;
+            size_t      size;
+            std::string buffer;
+            if (!string(this->reference(record, n), &key, &size, &buffer)) {
+                return false;
+            }
+
+            /* ASCII keys are passed directly from the input. */
+            if (!emit(handler->key(key, size))) {
+                return false;
+            }
+            if (!readObject(this->reference(record, record.length + n), handler)) {
+                return false;
+            }
+        }
+
+        if (!emit(handler->endDictionary())) {
+            return false;
+        }
+    }
+
+    _visiting.erase(reference);
+    return true;
+}
@@ -0,0 +1,486 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/BinaryWriter.h>
+#include <plist/Format/ABPCoderPrivate.h>
+#include <plist/Format/Encoding.h>
+#include <plist/Format/OutputBuffer.h>
+#include <plist/Objects.h>
+
+#include <cstring>
+
+using plist::Format::BinaryWriter;
+using plist::Format::BufferSink;
+using plist::Format::OutputBuffer;
+using plist::Format::Sink;
+using plist::Format::Encoding;
+using plist::Format::Encodings;
+using plist::Object;
+using plist::String;
+using plist::Integer;
+using plist::Real;
+using plist::Boolean;
+using plist::Null;
+using plist::Data;
+using plist::Date;
+using plist::UID;
+using plist::Array;
+using plist::Dictionary;
+
+/* The trailer is the last 32 bytes: sizes, then counts and offsets. */
+static size_t const TrailerSize = 32;
+
+/* Reference time is 2001/1/1 */
+static int64_t const ReferenceTimestamp = 978307200;
+
+/*
+ * The smallest number of bytes that holds a value.
+ */
+static inline size_t
+WordSize(uint64_t value)
+{
+    if (value > UINT32_MAX) {
+        return sizeof(uint64_t);
+    } else if (value > UINT16_MAX) {
+        return sizeof(uint32_t);
+    } else if (value > UINT8_MAX) {
+        return sizeof(uint16_t);
+    } else {
+        return sizeof(uint8_t);
+    }
+}
+
+/*
+ * Integers and lengths are stored in 1, 2, 4 or 8 bytes; this is the
+ * power of two used in their marker.
+ */
+static inline uint64_t
+WordBits(uint64_t value)
+{
+    switch (WordSize(value)) {
+        case sizeof(uint8_t):  return 0;
+        case sizeof(uint16_t): return 1;
+        case sizeof(uint32_t): return 2;
+        default:               return 3;
+    }
+}
+
+static inline uint8_t *
+WriteWord(uint8_t *p, size_t nbytes, uint64_t value)
+{
+    for (size_t n = nbytes; n > 0; n--) {
+        *p++ = static_cast<uint8_t>(value >> ((n - 1) * 8));
+    }
+    return p;
+}
+
+/*
+ * Size of a marker and, if it doesn't fit in the marker, the length.
+ */
+static inline size_t
+LengthSize(uint64_t length)
+{
+    if (length < 0x0f) {
+        return 1;
+    }
+
+    return 1 + 1 + (1 << WordBits(length));
+}
+
+static inline uint8_t *
+WriteTypeAndLength(uint8_t *p, ABPRecordType type, uint64_t length)
+{
+    *p++ = __ABPRecordTypeToByte(type, length < 0x0f ? length : 0x0f);
+    if (length >= 0x0f) {
+        uint64_t bits = WordBits(length);
+        *p++ = 0x10 | bits;
+        p = WriteWord(p, 1 << bits, length);
+    }
+    return p;
+}
+
+static inline bool
+IsData(ABPRecordType type)
+{
+    return (type == kABPRecordTypeData || type == kABPRecordTypeStringASCII || type == kABPRecordTypeStringUnicode);
+}
+
+/*
+ * The size of an object, not counting any references it contains.
+ */
+static size_t
+EntrySize(ABPRecordType type, uint64_t length)
+{
+    switch (type) {
+        case kABPRecordTypeNull:
+        case kABPRecordTypeBoolTrue:
+        case kABPRecordTypeBoolFalse:
+            return 1;
+        case kABPRecordTypeDate:
+            return 1 + sizeof(double);
+        case kABPRecordTypeInteger:
+        case kABPRecordTypeReal:
+            return 1 + (1 << length);
+        case kABPRecordTypeUid:
+            return 1 + length;
+        case kABPRecordTypeData:
+        case kABPRecordTypeStringASCII:
+            return LengthSize(length) + length;
+        case kABPRecordTypeStringUnicode:
+            return LengthSize(length) + length * sizeof(uint16_t);
+        case kABPRecordTypeArray:
+        case kABPRecordTypeDictionary:
+            return LengthSize(length);
+        default:
+            abort();
+    }
+}
+
+/*
+ * FNV-1a, over the type and either the contents or the value.
+ */
+static uint64_t
+Hash(ABPRecordType type, uint64_t value, char const *data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = (hash ^ static_cast<uint8_t>(type)) * 0x100000001b3ULL;
+    if (IsData(type)) {
+        for (size_t n = 0; n < size; n++) {
+            hash = (hash ^ static_cast<uint8_t>(data[n])) * 0x100000001b3ULL;
+        }
+    } else {
+        for (size_t n = 0; n < sizeof(value); n++) {
+            hash = (hash ^ static_cast<uint8_t>(value >> (n * 8))) * 0x100000001b3ULL;
+        }
+    }
+
+    return hash;
+}
+
+BinaryWriter::
+BinaryWriter() :
+    _size  (0),
+    _table (64, 0),
+    _unique(0)
+{
+}
+
+uint64_t BinaryWriter::
+push(Entry const &entry)
+{
+    _size += EntrySize(entry.type, entry.length);
+    _objects.push_back(entry);
+    return _objects.size() - 1;
+}
+
+void BinaryWriter::
+grow()
+{
+    std::vector<uint64_t> table = std::vector<uint64_t>(_table.size() * 2, 0);
+    size_t mask = table.size() - 1;
+
+    for (uint64_t slot : _table) {
+        if (slot != 0) {
+            size_t n = _objects[slot - 1].hash & mask;
+            while (table[n] != 0) {
+                n = (n + 1) & mask;
+            }
+            table[n] = slot;
+        }
+    }
+
+    _table = std::move(table);
+}
+
+/*
+ * Find an equal object already added, or add this one. The table holds
+ * references plus one, so zero is an empty slot.
+ */
+uint64_t BinaryWriter::
+scalar(Entry entry)
+{
+    entry.hash = Hash(entry.type, entry.value, entry.data, entry.size);
+
+    size_t mask = _table.size() - 1;
+    size_t slot = entry.hash & mask;
+    while (_table[slot] != 0) {
+        Entry const &other = _objects[_table[slot] - 1];
+        if (other.hash == entry.hash && other.type == entry.type) {
+            if (IsData(entry.type)) {
+                if (other.size == entry.size && ::memcmp(other.data, entry.data, entry.size) == 0) {
+                    return _table[slot] - 1;
+                }
+            } else if (other.length == entry.length && other.value == entry.value) {
+                return _table[slot] - 1;
+            }
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    /* Unicode strings are only converted once they're known to be new. */
+    if (entry.type == kABPRecordTypeStringUnicode) {
+        std::vector<uint8_t> buffer = std::vector<uint8_t>(entry.data, entry.data + entry.size);
+        _unicode.push_back(Encodings::Convert(buffer, Encoding::UTF8, Encoding::UTF16BE));
+        entry.length = _unicode.back().size() / sizeof(uint16_t);
+        entry.value  = _unicode.size() - 1;
+    }
+
+    uint64_t reference = push(entry);
+    _table[slot] = reference + 1;
+
+    /* Keep the table at most half full. */
+    if (++_unique * 2 > _table.size()) {
+        grow();
+    }
+
+    return reference;
+}
+
+uint64_t BinaryWriter::
+string(char const *data, size_t size)
+{
+    bool ascii = true;
+    for (size_t n = 0; n < size; n++) {
+        if (static_cast<uint8_t>(data[n]) >= 0x80) {
+            ascii = false;
+            break;
+        }
+    }
+
+    Entry entry;
+    entry.type   = (ascii ? kABPRecordTypeStringASCII : kABPRecordTypeStringUnicode);
+    entry.length = size;
+    entry.value  = 0;
+    entry.data   = data;
+    entry.size   = size;
+    return scalar(entry);
+}
+
+bool BinaryWriter::
+add(Object const *object, uint64_t *reference)
+{
+    Entry entry;
+    entry.length = 0;
+    entry.value  = 0;
+    entry.data   = nullptr;
+    entry.size   = 0;
+    entry.hash   = 0;
+
+    if (Array const *array = CastTo<Array>(object)) {
+        /* The array comes before its elements. */
+        size_t start = _references.size();
+        entry.type   = kABPRecordTypeArray;
+        entry.length = array->count();
+        entry.value  = start;
+        *reference = push(entry);
+
+        _references.resize(start + array->count());
+        for (size_t n = 0; n < array->count(); n++) {
+            uint64_t value;
+            if (!add(array->value(n), &value)) {
+                return false;
+            }
+            _references[start + n] = value;
+        }
+    } else if (Dictionary const *dict = CastTo<Dictionary>(object)) {
+        /* The dictionary comes first, then all of its keys, then the values. */
+        size_t start = _references.size();
+        entry.type   = kABPRecordTypeDictionary;
+        entry.length = dict->count();
+        entry.value  = start;
+        *reference = push(entry);
+
+        _references.resize(start + dict->count() * 2);
+        for (size_t n = 0; n < dict->count(); n++) {
+            std::string const &key = dict->key(n);
+            _references[start + n] = string(key.data(), key.size());
+        }
+        for (size_t n = 0; n < dict->count(); n++) {
+            uint64_t value;
+            if (!add(dict->value(n), &value)) {
+                return false;
+            }
+            _references[start + dict->count() + n] = value;
+        }
+    } else if (String const *string = CastTo<String>(object)) {
+        *reference = this->string(string->data(), string->size());
+    } else if (Integer const *integer = CastTo<Integer>(object)) {
+        /* Negative integers are always eight bytes. */
+        uint64_t value = static_cast<uint64_t>(integer->value());
+        entry.type   = kABPRecordTypeInteger;
+        entry.length = WordBits(value);
+        entry.value  = value;
+        *reference = scalar(entry);
+    } else if (Real const *real = CastTo<Real>(object)) {
+        /* Use single precision when it's exact. */
+        double value   = real->value();
+        float  value32 = static_cast<float>(value);
+        entry.type = kABPRecordTypeReal;
+        if (static_cast<double>(value32) == value) {
+            uint32_t bits;
+            ::memcpy(&bits, &value32, sizeof(bits));
+            entry.length = 2;
+            entry.value  = bits;
+        } else {
+            ::memcpy(&entry.value, &value, sizeof(entry.value));
+            entry.length = 3;
+        }
+        *reference = scalar(entry);
+    } else if (Boolean const *boolean = CastTo<Boolean>(object)) {
+        entry.type = (boolean->value() ? kABPRecordTypeBoolTrue : kABPRecordTypeBoolFalse);
+        *reference = scalar(entry);
+    } else if (CastTo<Null>(object) != nullptr) {
+        entry.type = kABPRecordTypeNull;
+        *reference = scalar(entry);
+    } else if (Data const *data = CastTo<Data>(object)) {
+        entry.type   = kABPRecordTypeData;
+        entry.length = data->value().size();
+        entry.data   = reinterpret_cast<char const *>(data->value().data());
+        entry.size   = data->value().size();
+        *reference = scalar(entry);
+    } else if (Date const *date = CastTo<Date>(object)) {
+        double seconds = static_cast<double>(static_cast<int64_t>(date->unixTimeValue()) - ReferenceTimestamp);
+        entry.type = kABPRecordTypeDate;
+        ::memcpy(&entry.value, &seconds, sizeof(entry.value));
+        *reference = scalar(entry);
+    } else if (UID const *uid = CastTo<UID>(object)) {
+        uint32_t value = uid->value();
+        entry.type   = kABPRecordTypeUid;
+        entry.length = WordSize(value);
+        entry.value  = value;
+        *reference = scalar(entry);
+    } else {
+        _error = "unsupported object type";
+        return false;
+    }
+
+    return true;
+}
+
+bool BinaryWriter::
+write(Object const *object, Sink *sink)
+{
+    uint64_t top;
+    if (object == nullptr) {
+        _error = "no object to write";
+        return false;
+    }
+    if (!add(object, &top)) {
+        return false;
+    }
+
+    /* Everything's size is known now, so lay out the whole file. */
+    size_t header        = ABPLIST_MAGIC_LENGTH + strlen(ABPLIST_VERSION);
+    size_t referenceSize = WordSize(_objects.size());
+    size_t table         = header + _size + _references.size() * referenceSize;
+    size_t offsetSize    = WordSize(table);
+    sink->reserve(table + _objects.size() * offsetSize + TrailerSize);
+
+    OutputBuffer output = OutputBuffer(sink);
+    output.append(ABPLIST_MAGIC ABPLIST_VERSION, header);
+
+    /* Markers and numbers are built here, contents are passed through. */
+    uint8_t scratch[16];
+    for (Entry const &entry : _objects) {
+        uint8_t *p = scratch;
+
+        switch (entry.type) {
+            case kABPRecordTypeNull:
+            case kABPRecordTypeBoolTrue:
+            case kABPRecordTypeBoolFalse:
+            case kABPRecordTypeDate:
+                *p++ = __ABPRecordTypeToByte(entry.type, 0);
+                if (entry.type == kABPRecordTypeDate) {
+                    p = WriteWord(p, sizeof(double), entry.value);
+                }
+                output.append(scratch, p - scratch);
+                break;
+            case kABPRecordTypeInteger:
+            case kABPRecordTypeReal:
+                *p++ = __ABPRecordTypeToByte(entry.type, entry.length);
+                p = WriteWord(p, 1 << entry.length, entry.value);
+                output.append(scratch, p - scratch);
+                break;
+            case kABPRecordTypeUid:
+                *p++ = __ABPRecordTypeToByte(entry.type, entry.length);
+                p = WriteWord(p, entry.length, entry.value);
+                output.append(scratch, p - scratch);
+                break;
+            case kABPRecordTypeData:
+            case kABPRecordTypeStringASCII:
+                p = WriteTypeAndLength(p, entry.type, entry.length);
+                output.append(scratch, p - scratch);
+                output.append(entry.data, entry.size);
+                break;
+            case kABPRecordTypeStringUnicode: {
+                std::vector<uint8_t> const &characters = _unicode[entry.value];
+                p = WriteTypeAndLength(p, entry.type, entry.length);
+                output.append(scratch, p - scratch);
+                output.append(characters.data(), characters.size());
+                break;
+            }
+            case kABPRecordTypeArray:
+            case kABPRecordTypeDictionary: {
+                size_t count = (entry.type == kABPRecordTypeDictionary ? entry.length * 2 : entry.length);
+                p = WriteTypeAndLength(p, entry.type, entry.length);
+                output.append(scratch, p - scratch);
+                for (size_t n = 0; n < count; n++) {
+                    p = WriteWord(scratch, referenceSize, _references[entry.value + n]);
+                    output.append(scratch, p - scratch);
+                }
+                break;
+            }
+            default:
+                abort();
+        }
+    }
+
+    /* The offset table, from the same sizes the layout used. */
+    uint64_t offset = header;
+    for (Entry const &entry : _objects) {
+        uint8_t *p = WriteWord(scratch, offsetSize, offset);
+        output.append(scratch, p - scratch);
+
+        offset += EntrySize(entry.type, entry.length);
+        if (entry.type == kABPRecordTypeArray) {
+            offset += entry.length * referenceSize;
+        } else if (entry.type == kABPRecordTypeDictionary) {
+            offset += entry.length * 2 * referenceSize;
+        }
+    }
+
+    /* Trailer: six unused bytes, the sizes, then the counts and offsets. */
+    uint8_t trailer[TrailerSize] = { 0 };
+    trailer[6] = offsetSize;
+    trailer[7] = referenceSize;
+    WriteWord(trailer + 8, 8, _objects.size());
+    WriteWord(trailer + 16, 8, top);
+    WriteWord(trailer + 24, 8, table);
+    output.append(trailer, TrailerSize);
+
+    if (!output.flush()) {
+        _error = "unable to write output";
+        return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<std::vector<uint8_t>> BinaryWriter::
+write(Object const *object)
+{
+    BufferSink sink;
+    if (!write(object, &sink)) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(std::move(sink.contents())));
+}
@@ -0,0 +1,140 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/Handler.h>
+#include <plist/Objects.h>
+
+using plist::Format::Handler;
+using plist::Format::Builder;
+using plist::Object;
+using plist::ObjectType;
+using plist::Array;
+using plist::Dictionary;
+
+Handler::
+~Handler()
+{
+}
+
+Builder::
+Builder()
+{
+}
+
+Builder::
+~Builder()
+{
+}
+
+bool Builder::
+begin(std::unique_ptr<Object> container)
+{
+    if (_root != nullptr) {
+        _error = "Double root.";
+        return false;
+    }
+
+    Level level;
+    level.container = std::move(container);
+    _levels.push_back(std::move(level));
+    return true;
+}
+
+bool Builder::
+end(ObjectType type)
+{
+    if (_levels.empty() || _levels.back().container->type() != type) {
+        _error = "Closing wrong kind of container.";
+        return false;
+    }
+
+    std::unique_ptr<Object> container = std::move(_levels.back().container);
+    _levels.pop_back();
+    return store(std::move(container));
+}
+
+bool Builder::
+store(std::unique_ptr<Object> value)
+{
+    if (_levels.empty()) {
+        if (_root != nullptr) {
+            _error = "Double root.";
+            return false;
+        }
+
+        _root = std::move(value);
+        return true;
+    }
+
+    Level &level = _levels.back();
+    if (Dictionary *dict = CastTo<Dictionary>(level.container.get())) {
+        dict->set(std::move(level.key), std::move(value));
+        level.key.clear();
+    } else {
+        static_cast<Array *>(level.container.get())->append(std::move(value));
+    }
+
+    return true;
+}
+
+bool Builder::
+beginDictionary()
+{
+    return begin(Dictionary::New());
+}
+
+bool Builder::
+endDictionary()
+{
+    return end(Dictionary::Type());
+}
+
+bool Builder::
+beginArray()
+{
+    return begin(Array::New());
+}
+
+bool Builder::
+endArray()
+{
+    return end(Array::Type());
+}
+
+bool Builder::
+key(char const *data, size_t size)
+{
+    if (_levels.empty() || _levels.back().container->type() != Dictionary::Type()) {
+        _error = "Storing key with no dictionary container.";
+        return false;
+    }
+
+    _levels.back().key.assign(data, size);
+    return true;
+}
+
+bool Builder::
+scalar(std::unique_ptr<Object> value)
+{
+    return store(std::move(value));
+}
+
+std::pair<std::unique_ptr<Object>, std::string> Builder::
+finish(std::pair<bool, std::string> const &read)
+{
+    if (!_error.empty()) {
+        return std::make_pair(nullptr, _error);
+    } else if (!read.first) {
+        return std::make_pair(nullptr, read.second);
+    } else if (!_levels.empty()) {
+        return std::make_pair(nullptr, "Unterminated container.");
+    }
+
+    return std::make_pair(std::move(_root), std::string());
+}
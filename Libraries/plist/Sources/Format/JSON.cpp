@@ -11,8 +11,12 @@
 #include <plist/Format/JSONParser.h>
 #include <plist/Format/JSONWriter.h>
 
+using plist::Format::Builder;
 using plist::Format::Encoding;
+using plist::Format::Handler;
 using plist::Format::Format;
+using plist::Format::Sink;
+using plist::Format::BufferSink;
 using plist::Format::JSON;
 using plist::Format::JSONParser;
 using plist::Format::JSONWriter;
@@ -34,25 +38,28 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
-Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
+std::pair<bool, std::string> Format<JSON>::
+Read(std::vector<uint8_t> const &contents, JSON const &format, Handler *handler)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
     /* Create lexer. */
     ASCIIPListLexer lexer;
     ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleJSON);
 
     /* Parse contents. */
-    JSONParser parser;
-    if (parser.parse(&lexer)) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    JSONParser parser = JSONParser(handler);
+    if (!parser.parse(&lexer) && !parser.stopped()) {
+        return std::make_pair(false, parser.error());
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(true, std::string());
+}
+
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
+Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
+{
+    Builder builder;
+    return builder.finish(Read(contents, format, &builder));
 }
 
 template<>
@@ -63,12 +70,29 @@ Serialize(Object const *object, JSON const &format)
         return std::make_pair(nullptr, "object was null");
     }
 
-    JSONWriter writer = JSONWriter(object);
+    BufferSink sink;
+    JSONWriter writer = JSONWriter(object, &sink);
     if (!writer.write()) {
         return std::make_pair(nullptr, "serialization failed");
     }
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(writer.contents())), std::string());
+    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(std::move(sink.contents()))), std::string());
+}
+
+template<>
+std::pair<bool, std::string> Format<JSON>::
+Serialize(Object const *object, JSON const &format, Sink *sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "object was null");
+    }
+
+    JSONWriter writer = JSONWriter(object, sink);
+    if (!writer.write()) {
+        return std::make_pair(false, "serialization failed");
+    }
+
+    return std::make_pair(true, std::string());
 }
 
 } }
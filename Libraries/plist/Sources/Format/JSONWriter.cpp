@@ -26,8 +26,9 @@ using plist::Dictionary;
 using plist::CastTo;
 
 JSONWriter::
-JSONWriter(Object const *root) :
+JSONWriter(Object const *root, Sink *sink) :
     _root   (root),
+    _output (sink),
     _indent (0),
     _lastKey(false)
 {
@@ -45,7 +46,7 @@ write()
         return false;
     }
 
-    return true;
+    return _output.flush();
 }
 
 /*
@@ -55,23 +56,20 @@ write()
 bool JSONWriter::
 primitiveWriteString(std::string const &string)
 {
-    _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return _output.append(string);
 }
 
 bool JSONWriter::
 primitiveWriteEscapedString(std::string const &string)
 {
-    _contents.reserve(_contents.size() + string.size());
-
     if (!primitiveWriteString("\"")) {
         return false;
     }
 
     for (char c : string) {
-        if (c < 0x20) {
+        if (static_cast<unsigned char>(c) < 0x20) {
             char buf[64];
-            int rc = snprintf(buf, sizeof(buf), "\\%04x", c);
+            int rc = snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
             assert(rc < (int)sizeof(buf));
             (void)rc;
 
@@ -81,8 +79,8 @@ primitiveWriteEscapedString(std::string const &string)
         } else {
             switch (c) {
                 case '"':  if (!primitiveWriteString("\\\"")) { return false; } break;
-                case '\\': if (!primitiveWriteString("\\"))   { return false; } break;
-                default: _contents.push_back(c); break;
+                case '\\': if (!primitiveWriteString("\\\\")) { return false; } break;
+                default: _output.append(c); break;
             }
         }
     }
@@ -0,0 +1,54 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/OutputBuffer.h>
+
+#include <cstring>
+
+using plist::Format::OutputBuffer;
+
+size_t const OutputBuffer::Capacity;
+
+OutputBuffer::
+OutputBuffer(Sink *sink) :
+    _sink  (sink),
+    _buffer(Capacity),
+    _used  (0),
+    _failed(false)
+{
+}
+
+bool OutputBuffer::
+flush()
+{
+    if (!_failed && _used != 0) {
+        _failed = !_sink->write(_buffer.data(), _used);
+    }
+
+    _used = 0;
+    return !_failed;
+}
+
+bool OutputBuffer::
+spill(uint8_t const *data, size_t size)
+{
+    if (!flush()) {
+        return false;
+    }
+
+    /* Large writes go straight through. */
+    if (size >= Capacity) {
+        _failed = !_sink->write(data, size);
+        return !_failed;
+    }
+
+    ::memcpy(_buffer.data(), data, size);
+    _used = size;
+    return true;
+}
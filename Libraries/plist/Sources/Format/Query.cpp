@@ -0,0 +1,236 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/Query.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using plist::Format::Query;
+using plist::Format::Builder;
+using plist::Object;
+
+/*
+ * Array indexes are parsed as by `strtoull()`, so they can be in any base.
+ */
+static size_t
+ParseIndex(std::string const &component)
+{
+    char *end = NULL;
+    unsigned long long index = ::strtoull(component.c_str(), &end, 0);
+    if (component.empty() || *end != '\0') {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    return static_cast<size_t>(index);
+}
+
+Query::
+Query(std::vector<std::string> const &path, Duplicates duplicates) :
+    _path      (path),
+    _duplicates(duplicates),
+    _skip      (0),
+    _capture   (0)
+{
+    for (std::string const &component : _path) {
+        _indexes.push_back(ParseIndex(component));
+    }
+}
+
+Query::
+~Query()
+{
+}
+
+/*
+ * Decide what to do with the value starting now: capture it if it is the
+ * value queried, descend into it if it's on the path, or otherwise skip it.
+ */
+Query::Action Query::
+next()
+{
+    bool matched;
+    if (_levels.empty()) {
+        /* The root is always on the path. */
+        matched = true;
+    } else {
+        Level &level = _levels.back();
+        if (level.dictionary) {
+            matched = level.matched;
+            level.matched = false;
+        } else {
+            matched = (level.index++ == _indexes[_levels.size() - 1]);
+        }
+    }
+
+    if (!matched) {
+        return Action::Skip;
+    }
+
+    /* A later duplicate key replaces anything found before it. */
+    _found.reset();
+
+    if (_levels.size() == _path.size()) {
+        return Action::Capture;
+    } else {
+        return Action::Descend;
+    }
+}
+
+/*
+ * Whether a key still to come could replace the value found, or hold the
+ * rest of the path. That's only possible when the last of duplicate keys
+ * is used, and only while a dictionary is left on the path.
+ */
+bool Query::
+pending() const
+{
+    if (_duplicates == Duplicates::First) {
+        return false;
+    }
+
+    for (Level const &level : _levels) {
+        if (level.dictionary) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Query::
+begin(bool dictionary)
+{
+    if (_builder != nullptr) {
+        _capture++;
+        return (dictionary ? _builder->beginDictionary() : _builder->beginArray());
+    } else if (_skip != 0) {
+        _skip++;
+        return true;
+    }
+
+    switch (next()) {
+        case Action::Capture:
+            _builder = std::unique_ptr<Builder>(new Builder());
+            _capture = 1;
+            return (dictionary ? _builder->beginDictionary() : _builder->beginArray());
+        case Action::Descend:
+            _levels.push_back({ dictionary, false, 0 });
+            return true;
+        case Action::Skip:
+            _skip = 1;
+            return true;
+    }
+
+    abort();
+}
+
+bool Query::
+end(bool dictionary)
+{
+    if (_builder != nullptr) {
+        bool result = (dictionary ? _builder->endDictionary() : _builder->endArray());
+
+        _capture--;
+        if (!result || _capture != 0) {
+            return result;
+        }
+
+        /* The value found is complete. */
+        _found = std::move(_builder);
+        return pending();
+    } else if (_skip != 0) {
+        _skip--;
+        return true;
+    }
+
+    /* A container on the path ended. */
+    _levels.pop_back();
+    return pending();
+}
+
+bool Query::
+beginDictionary()
+{
+    return begin(true);
+}
+
+bool Query::
+endDictionary()
+{
+    return end(true);
+}
+
+bool Query::
+beginArray()
+{
+    return begin(false);
+}
+
+bool Query::
+endArray()
+{
+    return end(false);
+}
+
+bool Query::
+key(char const *data, size_t size)
+{
+    if (_builder != nullptr) {
+        return _builder->key(data, size);
+    } else if (_skip != 0) {
+        return true;
+    } else if (_levels.empty()) {
+        return false;
+    }
+
+    std::string const &component = _path[_levels.size() - 1];
+    _levels.back().matched = (size == component.size() && ::memcmp(data, component.data(), size) == 0);
+    return true;
+}
+
+bool Query::
+scalar(std::unique_ptr<Object> value)
+{
+    if (_builder != nullptr) {
+        return _builder->scalar(std::move(value));
+    } else if (_skip != 0) {
+        return true;
+    }
+
+    switch (next()) {
+        case Action::Capture:
+            _found = std::unique_ptr<Builder>(new Builder());
+            _found->scalar(std::move(value));
+            return pending();
+        case Action::Descend:
+            /* The path continues past a value that's not a container. */
+            return pending();
+        case Action::Skip:
+            return true;
+    }
+
+    abort();
+}
+
+std::pair<std::unique_ptr<Object>, std::string> Query::
+finish(std::pair<bool, std::string> const &read)
+{
+    if (!read.first) {
+        return std::make_pair(nullptr, read.second);
+    } else if (_builder != nullptr) {
+        /* Reading stopped while the value was being built. */
+        return _builder->finish(read);
+    } else if (_found == nullptr) {
+        return std::make_pair(nullptr, std::string());
+    }
+
+    return _found->finish(read);
+}
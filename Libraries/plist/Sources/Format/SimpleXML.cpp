@@ -12,6 +12,7 @@
 
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::SimpleXML;
 using plist::Format::SimpleXMLParser;
 using plist::Object;
@@ -94,6 +95,13 @@ Serialize(Object const *object, SimpleXML const &format)
     return std::make_pair(nullptr, "not yet implemented");
 }
 
+template<>
+std::pair<bool, std::string> Format<SimpleXML>::
+Serialize(Object const *object, SimpleXML const &format, Sink *sink)
+{
+    return std::make_pair(false, "not yet implemented");
+}
+
 } }
 
 SimpleXML SimpleXML::
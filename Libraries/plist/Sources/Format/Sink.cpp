@@ -0,0 +1,81 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/Sink.h>
+
+#include <cerrno>
+
+#include <unistd.h>
+
+using plist::Format::Sink;
+using plist::Format::BufferSink;
+using plist::Format::FileSink;
+
+Sink::
+~Sink()
+{
+}
+
+void Sink::
+reserve(size_t size)
+{
+}
+
+BufferSink::
+BufferSink()
+{
+}
+
+BufferSink::
+~BufferSink()
+{
+}
+
+bool BufferSink::
+write(uint8_t const *data, size_t size)
+{
+    _contents.insert(_contents.end(), data, data + size);
+    return true;
+}
+
+void BufferSink::
+reserve(size_t size)
+{
+    _contents.reserve(_contents.size() + size);
+}
+
+FileSink::
+FileSink(int fd) :
+    _fd(fd)
+{
+}
+
+FileSink::
+~FileSink()
+{
+}
+
+bool FileSink::
+write(uint8_t const *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t written = ::write(_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
@@ -12,8 +12,12 @@
 #include <plist/Format/XMLWriter.h>
 
 using plist::Format::Type;
+using plist::Format::Builder;
+using plist::Format::Handler;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
+using plist::Format::BufferSink;
 using plist::Format::XML;
 using plist::Format::XMLParser;
 using plist::Format::XMLWriter;
@@ -82,18 +86,25 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<XML>::
-Deserialize(std::vector<uint8_t> const &contents, XML const &format)
+std::pair<bool, std::string> Format<XML>::
+Read(std::vector<uint8_t> const &contents, XML const &format, Handler *handler)
 {
     std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
 
-    XMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
-    if (root == nullptr) {
-        return std::make_pair(nullptr, parser.error());
+    XMLParser parser(handler);
+    if (!parser.parse(data)) {
+        return std::make_pair(false, parser.error());
     }
 
-    return std::make_pair(std::move(root), std::string());
+    return std::make_pair(true, std::string());
+}
+
+template<>
+std::pair<std::unique_ptr<Object>, std::string> Format<XML>::
+Deserialize(std::vector<uint8_t> const &contents, XML const &format)
+{
+    Builder builder;
+    return builder.finish(Read(contents, format, &builder));
 }
 
 template<>
@@ -104,16 +115,47 @@ Serialize(Object const *object, XML const &format)
         return std::make_pair(nullptr, "object was null");
     }
 
-    XMLWriter writer = XMLWriter(object);
+    BufferSink sink;
+    XMLWriter writer = XMLWriter(object, &sink);
     if (!writer.write()) {
         return std::make_pair(nullptr, "serialization failed");
     }
 
-    std::vector<uint8_t> const data = Encodings::Convert(writer.contents(), Encoding::UTF8, format.encoding());
+    std::vector<uint8_t> const data = Encodings::Convert(sink.contents(), Encoding::UTF8, format.encoding());
 
     return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(data.begin(), data.end())), std::string());
 }
 
+template<>
+std::pair<bool, std::string> Format<XML>::
+Serialize(Object const *object, XML const &format, Sink *sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "object was null");
+    }
+
+    /* Converting to other encodings needs the whole output. */
+    if (format.encoding() != Encoding::UTF8) {
+        auto serialized = Serialize(object, format);
+        if (serialized.first == nullptr) {
+            return std::make_pair(false, serialized.second);
+        }
+
+        if (!sink->write(serialized.first->data(), serialized.first->size())) {
+            return std::make_pair(false, "unable to write output");
+        }
+
+        return std::make_pair(true, std::string());
+    }
+
+    XMLWriter writer = XMLWriter(object, sink);
+    if (!writer.write()) {
+        return std::make_pair(false, "serialization failed");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
 } }
 
 XML XML::
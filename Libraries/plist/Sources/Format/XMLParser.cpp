@@ -12,57 +12,30 @@
 #include <plist/Objects.h>
 
 using plist::Format::XMLParser;
+using plist::Format::Handler;
 using plist::Object;
 
-XMLParser::XMLParser() :
+XMLParser::XMLParser(Handler *handler) :
     BaseXMLParser(),
-    _root        (nullptr)
+    _handler     (handler),
+    _root        (false),
+    _element     (Element::None),
+    _boolean     (false),
+    _pending     (Pending::None)
 {
 }
 
-Object *XMLParser::
+bool XMLParser::
 parse(std::vector<uint8_t> const &contents)
 {
-    if (_root != nullptr)
-        return nullptr;
-
-    if (!BaseXMLParser::parse(contents))
-        return nullptr;
-
-    return _root;
-}
-
-void XMLParser::
-onBeginParse()
-{
-    _root             = nullptr;
-    _state.current    = nullptr;
-    _state.key.valid  = false;
-    _state.key.active = false;
-}
-
-void XMLParser::
-onEndParse(bool success)
-{
-    if (!success) {
-        if (_state.current != nullptr && _state.current != _root) {
-            _state.current->release();
-        }
-        for (auto const &s : _stack) {
-            if (s.current != _state.current && s.current != _root) {
-                s.current->release();
-            }
-        }
-        _stack.clear();
-        if (_root != nullptr) {
-            _root->release();
-            _root = nullptr;
-        }
-    }
-    _state.current    = nullptr;
-    _state.key.valid  = false;
-    _state.key.active = false;
+    _root         = false;
+    _element      = Element::None;
+    _pending      = Pending::None;
+    _pendingValue = nullptr;
+    _levels.clear();
     _cdata.clear();
+
+    return BaseXMLParser::parse(contents);
 }
 
 void XMLParser::
@@ -79,7 +52,7 @@ onStartElement(std::string const &name, std::unordered_map<std::string, std::str
     // If we have a root, and depth == 1 there's an extra
     // entry after the first element, bail out.
     //
-    if (depth == 1 && _root != nullptr) {
+    if (depth == 1 && _root) {
         error("unexpected element '%s' after root element", name.c_str());
         return;
     }
@@ -92,7 +65,7 @@ onStartElement(std::string const &name, std::unordered_map<std::string, std::str
 void XMLParser::
 onEndElement(std::string const &name, size_t)
 {
-    if (!endObject(name)) {
+    if (!endObject(name) && !stopped()) {
         error("unexpected end element: " + name);
     }
 }
@@ -104,6 +77,7 @@ onCharacterData(std::string const &cdata, size_t)
         for (size_t n = 0; n < cdata.size(); n++) {
             if (!isspace(cdata[n])) {
                 error("unexpected cdata: " + cdata);
+                return;
             }
         }
         return;
@@ -113,43 +87,90 @@ onCharacterData(std::string const &cdata, size_t)
 }
 
 inline bool XMLParser::
-inContainer() const
+inDictionary() const
 {
-    return (depth() == 1 || inDictionary() || inArray());
+    return (!_levels.empty() && _levels.back().dictionary);
 }
 
 inline bool XMLParser::
-inArray() const
+isExpectingKey() const
 {
-    return (CastTo <Array> (_state.current) != nullptr);
+    return (inDictionary() && !_levels.back().keyed);
 }
 
 inline bool XMLParser::
-inDictionary() const
+isExpectingCDATA() const
 {
-    return (CastTo <Dictionary> (_state.current) != nullptr);
+    return (_element == Element::Key ||
+            _element == Element::String ||
+            _element == Element::Integer ||
+            _element == Element::Real ||
+            _element == Element::Data ||
+            _element == Element::Date);
 }
 
-inline bool XMLParser::
-isExpectingKey() const
+/*
+ * Pass on the result of an event. If the handler stopped, so does parsing.
+ */
+bool XMLParser::
+emit(bool result)
 {
-    return (inDictionary() && !_state.key.valid);
+    if (!result) {
+        stop();
+    }
+
+    return result;
 }
 
-inline bool XMLParser::
-isExpectingCDATA() const
+/*
+ * Send the events held back for a dictionary that turned out not to be
+ * a UID, if any.
+ */
+bool XMLParser::
+flush()
 {
-    return (CastTo <Integer> (_state.current) != nullptr ||
-            CastTo <Real> (_state.current) != nullptr ||
-            CastTo <String> (_state.current) != nullptr ||
-            CastTo <Data> (_state.current) != nullptr ||
-            CastTo <Date> (_state.current) != nullptr ||
-            (inDictionary() && _state.key.active));
+    if (_pending == Pending::None) {
+        return true;
+    }
+
+    Pending pending = _pending;
+    _pending = Pending::None;
+
+    if (!emit(_handler->beginDictionary())) {
+        return false;
+    }
+    if (pending != Pending::Dictionary && !emit(_handler->key("CF$UID", 6))) {
+        return false;
+    }
+    if (pending == Pending::Value && !emit(_handler->scalar(std::move(_pendingValue)))) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * A value ended; a dictionary it's in expects another key.
+ */
+bool XMLParser::
+value()
+{
+    if (inDictionary()) {
+        _levels.back().keyed = false;
+    }
+
+    return true;
 }
 
 bool XMLParser::
 beginObject(std::string const &name)
 {
+    if (_element != Element::None) {
+        error("unexpected '%s' element in a non-container element.",
+                name.c_str());
+        return false;
+    }
+
     if (inDictionary()) {
         if (name == "key") {
             if (!isExpectingKey()) {
@@ -158,7 +179,7 @@ beginObject(std::string const &name)
                 return false;
             }
 
-            return beginKey();
+            return beginScalar(Element::Key);
         } else if (isExpectingKey()) {
             error("unexpected element '%s' when a key "
                     "was expected in dictionary definition",
@@ -167,33 +188,32 @@ beginObject(std::string const &name)
         }
     }
 
-    if (!inContainer()) {
-        error("unexpected '%s' element in a non-container element.",
-                name.c_str());
-        return false;
+    if (depth() == 1) {
+        _root = true;
     }
 
-
     if (name == "array") {
-        return beginArray();
+        return beginContainer(false);
     } else if (name == "dict") {
-        return beginDictionary();
+        return beginContainer(true);
     } else if (name == "string") {
-        return beginString();
+        return beginScalar(Element::String);
     } else if (name == "integer") {
-        return beginInteger();
+        return beginScalar(Element::Integer);
     } else if (name == "real") {
-        return beginReal();
+        return beginScalar(Element::Real);
     } else if (name == "true") {
-        return beginBoolean(true);
+        _boolean = true;
+        return beginScalar(Element::Boolean);
     } else if (name == "false") {
-        return beginBoolean(false);
+        _boolean = false;
+        return beginScalar(Element::Boolean);
     } else if (name == "null") {
-        return beginNull();
+        return beginScalar(Element::Null);
     } else if (name == "data") {
-        return beginData();
+        return beginScalar(Element::Data);
     } else if (name == "date") {
-        return beginDate();
+        return beginScalar(Element::Date);
     }
 
     error("unexpected element '%s'", name.c_str());
@@ -201,259 +221,171 @@ beginObject(std::string const &name)
 }
 
 bool XMLParser::
-endObject(std::string const &name)
+beginContainer(bool dictionary)
 {
-    if (name == "plist") {
-        return true;
-    } if (name == "key") {
-        return endKey();
-    } else if (name == "array") {
-        return endArray();
-    } else if (name == "dict") {
-        return endDictionary();
-    } else if (name == "string") {
-        return endString();
-    } else if (name == "integer") {
-        return endInteger();
-    } else if (name == "real") {
-        return endReal();
-    } else if (name == "true" || name == "false") {
-        return endBoolean();
-    } else if (name == "null") {
-        return endNull();
-    } else if (name == "data") {
-        return endData();
-    } else if (name == "date") {
-        return endDate();
+    if (!flush()) {
+        return false;
     }
 
-    error("unexpected element '%s'", name.c_str());
-    return false;
-}
+    _levels.push_back({ dictionary, false });
 
-void XMLParser::
-push(Object *object)
-{
-    if (_state.current != nullptr) {
-        _stack.push_back(_state);
-    }
-    _state.current    = object;
-    _state.key.valid  = false;
-    _state.key.active = false;
-    if (_root == nullptr) {
-        _root = _state.current;
+    if (dictionary) {
+        _pending = Pending::Dictionary;
+        return true;
     }
+
+    return emit(_handler->beginArray());
 }
 
-void XMLParser::
-pop()
+bool XMLParser::
+beginScalar(Element element)
 {
-    if (_stack.empty() && _state.current == nullptr) {
-        error("stack underflow");
-        return;
-    }
-
-    if (_state.current != _root) {
-        State old = _state;
-        _state = _stack.back();
-        _stack.pop_back();
-
-        if (auto array = CastTo <Array> (_state.current)) {
-            array->append(std::unique_ptr<Object>(old.current));
-        } else if (auto dict = CastTo <Dictionary> (_state.current)) {
-            if (!isExpectingKey()) {
-                dict->set(_state.key.value, std::unique_ptr<Object>(old.current));
-                _state.key.valid  = false;
-                _state.key.active = false;
-            }
-        }
+    /* A CF$UID key, and an integer after it, may be part of a UID. */
+    bool uid = ((element == Element::Key && _pending == Pending::Dictionary) ||
+                (element == Element::Integer && _pending == Pending::Key));
+    if (!uid && !flush()) {
+        return false;
     }
 
+    _element = element;
     _cdata.clear();
-}
-
-bool XMLParser::
-beginArray()
-{
-    push(Array::New().release());
     return true;
 }
 
 bool XMLParser::
-endArray()
+endObject(std::string const &name)
 {
-    pop();
-    return true;
-}
+    if (name == "plist") {
+        return true;
+    }
 
-bool XMLParser::
-beginDictionary()
-{
-    push(Dictionary::New().release());
-    _state.key.valid  = false;
-    _state.key.active = false;
-    return true;
-}
+    if (_element == Element::Key) {
+        return endKey();
+    } else if (_element != Element::None) {
+        return endScalar();
+    }
 
-bool XMLParser::
-endDictionary()
-{
-    if (auto dict = CastTo<Dictionary>(_state.current)) {
-        /* Convert CF$UID dictionaries into UID objects. */
-        if (dict->count() == 1) {
-            std::string const &key = dict->key(0);
-            Object const *value = dict->value(0);
-            if (key == "CF$UID" && value->type() == Integer::Type()) {
-                Integer const *integer = CastTo<Integer>(value);
-
-                uint32_t value = integer->value();
-                _state.current->release();
-                _state.current = UID::New(value).release();
-            }
-        }
+    if (name == "array") {
+        return endContainer(false);
+    } else if (name == "dict") {
+        return endContainer(true);
     }
 
-    pop();
-    return true;
+    return false;
 }
 
 bool XMLParser::
-beginString()
+endContainer(bool dictionary)
 {
-    push(String::New().release());
-    _cdata.clear();
-    return true;
-}
+    if (_levels.empty() || _levels.back().dictionary != dictionary) {
+        return false;
+    }
 
-bool XMLParser::
-endString()
-{
-    CastTo <String> (_state.current)->setValue(_cdata);
-    pop();
-    return true;
-}
+    _levels.pop_back();
 
-bool XMLParser::
-beginInteger()
-{
-    push(Integer::New().release());
-    _cdata.clear();
-    return true;
-}
+    /* Convert CF$UID dictionaries into UID objects. */
+    if (dictionary && _pending == Pending::Value) {
+        uint32_t value = CastTo<Integer>(_pendingValue.get())->value();
+        _pending = Pending::None;
+        _pendingValue = nullptr;
 
-bool XMLParser::
-endInteger()
-{
-    char *end = NULL;
-    long long integer = ::strtoll(_cdata.c_str(), &end, 0);
-    if (end != _cdata.c_str()) {
-        CastTo <Integer> (_state.current)->setValue(integer);
-        pop();
-        return true;
-    } else {
-        pop();
-        return false;
+        if (!emit(_handler->scalar(UID::New(value)))) {
+            return false;
+        }
+        return this->value();
     }
-}
 
-bool XMLParser::
-beginReal()
-{
-    push(Real::New().release());
-    _cdata.clear();
-    return true;
-}
-
-bool XMLParser::
-endReal()
-{
-    char *end = NULL;
-    double real = ::strtod(_cdata.c_str(), &end);
-    if (end != _cdata.c_str()) {
-        CastTo <Real> (_state.current)->setValue(real);
-        pop();
-        return true;
-    } else {
-        pop();
+    if (!flush()) {
+        return false;
+    }
+    if (!emit(dictionary ? _handler->endDictionary() : _handler->endArray())) {
         return false;
     }
-}
 
-bool XMLParser::
-beginNull()
-{
-    push(Null::New().release());
-    return true;
+    return value();
 }
 
 bool XMLParser::
-endNull()
+endKey()
 {
-    pop();
-    return true;
-}
+    _element = Element::None;
+    _levels.back().keyed = true;
 
-bool XMLParser::
-beginBoolean(bool value)
-{
-    push(Boolean::New(value).release());
-    return true;
-}
+    if (_pending == Pending::Dictionary && _cdata == "CF$UID") {
+        _pending = Pending::Key;
+        return true;
+    }
 
-bool XMLParser::
-endBoolean()
-{
-    pop();
-    return true;
-}
+    if (!flush()) {
+        return false;
+    }
 
-bool XMLParser::
-beginData()
-{
-    push(Data::New().release());
-    _cdata.clear();
-    return true;
+    return emit(_handler->key(_cdata.data(), _cdata.size()));
 }
 
 bool XMLParser::
-endData()
-{
-    CastTo <Data> (_state.current)->setBase64Value(_cdata);
-    pop();
-    return true;
-}
+endScalar()
+{
+    Element element = _element;
+    _element = Element::None;
+
+    std::unique_ptr<Object> object;
+    switch (element) {
+        case Element::String:
+            object = String::New(std::move(_cdata));
+            break;
+        case Element::Integer: {
+            char *end = NULL;
+            long long integer = ::strtoll(_cdata.c_str(), &end, 0);
+            if (end == _cdata.c_str()) {
+                return false;
+            }
+            object = Integer::New(integer);
+            break;
+        }
+        case Element::Real: {
+            char *end = NULL;
+            double real = ::strtod(_cdata.c_str(), &end);
+            if (end == _cdata.c_str()) {
+                return false;
+            }
+            object = Real::New(real);
+            break;
+        }
+        case Element::Boolean:
+            object = Boolean::New(_boolean);
+            break;
+        case Element::Null:
+            object = Null::New();
+            break;
+        case Element::Data: {
+            std::unique_ptr<Data> data = Data::New();
+            data->setBase64Value(_cdata);
+            object = std::move(data);
+            break;
+        }
+        case Element::Date: {
+            std::unique_ptr<Date> date = Date::New();
+            date->setStringValue(_cdata);
+            object = std::move(date);
+            break;
+        }
+        case Element::None:
+        case Element::Key:
+            return false;
+    }
 
-bool XMLParser::
-beginDate()
-{
-    push(Date::New().release());
     _cdata.clear();
-    return true;
-}
 
-bool XMLParser::
-endDate()
-{
-    CastTo <Date> (_state.current)->setStringValue(_cdata);
-    pop();
-    return true;
-}
+    if (element == Element::Integer && _pending == Pending::Key) {
+        _pendingValue = std::move(object);
+        _pending = Pending::Value;
+        return value();
+    }
 
-bool XMLParser::
-beginKey()
-{
-    _state.key.valid = false;
-    _state.key.active = true;
-    _cdata.clear();
-    return true;
-}
+    if (!emit(_handler->scalar(std::move(object)))) {
+        return false;
+    }
 
-bool XMLParser::
-endKey()
-{
-    _state.key.active = false;
-    _state.key.valid = true;
-    _state.key.value = _cdata;
-    _cdata.clear();
-    return true;
+    return value();
 }
@@ -26,8 +26,9 @@ using plist::Dictionary;
 using plist::CastTo;
 
 XMLWriter::
-XMLWriter(Object const *root) :
+XMLWriter(Object const *root, Sink *sink) :
     _root   (root),
+    _output (sink),
     _indent (0)
 {
 }
@@ -60,7 +61,7 @@ write()
         return false;
     }
 
-    return true;
+    return _output.flush();
 }
 
 /*
@@ -70,15 +71,12 @@ write()
 bool XMLWriter::
 primitiveWriteString(std::string const &string)
 {
-    _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return _output.append(string);
 }
 
 bool XMLWriter::
 primitiveWriteEscapedString(std::string const &string)
 {
-    _contents.reserve(_contents.size() + string.size());
-
     for (char c : string) {
         switch (c) {
             case '<':
@@ -97,7 +95,7 @@ primitiveWriteEscapedString(std::string const &string)
                 }
                 break;
             default:
-                _contents.push_back(c);
+                _output.append(c);
                 break;
         }
     }
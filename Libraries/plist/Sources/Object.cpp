@@ -8,8 +8,51 @@
  */
 
 #include <plist/Object.h>
+#include <plist/Arena.h>
+
+#include <cstddef>
+#include <new>
 
 using plist::Object;
+using plist::Arena;
+
+/*
+ * Each object is preceded by the arena it was allocated in, or null if it
+ * was allocated normally. Sized to keep objects aligned.
+ */
+union ObjectHeader {
+    Arena            *arena;
+    std::max_align_t  alignment;
+};
+
+void *Object::
+operator new(size_t size)
+{
+    ObjectHeader *header;
+    if (Arena *arena = Arena::Scope::Current()) {
+        header = static_cast<ObjectHeader *>(arena->allocate(sizeof(ObjectHeader) + size));
+        header->arena = arena;
+    } else {
+        header = static_cast<ObjectHeader *>(::operator new(sizeof(ObjectHeader) + size));
+        header->arena = nullptr;
+    }
+
+    return header + 1;
+}
+
+void Object::
+operator delete(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    /* Memory in an arena is freed with the arena. */
+    ObjectHeader *header = static_cast<ObjectHeader *>(pointer) - 1;
+    if (header->arena == nullptr) {
+        ::operator delete(header);
+    }
+}
 
 std::unique_ptr<Object> Object::
 Coerce(Object const *obj)
@@ -8,6 +8,7 @@
  */
 
 #include <plist/String.h>
+#include <plist/Arena.h>
 #include <plist/Boolean.h>
 #include <plist/Date.h>
 #include <plist/Real.h>
@@ -34,10 +35,25 @@ New(std::string &&value)
     return std::unique_ptr<String>(new String(std::move(value)));
 }
 
+std::unique_ptr<String> String::
+Borrow(char const *data, size_t size)
+{
+    return std::unique_ptr<String>(new String(data, size));
+}
+
 std::unique_ptr<Object> String::
 _copy() const
 {
-    return plist::static_unique_pointer_cast<Object>(String::New(value()));
+    if (_borrowed != nullptr) {
+        Arena *arena = Arena::Scope::Current();
+        if (arena != nullptr && arena->retains(_borrowed)) {
+            return plist::static_unique_pointer_cast<Object>(String::Borrow(_borrowed, _borrowedSize));
+        }
+
+        return plist::static_unique_pointer_cast<Object>(String::New(std::string(_borrowed, _borrowedSize)));
+    }
+
+    return plist::static_unique_pointer_cast<Object>(String::New(_value));
 }
 
 std::unique_ptr<String> String::
@@ -0,0 +1,141 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/ASCIIPListLexer.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+struct Token {
+    int token;
+    int tokenBegin;
+    int tokenLength;
+    int line;
+    long lineStart;
+
+    bool operator==(Token const &rhs) const
+    {
+        return token == rhs.token && tokenBegin == rhs.tokenBegin && tokenLength == rhs.tokenLength &&
+            line == rhs.line && lineStart == rhs.lineStart;
+    }
+};
+
+static std::ostream &
+operator<<(std::ostream &out, Token const &token)
+{
+    return out << "{ token " << token.token << ", begin " << token.tokenBegin << ", length " << token.tokenLength <<
+        ", line " << token.line << ", line start " << token.lineStart << " }";
+}
+
+static std::vector<Token>
+Lex(std::string const &input, int style, bool vectorized)
+{
+    /* The scalar lexer can read past the end, so end the input with zeroes. */
+    std::vector<char> buffer = std::vector<char>(input.begin(), input.end());
+    buffer.resize(buffer.size() + 64, '\0');
+
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, buffer.data(), input.size(), style);
+    lexer.vectorized = vectorized;
+
+    std::vector<Token> tokens;
+    for (size_t n = 0; n <= input.size() + 1; ++n) {
+        int token = ASCIIPListLexerReadToken(&lexer);
+        tokens.push_back({ token, lexer.tokenBegin, lexer.tokenLength, lexer.line, lexer.lineStart - lexer.inputBuffer });
+        if (token < 0) {
+            break;
+        }
+    }
+    return tokens;
+}
+
+static void
+ExpectSame(std::string const &input)
+{
+    for (int style : { kASCIIPListLexerStyleASCII, kASCIIPListLexerStyleJSON }) {
+        std::vector<Token> scalar = Lex(input, style, false);
+        std::vector<Token> vectorized = Lex(input, style, true);
+        ASSERT_EQ(scalar, vectorized) << "input: " << input;
+    }
+}
+
+TEST(ASCIIPListLexer, Tokens)
+{
+    std::string input =
+        "// !$*UTF8*$!\n"
+        "{\n"
+        "\tarchiveVersion = 1;\n"
+        "\tclasses = {\n"
+        "\t};\n"
+        "\tobjects = {\n"
+        "\n"
+        "/* Begin PBXBuildFile section */\n"
+        "\t\t1D60589B0D05DD56006BFB54 /* main.m in Sources */ = {isa = PBXBuildFile; fileRef = 29B97316FDCFA39411CA2CEA /* main.m */; };\n"
+        "\t\t1D60589C0D05DD56006BFB54 = {isa = PBXFileReference; path = \"Some Long Path/With Spaces And \\\"Escapes\\\"/file.m\"; };\n"
+        "\t\tAAAA = ( 'single quoted', <0fbd 7777>, $(SRCROOT)/a-b.c, );\n"
+        "/* End PBXBuildFile section */\n"
+        "\t};\n"
+        "}\n";
+
+    std::vector<Token> tokens = Lex(input, kASCIIPListLexerStyleASCII, true);
+    ASSERT_FALSE(tokens.empty());
+    EXPECT_EQ(kASCIIPListLexerTokenInlineComment, tokens.front().token);
+    EXPECT_EQ(kASCIIPListLexerEndOfFile, tokens.back().token);
+    EXPECT_EQ(15, tokens.back().line);
+
+    ExpectSame(input);
+}
+
+TEST(ASCIIPListLexer, Boundaries)
+{
+    /* Tokens ending at every offset around a vector boundary. */
+    for (size_t n = 0; n < 80; ++n) {
+        std::string padding = std::string(n, 'a');
+        ExpectSame(padding + " = b;");
+        ExpectSame(std::string(n, ' ') + "x");
+        ExpectSame(std::string(n, '\n') + "x");
+        ExpectSame("\"" + padding + "\\\"" + padding + "\"");
+        ExpectSame("'" + padding + "\n" + padding + "'");
+        ExpectSame("/*" + padding + "\n*" + padding + "*/ x");
+        ExpectSame("//" + padding + "\r\n" + padding);
+
+        /* Unterminated tokens at the end of the input. */
+        ExpectSame(padding);
+        ExpectSame("\"" + padding);
+        ExpectSame("/*" + padding);
+    }
+}
+
+TEST(ASCIIPListLexer, Random)
+{
+    /* Mostly the characters the lexer treats specially. */
+    static char const alphabet[] = " \t\r\n\f{}()[]<>=;:,\"'\\/*$_.-+0123456789abcfXYZ\x80\xff";
+
+    std::mt19937 random(20161018);
+    std::uniform_int_distribution<size_t> character(0, sizeof(alphabet) - 2);
+    std::uniform_int_distribution<size_t> length(0, 200);
+    std::uniform_int_distribution<size_t> run(1, 40);
+
+    for (size_t n = 0; n < 5000; ++n) {
+        std::string input;
+        size_t size = length(random);
+        while (input.size() < size) {
+            /* Runs of one character, to cross vector boundaries. */
+            char c = alphabet[character(random)];
+            input.append((c == ' ' || c == 'a' || c == '\n') ? run(random) : 1, c);
+        }
+
+        ExpectSame(input);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
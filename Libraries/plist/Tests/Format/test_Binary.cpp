@@ -13,6 +13,13 @@
 
 using plist::Format::Binary;
 using plist::String;
+using plist::Integer;
+using plist::Real;
+using plist::Boolean;
+using plist::Null;
+using plist::Data;
+using plist::UID;
+using plist::Array;
 using plist::Dictionary;
 
 TEST(Binary, UnicodeString)
@@ -42,3 +49,90 @@ TEST(Binary, UnicodeString)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(Binary, Date)
+{
+    auto date = plist::Date::New(static_cast<uint64_t>(1476748800));
+
+    auto serialize = Binary::Serialize(date.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    auto deserialize = Binary::Deserialize(*serialize.first, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(date.get()));
+}
+
+TEST(Binary, RoundTrip)
+{
+    auto dict = Dictionary::New();
+    dict->set("negative", Integer::New(-2));
+    dict->set("large", Integer::New(0x123456789LL));
+    dict->set("float", Real::New(0.5));
+    dict->set("double", Real::New(0.1));
+    dict->set("true", Boolean::New(true));
+    dict->set("false", Boolean::New(false));
+    dict->set("data", Data::New(std::vector<uint8_t>(300, 0x2a)));
+    dict->set("before", plist::Date::New(static_cast<uint64_t>(946684800)));
+    dict->set("uid", UID::New(70000));
+    dict->set("long", String::New("a string longer than fifteen characters"));
+    dict->set("unicode", String::New("\u00e9t\u00e9 \U0001F643"));
+
+    /* Enough objects to need two byte references. */
+    auto array = Array::New();
+    for (int n = 0; n < 300; n++) {
+        array->append(Integer::New(n * 1000));
+    }
+    dict->set("array", std::move(array));
+
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    auto deserialize = Binary::Deserialize(*serialize.first, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(dict.get()));
+}
+
+TEST(Binary, Unique)
+{
+    auto inner = Dictionary::New();
+    inner->set("name", String::New("name"));
+    inner->set("count", Integer::New(7));
+
+    auto array = Array::New();
+    array->append(String::New("name"));
+    array->append(Integer::New(7));
+    array->append(Integer::New(7));
+    array->append(String::New("\u00e9t\u00e9"));
+    array->append(String::New("\u00e9t\u00e9"));
+    array->append(std::move(inner));
+
+    auto serialize = Binary::Serialize(array.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    /* The array, the inner dictionary, and one of each distinct value. */
+    std::vector<uint8_t> const &contents = *serialize.first;
+    uint64_t count = 0;
+    for (size_t n = contents.size() - 24; n < contents.size() - 16; n++) {
+        count = (count << 8) | contents[n];
+    }
+    EXPECT_EQ(6, count);
+
+    auto deserialize = Binary::Deserialize(contents, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(array.get()));
+}
+
+TEST(Binary, Cycle)
+{
+    /* An array containing itself. */
+    std::vector<uint8_t> contents = {
+        0x62, 0x70, 0x6c, 0x69, 0x73, 0x74, 0x30, 0x30, 0xa1, 0x00, 0x08, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a,
+    };
+
+    auto deserialize = Binary::Deserialize(contents, Binary::Create());
+    EXPECT_EQ(deserialize.first, nullptr);
+    EXPECT_NE(deserialize.second, "");
+}
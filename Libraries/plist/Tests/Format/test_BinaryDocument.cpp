@@ -0,0 +1,116 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/BinaryDocument.h>
+#include <plist/Objects.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+using plist::Format::Binary;
+using plist::Format::BinaryDocument;
+using plist::ObjectType;
+using plist::String;
+using plist::Integer;
+using plist::Array;
+using plist::Dictionary;
+
+static std::vector<uint8_t>
+CreateContents()
+{
+    auto inner = Dictionary::New();
+    inner->set("été", String::New("summer"));
+    inner->set("count", Integer::New(42));
+
+    auto array = Array::New();
+    array->append(String::New("zero"));
+    array->append(std::move(inner));
+
+    auto dict = Dictionary::New();
+    dict->set("name", String::New("value"));
+    dict->set("array", std::move(array));
+
+    return *Binary::Serialize(dict.get(), Binary::Create()).first;
+}
+
+TEST(BinaryDocument, Lookup)
+{
+    auto document = BinaryDocument::Create(CreateContents());
+    ASSERT_NE(nullptr, document.first);
+
+    BinaryDocument::Value root = document.first->root();
+    ASSERT_TRUE(root.valid());
+    EXPECT_EQ(ObjectType::Dictionary, root.type());
+    EXPECT_EQ(2, root.count());
+    EXPECT_EQ("name", root.key(0));
+
+    BinaryDocument::Value array = root.value(std::string("array"));
+    EXPECT_EQ(ObjectType::Array, array.type());
+    EXPECT_EQ(2, array.count());
+    EXPECT_TRUE(array.value(0).object()->equals(String::New("zero").get()));
+    EXPECT_FALSE(array.value(2).valid());
+
+    /* Unicode keys are compared as UTF-8. */
+    BinaryDocument::Value summer = root.find({ "array", "1", "été" });
+    ASSERT_TRUE(summer.valid());
+    EXPECT_EQ(ObjectType::String, summer.type());
+    EXPECT_TRUE(summer.object()->equals(String::New("summer").get()));
+
+    BinaryDocument::Value count = root.find({ "array", "0x1", "count" });
+    EXPECT_TRUE(count.object()->equals(Integer::New(42).get()));
+
+    EXPECT_FALSE(root.find({ "missing" }).valid());
+    EXPECT_FALSE(root.find({ "array", "one" }).valid());
+    EXPECT_FALSE(root.find({ "name", "more" }).valid());
+    EXPECT_EQ("", document.first->error());
+
+    /* Whole containers decode as usual. */
+    auto whole = Binary::Deserialize(CreateContents(), Binary::Create());
+    ASSERT_NE(nullptr, whole.first);
+    EXPECT_TRUE(root.object()->equals(whole.first.get()));
+}
+
+TEST(BinaryDocument, Open)
+{
+    char path[] = "/tmp/test_BinaryDocument.XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+
+    std::vector<uint8_t> contents = CreateContents();
+    ASSERT_EQ(static_cast<ssize_t>(contents.size()), ::write(fd, contents.data(), contents.size()));
+    ::close(fd);
+
+    auto document = BinaryDocument::Open(path);
+    ASSERT_NE(nullptr, document.first);
+    BinaryDocument::Value name = document.first->root().find({ "name" });
+    EXPECT_TRUE(name.object()->equals(String::New("value").get()));
+    ::unlink(path);
+
+    auto missing = BinaryDocument::Open(path);
+    EXPECT_EQ(nullptr, missing.first);
+    EXPECT_NE("", missing.second);
+}
+
+TEST(BinaryDocument, Invalid)
+{
+    std::string text = "{ a = b; }";
+    auto document = BinaryDocument::Create(std::vector<uint8_t>(text.begin(), text.end()));
+    EXPECT_EQ(nullptr, document.first);
+    EXPECT_NE("", document.second);
+
+    /* A reference past the offset table. */
+    std::vector<uint8_t> contents = CreateContents();
+    contents[contents.size() - 32 + 7] = 8;
+    auto corrupted = BinaryDocument::Create(contents);
+    ASSERT_NE(nullptr, corrupted.first);
+    EXPECT_FALSE(corrupted.first->root().find({ "array", "1" }).valid());
+}
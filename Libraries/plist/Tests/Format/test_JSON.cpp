@@ -72,6 +72,15 @@ TEST(JSON, String)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+TEST(JSON, EscapeString)
+{
+    auto string = String::New("quote \" backslash \\ newline \n unicode \xc3\xa9");
+
+    auto serialize = JSON::Serialize(string.get(), JSON::Create());
+    ASSERT_NE(serialize.first, nullptr);
+    EXPECT_EQ(*serialize.first, Contents("\"quote \\\" backslash \\\\ newline \\u000a unicode \xc3\xa9\""));
+}
+
 TEST(JSON, BooleanNumber)
 {
     auto contents = Contents("{\n\t\"boolean\": true,\n\t\"integer\": 42,\n\t\"real\": 3.14\n}");
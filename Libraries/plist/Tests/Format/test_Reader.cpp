@@ -0,0 +1,268 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/JSON.h>
+#include <plist/Format/XML.h>
+#include <plist/Objects.h>
+
+using plist::Format::Any;
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::Encoding;
+using plist::Format::Handler;
+using plist::Format::JSON;
+using plist::Format::Query;
+using plist::Format::XML;
+using plist::Object;
+using plist::String;
+using plist::Integer;
+using plist::Array;
+using plist::Dictionary;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * Records events as text, stopping after a number of them if asked.
+ */
+class Recorder : public Handler {
+public:
+    std::string events;
+    int         limit;
+
+public:
+    explicit Recorder(int limit = -1) :
+        limit(limit)
+    {
+    }
+
+private:
+    bool record(std::string const &event)
+    {
+        events += (events.empty() ? "" : " ") + event;
+        return (limit < 0 || --limit > 0);
+    }
+
+public:
+    virtual bool beginDictionary()
+    { return record("{"); }
+    virtual bool endDictionary()
+    { return record("}"); }
+    virtual bool beginArray()
+    { return record("("); }
+    virtual bool endArray()
+    { return record(")"); }
+    virtual bool key(char const *data, size_t size)
+    { return record(std::string(data, size) + "="); }
+
+    virtual bool scalar(std::unique_ptr<Object> value)
+    {
+        if (String const *string = plist::CastTo<String>(value.get())) {
+            return record(string->value());
+        } else if (Integer const *integer = plist::CastTo<Integer>(value.get())) {
+            return record(std::to_string(integer->value()));
+        } else {
+            return record("?");
+        }
+    }
+};
+
+static std::unique_ptr<Dictionary>
+CreateObject()
+{
+    auto array = Array::New();
+    array->append(String::New("one"));
+    array->append(Dictionary::New());
+    array->append(Integer::New(3));
+
+    auto dict = Dictionary::New();
+    dict->set("name", String::New("value"));
+    dict->set("array", std::move(array));
+    dict->set("empty", Array::New());
+    return dict;
+}
+
+TEST(Reader, Events)
+{
+    auto object = CreateObject();
+    std::string expected = "{ name= value array= ( one { } 3 ) empty= ( ) }";
+
+    auto ascii = ASCII::Serialize(object.get(), ASCII::Create(false, Encoding::UTF8));
+    ASSERT_NE(nullptr, ascii.first);
+    Recorder asciiRecorder;
+    EXPECT_TRUE(ASCII::Read(*ascii.first, ASCII::Create(false, Encoding::UTF8), &asciiRecorder).first);
+    EXPECT_EQ(expected, asciiRecorder.events);
+
+    auto xml = XML::Serialize(object.get(), XML::Create(Encoding::UTF8));
+    ASSERT_NE(nullptr, xml.first);
+    Recorder xmlRecorder;
+    EXPECT_TRUE(XML::Read(*xml.first, XML::Create(Encoding::UTF8), &xmlRecorder).first);
+    EXPECT_EQ(expected, xmlRecorder.events);
+
+    auto binary = Binary::Serialize(object.get(), Binary::Create());
+    ASSERT_NE(nullptr, binary.first);
+    Recorder binaryRecorder;
+    EXPECT_TRUE(Binary::Read(*binary.first, Binary::Create(), &binaryRecorder).first);
+    EXPECT_EQ(expected, binaryRecorder.events);
+
+    auto json = JSON::Serialize(object.get(), JSON::Create());
+    ASSERT_NE(nullptr, json.first);
+    Recorder jsonRecorder;
+    EXPECT_TRUE(JSON::Read(*json.first, JSON::Create(), &jsonRecorder).first);
+    EXPECT_EQ(expected, jsonRecorder.events);
+}
+
+TEST(Reader, Stop)
+{
+    auto object = CreateObject();
+
+    /* Stopping is successful, and no more events are sent. */
+    auto xml = XML::Serialize(object.get(), XML::Create(Encoding::UTF8));
+    ASSERT_NE(nullptr, xml.first);
+    Recorder xmlRecorder = Recorder(4);
+    EXPECT_TRUE(XML::Read(*xml.first, XML::Create(Encoding::UTF8), &xmlRecorder).first);
+    EXPECT_EQ("{ name= value array=", xmlRecorder.events);
+
+    auto binary = Binary::Serialize(object.get(), Binary::Create());
+    ASSERT_NE(nullptr, binary.first);
+    Recorder binaryRecorder = Recorder(4);
+    EXPECT_TRUE(Binary::Read(*binary.first, Binary::Create(), &binaryRecorder).first);
+    EXPECT_EQ("{ name= value array=", binaryRecorder.events);
+
+    /* Input after stopping isn't read, so errors in it aren't found. */
+    Recorder asciiRecorder = Recorder(3);
+    EXPECT_TRUE(ASCII::Read(Contents("{ a = b; c = <invalid"), ASCII::Create(false, Encoding::UTF8), &asciiRecorder).first);
+    EXPECT_EQ("{ a= b", asciiRecorder.events);
+
+    Recorder errorRecorder;
+    EXPECT_FALSE(ASCII::Read(Contents("{ a = b; c = <invalid"), ASCII::Create(false, Encoding::UTF8), &errorRecorder).first);
+}
+
+TEST(Reader, UID)
+{
+    /* CF$UID dictionaries are read as UIDs, but other dictionaries aren't. */
+    auto contents = Contents(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<plist version=\"1.0\">\n"
+        "<array>\n"
+        "\t<dict><key>CF$UID</key><integer>4</integer></dict>\n"
+        "\t<dict><key>CF$UID</key><integer>4</integer><key>other</key><string>x</string></dict>\n"
+        "\t<dict><key>CF$UID</key><string>4</string></dict>\n"
+        "\t<dict/>\n"
+        "</array>\n"
+        "</plist>\n");
+
+    Recorder recorder;
+    EXPECT_TRUE(XML::Read(contents, XML::Create(Encoding::UTF8), &recorder).first);
+    EXPECT_EQ("( ? { CF$UID= 4 other= x } { CF$UID= 4 } { } )", recorder.events);
+}
+
+TEST(Reader, Extract)
+{
+    auto object = CreateObject();
+    auto binary = Binary::Serialize(object.get(), Binary::Create());
+    ASSERT_NE(nullptr, binary.first);
+    std::unique_ptr<Any> format = Any::Identify(*binary.first);
+    ASSERT_NE(nullptr, format);
+
+    auto value = Any::Extract(*binary.first, *format, { "array", "2" });
+    ASSERT_NE(nullptr, value.first);
+    EXPECT_TRUE(value.first->equals(Integer::New(3).get()));
+
+    auto container = Any::Extract(*binary.first, *format, { "array" });
+    ASSERT_NE(nullptr, container.first);
+    EXPECT_TRUE(container.first->equals(object->value("array")));
+
+    auto root = Any::Extract(*binary.first, *format, { });
+    ASSERT_NE(nullptr, root.first);
+    EXPECT_TRUE(root.first->equals(object.get()));
+
+    /* Paths not found are not an error. */
+    for (std::vector<std::string> const &path : std::vector<std::vector<std::string>>({ { "missing" }, { "array", "3" }, { "array", "first" }, { "name", "more" } })) {
+        auto missing = Any::Extract(*binary.first, *format, path);
+        EXPECT_EQ(nullptr, missing.first);
+        EXPECT_EQ("", missing.second);
+    }
+}
+
+TEST(Reader, ExtractEarly)
+{
+    /* Only the input up to the value is read. */
+    auto contents = Contents("{ a = { b = (1, (2, 3)); }; c = <invalid");
+    auto format = ASCII::Create(false, Encoding::UTF8);
+
+    auto value = ASCII::Extract(contents, format, { "a", "b", "1" });
+    ASSERT_NE(nullptr, value.first);
+    auto expected = Array::New();
+    expected->append(String::New("2"));
+    expected->append(String::New("3"));
+    EXPECT_TRUE(value.first->equals(expected.get()));
+
+    auto error = ASCII::Extract(contents, format, { "c" });
+    EXPECT_EQ(nullptr, error.first);
+    EXPECT_NE("", error.second);
+
+    /* Using the last of duplicate keys reads dictionaries through... */
+    auto through = ASCII::Extract(contents, format, { "a", "b", "1" }, Query::Duplicates::Last);
+    EXPECT_EQ(nullptr, through.first);
+    EXPECT_NE("", through.second);
+
+    /* ...but can still stop early in arrays. */
+    auto array = Contents("( (1, (2, 3)), <invalid");
+    auto element = ASCII::Extract(array, format, { "0", "1" }, Query::Duplicates::Last);
+    ASSERT_NE(nullptr, element.first);
+    EXPECT_TRUE(element.first->equals(expected.get()));
+}
+
+TEST(Reader, ExtractDuplicateKeys)
+{
+    auto contents = Contents("{ a = { b = 1; b = 2; }; c = 3; a = { b = 4; d = (5); }; c = 6; }");
+    auto format = ASCII::Create(false, Encoding::UTF8);
+
+    /* By default, the first of duplicate keys is used. */
+    auto first = ASCII::Extract(contents, format, { "a", "b" });
+    ASSERT_NE(nullptr, first.first);
+    EXPECT_TRUE(first.first->equals(String::New("1").get()));
+
+    auto absent = ASCII::Extract(contents, format, { "a", "d" });
+    EXPECT_EQ(nullptr, absent.first);
+    EXPECT_EQ("", absent.second);
+
+    /* Otherwise the last is used, as when deserializing. */
+    auto deserialized = ASCII::Deserialize(contents, format);
+    ASSERT_NE(nullptr, deserialized.first);
+
+    for (std::vector<std::string> const &path : std::vector<std::vector<std::string>>({ { "a" }, { "a", "b" }, { "a", "d", "0" }, { "c" } })) {
+        Object const *expected = deserialized.first.get();
+        for (std::string const &component : path) {
+            if (Dictionary const *dictionary = plist::CastTo<Dictionary>(expected)) {
+                expected = dictionary->value(component);
+            } else {
+                expected = plist::CastTo<Array>(expected)->value(std::stoul(component));
+            }
+        }
+
+        auto value = ASCII::Extract(contents, format, path, Query::Duplicates::Last);
+        ASSERT_NE(nullptr, value.first);
+        EXPECT_TRUE(value.first->equals(expected));
+    }
+
+    /* A later value without the rest of the path replaces one with it. */
+    auto replaced = Contents("{ a = { b = 1; }; a = 2; }");
+    auto missing = ASCII::Extract(replaced, format, { "a", "b" }, Query::Duplicates::Last);
+    EXPECT_EQ(nullptr, missing.first);
+    EXPECT_EQ("", missing.second);
+}
@@ -0,0 +1,159 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/JSON.h>
+#include <plist/Format/Sink.h>
+#include <plist/Format/XML.h>
+#include <plist/Objects.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::BufferSink;
+using plist::Format::Encoding;
+using plist::Format::FileSink;
+using plist::Format::JSON;
+using plist::Format::Sink;
+using plist::Format::XML;
+using plist::String;
+using plist::Integer;
+using plist::Array;
+using plist::Dictionary;
+
+/*
+ * Records the size of each piece, and can fail after some number of them.
+ */
+class RecordingSink : public BufferSink {
+public:
+    std::vector<size_t> pieces;
+    size_t              limit;
+
+public:
+    RecordingSink() :
+        limit(SIZE_MAX)
+    {
+    }
+
+public:
+    virtual bool write(uint8_t const *data, size_t size)
+    {
+        if (pieces.size() == limit) {
+            return false;
+        }
+
+        pieces.push_back(size);
+        return BufferSink::write(data, size);
+    }
+};
+
+static std::unique_ptr<Dictionary>
+CreateLarge()
+{
+    auto dict = Dictionary::New();
+    for (int n = 0; n < 10000; n++) {
+        auto entry = Dictionary::New();
+        entry->set("name", String::New("entry <" + std::to_string(n) + ">"));
+        entry->set("value", Integer::New(n));
+
+        auto array = Array::New();
+        array->append(std::move(entry));
+        dict->set("key" + std::to_string(n), std::move(array));
+    }
+    return dict;
+}
+
+template<typename T>
+static void
+ExpectStreamed(Dictionary const *dict, T const &format)
+{
+    auto serialized = T::Serialize(dict, format);
+    ASSERT_NE(nullptr, serialized.first);
+
+    RecordingSink sink;
+    auto streamed = T::Serialize(dict, format, &sink);
+    EXPECT_TRUE(streamed.first);
+    EXPECT_EQ(*serialized.first, sink.contents());
+
+    /* Output is passed on in pieces, not all at once. */
+    EXPECT_GT(sink.pieces.size(), 1);
+    for (size_t size : sink.pieces) {
+        EXPECT_LE(size, 64 * 1024);
+    }
+}
+
+TEST(Sink, Formats)
+{
+    auto dict = CreateLarge();
+    ExpectStreamed(dict.get(), XML::Create(Encoding::UTF8));
+    ExpectStreamed(dict.get(), ASCII::Create(false, Encoding::UTF8));
+    ExpectStreamed(dict.get(), JSON::Create());
+    ExpectStreamed(dict.get(), Binary::Create());
+}
+
+TEST(Sink, Encoding)
+{
+    /* Other encodings are converted before writing. */
+    auto dict = Dictionary::New();
+    dict->set("key", String::New("été"));
+
+    auto format = XML::Create(Encoding::UTF16LE);
+    BufferSink sink;
+    EXPECT_TRUE(XML::Serialize(dict.get(), format, &sink).first);
+    EXPECT_EQ(*XML::Serialize(dict.get(), format).first, sink.contents());
+}
+
+TEST(Sink, Failure)
+{
+    auto dict = CreateLarge();
+
+    RecordingSink xml;
+    xml.limit = 1;
+    auto result = XML::Serialize(dict.get(), XML::Create(Encoding::UTF8), &xml);
+    EXPECT_FALSE(result.first);
+    EXPECT_EQ(1, xml.pieces.size());
+
+    RecordingSink binary;
+    binary.limit = 1;
+    result = Binary::Serialize(dict.get(), Binary::Create(), &binary);
+    EXPECT_FALSE(result.first);
+    EXPECT_NE("", result.second);
+}
+
+TEST(Sink, File)
+{
+    char path[] = "/tmp/test_Sink.XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+
+    auto dict = CreateLarge();
+    FileSink sink = FileSink(fd);
+    EXPECT_TRUE(Binary::Serialize(dict.get(), Binary::Create(), &sink).first);
+    ::close(fd);
+
+    std::vector<uint8_t> contents;
+    FILE *file = ::fopen(path, "rb");
+    ASSERT_NE(nullptr, file);
+    uint8_t buffer[4096];
+    size_t size;
+    while ((size = ::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + size);
+    }
+    ::fclose(file);
+    ::unlink(path);
+
+    auto deserialized = Binary::Deserialize(contents, Binary::Create());
+    ASSERT_NE(nullptr, deserialized.first);
+    EXPECT_TRUE(deserialized.first->equals(dict.get()));
+}
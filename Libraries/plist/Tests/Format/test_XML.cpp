@@ -9,14 +9,18 @@
 
 #include <gtest/gtest.h>
 #include <plist/Format/XML.h>
+#include <plist/Format/XMLParser.h>
 #include <plist/Objects.h>
 
 using plist::Format::XML;
+using plist::Format::XMLParser;
+using plist::Format::Builder;
 using plist::Format::Encoding;
 using plist::String;
 using plist::Boolean;
 using plist::Integer;
 using plist::Real;
+using plist::Data;
 using plist::UID;
 using plist::Dictionary;
 using plist::Array;
@@ -70,3 +74,85 @@ TEST(XML, UID)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+/*
+ * Parse both directly and through libxml2.
+ */
+static std::pair<std::unique_ptr<plist::Object>, std::unique_ptr<plist::Object>>
+ParseBoth(std::vector<uint8_t> const &contents)
+{
+    Builder direct;
+    XMLParser directParser(&direct);
+    bool directSuccess = directParser.parse(contents);
+
+    Builder libxml;
+    XMLParser libxmlParser(&libxml);
+    libxmlParser.setLibXML(true);
+    bool libxmlSuccess = libxmlParser.parse(contents);
+
+    return std::make_pair(
+        direct.finish(std::make_pair(directSuccess, directParser.error())).first,
+        libxml.finish(std::make_pair(libxmlSuccess, libxmlParser.error())).first);
+}
+
+TEST(XML, Text)
+{
+    auto contents = Contents(std::string(XMLHeader) +
+        "<array>\n"
+        "\t<string>a &amp; b &#x41;&#66; &lt;&gt;&quot;&apos; &#x1F643;</string>\n"
+        "\t<string><![CDATA[<x> & <y>]]></string>\n"
+        "\t<string>one<!-- comment -->two<?pi?>three</string>\n"
+        "\t<string>  </string>\n"
+        "\t<string>line\r\nbreak</string>\n"
+        "\t<string/>\n"
+        "\t<data>\n\tSGVs\n\tbG8=\n\t</data>\n"
+        "\t<integer> 5 </integer>\n"
+        "</array>\n" + std::string(XMLFooter));
+
+    auto array = Array::New();
+    array->append(String::New("a & b AB <>\"' \U0001F643"));
+    array->append(String::New("<x> & <y>"));
+    array->append(String::New("onetwothree"));
+    array->append(String::New("  "));
+    array->append(String::New("line\nbreak"));
+    array->append(String::New(""));
+    array->append(Data::New(std::vector<uint8_t>({ 'H', 'e', 'l', 'l', 'o' })));
+    array->append(Integer::New(5));
+
+    auto both = ParseBoth(contents);
+    ASSERT_NE(both.first, nullptr);
+    ASSERT_NE(both.second, nullptr);
+    EXPECT_TRUE(both.first->equals(array.get()));
+    EXPECT_TRUE(both.second->equals(array.get()));
+}
+
+TEST(XML, Fallback)
+{
+    /* Declaring entities needs libxml2. */
+    auto contents = Contents(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<!DOCTYPE plist [ <!ENTITY name \"value\"> ]>\n"
+        "<plist version=\"1.0\"><string>&name;</string></plist>\n");
+
+    auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(String::New("value").get()));
+}
+
+TEST(XML, Errors)
+{
+    for (std::string const &body : std::vector<std::string>({
+        "<string>a</strin>",
+        "<string>&undefined;</string>",
+        "<string>&#xD800;</string>",
+        "<string>unterminated",
+        "<string>a</string><string>b</string>",
+        "<dict><string>a</string></dict>",
+        "<string><![CDATA[a</string>",
+    })) {
+        auto contents = Contents(std::string(XMLHeader) + body + std::string(XMLFooter));
+        auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+        EXPECT_EQ(deserialize.first, nullptr) << body;
+        EXPECT_NE(deserialize.second, "") << body;
+    }
+}
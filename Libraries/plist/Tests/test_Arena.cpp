@@ -0,0 +1,165 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Arena.h>
+#include <plist/Objects.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
+
+using plist::Arena;
+using plist::Dictionary;
+using plist::String;
+using plist::Array;
+using plist::Format::Any;
+using plist::Format::Binary;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(Arena, Allocate)
+{
+    Arena arena(64);
+    void *small = arena.allocate(1);
+    void *aligned = arena.allocate(1);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % alignof(std::max_align_t));
+    EXPECT_NE(small, aligned);
+
+    /* Large allocations get their own block. */
+    void *large = arena.allocate(1024);
+    EXPECT_NE(nullptr, large);
+    EXPECT_GE(arena.size(), 1026);
+}
+
+TEST(Arena, Deserialize)
+{
+    std::vector<uint8_t> contents = Contents("{ a = 1; b = ( x, y, { c = \"z\"; } ); d = <0102>; }");
+
+    auto heap = Any::Deserialize(contents);
+    ASSERT_NE(nullptr, heap.first);
+
+    Arena arena;
+    auto result = Any::Deserialize(contents, &arena);
+    ASSERT_NE(nullptr, result.first);
+    EXPECT_GT(arena.size(), 0);
+    EXPECT_TRUE(result.first->equals(heap.first.get()));
+
+    /* Objects created after deserializing are allocated normally. */
+    EXPECT_EQ(nullptr, Arena::Scope::Current());
+    Dictionary *root = plist::CastTo<Dictionary>(result.first.get());
+    ASSERT_NE(nullptr, root);
+    size_t size = arena.size();
+    root->set("e", String::New("heap"));
+    root->value<Array>("b")->append(String::New("w"));
+    EXPECT_EQ(size, arena.size());
+
+    /* Arena objects can be replaced and removed. */
+    root->set("a", String::New("2"));
+    root->remove("d");
+    EXPECT_EQ("2", root->value<String>("a")->value());
+}
+
+TEST(Arena, Scope)
+{
+    Arena outer;
+    Arena inner;
+
+    {
+        Arena::Scope outerScope(&outer);
+        EXPECT_EQ(&outer, Arena::Scope::Current());
+        {
+            Arena::Scope innerScope(&inner);
+            EXPECT_EQ(&inner, Arena::Scope::Current());
+            {
+                Arena::Scope heapScope(nullptr);
+                EXPECT_EQ(nullptr, Arena::Scope::Current());
+            }
+            auto string = String::New("inner");
+            EXPECT_GT(inner.size(), 0);
+        }
+        EXPECT_EQ(&outer, Arena::Scope::Current());
+        auto string = String::New("outer");
+        EXPECT_GT(outer.size(), 0);
+    }
+
+    EXPECT_EQ(nullptr, Arena::Scope::Current());
+}
+
+TEST(Arena, BorrowASCII)
+{
+    std::vector<uint8_t> contents = Contents("{ plain = value; \"quoted key\" = \"quoted value\"; escaped = \"a\\nb\"; }");
+
+    Arena arena;
+    auto result = Any::Deserialize(contents, &arena);
+    ASSERT_NE(nullptr, result.first);
+    Dictionary *root = plist::CastTo<Dictionary>(result.first.get());
+    ASSERT_NE(nullptr, root);
+
+    /* Strings without escapes borrow from the input. */
+    String const *plain = root->value<String>("plain");
+    ASSERT_NE(nullptr, plain);
+    EXPECT_TRUE(plain->borrowed());
+    EXPECT_EQ("value", std::string(plain->data(), plain->size()));
+    EXPECT_EQ("value", plain->value());
+
+    String const *quoted = root->value<String>("quoted key");
+    ASSERT_NE(nullptr, quoted);
+    EXPECT_TRUE(quoted->borrowed());
+    EXPECT_EQ("quoted value", quoted->value());
+
+    String const *escaped = root->value<String>("escaped");
+    ASSERT_NE(nullptr, escaped);
+    EXPECT_FALSE(escaped->borrowed());
+    EXPECT_EQ("a\nb", escaped->value());
+
+    /* Copies outside the arena own their characters. */
+    auto copy = plain->copy();
+    EXPECT_FALSE(copy->borrowed());
+    EXPECT_TRUE(copy->equals(plain));
+
+    /* Without an arena, nothing is borrowed. */
+    auto heap = Any::Deserialize(contents);
+    ASSERT_NE(nullptr, heap.first);
+    EXPECT_FALSE(plist::CastTo<Dictionary>(heap.first.get())->value<String>("plain")->borrowed());
+    EXPECT_TRUE(heap.first->equals(result.first.get()));
+}
+
+TEST(Arena, BorrowBinary)
+{
+    auto dict = Dictionary::New();
+    dict->set("key", String::New("value"));
+    dict->set("unicode", String::New("\xc3\xa9"));
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(nullptr, serialize.first);
+
+    Arena arena;
+    auto result = Binary::Deserialize(*serialize.first, Binary::Create(), &arena);
+    ASSERT_NE(nullptr, result.first);
+    Dictionary *root = plist::CastTo<Dictionary>(result.first.get());
+    ASSERT_NE(nullptr, root);
+    EXPECT_TRUE(root->equals(dict.get()));
+
+    String const *value = root->value<String>("key");
+    ASSERT_NE(nullptr, value);
+    EXPECT_TRUE(value->borrowed());
+    EXPECT_EQ("value", value->value());
+
+    /* Non-ASCII strings are converted, so aren't borrowed. */
+    String const *unicode = root->value<String>("unicode");
+    ASSERT_NE(nullptr, unicode);
+    EXPECT_FALSE(unicode->borrowed());
+
+    /* Setting a borrowed string makes it owned. */
+    root->value<String>("key")->setValue("changed");
+    EXPECT_FALSE(value->borrowed());
+    EXPECT_EQ("changed", value->value());
+}
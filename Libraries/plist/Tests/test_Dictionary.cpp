@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Objects.h>
+
+using plist::Dictionary;
+using plist::String;
+using plist::Integer;
+
+TEST(Dictionary, Order)
+{
+    auto d = Dictionary::New();
+    d->set("b", String::New("1"));
+    d->set("a", String::New("2"));
+    d->set("c", String::New("3"));
+
+    ASSERT_EQ(3, d->count());
+    EXPECT_EQ("b", d->key(0));
+    EXPECT_EQ("a", d->key(1));
+    EXPECT_EQ("c", d->key(2));
+    EXPECT_EQ("2", d->value<String>("a")->value());
+    EXPECT_EQ("2", d->value<String>(1)->value());
+
+    std::vector<std::string> keys;
+    for (std::string const &key : *d) {
+        keys.push_back(key);
+    }
+    EXPECT_EQ(std::vector<std::string>({ "b", "a", "c" }), keys);
+}
+
+TEST(Dictionary, Replace)
+{
+    auto d = Dictionary::New();
+    d->set("a", String::New("1"));
+    d->set("b", String::New("2"));
+    d->set("a", String::New("3"));
+
+    /* Replacing a value moves its key to the end. */
+    ASSERT_EQ(2, d->count());
+    EXPECT_EQ("b", d->key(0));
+    EXPECT_EQ("a", d->key(1));
+    EXPECT_EQ("3", d->value<String>("a")->value());
+
+    d->remove("b");
+    d->remove("missing");
+    ASSERT_EQ(1, d->count());
+    EXPECT_EQ(nullptr, d->value("b"));
+    EXPECT_EQ("3", d->value<String>("a")->value());
+}
+
+TEST(Dictionary, Large)
+{
+    auto d = Dictionary::New();
+    for (int n = 0; n < 100; ++n) {
+        d->set("key" + std::to_string(n), Integer::New(n));
+    }
+    ASSERT_EQ(100, d->count());
+
+    for (int n = 0; n < 100; n += 2) {
+        d->remove("key" + std::to_string(n));
+    }
+    d->set("key1", Integer::New(1000));
+
+    ASSERT_EQ(50, d->count());
+    for (int n = 0; n < 100; ++n) {
+        Integer const *value = d->value<Integer>("key" + std::to_string(n));
+        if (n % 2 == 0) {
+            EXPECT_EQ(nullptr, value);
+        } else {
+            ASSERT_NE(nullptr, value);
+            EXPECT_EQ(n == 1 ? 1000 : n, value->value());
+        }
+    }
+    EXPECT_EQ("key3", d->key(0));
+    EXPECT_EQ("key1", d->key(49));
+}
+
+TEST(Dictionary, Merge)
+{
+    auto d1 = Dictionary::New();
+    d1->set("a", String::New("1"));
+    d1->set("b", String::New("2"));
+
+    auto d2 = Dictionary::New();
+    d2->set("b", String::New("3"));
+    d2->set("c", String::New("4"));
+
+    d1->merge(d2.get(), false);
+    ASSERT_EQ(3, d1->count());
+    EXPECT_EQ("2", d1->value<String>("b")->value());
+    EXPECT_EQ("4", d1->value<String>("c")->value());
+
+    d1->merge(d2.get(), true);
+    EXPECT_EQ("3", d1->value<String>("b")->value());
+
+    auto copy = d1->copy();
+    EXPECT_TRUE(copy->equals(d1.get()));
+}
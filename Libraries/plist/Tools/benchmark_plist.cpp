@@ -0,0 +1,344 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Arena.h>
+#include <plist/Objects.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/BinaryDocument.h>
+#include <plist/Format/XML.h>
+#include <plist/Format/XMLParser.h>
+#include <plist/Format/Encoding.h>
+#include <plist/Format/ASCIIPListLexer.h>
+#include <plist/Format/ABPCoder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+using plist::Arena;
+using plist::Array;
+using plist::Dictionary;
+using plist::Object;
+using plist::String;
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::BinaryDocument;
+using plist::Format::Builder;
+using plist::Format::XML;
+using plist::Format::XMLParser;
+using plist::Format::Encoding;
+
+/*
+ * Creates a property list shaped like a large project file: an objects
+ * dictionary of file references, build files and groups, keyed by IDs.
+ */
+static std::unique_ptr<Dictionary>
+CreateProject(int files)
+{
+    auto objects = Dictionary::New();
+    auto children = Array::New();
+
+    for (int n = 0; n < files; ++n) {
+        char fileID[25];
+        char buildID[25];
+        snprintf(fileID, sizeof(fileID), "%024X", n * 2);
+        snprintf(buildID, sizeof(buildID), "%024X", n * 2 + 1);
+
+        auto file = Dictionary::New();
+        file->set("isa", String::New("PBXFileReference"));
+        file->set("fileEncoding", String::New("4"));
+        file->set("lastKnownFileType", String::New("sourcecode.c.objc"));
+        file->set("path", String::New("Source" + std::to_string(n) + ".m"));
+        file->set("sourceTree", String::New("<group>"));
+        objects->set(fileID, std::move(file));
+
+        auto settings = Dictionary::New();
+        auto flags = Array::New();
+        flags->append(String::New("-fno-objc-arc"));
+        flags->append(String::New("-DSOURCE=\"" + std::to_string(n) + "\""));
+        settings->set("COMPILER_FLAGS", std::move(flags));
+
+        auto build = Dictionary::New();
+        build->set("isa", String::New("PBXBuildFile"));
+        build->set("fileRef", String::New(fileID));
+        build->set("settings", std::move(settings));
+        objects->set(buildID, std::move(build));
+
+        children->append(String::New(fileID));
+    }
+
+    auto group = Dictionary::New();
+    group->set("isa", String::New("PBXGroup"));
+    group->set("children", std::move(children));
+    group->set("name", String::New("Sources"));
+    group->set("sourceTree", String::New("<group>"));
+    objects->set("GROUP", std::move(group));
+
+    auto root = Dictionary::New();
+    root->set("archiveVersion", String::New("1"));
+    root->set("classes", Dictionary::New());
+    root->set("objectVersion", String::New("46"));
+    root->set("objects", std::move(objects));
+    root->set("rootObject", String::New("GROUP"));
+    return root;
+}
+
+static double
+Measure(std::function<void()> const &function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+static size_t
+Lex(std::vector<uint8_t> const &contents, bool vectorized)
+{
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleASCII);
+    lexer.vectorized = vectorized;
+
+    size_t tokens = 0;
+    while (ASCIIPListLexerReadToken(&lexer) >= 0) {
+        tokens++;
+    }
+    return tokens;
+}
+
+/*
+ * Writes a binary property list through the stream writer, which seeks and
+ * writes each object separately, for comparison with the buffer writer.
+ */
+struct StreamWriter {
+    std::vector<uint8_t> contents;
+    off_t                offset;
+};
+
+static off_t
+StreamSeek(void *opaque, off_t offset, int whence)
+{
+    auto self = reinterpret_cast<StreamWriter *>(opaque);
+
+    switch (whence) {
+        case SEEK_SET:
+            self->offset = offset;
+            break;
+        case SEEK_CUR:
+            self->offset += offset;
+            break;
+        case SEEK_END:
+            self->offset = self->contents.size() + offset;
+            break;
+    }
+
+    return (static_cast<size_t>(self->offset) > self->contents.size() ? -1 : self->offset);
+}
+
+static ssize_t
+StreamWrite(void *opaque, void const *buffer, size_t size)
+{
+    auto self = reinterpret_cast<StreamWriter *>(opaque);
+
+    if (self->offset + size > self->contents.size()) {
+        self->contents.resize(self->offset + size);
+    }
+    ::memcpy(self->contents.data() + self->offset, buffer, size);
+
+    self->offset += size;
+    return size;
+}
+
+static bool
+StreamProcess(void *opaque, Object const **object)
+{
+    return true;
+}
+
+static size_t
+StreamSerialize(Object const *object)
+{
+    StreamWriter writer;
+    writer.offset = 0;
+
+    ABPStreamCallBacks streamCallBacks;
+    streamCallBacks.version = 0;
+    streamCallBacks.opaque  = &writer;
+    streamCallBacks.write   = &StreamWrite;
+    streamCallBacks.seek    = &StreamSeek;
+    streamCallBacks.close   = nullptr;
+    streamCallBacks.read    = nullptr;
+
+    ABPProcessCallBacks processCallBacks;
+    processCallBacks.version = 0;
+    processCallBacks.opaque  = nullptr;
+    processCallBacks.process = &StreamProcess;
+
+    ABPContext context;
+    if (!ABPWriterInit(&context, &streamCallBacks, &processCallBacks) ||
+        !ABPWriterOpen(&context) ||
+        !ABPWriteTopLevelObject(&context, object) ||
+        !ABPWriterClose(&context)) {
+        return 0;
+    }
+
+    return writer.contents.size();
+}
+
+static void
+Report(char const *name, size_t bytes, int iterations, double milliseconds)
+{
+    double each = milliseconds / iterations;
+    fprintf(stdout, "%s: %.3f ms each (%.1f MB/s)\n", name, each, (bytes / (1024.0 * 1024.0)) / (each / 1000.0));
+}
+
+int
+main(int argc, char **argv)
+{
+    /*
+     * Benchmark either a given property list or a generated project.
+     */
+    std::vector<uint8_t> contents;
+    int iterations = 5;
+    if (argc > 1 && std::atoi(argv[1]) == 0) {
+        std::ifstream file(argv[1], std::ios::binary);
+        contents = std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (contents.empty()) {
+            fprintf(stderr, "error: couldn't read %s\n", argv[1]);
+            return -1;
+        }
+    } else {
+        int files = (argc > 1 ? std::atoi(argv[1]) : 100000);
+        if (files <= 0) {
+            fprintf(stderr, "usage: %s [files | path]\n", argv[0]);
+            return -1;
+        }
+
+        auto project = CreateProject(files);
+        auto serialize = ASCII::Serialize(project.get(), ASCII::Create(false, Encoding::UTF8));
+        contents = std::move(*serialize.first);
+    }
+
+    fprintf(stdout, "input: %.1f MB\n", contents.size() / (1024.0 * 1024.0));
+
+    std::unique_ptr<ASCII> format = ASCII::Identify(contents);
+    if (format == nullptr) {
+        fprintf(stderr, "error: not an ASCII property list\n");
+        return -1;
+    }
+
+    size_t tokens = 0;
+    double scalar = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            tokens = Lex(contents, false);
+        }
+    });
+    Report("ascii lex (scalar)", contents.size(), iterations, scalar);
+
+    double vectorized = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            if (Lex(contents, true) != tokens) {
+                fprintf(stderr, "error: vectorized lexer found different tokens\n");
+            }
+        }
+    });
+    Report("ascii lex (vectorized)", contents.size(), iterations, vectorized);
+
+    double heap = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            auto deserialize = ASCII::Deserialize(contents, *format);
+        }
+    });
+    Report("ascii parse and free", contents.size(), iterations, heap);
+
+    size_t arenaSize = 0;
+    double arena = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            Arena arena;
+            auto deserialize = ASCII::Deserialize(contents, *format, &arena);
+            arenaSize = arena.size();
+        }
+    });
+    Report("ascii parse and free (arena)", contents.size(), iterations, arena);
+    fprintf(stdout, "arena: %.1f MB\n", arenaSize / (1024.0 * 1024.0));
+
+    /*
+     * Look up one value in a binary property list, either by reading the
+     * whole file or by only decoding the objects on the way to the value.
+     */
+    auto object = ASCII::Deserialize(contents, *format);
+    auto binary = Binary::Serialize(object.first.get(), Binary::Create());
+    if (binary.first == nullptr) {
+        fprintf(stderr, "error: %s\n", binary.second.c_str());
+        return -1;
+    }
+
+    size_t streamSize = 0;
+    double stream = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            streamSize = StreamSerialize(object.first.get());
+        }
+    });
+    Report("binary write (stream)", streamSize, iterations, stream);
+
+    double buffer = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            auto serialize = Binary::Serialize(object.first.get(), Binary::Create());
+        }
+    });
+    Report("binary write", binary.first->size(), iterations, buffer);
+    fprintf(stdout, "binary: %.1f MB, %.1f MB without uniquing\n", binary.first->size() / (1024.0 * 1024.0), streamSize / (1024.0 * 1024.0));
+
+    double full = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            auto deserialize = Binary::Deserialize(*binary.first, Binary::Create());
+            if (Dictionary const *root = plist::CastTo<Dictionary>(deserialize.first.get())) {
+                root->value("rootObject");
+            }
+        }
+    });
+    Report("binary lookup (deserialize)", binary.first->size(), iterations, full);
+
+    auto document = BinaryDocument::Create(*binary.first);
+    double lazy = Measure([&] {
+        for (int n = 0; n < iterations; ++n) {
+            document.first->root().find({ "rootObject" }).object();
+        }
+    });
+    Report("binary lookup (lazy)", binary.first->size(), iterations, lazy);
+
+    /*
+     * Parse an XML property list directly, and through libxml2.
+     */
+    auto xml = XML::Serialize(object.first.get(), XML::Create(Encoding::UTF8));
+    if (xml.first == nullptr) {
+        fprintf(stderr, "error: %s\n", xml.second.c_str());
+        return -1;
+    }
+
+    for (bool libxml : { true, false }) {
+        double parse = Measure([&] {
+            for (int n = 0; n < iterations; ++n) {
+                Builder builder;
+                XMLParser parser(&builder);
+                parser.setLibXML(libxml);
+                if (!parser.parse(*xml.first)) {
+                    fprintf(stderr, "error: %s\n", parser.error().c_str());
+                }
+            }
+        });
+        Report(libxml ? "xml parse (libxml2)" : "xml parse", xml.first->size(), iterations, parse);
+    }
+
+    return 0;
+}
@@ -19,8 +19,10 @@
 #include <plist/Format/Any.h>
 #include <plist/Format/ASCII.h>
 #include <plist/Format/Binary.h>
+#include <plist/Format/BinaryDocument.h>
 #include <plist/Format/Encoding.h>
 #include <plist/Format/JSON.h>
+#include <plist/Format/Sink.h>
 #include <plist/Format/XML.h>
 #include <libutil/Options.h>
 #include <libutil/DefaultFilesystem.h>
@@ -30,6 +32,7 @@
 #include <process/Context.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <iterator>
 #include <iostream>
 
@@ -477,21 +480,89 @@ Read(Filesystem const *filesystem, std::string const &path = "-")
     return std::make_pair(true, std::move(contents));
 }
 
-static bool
-Write(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path = "-")
-{
-    if (path == "-") {
-        /* - means write to stdout. */
-        std::copy(contents.begin(), contents.end(), std::ostream_iterator<char>(std::cout));
-    } else {
-        /* Read from file. */
-        if (!filesystem->write(contents, path)) {
+/*
+ * Writes output as it's serialized: to stdout for "-", otherwise to a file
+ * opened once up front. Buffered output is only written once it's complete,
+ * so a failure part way through leaves an existing file as it was.
+ */
+class OutputSink : public plist::Format::Sink {
+private:
+    Filesystem           *_filesystem;
+    std::string           _path;
+    bool                  _buffered;
+    bool                  _failed;
+    FILE                 *_fp;
+    std::vector<uint8_t>  _contents;
+
+public:
+    OutputSink(Filesystem *filesystem, std::string const &path, bool buffered) :
+        _filesystem(filesystem),
+        _path      (path),
+        _buffered  (buffered),
+        _failed    (false),
+        _fp        (nullptr)
+    {
+        if (_path != "-" && !_buffered) {
+            _fp = std::fopen(_path.c_str(), "wb");
+            _failed = (_fp == nullptr);
+        }
+    }
+
+    ~OutputSink()
+    {
+        if (_fp != nullptr) {
+            std::fclose(_fp);
+        }
+    }
+
+private:
+    OutputSink(OutputSink const &) = delete;
+    OutputSink &operator=(OutputSink const &) = delete;
+
+public:
+    bool failed() const
+    { return _failed; }
+
+public:
+    virtual bool write(uint8_t const *data, size_t size)
+    {
+        if (_failed) {
             return false;
         }
+
+        if (_path == "-") {
+            /* - means write to stdout. */
+            std::cout.write(reinterpret_cast<char const *>(data), size);
+            _failed = !std::cout;
+        } else if (_buffered) {
+            _contents.insert(_contents.end(), data, data + size);
+        } else if (size > 0) {
+            _failed = (std::fwrite(data, size, 1, _fp) != 1);
+        }
+
+        return !_failed;
     }
 
-    return true;
-}
+    bool finish()
+    {
+        if (_failed) {
+            return false;
+        }
+
+        if (_path == "-") {
+            std::cout.flush();
+            _failed = !std::cout;
+        } else if (_buffered) {
+            _failed = !_filesystem->write(_contents, _path);
+        } else {
+            /* Closing flushes what's left, which can fail too. */
+            _failed = (std::fclose(_fp) != 0);
+            _fp = nullptr;
+        }
+
+        return !_failed;
+    }
+};
 
 static bool
 Lint(Options const &options, std::string const &file)
@@ -509,15 +580,10 @@ Print(Filesystem *filesystem, Options const &options, std::unique_ptr<plist::Obj
 {
     /* Convert to ASCII. */
     plist::Format::ASCII out = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
-    auto serialize = plist::Format::ASCII::Serialize(object.get(), out);
-    if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
-        return false;
-    }
-
-    /* Print. */
-    if (!Write(filesystem, *serialize.first)) {
-        fprintf(stderr, "error: unable to write\n");
+    OutputSink sink(filesystem, "-", false);
+    auto serialize = plist::Format::ASCII::Serialize(object.get(), out, &sink);
+    if (!serialize.first || !sink.finish()) {
+        fprintf(stderr, "error: %s\n", sink.failed() ? "unable to write" : serialize.second.c_str());
         return false;
     }
 
@@ -599,6 +665,34 @@ PerformAdjustment(plist::Object *object, plist::Object **rootObject, std::string
     }
 }
 
+static bool
+Output(Filesystem *filesystem, Options const &options, std::string const &file, plist::Object const *writeObject, Options::Format const &inputFormat)
+{
+    std::string output = OutputPath(options, file);
+
+    /* Overwriting the input waits until all of the output is serialized. */
+    OutputSink sink(filesystem, output, output == file);
+
+    /* Convert to desired format. */
+    std::pair<bool, std::string> serialize;
+
+    Options::Format outputFormat = options.convert().value_or(inputFormat);
+    if (ext::optional<plist::Format::Any> any = outputFormat.any()) {
+        serialize = plist::Format::Any::Serialize(writeObject, *any, &sink);
+    } else if (ext::optional<plist::Format::JSON> json = outputFormat.json()) {
+        serialize = plist::Format::JSON::Serialize(writeObject, *json, &sink);
+    } else {
+        abort();
+    }
+
+    if (!serialize.first || !sink.finish()) {
+        fprintf(stderr, "error: %s\n", sink.failed() ? "unable to write" : serialize.second.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 static bool
 Modify(Filesystem *filesystem, Options const &options, std::string const &file, std::unique_ptr<plist::Object> object, Options::Format const &inputFormat)
 {
@@ -638,31 +732,81 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
         } while (end != std::string::npos);
     }
 
-    /* Convert to desired format. */
-    std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> serialize;
+    return Output(filesystem, options, file, writeObject, inputFormat);
+}
 
-    Options::Format outputFormat = options.convert().value_or(inputFormat);
-    if (ext::optional<plist::Format::Any> any = outputFormat.any()) {
-        serialize = plist::Format::Any::Serialize(writeObject, *any);
-    } else if (ext::optional<plist::Format::JSON> json = outputFormat.json()) {
-        serialize = plist::Format::JSON::Serialize(writeObject, *json);
-    } else {
-        abort();
-    }
+static std::vector<std::string>
+KeyPath(std::string const &keyPath)
+{
+    std::vector<std::string> path;
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    do {
+        end = keyPath.find('.', start);
+        path.push_back(keyPath.substr(start, end != std::string::npos ? end - start : std::string::npos));
+        start = end + 1;
+    } while (end != std::string::npos);
+
+    return path;
+}
 
-    if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
+static bool
+Extracted(Filesystem *filesystem, Options const &options, std::string const &file, std::pair<std::unique_ptr<plist::Object>, std::string> const &extract, Options::Format const &format)
+{
+    if (extract.first == nullptr) {
+        if (!extract.second.empty()) {
+            fprintf(stderr, "error: %s\n", extract.second.c_str());
+        } else {
+            fprintf(stderr, "error: invalid key path\n");
+        }
         return false;
     }
 
-    /* Write to output. */
-    std::string output = OutputPath(options, file);
-    if (!Write(filesystem, *serialize.first, output)) {
-        fprintf(stderr, "error: unable to write\n");
-        return false;
+    return Output(filesystem, options, file, extract.first.get(), format);
+}
+
+/*
+ * Extract a single value, reading the input only as far as the value.
+ */
+static bool
+Extract(Filesystem *filesystem, Options const &options, std::string const &file, std::vector<uint8_t> const &contents, Options::Adjustment const &adjustment)
+{
+    std::vector<std::string> path = KeyPath(adjustment.path());
+
+    ext::optional<Options::Format> format;
+    std::pair<std::unique_ptr<plist::Object>, std::string> extract;
+
+    if (auto any = plist::Format::Any::Identify(contents)) {
+        extract = plist::Format::Any::Extract(contents, *any, path);
+        format = Options::Format(*any);
+    } else {
+        auto json = plist::Format::JSON::Create();
+        extract = plist::Format::JSON::Extract(contents, json, path);
+        format = Options::Format(json);
     }
 
-    return true;
+    return Extracted(filesystem, options, file, extract, *format);
+}
+
+/*
+ * Extract a single value from a mapped binary property list, decoding
+ * only the objects along the key path.
+ */
+static bool
+Extract(Filesystem *filesystem, Options const &options, std::string const &file, plist::Format::BinaryDocument const &document, Options::Adjustment const &adjustment)
+{
+    std::pair<std::unique_ptr<plist::Object>, std::string> extract;
+
+    plist::Format::BinaryDocument::Value value = document.root().find(KeyPath(adjustment.path()));
+    if (value.valid()) {
+        extract.first = value.object();
+    }
+    if (extract.first == nullptr) {
+        extract.second = document.error();
+    }
+
+    Options::Format format = Options::Format(plist::Format::Any::Create(plist::Format::Binary::Create()));
+    return Extracted(filesystem, options, file, extract, format);
 }
 
 int
@@ -700,6 +844,17 @@ main(int argc, char **argv)
 
         /* Actions applied to each input file separately. */
         for (std::string const &file : options.inputs()) {
+            bool extract = (options.adjustments().size() == 1 && options.adjustments().front().type() == Options::Adjustment::Type::Extract);
+
+            /* Binary files are mapped for extracting, rather than read. */
+            if (extract && file != "-") {
+                auto document = plist::Format::BinaryDocument::Open(file);
+                if (document.first != nullptr) {
+                    success &= Extract(&filesystem, options, file, *document.first, options.adjustments().front());
+                    continue;
+                }
+            }
+
             std::pair<bool, std::vector<uint8_t>> result = Read(&filesystem, file);
             if (!result.first) {
                 fprintf(stderr, "error: unable to read %s\n", file.c_str());
@@ -707,6 +862,12 @@ main(int argc, char **argv)
                 continue;
             }
 
+            /* Extracting a value doesn't need the rest of the input. */
+            if (extract) {
+                success &= Extract(&filesystem, options, file, result.second, options.adjustments().front());
+                continue;
+            }
+
             /* Deserialize input, storing input format. */
             ext::optional<Options::Format> format;
             std::unique_ptr<plist::Object> root;
@@ -49,6 +49,9 @@ private:
     ext::optional<std::string> _formatter;
     ext::optional<std::string> _executor;
     ext::optional<bool>        _generate;
+    ext::optional<std::string> _actionCache;
+    ext::optional<std::string> _trace;
+    ext::optional<bool>        _statistics;
 
 private:
     ext::optional<bool>        _parallelizeTargets;
@@ -158,12 +161,26 @@ public:
     /* Extension. */
     bool generate() const
     { return _generate.value_or(false); }
+    /* Extension. */
+    ext::optional<std::string> const &actionCache() const
+    { return _actionCache; }
+    /* Extension. */
+    ext::optional<std::string> const &trace() const
+    { return _trace; }
+    /* Extension. */
+    bool statistics() const
+    { return _statistics.value_or(false); }
 
 public:
     bool parallelizeTargets() const
     { return _parallelizeTargets.value_or(false); }
     ext::optional<int> jobs() const
     { return _jobs; }
+    /*
+     * The number of jobs to run at once: as given with -jobs, or by default
+     * one for each available core. Null if -jobs is not a positive number.
+     */
+    ext::optional<size_t> resolvedJobs() const;
     bool dryRun() const
     { return _dryRun.value_or(false); }
     bool hideShellScriptEnvironment() const
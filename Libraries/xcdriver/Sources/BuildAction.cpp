@@ -10,20 +10,26 @@
 #include <xcdriver/BuildAction.h>
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/Tracer.h>
 #include <xcexecution/NinjaExecutor.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcformatter/BuildStatistics.h>
 #include <xcformatter/DefaultFormatter.h>
 #include <xcformatter/NullFormatter.h>
 #include <builtin/Registry.h>
 #include <libutil/Base.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
 #include <process/Context.h>
 
+#include <sys/resource.h>
 #include <unistd.h>
 
 using xcdriver::BuildAction;
 using xcdriver::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 BuildAction::
 BuildAction()
@@ -57,14 +63,18 @@ CreateExecutor(
     ext::optional<std::string> const &executor,
     std::shared_ptr<xcformatter::Formatter> const &formatter,
     bool dryRun,
-    bool generate)
+    bool generate,
+    size_t jobs,
+    bool parallelizeTargets,
+    std::shared_ptr<xcexecution::ActionCache> const &actionCache,
+    std::shared_ptr<xcexecution::Tracer> const &tracer)
 {
     if (!executor || *executor == "simple") {
         auto registry = builtin::Registry::Default();
-        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry);
+        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry, jobs, parallelizeTargets, actionCache, tracer);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     } else if (*executor == "ninja") {
-        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate);
+        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate, jobs, actionCache, tracer);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     }
 
@@ -86,10 +96,6 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: destination option not implemented\n");
     }
 
-    if (options.parallelizeTargets() || options.jobs()) {
-        fprintf(stderr, "warning: job control option not implemented\n");
-    }
-
     if (options.enableAddressSanitizer() || options.enableThreadSanitizer() || options.enableCodeCoverage()) {
         fprintf(stderr, "warning: build mode option not implemented\n");
     }
@@ -115,6 +121,22 @@ VerifySupportedOptions(Options const &options)
     return true;
 }
 
+/*
+ * The user and system CPU time used, in microseconds.
+ */
+static uint64_t
+CPUTime(int who)
+{
+    struct rusage usage;
+    if (getrusage(who, &usage) != 0) {
+        return 0;
+    }
+
+    uint64_t seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec;
+    uint64_t microseconds = usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    return seconds * 1000000 + microseconds;
+}
+
 int BuildAction::
 Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options)
 {
@@ -137,10 +159,37 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         return -1;
     }
 
+    /*
+     * Determine how many jobs to run at once. By default, use all available cores.
+     */
+    ext::optional<size_t> jobs = options.resolvedJobs();
+    if (!jobs) {
+        fprintf(stderr, "error: invalid number of jobs %d\n", *options.jobs());
+        return -1;
+    }
+
+    /*
+     * Use an action cache, if requested, to restore outputs of unchanged invocations.
+     */
+    std::shared_ptr<xcexecution::ActionCache> actionCache;
+    if (options.actionCache()) {
+        actionCache = xcexecution::ActionCache::Create(
+            FSUtil::ResolveRelativePath(*options.actionCache(), processContext->currentDirectory()),
+            processContext->executablePath());
+    }
+
+    /*
+     * Record how long each part of the build takes, if requested.
+     */
+    std::shared_ptr<xcexecution::Tracer> tracer;
+    if (options.trace() || options.statistics()) {
+        tracer = xcexecution::Tracer::Create();
+    }
+
     /*
      * Create the executor used to perform the build.
      */
-    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate());
+    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), *jobs, options.parallelizeTargets(), actionCache, tracer);
     if (executor == nullptr) {
         fprintf(stderr, "error: unknown executor '%s'\n", options.executor()->c_str());
         return -1;
@@ -172,7 +221,30 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
     /*
      * Perform the build!
      */
+    uint64_t processTime = CPUTime(RUSAGE_SELF);
+    uint64_t childProcessTime = CPUTime(RUSAGE_CHILDREN);
     bool success = executor->build(processContext, processLauncher, filesystem, *buildEnvironment, parameters);
+
+    /*
+     * Report where the time went, even if the build failed.
+     */
+    if (options.statistics()) {
+        xcformatter::BuildStatistics statistics = tracer->statistics(
+            CPUTime(RUSAGE_SELF) - processTime,
+            CPUTime(RUSAGE_CHILDREN) - childProcessTime);
+        xcformatter::Formatter::Print(formatter->statistics(statistics));
+    }
+
+    /*
+     * Write out the trace, even if the build failed.
+     */
+    if (options.trace()) {
+        std::string tracePath = FSUtil::ResolveRelativePath(*options.trace(), processContext->currentDirectory());
+        if (!tracer->write(filesystem, tracePath)) {
+            fprintf(stderr, "warning: failed to write trace to %s\n", tracePath.c_str());
+        }
+    }
+
     if (!success) {
         return 1;
     }
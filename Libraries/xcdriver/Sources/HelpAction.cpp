@@ -72,6 +72,18 @@ Run(process::Context const *processContext)
         "    -generate                                   "
         "specify that an execution engine based on generating another build "
         "language should regenerate\n");
+    fprintf(
+        stdout,
+        "    -actionCache PATH                           "
+        "restore outputs of unchanged build operations from a cache at PATH\n");
+    fprintf(
+        stdout,
+        "    -trace PATH                                 "
+        "write the time taken by each part of the build to PATH as a Chrome trace\n");
+    fprintf(
+        stdout,
+        "    -statistics                                 "
+        "report the critical path and where the time went after the build\n");
     fprintf(
         stdout,
         "    -project NAME                               "
@@ -125,11 +137,11 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -parallelizeTargets                         "
-        "not yet implemented\n");
+        "build independent targets in parallel\n");
     fprintf(
         stdout,
         "    -jobs NUMBER                                "
-        "not yet implemented\n");
+        "specify the maximum number of concurrent build operations\n");
     fprintf(
         stdout,
         "    -dry-run                                    "
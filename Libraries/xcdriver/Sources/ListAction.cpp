@@ -30,7 +30,7 @@ ListAction::
 }
 
 int ListAction::
-Run(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+Run(process::Context const *processContext, Filesystem *filesystem, Options const &options)
 {
     ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(processContext, filesystem);
     if (!buildEnvironment) {
@@ -9,6 +9,9 @@
 
 #include <xcdriver/Options.h>
 
+#include <algorithm>
+#include <thread>
+
 using xcdriver::Options;
 
 Options::
@@ -130,6 +133,12 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_formatter, args, it);
     } else if (arg == "-generate") {
         return libutil::Options::Current<bool>(&_generate, arg);
+    } else if (arg == "-actionCache") {
+        return libutil::Options::Next<std::string>(&_actionCache, args, it);
+    } else if (arg == "-trace") {
+        return libutil::Options::Next<std::string>(&_trace, args, it);
+    } else if (arg == "-statistics") {
+        return libutil::Options::Current<bool>(&_statistics, arg);
     } else if (!arg.empty() && arg[0] != '-') {
         if (arg.find('=') != std::string::npos) {
             if (ext::optional<pbxsetting::Setting> setting = pbxsetting::Setting::Parse(arg)) {
@@ -147,3 +156,14 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
     }
 }
 
+ext::optional<size_t> Options::
+resolvedJobs() const
+{
+    if (!_jobs) {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    } else if (*_jobs <= 0) {
+        return ext::nullopt;
+    }
+
+    return static_cast<size_t>(*_jobs);
+}
@@ -10,11 +10,13 @@
 #include <xcdriver/ShowBuildSettingsAction.h>
 #include <xcdriver/Options.h>
 #include <xcdriver/Action.h>
+#include <xcexecution/JobPool.h>
 #include <libutil/Filesystem.h>
 #include <process/Context.h>
 
 using xcdriver::ShowBuildSettingsAction;
 using xcdriver::Options;
+using xcexecution::JobPool;
 using libutil::Filesystem;
 
 ShowBuildSettingsAction::
@@ -28,7 +30,7 @@ ShowBuildSettingsAction::
 }
 
 int ShowBuildSettingsAction::
-Run(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+Run(process::Context const *processContext, Filesystem *filesystem, Options const &options)
 {
     if (!Action::VerifyBuildActions(options.actions())) {
         return -1;
@@ -64,22 +66,62 @@ Run(process::Context const *processContext, Filesystem const *filesystem, Option
         return -1;
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *targets) {
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(*buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment\n");
-            continue;
+    /*
+     * Targets don't depend on each other's settings, so compute them in
+     * parallel. Print them in order as soon as each is ready.
+     */
+    ext::optional<size_t> jobs = options.resolvedJobs();
+    if (!jobs) {
+        fprintf(stderr, "error: invalid number of jobs %d\n", *options.jobs());
+        return -1;
+    }
+
+    JobPool pool(*jobs);
+    JobPool::Group group(&pool);
+
+    std::vector<std::map<std::string, std::string>> targetValues = std::vector<std::map<std::string, std::string>>(targets->size());
+    std::vector<bool> finished = std::vector<bool>(targets->size(), false);
+    std::vector<bool> succeeded = std::vector<bool>(targets->size(), false);
+    size_t started = 0;
+    size_t printed = 0;
+
+    while (printed < targets->size()) {
+        while (started < targets->size() && group.acquire()) {
+            pbxproj::PBX::Target::shared_ptr const &target = (*targets)[started];
+            std::map<std::string, std::string> *values = &targetValues[started];
+            group.start(started, [&buildEnvironment, &buildContext, target, values] {
+                ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(*buildEnvironment, target);
+                if (!targetEnvironment) {
+                    return false;
+                }
+
+                std::unordered_map<std::string, std::string> computed = targetEnvironment->environment().computeValues(pbxsetting::Condition::Empty());
+                *values = std::map<std::string, std::string>(computed.begin(), computed.end());
+                return true;
+            });
+            started++;
         }
 
-        pbxsetting::Environment const &environment = targetEnvironment->environment();
-        std::unordered_map<std::string, std::string> values = environment.computeValues(pbxsetting::Condition::Empty());
-        std::map<std::string, std::string> orderedValues = std::map<std::string, std::string>(values.begin(), values.end());
+        for (JobPool::Group::Result const &result : group.wait(started < targets->size())) {
+            finished[result.first] = true;
+            succeeded[result.first] = result.second;
+        }
+
+        for (; printed < targets->size() && finished[printed]; ++printed) {
+            if (!succeeded[printed]) {
+                fprintf(stderr, "error: couldn't create target environment\n");
+                continue;
+            }
+
+            printf("Build settings for action %s and target %s:\n", buildContext->action().c_str(), (*targets)[printed]->name().c_str());
+            for (auto const &value : targetValues[printed]) {
+                printf("    %s = %s\n", value.first.c_str(), value.second.c_str());
+            }
+            printf("\n");
 
-        printf("Build settings for action %s and target %s:\n", buildContext->action().c_str(), target->name().c_str());
-        for (auto const &value : orderedValues) {
-            printf("    %s = %s\n", value.first.c_str(), value.second.c_str());
+            /* Free the settings once printed. */
+            targetValues[printed].clear();
         }
-        printf("\n");
     }
 
     return 0;
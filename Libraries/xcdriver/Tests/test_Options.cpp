@@ -39,3 +39,25 @@ TEST(Options, CaseSensitivity)
     auto result2 = libutil::Options::Parse<Options>(&invalid, { "-showbuildsettings" });
     EXPECT_FALSE(result2.first);
 }
+
+TEST(Options, Jobs)
+{
+    Options defaulted;
+    auto result1 = libutil::Options::Parse<Options>(&defaulted, { });
+    EXPECT_TRUE(result1.first);
+    ASSERT_TRUE(defaulted.resolvedJobs());
+    EXPECT_GE(*defaulted.resolvedJobs(), 1);
+
+    Options given;
+    auto result2 = libutil::Options::Parse<Options>(&given, { "-jobs", "3" });
+    EXPECT_TRUE(result2.first);
+    EXPECT_EQ(ext::optional<size_t>(3), given.resolvedJobs());
+
+    /* Zero or negative jobs are invalid, rather than ignored. */
+    for (std::string const &count : { "0", "-2" }) {
+        Options invalid;
+        auto result3 = libutil::Options::Parse<Options>(&invalid, { "-jobs", count });
+        EXPECT_TRUE(result3.first);
+        EXPECT_FALSE(invalid.resolvedJobs());
+    }
+}
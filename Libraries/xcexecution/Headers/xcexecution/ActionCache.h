@@ -0,0 +1,165 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ActionCache_h
+#define __xcexecution_ActionCache_h
+
+#include <pbxbuild/Tool/Invocation.h>
+#include <dependency/DependencyInfoFormat.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * A local, content-addressed cache of action outputs. Actions are keyed by a
+ * digest of how they run and the contents of their inputs; if the same action
+ * ran before with the same input contents, its outputs are restored from the
+ * cache rather than running the tool again.
+ *
+ * Inputs discovered from dependency info are not known until the action has
+ * run, so they are stored with the cached outputs and checked before those
+ * outputs are restored.
+ *
+ * Each key keeps a few results with different discovered inputs, newest first.
+ * Files in the cache are written to a temporary path and moved into place, so
+ * multiple builds can share a cache. Restored outputs are copies, so they can
+ * be modified without affecting the cache.
+ */
+class ActionCache {
+public:
+    /*
+     * What the cache needs to know about an action.
+     */
+    class Action {
+    private:
+        std::string                                                          _fingerprint;
+        ext::optional<std::string>                                           _executable;
+        std::string                                                          _workingDirectory;
+        std::vector<std::string>                                             _inputs;
+        std::vector<std::string>                                             _outputs;
+        std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _dependencyInfo;
+
+    public:
+        Action(
+            std::string const &fingerprint,
+            ext::optional<std::string> const &executable,
+            std::string const &workingDirectory,
+            std::vector<std::string> const &inputs,
+            std::vector<std::string> const &outputs,
+            std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo);
+
+    public:
+        /*
+         * Identifies the command line and environment of the action.
+         */
+        std::string const &fingerprint() const
+        { return _fingerprint; }
+
+        /*
+         * The external executable run, if any. Its size and modification
+         * time are part of the key, so updated tools are run again. Builtin
+         * tools use the cache's builtin executable instead.
+         */
+        ext::optional<std::string> const &executable() const
+        { return _executable; }
+
+        /*
+         * The directory relative paths are resolved against.
+         */
+        std::string const &workingDirectory() const
+        { return _workingDirectory; }
+
+        /*
+         * The files known to be read by the action before it runs.
+         */
+        std::vector<std::string> const &inputs() const
+        { return _inputs; }
+
+        /*
+         * The files written by the action, including its dependency info.
+         */
+        std::vector<std::string> const &outputs() const
+        { return _outputs; }
+
+        /*
+         * The dependency info written by the action.
+         */
+        std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo() const
+        { return _dependencyInfo; }
+
+    public:
+        /*
+         * Describe an invocation run with an external executable at a path,
+         * or a builtin tool if there is no path.
+         */
+        static Action
+        Create(pbxbuild::Tool::Invocation const &invocation, ext::optional<std::string> const &executablePath);
+    };
+
+private:
+    std::string                _path;
+    ext::optional<std::string> _builtinExecutable;
+
+public:
+    ActionCache(std::string const &path, ext::optional<std::string> const &builtinExecutable);
+    ~ActionCache();
+
+public:
+    /*
+     * The root directory of the cache.
+     */
+    std::string const &path() const
+    { return _path; }
+
+    /*
+     * The executable that runs builtin tools, if any.
+     */
+    ext::optional<std::string> const &builtinExecutable() const
+    { return _builtinExecutable; }
+
+public:
+    /*
+     * The key for an action with the current contents of its inputs. Actions
+     * without outputs, with inputs that can't be read, or without a known
+     * executable can't be cached.
+     */
+    ext::optional<std::string> key(libutil::Filesystem const *filesystem, Action const &action) const;
+
+    /*
+     * Restore the outputs of an action from the cache. Fails if the action
+     * is not in the cache, its discovered inputs have changed, or a cached
+     * output no longer matches its hash.
+     */
+    bool restore(libutil::Filesystem *filesystem, Action const &action, std::string const &key) const;
+
+    /*
+     * Store the outputs of an action that just ran successfully.
+     */
+    bool store(libutil::Filesystem *filesystem, Action const &action, std::string const &key) const;
+
+public:
+    /*
+     * Create a cache rooted at a path. The directory is created as needed.
+     * Builtin tools run inside the builtin executable, so its identity is
+     * used in their keys; without one, builtin tools aren't cached.
+     */
+    static std::shared_ptr<ActionCache>
+    Create(std::string const &path, ext::optional<std::string> const &builtinExecutable);
+};
+
+}
+
+#endif // !__xcexecution_ActionCache_h
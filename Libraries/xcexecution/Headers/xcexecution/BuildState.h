@@ -0,0 +1,112 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildState_h
+#define __xcexecution_BuildState_h
+
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Persistent record of the invocations that last finished successfully, used
+ * to skip invocations that are already up to date. Each invocation records a
+ * fingerprint of how it was run and the size and modification time of its
+ * inputs, including inputs discovered from its dependency info.
+ */
+class BuildState {
+public:
+    /*
+     * The size and modification time of an input, if it exists.
+     */
+    using Signature = ext::optional<std::pair<uint64_t, uint64_t>>;
+
+    /*
+     * What is known about an invocation from when it last ran.
+     */
+    class Record {
+    private:
+        std::string                                     _fingerprint;
+        std::vector<std::pair<std::string, Signature>> _inputs;
+
+    public:
+        Record(std::string const &fingerprint, std::vector<std::pair<std::string, Signature>> const &inputs);
+
+    public:
+        /*
+         * Identifies the command line, environment, inputs and outputs.
+         */
+        std::string const &fingerprint() const
+        { return _fingerprint; }
+
+        /*
+         * The inputs read by the invocation, with their signatures.
+         */
+        std::vector<std::pair<std::string, Signature>> const &inputs() const
+        { return _inputs; }
+    };
+
+private:
+    std::unordered_map<std::string, Record> _records;
+    bool                                    _modified;
+
+public:
+    BuildState();
+
+public:
+    /*
+     * If an invocation's outputs exist and nothing it depends on has changed
+     * since it was recorded. Invocations without outputs are never up to date.
+     */
+    bool upToDate(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const;
+
+    /*
+     * Record that an invocation finished successfully. Must be called after
+     * the invocation ran, so its dependency info is available.
+     */
+    void record(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation);
+
+    /*
+     * Forget an invocation, so that it will run next time.
+     */
+    void invalidate(pbxbuild::Tool::Invocation const &invocation);
+
+public:
+    /*
+     * Write the state to a path, if it has changed since it was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Load the state from a path. A missing or unreadable state is empty,
+     * so that everything will run.
+     */
+    static BuildState
+    Load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Identifies how an invocation is run: its executable, arguments,
+     * environment, inputs, outputs and auxiliary files.
+     */
+    static std::string
+    Fingerprint(pbxbuild::Tool::Invocation const &invocation);
+};
+
+}
+
+#endif // !__xcexecution_BuildState_h
@@ -11,6 +11,7 @@
 #define __xcexecution_Executor_h
 
 #include <xcformatter/Formatter.h>
+#include <xcexecution/Tracer.h>
 
 #include <memory>
 
@@ -31,20 +32,33 @@ class Parameters;
 /*
  * Abstract executor for builds. The executor is responsible for creating
  * environments for the target graph and actually executing the build, taking
- * into account the `formatter` and `dryRun` parameters passed in.
+ * into account the `formatter` and `dryRun` parameters passed in. If there is
+ * a `tracer`, the executor records how long each part of the build takes.
  */
 class Executor {
 protected:
     std::shared_ptr<xcformatter::Formatter> _formatter;
     bool                                    _dryRun;
     bool                                    _generate;
+    std::shared_ptr<Tracer>                 _tracer;
 
 protected:
-    Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<Tracer> const &tracer);
 
 public:
     virtual ~Executor();
 
+protected:
+    /*
+     * The time to start a span from, if tracing.
+     */
+    uint64_t traceStart() const;
+
+    /*
+     * Record work done on the current thread since `start`, if tracing.
+     */
+    void traceSpan(std::string const &category, std::string const &name, uint64_t start) const;
+
 public:
     /*
      * Abstract build method. Override to implement the build.
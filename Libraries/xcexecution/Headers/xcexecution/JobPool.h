@@ -0,0 +1,120 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_JobPool_h
+#define __xcexecution_JobPool_h
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xcexecution {
+
+/*
+ * A budget of jobs that can run at the same time. Work is run on background
+ * threads, but completion is reported back to the thread waiting on a job
+ * group, so non-thread-safe state (like the formatter) can stay on one thread.
+ *
+ * A single pool can be shared between multiple groups to limit the total
+ * number of jobs across all of them, for example between targets building in
+ * parallel.
+ */
+class JobPool {
+public:
+    /*
+     * A set of jobs started and waited on by a single client thread.
+     */
+    class Group {
+    public:
+        /*
+         * A finished job: its identifier and whether it succeeded.
+         */
+        using Result = std::pair<size_t, bool>;
+
+    private:
+        JobPool                                 *_pool;
+        std::unordered_map<size_t, std::thread>  _threads;
+        std::vector<Result>                      _finished;
+
+    public:
+        Group(JobPool *pool);
+        ~Group();
+
+    public:
+        /*
+         * Reserves a job slot without blocking. If this returns true, the slot
+         * must be used by `start()` or given back with `release()`. Always
+         * fails once the pool is cancelled.
+         */
+        bool acquire();
+
+        /*
+         * Gives back a slot reserved with `acquire()` that was not used.
+         */
+        void release();
+
+        /*
+         * Runs work on a background thread using a slot reserved with
+         * `acquire()`. The work returns if it succeeded.
+         */
+        void start(size_t identifier, std::function<bool()> const &work);
+
+    public:
+        /*
+         * The number of jobs in this group that have not been waited for.
+         */
+        size_t running() const
+        { return _threads.size(); }
+
+        /*
+         * Blocks until a job in this group finishes. If `slot` is set, also
+         * returns when a slot in the pool becomes available. Returns the jobs
+         * that finished, if any.
+         */
+        std::vector<Result> wait(bool slot);
+    };
+
+private:
+    size_t                  _jobs;
+    size_t                  _active;
+    bool                    _cancelled;
+    std::mutex              _mutex;
+    std::condition_variable _condition;
+
+public:
+    JobPool(size_t jobs);
+    ~JobPool();
+
+public:
+    /*
+     * The maximum number of jobs to run at once.
+     */
+    size_t jobs() const
+    { return _jobs; }
+
+public:
+    /*
+     * Stops any new jobs from starting in any group. Jobs already running
+     * finish normally. A cancelled pool stays cancelled.
+     */
+    void cancel();
+
+    /*
+     * If the pool has been cancelled.
+     */
+    bool cancelled();
+};
+
+}
+
+#endif // !__xcexecution_JobPool_h
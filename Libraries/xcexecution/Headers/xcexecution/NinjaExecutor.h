@@ -10,20 +10,31 @@
 #ifndef __xcexecution_NinjaExecutor_h
 #define __xcexecution_NinjaExecutor_h
 
+#include <xcexecution/ActionCache.h>
 #include <xcexecution/Executor.h>
 #include <pbxbuild/Tool/Invocation.h>
 #include <pbxbuild/DirectedGraph.h>
+#include <pbxspec/Manager.h>
+
+#include <functional>
 
 namespace ninja { class Writer; }
 
 namespace xcexecution {
 
 /*
- * Concrete executor that generates Ninja files.
+ * Concrete executor that generates Ninja files. Ninja files are kept for a few
+ * recently used configurations, so switching between them doesn't need to
+ * load the workspace again. If an action cache is used, each invocation runs
+ * through a tool that restores its outputs from the cache when possible.
  */
 class NinjaExecutor : public Executor {
+private:
+    size_t                       _jobs;
+    std::shared_ptr<ActionCache> _actionCache;
+
 public:
-    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, size_t jobs, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer);
     ~NinjaExecutor();
 
 public:
@@ -43,9 +54,10 @@ private:
         pbxbuild::Build::Context const &buildContext,
         pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheToolPath,
         std::string const &ninjaPath,
         std::string const &configurationHashPath,
-        std::string const &intermediatesDirectory);
+        std::string const &configurationDirectory);
     bool buildOutputDirectories(
         ninja::Writer *writer,
         std::vector<pbxbuild::Tool::Invocation> const &invocations,
@@ -54,9 +66,12 @@ private:
         process::Context const *processContext,
         libutil::Filesystem *filesystem,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheToolPath,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
-        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> const &dependencies,
+        std::vector<pbxbuild::Tool::Invocation> const &invocations,
+        std::string const &path);
 
 private:
     bool buildAuxiliaryFile(
@@ -68,12 +83,68 @@ private:
         pbxbuild::Tool::Invocation const &invocation,
         std::string const &executablePath,
         std::string const &dependencyInfoToolPath,
+        std::string const &actionCacheToolPath,
         std::string const &temporaryDirectory,
         std::string const &after);
 
+public:
+    /*
+     * Fingerprint the specification and build rule files loaded, which
+     * define the options of every tool.
+     */
+    static std::string
+    SpecificationFingerprint(libutil::Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager);
+
+    /*
+     * Fingerprint everything a target's Ninja file is generated from: the
+     * generator, specifications, project, the xcconfig files used and the
+     * files they include, the target and the settings in its environment.
+     */
+    static std::string
+    TargetFingerprint(
+        libutil::Filesystem const *filesystem,
+        std::string const &generatorFingerprint,
+        std::string const &specificationFingerprint,
+        std::string const &projectFingerprint,
+        pbxbuild::Build::Context const &buildContext,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        pbxbuild::Target::Environment const &targetEnvironment,
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> const &dependencies);
+
+    /*
+     * Write a target's Ninja file at `targetPath` with `generate`, unless it
+     * was last written from the same fingerprint, then record the fingerprint.
+     * Sets `generated` to whether the file was written.
+     */
+    static bool
+    GenerateTargetNinja(libutil::Filesystem *filesystem, std::string const &targetPath, std::string const &fingerprint, std::function<bool()> const &generate, bool *generated);
+
+public:
+    /*
+     * Record that the Ninja files in a configuration directory were just used.
+     */
+    static bool
+    MarkConfigurationUsed(libutil::Filesystem *filesystem, std::string const &configurationDirectory);
+
+    /*
+     * Remove the least recently used configurations next to a configuration
+     * directory, keeping at most `limit` in total. The configuration passed
+     * in is in use, so it is always kept.
+     */
+    static void
+    PruneConfigurations(libutil::Filesystem *filesystem, std::string const &configurationDirectory, size_t limit);
+
+    /*
+     * Record the commands Ninja ran in a configuration directory, from the
+     * end of its log when it was `previousSize` bytes, as jobs that started
+     * at `start`. Each is recorded under the tool identifier of its output.
+     */
+    static void
+    TraceLog(libutil::Filesystem const *filesystem, std::string const &configurationDirectory, uint64_t previousSize, uint64_t start, Tracer *tracer);
+
 public:
     static std::unique_ptr<NinjaExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, size_t jobs, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer);
 };
 
 }
@@ -112,10 +112,11 @@ public:
 
 public:
     /*
-     * Loads the workspace from the build parameters.
+     * Loads the workspace from the build parameters. Parsed configuration
+     * files are cached in the workspace's intermediates directory.
      */
     ext::optional<pbxbuild::WorkspaceContext> loadWorkspace(
-        libutil::Filesystem const *filesystem,
+        libutil::Filesystem *filesystem,
         std::string const &userName,
         pbxbuild::Build::Environment const &buildEnvironment,
         std::string const &workingDirectory) const;
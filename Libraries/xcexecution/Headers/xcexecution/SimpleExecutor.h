@@ -10,21 +10,34 @@
 #ifndef __xcexecution_SimpleExecutor_h
 #define __xcexecution_SimpleExecutor_h
 
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildState.h>
 #include <xcexecution/Executor.h>
+#include <xcexecution/JobPool.h>
 #include <builtin/Registry.h>
+#include <pbxbuild/DirectedGraph.h>
+
+#include <functional>
 
 namespace xcexecution {
 
 /*
- * Simple executor that simply runs invocations in sequence. Advanced features
- * like incremental builds, dependency info, and such are not supported.
+ * Simple executor that runs invocations as soon as their dependencies have
+ * finished, up to a maximum number of jobs at once. If targets are built in
+ * parallel, independent targets also build at the same time, sharing the same
+ * limit on jobs. Invocations are skipped if they are up to date with the
+ * inputs and dependency info recorded in each target's build state, and if
+ * an action cache is used, outputs are restored from it when possible.
  */
 class SimpleExecutor : public Executor {
 private:
-    builtin::Registry _builtins;
+    builtin::Registry            _builtins;
+    std::shared_ptr<JobPool>     _jobPool;
+    bool                         _parallelizeTargets;
+    std::shared_ptr<ActionCache> _actionCache;
 
 public:
-    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer);
     ~SimpleExecutor();
 
 public:
@@ -35,6 +48,28 @@ public:
         pbxbuild::Build::Environment const &buildEnvironment,
         Parameters const &buildParameters);
 
+private:
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> planAndBuildTarget(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    /*
+     * Builds each target once the targets it depends on are built, with up to
+     * the job limit building at once. Targets build on their own threads, and
+     * the formatter output of each is collected and printed as one block on
+     * this thread when it finishes, so output from parallel targets doesn't
+     * interleave. Returns the failing invocations of every failed target.
+     */
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTargetsInParallel(
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+        std::function<std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>(pbxproj::PBX::Target::shared_ptr const &target)> const &buildTarget);
+
 public:
     bool writeAuxiliaryFiles(
         libutil::Filesystem *filesystem,
@@ -47,7 +82,8 @@ public:
         libutil::Filesystem *filesystem,
         std::vector<std::string> const &executablePaths,
         std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-        bool createProductStructure);
+        bool createProductStructure,
+        BuildState *buildState = nullptr);
     std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTarget(
         process::Context const *processContext,
         process::Launcher *processLauncher,
@@ -58,7 +94,7 @@ public:
 
 public:
     static std::unique_ptr<SimpleExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer);
 };
 
 }
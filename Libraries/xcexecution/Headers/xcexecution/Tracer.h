@@ -0,0 +1,193 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_Tracer_h
+#define __xcexecution_Tracer_h
+
+#include <xcformatter/BuildStatistics.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Records how long each part of a build takes, to be written out in the
+ * Chrome trace event format and loaded into a trace viewer.
+ *
+ * Work done by xcbuild itself is recorded on a lane for the thread doing it.
+ * Jobs, like invocations, can start and finish on different threads, so they
+ * are instead recorded on the lowest numbered job lane free when they start;
+ * the number of job lanes used shows how many jobs ran at once.
+ *
+ * All methods are safe to call from multiple threads.
+ */
+class Tracer {
+public:
+    /*
+     * Where an event was recorded.
+     */
+    enum class Lane {
+        Thread,
+        Job,
+    };
+
+    /*
+     * A span of time in the build.
+     */
+    class Event {
+    private:
+        std::string _category;
+        std::string _name;
+        uint64_t    _start;
+        uint64_t    _duration;
+        Lane        _lane;
+        size_t      _index;
+
+    private:
+        size_t              _identifier;
+        bool                _dependenciesKnown;
+        std::vector<size_t> _predecessors;
+
+    public:
+        Event(std::string const &category, std::string const &name, uint64_t start, uint64_t duration, Lane lane, size_t index);
+        Event(std::string const &category, std::string const &name, uint64_t start, uint64_t duration, Lane lane, size_t index, size_t identifier, std::vector<size_t> const &predecessors);
+
+    public:
+        /*
+         * What kind of work this is, like a build step or a tool identifier.
+         */
+        std::string const &category() const
+        { return _category; }
+
+        /*
+         * What was done.
+         */
+        std::string const &name() const
+        { return _name; }
+
+    public:
+        /*
+         * When the event started, in microseconds since the tracer was created.
+         */
+        uint64_t start() const
+        { return _start; }
+
+        /*
+         * How long the event took, in microseconds.
+         */
+        uint64_t duration() const
+        { return _duration; }
+
+    public:
+        /*
+         * The kind of lane and lane number the event was recorded on.
+         */
+        Lane lane() const
+        { return _lane; }
+        size_t index() const
+        { return _index; }
+
+    public:
+        /*
+         * For jobs, the identifier returned when the job finished, and the
+         * identifiers of the jobs it waited on, if they are known.
+         */
+        size_t identifier() const
+        { return _identifier; }
+        bool dependenciesKnown() const
+        { return _dependenciesKnown; }
+        std::vector<size_t> const &predecessors() const
+        { return _predecessors; }
+    };
+
+private:
+    std::chrono::steady_clock::time_point       _epoch;
+
+private:
+    mutable std::mutex                          _mutex;
+    std::vector<Event>                          _events;
+    std::unordered_map<std::thread::id, size_t> _threadLanes;
+    std::vector<bool>                           _jobLanes;
+    size_t                                      _jobs;
+
+public:
+    Tracer();
+    ~Tracer();
+
+public:
+    /*
+     * The current time, in microseconds since the tracer was created.
+     */
+    uint64_t now() const;
+
+public:
+    /*
+     * Record work done on the current thread, from `start` until now.
+     */
+    void span(std::string const &category, std::string const &name, uint64_t start);
+
+    /*
+     * Reserve a job lane for a job starting now. The lane must be given
+     * back with `finishJob()`.
+     */
+    size_t beginJob();
+
+    /*
+     * Record a job on its lane, from `start` until now, and free the lane.
+     * Returns an identifier for the job. If given, `predecessors` are the
+     * identifiers of the jobs this one waited on for its inputs.
+     */
+    size_t finishJob(size_t lane, std::string const &category, std::string const &name, uint64_t start);
+    size_t finishJob(size_t lane, std::string const &category, std::string const &name, uint64_t start, std::vector<size_t> const &predecessors);
+
+    /*
+     * Record an event timed elsewhere, like a job run by another program.
+     */
+    void record(Event const &event);
+
+public:
+    /*
+     * The events recorded so far.
+     */
+    std::vector<Event> events() const;
+
+    /*
+     * Summarize the recorded events. Jobs are the invocations of the build,
+     * and events in the "plan" category count as planning; planning events
+     * nested inside each other on the same thread are only counted once.
+     * CPU times are measured by the caller, which knows what to include.
+     */
+    xcformatter::BuildStatistics statistics(uint64_t processTime, uint64_t childProcessTime) const;
+
+public:
+    /*
+     * Write the recorded events as a Chrome trace event JSON file.
+     */
+    bool write(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Create a tracer. Times are relative to its creation.
+     */
+    static std::shared_ptr<Tracer>
+    Create();
+};
+
+}
+
+#endif // !__xcexecution_Tracer_h
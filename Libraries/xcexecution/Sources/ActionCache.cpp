@@ -0,0 +1,473 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildState.h>
+
+#include <dependency/DependencyInfo.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+using xcexecution::ActionCache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Permissions;
+
+/*
+ * Bump when the format of keys or cached actions changes.
+ */
+static int64_t const ActionCacheVersion = 2;
+
+/*
+ * How many sets of discovered inputs to keep for each key. Each set is a
+ * different result of running the same action, for example after a header
+ * found through a search path changed.
+ */
+static size_t const ActionCacheEntryLimit = 4;
+
+ActionCache::Action::
+Action(
+    std::string const &fingerprint,
+    ext::optional<std::string> const &executable,
+    std::string const &workingDirectory,
+    std::vector<std::string> const &inputs,
+    std::vector<std::string> const &outputs,
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo) :
+    _fingerprint     (fingerprint),
+    _executable      (executable),
+    _workingDirectory(workingDirectory),
+    _inputs          (inputs),
+    _outputs         (outputs),
+    _dependencyInfo  (dependencyInfo)
+{
+}
+
+ActionCache::Action ActionCache::Action::
+Create(pbxbuild::Tool::Invocation const &invocation, ext::optional<std::string> const &executablePath)
+{
+    std::vector<std::string> inputs;
+    inputs.insert(inputs.end(), invocation.inputs().begin(), invocation.inputs().end());
+    inputs.insert(inputs.end(), invocation.phonyInputs().begin(), invocation.phonyInputs().end());
+    inputs.insert(inputs.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
+    for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        inputs.push_back(auxiliaryFile.path());
+    }
+
+    /* Dependency info is restored with the outputs so later builds can use it. */
+    std::vector<std::string> outputs = invocation.outputs();
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> dependencyInfo;
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &entry : invocation.dependencyInfo()) {
+        dependencyInfo.push_back({ entry.format(), entry.path() });
+        outputs.push_back(entry.path());
+    }
+
+    return Action(
+        BuildState::Fingerprint(invocation),
+        executablePath,
+        invocation.workingDirectory(),
+        inputs,
+        outputs,
+        dependencyInfo);
+}
+
+ActionCache::
+ActionCache(std::string const &path, ext::optional<std::string> const &builtinExecutable) :
+    _path             (path),
+    _builtinExecutable(builtinExecutable)
+{
+}
+
+ActionCache::
+~ActionCache()
+{
+}
+
+static std::string
+Digest(md5_state_t *state)
+{
+    uint8_t digest[16];
+    md5_finish(state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return ss.str();
+}
+
+static void
+DigestAppend(md5_state_t *state, std::string const &value)
+{
+    /* Include the terminator so adjacent values can't run together. */
+    md5_append(state, reinterpret_cast<const md5_byte_t *>(value.c_str()), value.size() + 1);
+}
+
+static std::string
+ContentsHash(std::vector<uint8_t> const &contents)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data()), contents.size());
+    return Digest(&state);
+}
+
+/*
+ * The hash of a file's contents. Missing files have an empty hash; files
+ * that exist but can't be read, like directories, have no hash.
+ */
+static ext::optional<std::string>
+ContentHash(Filesystem const *filesystem, std::string const &path, std::vector<uint8_t> *contents = nullptr)
+{
+    ext::optional<Filesystem::Type> type = filesystem->type(path);
+    if (!type) {
+        return std::string();
+    }
+
+    std::vector<uint8_t> data;
+    if (*type == Filesystem::Type::Directory || !filesystem->read(&data, path)) {
+        return ext::nullopt;
+    }
+
+    std::string hash = ContentsHash(data);
+    if (contents != nullptr) {
+        *contents = std::move(data);
+    }
+
+    return hash;
+}
+
+static std::string
+ShardedPath(std::string const &root, std::string const &hash)
+{
+    /* Avoid very large directories by splitting on the first byte. */
+    return root + "/" + hash.substr(0, 2) + "/" + hash;
+}
+
+/*
+ * Write a file in the cache so it is never seen partially written. Other
+ * threads and processes can be using the cache at the same time, so the
+ * contents are written to a unique temporary path and moved into place.
+ */
+static bool
+WriteAtomically(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path)
+{
+    static std::atomic<uint64_t> counter(0);
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    std::string temporaryPath = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+    if (!filesystem->write(contents, temporaryPath)) {
+        filesystem->removeFile(temporaryPath);
+        return false;
+    }
+
+    if (!filesystem->moveFile(temporaryPath, path)) {
+        filesystem->removeFile(temporaryPath);
+        return false;
+    }
+
+    return true;
+}
+
+ext::optional<std::string> ActionCache::
+key(Filesystem const *filesystem, Action const &action) const
+{
+    if (action.outputs().empty()) {
+        return ext::nullopt;
+    }
+
+    /* Builtin tools are part of the executable running them. */
+    ext::optional<std::string> executable = (action.executable() ? action.executable() : _builtinExecutable);
+    if (!executable) {
+        return ext::nullopt;
+    }
+
+    md5_state_t state;
+    md5_init(&state);
+    DigestAppend(&state, std::to_string(ActionCacheVersion));
+    DigestAppend(&state, action.fingerprint());
+
+    /* Executables are large, so check their size and time rather than contents. */
+    uint64_t size;
+    uint64_t modificationTime;
+    if (!filesystem->readInfo(*executable, &size, &modificationTime)) {
+        return ext::nullopt;
+    }
+
+    DigestAppend(&state, *executable);
+    DigestAppend(&state, std::to_string(size));
+    DigestAppend(&state, std::to_string(modificationTime));
+
+    for (std::string const &input : action.inputs()) {
+        std::string path = FSUtil::ResolveRelativePath(input, action.workingDirectory());
+        ext::optional<std::string> hash = ContentHash(filesystem, path);
+        if (!hash) {
+            return ext::nullopt;
+        }
+
+        DigestAppend(&state, path);
+        DigestAppend(&state, *hash);
+    }
+
+    return Digest(&state);
+}
+
+/*
+ * Read the entries stored for a key, newest first.
+ */
+static std::unique_ptr<plist::Array>
+ReadEntries(Filesystem const *filesystem, std::string const &actionPath)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->exists(actionPath) || !filesystem->read(&contents, actionPath)) {
+        return nullptr;
+    }
+
+    auto deserialize = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    auto root = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (root == nullptr) {
+        return nullptr;
+    }
+
+    auto version = root->value<plist::Integer>("version");
+    auto entries = root->value<plist::Array>("entries");
+    if (version == nullptr || version->value() != ActionCacheVersion || entries == nullptr) {
+        return nullptr;
+    }
+
+    return entries->copy();
+}
+
+/*
+ * Restore outputs from one entry stored for a key.
+ */
+static bool
+RestoreEntry(Filesystem *filesystem, std::string const &objectsPath, ActionCache::Action const &action, plist::Dictionary const *entry)
+{
+    auto discovered = entry->value<plist::Dictionary>("discovered");
+    auto outputs = entry->value<plist::Dictionary>("outputs");
+    if (discovered == nullptr || outputs == nullptr) {
+        return false;
+    }
+
+    /* Inputs found from dependency info must be unchanged since they were stored. */
+    for (size_t n = 0; n < discovered->count(); ++n) {
+        auto hash = discovered->value<plist::String>(n);
+        if (hash == nullptr || ContentHash(filesystem, discovered->key(n)) != hash->value()) {
+            return false;
+        }
+    }
+
+    /*
+     * Read and verify everything before changing any outputs. An object that
+     * doesn't match its hash was damaged, so it is removed to be stored again.
+     */
+    struct Restore {
+        std::string          path;
+        std::vector<uint8_t> contents;
+        bool                 executable;
+    };
+    std::vector<Restore> restore;
+    for (std::string const &output : action.outputs()) {
+        std::string path = FSUtil::ResolveRelativePath(output, action.workingDirectory());
+        auto object = outputs->value<plist::Dictionary>(path);
+        if (object == nullptr || object->value<plist::String>("hash") == nullptr) {
+            return false;
+        }
+
+        std::string hash = object->value<plist::String>("hash")->value();
+        std::string objectPath = ShardedPath(objectsPath, hash);
+
+        std::vector<uint8_t> contents;
+        if (!filesystem->exists(objectPath) || !filesystem->read(&contents, objectPath)) {
+            return false;
+        }
+
+        if (ContentsHash(contents) != hash) {
+            filesystem->removeFile(objectPath);
+            return false;
+        }
+
+        auto executable = object->value<plist::Boolean>("executable");
+        restore.push_back({ path, std::move(contents), executable != nullptr && executable->value() });
+    }
+
+    /*
+     * Outputs are copied rather than linked from the cache, so later steps
+     * can modify them in place, and are written fresh so they are newer than
+     * the inputs used to create them.
+     */
+    for (Restore const &entry : restore) {
+        if (!filesystem->createDirectory(FSUtil::GetDirectoryName(entry.path), true)) {
+            return false;
+        }
+
+        if (filesystem->type(entry.path) == Filesystem::Type::File && !filesystem->removeFile(entry.path)) {
+            return false;
+        }
+
+        if (!filesystem->write(entry.contents, entry.path)) {
+            return false;
+        }
+
+        if (entry.executable) {
+            Permissions permissions = Permissions(
+                { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
+                { Permissions::Permission::Read, Permissions::Permission::Execute },
+                { Permissions::Permission::Read, Permissions::Permission::Execute });
+            if (!filesystem->writeFilePermissions(entry.path, Permissions::Operation::Set, permissions)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ActionCache::
+restore(Filesystem *filesystem, Action const &action, std::string const &key) const
+{
+    std::unique_ptr<plist::Array> entries = ReadEntries(filesystem, ShardedPath(_path + "/actions", key));
+    if (entries == nullptr) {
+        return false;
+    }
+
+    for (size_t n = 0; n < entries->count(); ++n) {
+        auto entry = entries->value<plist::Dictionary>(n);
+        if (entry != nullptr && RestoreEntry(filesystem, _path + "/objects", action, entry)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ActionCache::
+store(Filesystem *filesystem, Action const &action, std::string const &key) const
+{
+    /*
+     * Find the inputs the action discovered while it ran.
+     */
+    auto discovered = plist::Dictionary::New();
+    for (std::pair<dependency::DependencyInfoFormat, std::string> const &entry : action.dependencyInfo()) {
+        std::string path = FSUtil::ResolveRelativePath(entry.second, action.workingDirectory());
+
+        std::vector<dependency::DependencyInfo> info;
+        if (!filesystem->exists(path) || !dependency::DependencyInfo::Load(filesystem, path, entry.first, &info)) {
+            return false;
+        }
+
+        for (dependency::DependencyInfo const &dependencyInfo : info) {
+            for (std::string const &input : dependencyInfo.inputs()) {
+                std::string inputPath = FSUtil::ResolveRelativePath(input, action.workingDirectory());
+                ext::optional<std::string> hash = ContentHash(filesystem, inputPath);
+                if (!hash) {
+                    return false;
+                }
+
+                discovered->set(inputPath, plist::String::New(*hash));
+            }
+        }
+    }
+
+    /*
+     * Copy the outputs into the cache. Only regular files can be cached.
+     */
+    auto outputs = plist::Dictionary::New();
+    for (std::string const &output : action.outputs()) {
+        std::string path = FSUtil::ResolveRelativePath(output, action.workingDirectory());
+        if (filesystem->type(path) != Filesystem::Type::File) {
+            return false;
+        }
+
+        std::vector<uint8_t> contents;
+        ext::optional<std::string> hash = ContentHash(filesystem, path, &contents);
+        if (!hash) {
+            return false;
+        }
+
+        std::string objectPath = ShardedPath(_path + "/objects", *hash);
+        if (!filesystem->exists(objectPath)) {
+            if (!WriteAtomically(filesystem, contents, objectPath)) {
+                return false;
+            }
+        }
+
+        auto object = plist::Dictionary::New();
+        object->set("hash", plist::String::New(*hash));
+        object->set("executable", plist::Boolean::New(filesystem->isExecutable(path)));
+        outputs->set(path, std::move(object));
+    }
+
+    /*
+     * Keep the most recent results for other sets of discovered inputs, so
+     * switching back and forth between them can still be restored. If two
+     * stores for a key race, one entry can be lost, but the file is replaced
+     * atomically so it is always complete.
+     */
+    std::string actionPath = ShardedPath(_path + "/actions", key);
+    std::unique_ptr<plist::Array> previous = ReadEntries(filesystem, actionPath);
+
+    auto entries = plist::Array::New();
+    if (previous != nullptr) {
+        for (size_t n = 0; n < previous->count() && entries->count() + 1 < ActionCacheEntryLimit; ++n) {
+            auto entry = previous->value<plist::Dictionary>(n);
+            if (entry == nullptr) {
+                continue;
+            }
+
+            /* The new entry replaces any with the same discovered inputs. */
+            auto entryDiscovered = entry->value<plist::Dictionary>("discovered");
+            if (entryDiscovered == nullptr || entryDiscovered->equals(discovered.get())) {
+                continue;
+            }
+
+            entries->append(entry->copy());
+        }
+    }
+
+    auto entry = plist::Dictionary::New();
+    entry->set("discovered", std::move(discovered));
+    entry->set("outputs", std::move(outputs));
+    entries->insert(0, std::move(entry));
+
+    auto root = plist::Dictionary::New();
+    root->set("version", plist::Integer::New(ActionCacheVersion));
+    root->set("entries", std::move(entries));
+
+    auto serialize = plist::Format::Binary::Serialize(root.get(), plist::Format::Binary::Create());
+    if (serialize.first == nullptr) {
+        return false;
+    }
+
+    return WriteAtomically(filesystem, *serialize.first, actionPath);
+}
+
+std::shared_ptr<ActionCache> ActionCache::
+Create(std::string const &path, ext::optional<std::string> const &builtinExecutable)
+{
+    return std::make_shared<ActionCache>(path, builtinExecutable);
+}
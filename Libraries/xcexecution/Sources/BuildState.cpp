@@ -0,0 +1,329 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildState.h>
+
+#include <dependency/DependencyInfo.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+
+using xcexecution::BuildState;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * Bump when the format of the saved state changes.
+ */
+static int64_t const BuildStateVersion = 1;
+
+BuildState::Record::
+Record(std::string const &fingerprint, std::vector<std::pair<std::string, Signature>> const &inputs) :
+    _fingerprint(fingerprint),
+    _inputs     (inputs)
+{
+}
+
+BuildState::
+BuildState() :
+    _modified(false)
+{
+}
+
+static std::string
+RecordKey(pbxbuild::Tool::Invocation const &invocation)
+{
+    /* Outputs can only be produced by a single invocation. */
+    return invocation.outputs().front();
+}
+
+static BuildState::Signature
+ReadSignature(Filesystem const *filesystem, std::string const &path)
+{
+    uint64_t size;
+    uint64_t modificationTime;
+    if (!filesystem->readInfo(path, &size, &modificationTime)) {
+        return ext::nullopt;
+    }
+
+    return std::make_pair(size, modificationTime);
+}
+
+bool BuildState::
+upToDate(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const
+{
+    if (invocation.outputs().empty()) {
+        return false;
+    }
+
+    auto it = _records.find(RecordKey(invocation));
+    if (it == _records.end()) {
+        return false;
+    }
+
+    Record const &record = it->second;
+    if (record.fingerprint() != Fingerprint(invocation)) {
+        return false;
+    }
+
+    for (std::string const &output : invocation.outputs()) {
+        if (!filesystem->exists(output)) {
+            return false;
+        }
+    }
+
+    for (std::pair<std::string, Signature> const &input : record.inputs()) {
+        if (ReadSignature(filesystem, input.first) != input.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BuildState::
+record(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation)
+{
+    if (invocation.outputs().empty()) {
+        return;
+    }
+
+    invalidate(invocation);
+
+    std::vector<std::string> paths;
+    paths.insert(paths.end(), invocation.inputs().begin(), invocation.inputs().end());
+    paths.insert(paths.end(), invocation.phonyInputs().begin(), invocation.phonyInputs().end());
+    paths.insert(paths.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
+    for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        paths.push_back(auxiliaryFile.path());
+    }
+
+    /*
+     * Inputs discovered while running, like included headers. If the tool
+     * did not write its dependency info, the inputs are unknown, so don't
+     * record the invocation as it could never be known to be up to date.
+     */
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        std::string path = FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory());
+        if (!filesystem->exists(path)) {
+            return;
+        }
+
+        std::vector<dependency::DependencyInfo> info;
+        if (!dependency::DependencyInfo::Load(filesystem, path, dependencyInfo.format(), &info)) {
+            return;
+        }
+
+        for (dependency::DependencyInfo const &entry : info) {
+            paths.insert(paths.end(), entry.inputs().begin(), entry.inputs().end());
+        }
+    }
+
+    std::unordered_set<std::string> seen;
+    std::vector<std::pair<std::string, Signature>> inputs;
+    for (std::string const &path : paths) {
+        std::string resolved = FSUtil::ResolveRelativePath(path, invocation.workingDirectory());
+        if (seen.insert(resolved).second) {
+            inputs.push_back({ resolved, ReadSignature(filesystem, resolved) });
+        }
+    }
+
+    _records.insert({ RecordKey(invocation), Record(Fingerprint(invocation), inputs) });
+    _modified = true;
+}
+
+void BuildState::
+invalidate(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (invocation.outputs().empty()) {
+        return;
+    }
+
+    if (_records.erase(RecordKey(invocation)) > 0) {
+        _modified = true;
+    }
+}
+
+bool BuildState::
+save(Filesystem *filesystem, std::string const &path) const
+{
+    if (!_modified) {
+        return true;
+    }
+
+    auto records = plist::Dictionary::New();
+    for (std::pair<std::string, Record> const &entry : _records) {
+        auto inputs = plist::Array::New();
+        for (std::pair<std::string, Signature> const &input : entry.second.inputs()) {
+            auto signature = plist::Dictionary::New();
+            signature->set("path", plist::String::New(input.first));
+            if (input.second) {
+                signature->set("size", plist::Integer::New(static_cast<int64_t>(input.second->first)));
+                signature->set("time", plist::Integer::New(static_cast<int64_t>(input.second->second)));
+            }
+            inputs->append(std::move(signature));
+        }
+
+        auto record = plist::Dictionary::New();
+        record->set("fingerprint", plist::String::New(entry.second.fingerprint()));
+        record->set("inputs", std::move(inputs));
+        records->set(entry.first, std::move(record));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("version", plist::Integer::New(BuildStateVersion));
+    root->set("records", std::move(records));
+
+    auto serialize = plist::Format::Binary::Serialize(root.get(), plist::Format::Binary::Create());
+    if (serialize.first == nullptr) {
+        fprintf(stderr, "error: failed to serialize build state: %s\n", serialize.second.c_str());
+        return false;
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    if (!filesystem->write(*serialize.first, path)) {
+        fprintf(stderr, "error: failed to write build state to %s\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+BuildState BuildState::
+Load(Filesystem const *filesystem, std::string const &path)
+{
+    BuildState state;
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->exists(path) || !filesystem->read(&contents, path)) {
+        return state;
+    }
+
+    auto deserialize = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    auto root = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    if (root == nullptr) {
+        return state;
+    }
+
+    auto version = root->value<plist::Integer>("version");
+    auto records = root->value<plist::Dictionary>("records");
+    if (version == nullptr || version->value() != BuildStateVersion || records == nullptr) {
+        return state;
+    }
+
+    for (size_t n = 0; n < records->count(); ++n) {
+        auto record = records->value<plist::Dictionary>(n);
+        if (record == nullptr) {
+            continue;
+        }
+
+        auto fingerprint = record->value<plist::String>("fingerprint");
+        auto inputs = record->value<plist::Array>("inputs");
+        if (fingerprint == nullptr || inputs == nullptr) {
+            continue;
+        }
+
+        std::vector<std::pair<std::string, Signature>> signatures;
+        for (size_t i = 0; i < inputs->count(); ++i) {
+            auto input = inputs->value<plist::Dictionary>(i);
+            if (input == nullptr || input->value<plist::String>("path") == nullptr) {
+                continue;
+            }
+
+            Signature signature;
+            auto size = input->value<plist::Integer>("size");
+            auto time = input->value<plist::Integer>("time");
+            if (size != nullptr && time != nullptr) {
+                signature = std::make_pair(static_cast<uint64_t>(size->value()), static_cast<uint64_t>(time->value()));
+            }
+
+            signatures.push_back({ input->value<plist::String>("path")->value(), signature });
+        }
+
+        state._records.insert({ records->key(n), Record(fingerprint->value(), signatures) });
+    }
+
+    return state;
+}
+
+static void
+FingerprintAppend(md5_state_t *state, std::string const &value)
+{
+    /* Include the terminator so adjacent values can't run together. */
+    md5_append(state, reinterpret_cast<const md5_byte_t *>(value.c_str()), value.size() + 1);
+}
+
+static void
+FingerprintAppend(md5_state_t *state, std::vector<std::string> const &values)
+{
+    FingerprintAppend(state, std::to_string(values.size()));
+    for (std::string const &value : values) {
+        FingerprintAppend(state, value);
+    }
+}
+
+std::string BuildState::
+Fingerprint(pbxbuild::Tool::Invocation const &invocation)
+{
+    md5_state_t state;
+    md5_init(&state);
+
+    if (invocation.executable()) {
+        if (invocation.executable()->builtin()) {
+            FingerprintAppend(&state, "builtin:" + *invocation.executable()->builtin());
+        } else if (invocation.executable()->external()) {
+            FingerprintAppend(&state, "external:" + *invocation.executable()->external());
+        }
+    }
+
+    FingerprintAppend(&state, invocation.arguments());
+    FingerprintAppend(&state, invocation.workingDirectory());
+
+    /* Sort the environment, as its order is not stable. */
+    std::vector<std::string> environment;
+    for (std::pair<std::string, std::string> const &entry : invocation.environment()) {
+        environment.push_back(entry.first + "=" + entry.second);
+    }
+    std::sort(environment.begin(), environment.end());
+    FingerprintAppend(&state, environment);
+
+    FingerprintAppend(&state, invocation.inputs());
+    FingerprintAppend(&state, invocation.outputs());
+    FingerprintAppend(&state, invocation.phonyInputs());
+    FingerprintAppend(&state, invocation.inputDependencies());
+
+    for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        FingerprintAppend(&state, auxiliaryFile.path());
+        FingerprintAppend(&state, auxiliaryFile.executable() ? "executable" : "");
+    }
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return ss.str();
+}
@@ -12,10 +12,11 @@
 using xcexecution::Executor;
 
 Executor::
-Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
+Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<Tracer> const &tracer) :
     _formatter(formatter),
     _dryRun   (dryRun),
-    _generate (generate)
+    _generate (generate),
+    _tracer   (tracer)
 {
 }
 
@@ -23,3 +24,17 @@ Executor::
 ~Executor()
 {
 }
+
+uint64_t Executor::
+traceStart() const
+{
+    return (_tracer != nullptr ? _tracer->now() : 0);
+}
+
+void Executor::
+traceSpan(std::string const &category, std::string const &name, uint64_t start) const
+{
+    if (_tracer != nullptr) {
+        _tracer->span(category, name, start);
+    }
+}
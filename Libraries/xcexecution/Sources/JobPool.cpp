@@ -0,0 +1,114 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/JobPool.h>
+
+using xcexecution::JobPool;
+
+JobPool::
+JobPool(size_t jobs) :
+    _jobs     (jobs > 0 ? jobs : 1),
+    _active   (0),
+    _cancelled(false)
+{
+}
+
+JobPool::
+~JobPool()
+{
+}
+
+void JobPool::
+cancel()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cancelled = true;
+    _condition.notify_all();
+}
+
+bool JobPool::
+cancelled()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cancelled;
+}
+
+JobPool::Group::
+Group(JobPool *pool) :
+    _pool(pool)
+{
+}
+
+JobPool::Group::
+~Group()
+{
+    while (!_threads.empty()) {
+        wait(false);
+    }
+}
+
+bool JobPool::Group::
+acquire()
+{
+    std::lock_guard<std::mutex> lock(_pool->_mutex);
+    if (_pool->_cancelled || _pool->_active >= _pool->_jobs) {
+        return false;
+    }
+
+    _pool->_active++;
+    return true;
+}
+
+void JobPool::Group::
+release()
+{
+    std::lock_guard<std::mutex> lock(_pool->_mutex);
+    _pool->_active--;
+    _pool->_condition.notify_all();
+}
+
+void JobPool::Group::
+start(size_t identifier, std::function<bool()> const &work)
+{
+    JobPool *pool = _pool;
+    std::vector<Result> *finished = &_finished;
+
+    _threads.insert({ identifier, std::thread([pool, finished, identifier, work] {
+        bool success = work();
+
+        /* Report completion and free up the slot for the next job. */
+        std::lock_guard<std::mutex> lock(pool->_mutex);
+        finished->push_back({ identifier, success });
+        pool->_active--;
+        pool->_condition.notify_all();
+    }) });
+}
+
+std::vector<JobPool::Group::Result> JobPool::Group::
+wait(bool slot)
+{
+    std::vector<Result> finished;
+
+    {
+        std::unique_lock<std::mutex> lock(_pool->_mutex);
+        _pool->_condition.wait(lock, [this, slot] {
+            return !_finished.empty() || (slot && (_pool->_cancelled || _pool->_active < _pool->_jobs));
+        });
+
+        finished.swap(_finished);
+    }
+
+    for (Result const &result : finished) {
+        auto it = _threads.find(result.first);
+        it->second.join();
+        _threads.erase(it);
+    }
+
+    return finished;
+}
@@ -12,6 +12,10 @@
 #include <xcexecution/Parameters.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <pbxbuild/Tool/AssetCatalogResolver.h>
+#include <pbxbuild/Tool/LinkerResolver.h>
+#include <pbxbuild/Tool/SwiftResolver.h>
+#include <ninja/Log.h>
 #include <ninja/Writer.h>
 #include <ninja/Value.h>
 #include <plist/Data.h>
@@ -23,6 +27,9 @@
 #include <process/Launcher.h>
 #include <libutil/md5.h>
 
+#include <algorithm>
+#include <climits>
+#include <map>
 #include <sstream>
 #include <iomanip>
 
@@ -30,14 +37,18 @@
 #include <sys/stat.h>
 
 using xcexecution::NinjaExecutor;
+using xcexecution::ActionCache;
 using xcexecution::Parameters;
+using xcexecution::Tracer;
 using libutil::Escape;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
 NinjaExecutor::
-NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
-    Executor(formatter, dryRun, generate)
+NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, size_t jobs, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer) :
+    Executor    (formatter, dryRun, generate, tracer),
+    _jobs       (jobs),
+    _actionCache(actionCache)
 {
 }
 
@@ -65,23 +76,25 @@ TargetNinjaFinish(pbxproj::PBX::Target::shared_ptr const &target)
 }
 
 static std::string
-TargetNinjaPath(pbxproj::PBX::Target::shared_ptr const &target, pbxbuild::Target::Environment const &targetEnvironment)
+NinjaRuleName()
 {
-    /*
-     * Determine where the Ninja file should go. We use the target's temp dir
-     * as, being target-specific, it will allow the Ninja files to not conflict.
-     */
-    pbxsetting::Environment const &environment = targetEnvironment.environment();
-    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
-    // TODO(grp): How to handle varying configurations / actions / other build context options?
-
-    return temporaryDirectory + "/" + "build.ninja";
+    return "invoke";
 }
 
-static std::string
-NinjaRuleName()
+static ext::optional<std::string>
+NinjaPoolName(std::string const &toolIdentifier)
 {
-    return "invoke";
+    if (toolIdentifier == pbxbuild::Tool::LinkerResolver::LinkerToolIdentifier() ||
+        toolIdentifier == pbxbuild::Tool::LinkerResolver::LibtoolToolIdentifier() ||
+        toolIdentifier == pbxbuild::Tool::LinkerResolver::LipoToolIdentifier()) {
+        return std::string("link");
+    } else if (toolIdentifier == pbxbuild::Tool::AssetCatalogResolver::ToolIdentifier()) {
+        return std::string("asset-catalog");
+    } else if (toolIdentifier == pbxbuild::Tool::SwiftResolver::ToolIdentifier()) {
+        return std::string("swift");
+    } else {
+        return ext::nullopt;
+    }
 }
 
 static std::string
@@ -114,6 +127,362 @@ NinjaHash(std::string const &input)
     return ss.str();
 }
 
+static std::string
+TargetNinjaPath(pbxbuild::Target::Environment const &targetEnvironment, std::string const &configurationDirectory)
+{
+    /*
+     * Determine where the Ninja file should go. The target's temp dir is specific
+     * to the target, but can be shared between configurations that differ only in
+     * other parameters, so the Ninja file goes with the rest of the configuration.
+     */
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    return configurationDirectory + "/" + "targets" + "/" + NinjaHash(temporaryDirectory) + ".ninja";
+}
+
+static std::string
+TargetNinjaFingerprintPath(std::string const &targetPath)
+{
+    return targetPath + "-fingerprint";
+}
+
+/*
+ * The tool identifier of each output in a target's Ninja file, one per line
+ * as the identifier then the output path, separated by a space. Ninja's log
+ * only records outputs, so this is how time is attributed to tools.
+ */
+static std::string
+TargetNinjaToolsPath(std::string const &targetPath)
+{
+    return targetPath + "-tools";
+}
+
+/*
+ * Bump when the contents of target Ninja files change.
+ */
+static int const TargetNinjaVersion = 1;
+
+static void
+FingerprintAppend(std::string *fingerprint, std::string const &value)
+{
+    /* Terminate each value so adjacent values can't run together. */
+    fingerprint->append(value);
+    fingerprint->push_back('\0');
+}
+
+static void
+FingerprintAppendFile(std::string *fingerprint, Filesystem const *filesystem, std::string const &path)
+{
+    /* Checking size and time is much faster than reading every file. */
+    uint64_t size = 0;
+    uint64_t modificationTime = 0;
+    FingerprintAppend(fingerprint, path);
+    if (filesystem->readInfo(path, &size, &modificationTime)) {
+        FingerprintAppend(fingerprint, std::to_string(size));
+        FingerprintAppend(fingerprint, std::to_string(modificationTime));
+    } else {
+        FingerprintAppend(fingerprint, std::string());
+    }
+}
+
+static void
+FingerprintAppendConfig(std::string *fingerprint, Filesystem const *filesystem, pbxsetting::XC::Config const &config)
+{
+    FingerprintAppendFile(fingerprint, filesystem, config.path());
+
+    for (pbxsetting::XC::Config::Entry const &entry : config.contents()) {
+        if (entry.type() == pbxsetting::XC::Config::Entry::Type::Include && entry.config() != nullptr) {
+            FingerprintAppendConfig(fingerprint, filesystem, *entry.config());
+        }
+    }
+}
+
+static void
+FingerprintAppendBuildFiles(std::string *fingerprint, pbxproj::PBX::BuildFile::vector const &buildFiles)
+{
+    FingerprintAppend(fingerprint, std::to_string(buildFiles.size()));
+
+    for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildFiles) {
+        pbxproj::PBX::GroupItem::shared_ptr const &fileRef = buildFile->fileRef();
+        if (fileRef == nullptr) {
+            FingerprintAppend(fingerprint, std::string());
+        } else {
+            FingerprintAppend(fingerprint, fileRef->isa());
+            FingerprintAppend(fingerprint, fileRef->resolve().raw());
+
+            if (fileRef->type() == pbxproj::PBX::GroupItem::Type::FileReference) {
+                auto fileReference = std::static_pointer_cast<pbxproj::PBX::FileReference>(fileRef);
+                FingerprintAppend(fingerprint, fileReference->lastKnownFileType());
+                FingerprintAppend(fingerprint, fileReference->explicitFileType());
+            } else if (fileRef->type() == pbxproj::PBX::GroupItem::Type::Group ||
+                       fileRef->type() == pbxproj::PBX::GroupItem::Type::VariantGroup ||
+                       fileRef->type() == pbxproj::PBX::GroupItem::Type::VersionGroup) {
+                /* Variant groups build each of their localizations. */
+                auto group = std::static_pointer_cast<pbxproj::PBX::BaseGroup>(fileRef);
+                FingerprintAppend(fingerprint, std::to_string(group->children().size()));
+                for (pbxproj::PBX::GroupItem::shared_ptr const &child : group->children()) {
+                    FingerprintAppend(fingerprint, child->resolve().raw());
+                }
+            }
+        }
+
+        FingerprintAppend(fingerprint, std::to_string(buildFile->compilerFlags().size()));
+        for (std::string const &flag : buildFile->compilerFlags()) {
+            FingerprintAppend(fingerprint, flag);
+        }
+
+        FingerprintAppend(fingerprint, std::to_string(buildFile->attributes().size()));
+        for (std::string const &attribute : buildFile->attributes()) {
+            FingerprintAppend(fingerprint, attribute);
+        }
+    }
+}
+
+static std::string
+ProjectNinjaFingerprint(pbxproj::PBX::Project::shared_ptr const &project)
+{
+    /*
+     * Targets see more of their project than their own files: headermaps
+     * include every header in the project and in each target's headers phase.
+     */
+    std::string fingerprint;
+    FingerprintAppend(&fingerprint, project->projectFile());
+
+    for (pbxproj::PBX::FileReference::shared_ptr const &fileReference : project->fileReferences()) {
+        FingerprintAppend(&fingerprint, fileReference->resolve().raw());
+        FingerprintAppend(&fingerprint, fileReference->lastKnownFileType());
+        FingerprintAppend(&fingerprint, fileReference->explicitFileType());
+    }
+
+    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+        FingerprintAppend(&fingerprint, target->name());
+        FingerprintAppend(&fingerprint, target->productName());
+
+        for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+            if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::Headers) {
+                FingerprintAppendBuildFiles(&fingerprint, buildPhase->files());
+            }
+        }
+    }
+
+    return NinjaHash(fingerprint);
+}
+
+std::string NinjaExecutor::
+SpecificationFingerprint(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager)
+{
+    /*
+     * Specifications define the options of every tool, not just the default
+     * build settings, so a changed specification can change any invocation.
+     */
+    std::vector<std::string> paths = specManager->loadedFilePaths();
+    std::sort(paths.begin(), paths.end());
+
+    std::string fingerprint;
+    for (std::string const &path : paths) {
+        FingerprintAppendFile(&fingerprint, filesystem, path);
+    }
+
+    return NinjaHash(fingerprint);
+}
+
+std::string NinjaExecutor::
+TargetFingerprint(
+    Filesystem const *filesystem,
+    std::string const &generatorFingerprint,
+    std::string const &specificationFingerprint,
+    std::string const &projectFingerprint,
+    pbxbuild::Build::Context const &buildContext,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment,
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> const &dependencies)
+{
+    /*
+     * Everything resolving a target's invocations depends on.
+     */
+    std::string fingerprint;
+    FingerprintAppend(&fingerprint, std::to_string(TargetNinjaVersion));
+    FingerprintAppend(&fingerprint, generatorFingerprint);
+    FingerprintAppend(&fingerprint, specificationFingerprint);
+    FingerprintAppend(&fingerprint, projectFingerprint);
+
+    /*
+     * The xcconfig files for the project and target configurations, and any
+     * files they include.
+     */
+    for (pbxproj::XC::ConfigurationList::shared_ptr const &configurationList : { target->project()->buildConfigurationList(), target->buildConfigurationList() }) {
+        if (configurationList == nullptr) {
+            continue;
+        }
+
+        for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
+            if (buildConfiguration->name() != buildContext.configuration()) {
+                continue;
+            }
+
+            auto config = buildContext.workspaceContext().configs().find(buildConfiguration);
+            if (config != buildContext.workspaceContext().configs().end()) {
+                FingerprintAppendConfig(&fingerprint, filesystem, config->second);
+            }
+        }
+    }
+
+    /*
+     * The target itself and the targets it waits for.
+     */
+    FingerprintAppend(&fingerprint, target->isa());
+    FingerprintAppend(&fingerprint, target->name());
+    FingerprintAppend(&fingerprint, target->productName());
+
+    std::vector<std::string> dependencyNames;
+    for (pbxproj::PBX::Target::shared_ptr const &dependency : dependencies) {
+        dependencyNames.push_back(dependency->name());
+    }
+    std::sort(dependencyNames.begin(), dependencyNames.end());
+    FingerprintAppend(&fingerprint, std::to_string(dependencyNames.size()));
+    for (std::string const &name : dependencyNames) {
+        FingerprintAppend(&fingerprint, name);
+    }
+
+    if (target->type() == pbxproj::PBX::Target::Type::Legacy) {
+        auto legacyTarget = std::static_pointer_cast<pbxproj::PBX::LegacyTarget>(target);
+        FingerprintAppend(&fingerprint, legacyTarget->buildToolPath());
+        FingerprintAppend(&fingerprint, legacyTarget->buildArgumentsString().raw());
+        FingerprintAppend(&fingerprint, legacyTarget->buildWorkingDirectory());
+        FingerprintAppend(&fingerprint, legacyTarget->passBuildSettingsInEnvironment() ? "YES" : "NO");
+    } else if (target->type() == pbxproj::PBX::Target::Type::Native) {
+        auto nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+        FingerprintAppend(&fingerprint, nativeTarget->productType());
+        for (pbxproj::PBX::BuildRule::shared_ptr const &buildRule : nativeTarget->buildRules()) {
+            FingerprintAppend(&fingerprint, buildRule->compilerSpec());
+            FingerprintAppend(&fingerprint, buildRule->filePatterns());
+            FingerprintAppend(&fingerprint, buildRule->fileType());
+            FingerprintAppend(&fingerprint, buildRule->script());
+            FingerprintAppend(&fingerprint, std::to_string(buildRule->outputFiles().size()));
+            for (std::string const &outputFile : buildRule->outputFiles()) {
+                FingerprintAppend(&fingerprint, outputFile);
+            }
+        }
+    }
+
+    /*
+     * The build phases and their files.
+     */
+    for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+        FingerprintAppend(&fingerprint, buildPhase->isa());
+        FingerprintAppend(&fingerprint, buildPhase->name());
+        FingerprintAppend(&fingerprint, buildPhase->runOnlyForDeploymentPostprocessing() ? "YES" : "NO");
+        FingerprintAppend(&fingerprint, std::to_string(buildPhase->buildActionMask()));
+        FingerprintAppendBuildFiles(&fingerprint, buildPhase->files());
+
+        if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::ShellScript) {
+            auto shellScriptPhase = std::static_pointer_cast<pbxproj::PBX::ShellScriptBuildPhase>(buildPhase);
+            FingerprintAppend(&fingerprint, shellScriptPhase->shellPath());
+            FingerprintAppend(&fingerprint, shellScriptPhase->shellScript());
+            FingerprintAppend(&fingerprint, shellScriptPhase->showEnvVarsInLog() ? "YES" : "NO");
+            FingerprintAppend(&fingerprint, std::to_string(shellScriptPhase->inputPaths().size()));
+            for (pbxsetting::Value const &inputPath : shellScriptPhase->inputPaths()) {
+                FingerprintAppend(&fingerprint, inputPath.raw());
+            }
+            FingerprintAppend(&fingerprint, std::to_string(shellScriptPhase->outputPaths().size()));
+            for (pbxsetting::Value const &outputPath : shellScriptPhase->outputPaths()) {
+                FingerprintAppend(&fingerprint, outputPath.raw());
+            }
+        } else if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::CopyFiles) {
+            auto copyFilesPhase = std::static_pointer_cast<pbxproj::PBX::CopyFilesBuildPhase>(buildPhase);
+            FingerprintAppend(&fingerprint, copyFilesPhase->dstPath().raw());
+            FingerprintAppend(&fingerprint, std::to_string(static_cast<int>(copyFilesPhase->dstSubfolderSpec())));
+        }
+    }
+
+    /*
+     * The resolved environment of the target.
+     */
+    if (targetEnvironment.sdk() != nullptr) {
+        FingerprintAppend(&fingerprint, targetEnvironment.sdk()->path());
+    }
+    FingerprintAppend(&fingerprint, targetEnvironment.workingDirectory());
+    for (std::string const &executablePath : targetEnvironment.executablePaths()) {
+        FingerprintAppend(&fingerprint, executablePath);
+    }
+    for (std::string const &specDomain : targetEnvironment.specDomains()) {
+        FingerprintAppend(&fingerprint, specDomain);
+    }
+
+    FingerprintAppend(&fingerprint, std::to_string(targetEnvironment.variants().size()));
+    for (std::string const &variant : targetEnvironment.variants()) {
+        FingerprintAppend(&fingerprint, variant);
+    }
+    FingerprintAppend(&fingerprint, std::to_string(targetEnvironment.architectures().size()));
+    for (std::string const &arch : targetEnvironment.architectures()) {
+        FingerprintAppend(&fingerprint, arch);
+    }
+
+    /*
+     * The build settings. Every resolved value, for any variant or
+     * architecture, follows from the settings in the environment's levels,
+     * so those are used directly rather than resolving them all again.
+     */
+    for (pbxsetting::Level const &level : targetEnvironment.environment().levels()) {
+        FingerprintAppend(&fingerprint, std::to_string(level.settings().size()));
+        for (pbxsetting::Setting const &setting : level.settings()) {
+            FingerprintAppend(&fingerprint, setting.name());
+
+            std::map<std::string, std::string> condition = std::map<std::string, std::string>(setting.condition().values().begin(), setting.condition().values().end());
+            for (std::pair<std::string const, std::string> const &value : condition) {
+                FingerprintAppend(&fingerprint, value.first + "=" + value.second);
+            }
+
+            FingerprintAppend(&fingerprint, setting.value().raw());
+        }
+    }
+
+    return NinjaHash(fingerprint);
+}
+
+static bool
+TargetNinjaUpToDate(Filesystem const *filesystem, std::string const &targetPath, std::string const &fingerprint)
+{
+    std::string fingerprintPath = TargetNinjaFingerprintPath(targetPath);
+    if (!filesystem->exists(targetPath) || !filesystem->exists(fingerprintPath)) {
+        return false;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, fingerprintPath)) {
+        return false;
+    }
+
+    return std::string(contents.begin(), contents.end()) == fingerprint;
+}
+
+bool NinjaExecutor::
+GenerateTargetNinja(Filesystem *filesystem, std::string const &targetPath, std::string const &fingerprint, std::function<bool()> const &generate, bool *generated)
+{
+    *generated = false;
+
+    if (TargetNinjaUpToDate(filesystem, targetPath, fingerprint)) {
+        return true;
+    }
+
+    if (!generate()) {
+        return false;
+    }
+
+    /*
+     * Record what the target's Ninja file was generated from.
+     */
+    std::vector<uint8_t> contents = std::vector<uint8_t>(fingerprint.begin(), fingerprint.end());
+    if (!filesystem->write(contents, TargetNinjaFingerprintPath(targetPath))) {
+        fprintf(stderr, "error: unable to write target ninja fingerprint: %s\n", targetPath.c_str());
+        return false;
+    }
+
+    *generated = true;
+    return true;
+}
+
 static ext::optional<std::string>
 NinjaExecutablePath(
     process::Context const *processContext,
@@ -194,13 +563,17 @@ WriteNinjaRegenerate(
     std::string const &workingDirectory,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
-    std::vector<std::string> const &inputPaths)
+    std::vector<std::string> const &inputPaths,
+    ActionCache const *actionCache)
 {
     /*
      * Regenerate using this executor. Force regeneration to avoid recursively
      * executing Ninja when Ninja itself calls this generate command.
      */
     std::vector<std::string> generateArguments = { "-generate", "-executor", "ninja" };
+    if (actionCache != nullptr) {
+        generateArguments.insert(generateArguments.end(), { "-actionCache", actionCache->path() });
+    }
 
     /*
      * Add arguments necessary to recreate the same set of build parameters.
@@ -265,8 +638,52 @@ WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string cons
     return true;
 }
 
+static std::string
+NinjaPoolsPath(std::string const &configurationDirectory)
+{
+    return configurationDirectory + "/" + "pools.ninja";
+}
+
+static bool
+WriteNinjaPools(Filesystem *filesystem, std::string const &path, size_t jobs)
+{
+    /*
+     * Limit how many invocations of heavy tools run at once, so they don't
+     * oversubscribe memory while other invocations keep every job busy.
+     * Linking and compiling asset catalogs take a lot of memory, and the
+     * Swift driver runs its own jobs in parallel. The pools are in their own
+     * file, written on every build, so their depths follow the number of jobs
+     * without generating the rest of the Ninja files again.
+     */
+    int depth = static_cast<int>(std::min<size_t>(jobs, INT_MAX));
+    ninja::Writer writer;
+    writer.pool("link", std::max(depth / 4, 1));
+    writer.pool("asset-catalog", std::max(depth / 4, 1));
+    writer.pool("swift", std::max(depth / 2, 1));
+
+    std::string contents = writer.serialize();
+    std::vector<uint8_t> existing;
+    if (filesystem->exists(path) && filesystem->read(&existing, path) && std::string(existing.begin(), existing.end()) == contents) {
+        return true;
+    }
+
+    return WriteNinja(filesystem, writer, path);
+}
+
+static std::string
+NinjaConfigurationHash(Parameters const &buildParameters, ActionCache const *actionCache)
+{
+    /* The action cache changes the command for every invocation. */
+    std::string hash = buildParameters.canonicalHash();
+    if (actionCache != nullptr) {
+        hash += "\n" + actionCache->path();
+    }
+
+    return hash;
+}
+
 static bool
-ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters const &buildParameters, std::string const &ninjaPath, std::string const &configurationHashPath)
+ShouldGenerateNinja(Filesystem const *filesystem, bool generate, std::string const &configurationHash, std::string const &ninjaPath, std::string const &configurationHashPath)
 {
     /*
      * If explicitly asked to generate, definitely need to regenerate.
@@ -299,7 +716,7 @@ ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters cons
         /* Can't be read, same as not existing. */
         return true;
     }
-    if (std::string(contents.begin(), contents.end()) != buildParameters.canonicalHash()) {
+    if (std::string(contents.begin(), contents.end()) != configurationHash) {
         return true;
     }
 
@@ -309,6 +726,216 @@ ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters cons
     return false;
 }
 
+/*
+ * The number of generated configurations to keep. Switching back to one of
+ * these reuses its Ninja files rather than loading the workspace again.
+ */
+static size_t const NinjaConfigurationLimit = 4;
+
+static std::string
+NinjaConfigurationDirectory(std::string const &intermediatesDirectory, std::string const &configurationHash)
+{
+    return intermediatesDirectory + "/" + "ninja" + "/" + NinjaHash(configurationHash);
+}
+
+static std::string
+NinjaConfigurationUsedPath(std::string const &configurationDirectory)
+{
+    /*
+     * Separate from the configuration hash, which the Ninja file depends on:
+     * marking a configuration as used must not cause it to be regenerated.
+     */
+    return configurationDirectory + "/" + ".ninja-used";
+}
+
+bool NinjaExecutor::
+MarkConfigurationUsed(Filesystem *filesystem, std::string const &configurationDirectory)
+{
+    if (!filesystem->createDirectory(configurationDirectory, true)) {
+        return false;
+    }
+
+    /* The modification time records when the configuration was last used. */
+    return filesystem->write(std::vector<uint8_t>(), NinjaConfigurationUsedPath(configurationDirectory));
+}
+
+void NinjaExecutor::
+PruneConfigurations(Filesystem *filesystem, std::string const &configurationDirectory, size_t limit)
+{
+    std::string configurationsDirectory = FSUtil::GetDirectoryName(configurationDirectory);
+    std::string current = FSUtil::GetBaseName(configurationDirectory);
+
+    /*
+     * Find each other generated configuration and when it was last used. Those
+     * that were never marked as used sort last, so they are removed first.
+     */
+    std::vector<std::pair<uint64_t, std::string>> configurations;
+    filesystem->readDirectory(configurationsDirectory, false, [&](std::string const &name) {
+        std::string path = configurationsDirectory + "/" + name;
+        if (name == current || filesystem->type(path) != Filesystem::Type::Directory) {
+            return;
+        }
+
+        uint64_t size = 0;
+        uint64_t modificationTime = 0;
+        if (!filesystem->readInfo(NinjaConfigurationUsedPath(path), &size, &modificationTime)) {
+            modificationTime = 0;
+        }
+
+        configurations.push_back({ modificationTime, path });
+    });
+
+    /* The current configuration takes one of the places. */
+    size_t keep = (limit > 0 ? limit - 1 : 0);
+    if (configurations.size() <= keep) {
+        return;
+    }
+
+    /*
+     * Remove the least recently used configurations, with their target Ninja files.
+     */
+    std::sort(configurations.begin(), configurations.end(), [](std::pair<uint64_t, std::string> const &a, std::pair<uint64_t, std::string> const &b) {
+        return a.first > b.first;
+    });
+    for (auto it = configurations.begin() + keep; it != configurations.end(); ++it) {
+        if (!filesystem->removeDirectory(it->second, true)) {
+            fprintf(stderr, "warning: failed to remove unused Ninja files in %s\n", it->second.c_str());
+        }
+    }
+}
+
+static std::string
+NinjaLogPath(std::string const &configurationDirectory)
+{
+    /* Ninja writes its log into the builddir set in the Ninja file. */
+    return configurationDirectory + "/" + ".ninja_log";
+}
+
+static uint64_t
+NinjaLogSize(Filesystem const *filesystem, std::string const &logPath)
+{
+    uint64_t size;
+    uint64_t modificationTime;
+    if (!filesystem->exists(logPath) || !filesystem->readInfo(logPath, &size, &modificationTime)) {
+        return 0;
+    }
+
+    return size;
+}
+
+/*
+ * The tool identifier for each output, from every target's Ninja file.
+ */
+static std::unordered_map<std::string, std::string>
+NinjaOutputTools(Filesystem const *filesystem, std::string const &configurationDirectory)
+{
+    std::unordered_map<std::string, std::string> tools;
+
+    std::string targetsDirectory = configurationDirectory + "/" + "targets";
+    filesystem->readDirectory(targetsDirectory, false, [&](std::string const &name) {
+        std::string path = targetsDirectory + "/" + name;
+        if (FSUtil::GetFileExtension(path) != "ninja-tools") {
+            return;
+        }
+
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            return;
+        }
+
+        std::istringstream stream = std::istringstream(std::string(contents.begin(), contents.end()));
+        std::string line;
+        while (std::getline(stream, line)) {
+            std::string::size_type space = line.find(' ');
+            if (space != std::string::npos) {
+                tools[line.substr(space + 1)] = line.substr(0, space);
+            }
+        }
+    });
+
+    return tools;
+}
+
+/*
+ * Record the commands Ninja ran as jobs in the tracer. Ninja only appends
+ * to its log, so the entries for this run are those after `previousSize`,
+ * unless Ninja compacted the log first. Either way, a run's entries are
+ * written as they finish; the last run starts after the finish times drop.
+ */
+void NinjaExecutor::
+TraceLog(Filesystem const *filesystem, std::string const &configurationDirectory, uint64_t previousSize, uint64_t start, Tracer *tracer)
+{
+    std::string logPath = NinjaLogPath(configurationDirectory);
+    uint64_t size = NinjaLogSize(filesystem, logPath);
+    uint64_t offset = (size >= previousSize ? previousSize : 0);
+    if (size == offset) {
+        return;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, logPath, offset, size - offset)) {
+        return;
+    }
+
+    std::vector<ninja::Log::Entry> entries;
+    if (!ninja::Log::Parse(std::string(contents.begin(), contents.end()), &entries)) {
+        fprintf(stderr, "warning: failed to parse ninja log %s\n", logPath.c_str());
+        return;
+    }
+
+    size_t first = 0;
+    for (size_t n = 1; n < entries.size(); ++n) {
+        if (entries[n].end() < entries[n - 1].end()) {
+            first = n;
+        }
+    }
+
+    /*
+     * Edges with multiple outputs have an entry for each; only count them once.
+     */
+    std::vector<ninja::Log::Entry> commands;
+    for (size_t n = first; n < entries.size(); ++n) {
+        ninja::Log::Entry const &entry = entries[n];
+        if (!commands.empty() && commands.back().start() == entry.start() && commands.back().end() == entry.end() && commands.back().commandHash() == entry.commandHash()) {
+            continue;
+        }
+
+        commands.push_back(entry);
+    }
+
+    /*
+     * Put each command on the lowest job lane free when it started.
+     */
+    std::sort(commands.begin(), commands.end(), [](ninja::Log::Entry const &a, ninja::Log::Entry const &b) {
+        return a.start() < b.start();
+    });
+
+    std::unordered_map<std::string, std::string> tools = NinjaOutputTools(filesystem, configurationDirectory);
+
+    std::vector<uint64_t> lanes;
+    for (ninja::Log::Entry const &entry : commands) {
+        auto lane = std::find_if(lanes.begin(), lanes.end(), [&](uint64_t end) {
+            return end <= entry.start();
+        });
+        if (lane == lanes.end()) {
+            lane = lanes.insert(lanes.end(), 0);
+        }
+        *lane = entry.end();
+
+        /* Outputs without a known tool, like auxiliary files, are just from Ninja. */
+        auto tool = tools.find(entry.output());
+
+        /* Ninja's times are in milliseconds since it started. */
+        tracer->record(Tracer::Event(
+            (tool != tools.end() ? tool->second : "ninja"),
+            entry.output(),
+            start + entry.start() * 1000,
+            (entry.end() - entry.start()) * 1000,
+            Tracer::Lane::Job,
+            std::distance(lanes.begin(), lane)));
+    }
+}
+
 bool NinjaExecutor::
 build(
     process::Context const *processContext,
@@ -337,8 +964,15 @@ build(
      * at this point because that includes the EFFECTIVE_PLATFORM_NAME, but we don't have a platform.
      */
     std::string intermediatesDirectory = environment.resolve("OBJROOT");
-    std::string ninjaPath = intermediatesDirectory + "/" + "build.ninja";
-    std::string configurationHashPath = intermediatesDirectory + "/" + ".ninja-configuration";
+
+    /*
+     * Each configuration gets its own Ninja files, so switching between recently
+     * used configurations doesn't need to generate them again.
+     */
+    std::string configurationHash = NinjaConfigurationHash(buildParameters, _actionCache.get());
+    std::string configurationDirectory = NinjaConfigurationDirectory(intermediatesDirectory, configurationHash);
+    std::string ninjaPath = configurationDirectory + "/" + "build.ninja";
+    std::string configurationHashPath = configurationDirectory + "/" + ".ninja-configuration";
 
     /*
      * Find the dependency info tool.
@@ -346,16 +980,22 @@ build(
     std::string executableRoot = FSUtil::GetDirectoryName(processContext->executablePath());
     std::string dependencyInfoToolPath = executableRoot + "/" + "dependency-info-tool";
 
+    /*
+     * Find the action cache tool, used to run invocations through the cache.
+     */
+    std::string actionCacheToolPath = executableRoot + "/" + "action-cache-tool";
+
     /*
      * If the Ninja file needs to be generated, generate it.
      */
-    if (ShouldGenerateNinja(filesystem, _generate, buildParameters, ninjaPath, configurationHashPath)) {
+    if (ShouldGenerateNinja(filesystem, _generate, configurationHash, ninjaPath, configurationHashPath)) {
         fprintf(stderr, "Generating Ninja files...\n");
 
         /*
          * Load the workspace. This can be quite slow, so only do it if it's needed to generate
          * the Ninja file. Similarly, only resolve dependencies in that case.
          */
+        uint64_t loadStart = traceStart();
         ext::optional<pbxbuild::WorkspaceContext> workspaceContext = buildParameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
         if (!workspaceContext) {
             fprintf(stderr, "error: unable to load workspace\n");
@@ -367,16 +1007,20 @@ build(
             fprintf(stderr, "error: unable to create build context\n");
             return false;
         }
+        traceSpan("plan", "Load Workspace", loadStart);
 
+        uint64_t resolveStart = traceStart();
         ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
         if (!targetGraph) {
             fprintf(stderr, "error: unable to resolve dependencies\n");
             return false;
         }
+        traceSpan("plan", "Resolve Dependencies", resolveStart);
 
         /*
          * Generate the Ninja file.
          */
+        uint64_t generateStart = traceStart();
         bool result = buildAction(
             processContext,
             filesystem,
@@ -385,26 +1029,49 @@ build(
             *buildContext,
             *targetGraph,
             dependencyInfoToolPath,
+            actionCacheToolPath,
             ninjaPath,
             configurationHashPath,
-            intermediatesDirectory);
+            configurationDirectory);
 
         if (!result) {
             fprintf(stderr, "error: failed to generate build.ninja\n");
             return false;
         }
+        traceSpan("plan", "Generate Ninja", generateStart);
 
         /*
          * Write out the configuration hash for the parameters in the Ninja.
          */
-        std::string hashContents = buildParameters.canonicalHash();
-        auto contents = std::vector<uint8_t>(hashContents.begin(), hashContents.end());
+        auto contents = std::vector<uint8_t>(configurationHash.begin(), configurationHash.end());
         if (!filesystem->write(contents, configurationHashPath)) {
             fprintf(stderr, "error: failed to generate ninja configuration hash\n");
             return false;
         }
     }
 
+    /*
+     * Keep this configuration, and only a few others, for next time.
+     */
+    if (MarkConfigurationUsed(filesystem, configurationDirectory)) {
+        PruneConfigurations(filesystem, configurationDirectory, NinjaConfigurationLimit);
+    } else {
+        /* Without a record of use, this configuration could look unused to the next build. */
+        fprintf(stderr, "warning: failed to mark ninja configuration as used, not removing unused configurations\n");
+    }
+
+    /*
+     * Size the pools for this build's number of jobs. When Ninja regenerates
+     * its files, it runs without the original job count, so keep the pools.
+     */
+    std::string poolsPath = NinjaPoolsPath(configurationDirectory);
+    if (!_generate || !filesystem->exists(poolsPath)) {
+        if (!WriteNinjaPools(filesystem, poolsPath, _jobs)) {
+            fprintf(stderr, "error: failed to write Ninja pools to %s\n", poolsPath.c_str());
+            return false;
+        }
+    }
+
     /*
      * Only perform a build if not passing -generate. If -generate is passed, that's because Ninja
      * is already running and asking to re-generate the project file. Re-running it would recurse.
@@ -447,7 +1114,11 @@ build(
             arguments.push_back("-n");
         }
 
-        // TODO(grp): Pass number of jobs if specified.
+        /*
+         * Limit the number of jobs Ninja runs at once.
+         */
+        arguments.push_back("-j");
+        arguments.push_back(std::to_string(_jobs));
 
         /*
          * Run Ninja and return if it failed. Ninja itself does the build.
@@ -462,7 +1133,19 @@ build(
             processContext->userName(),
             processContext->groupName());
 
+        std::string logPath = NinjaLogPath(configurationDirectory);
+        uint64_t logSize = NinjaLogSize(filesystem, logPath);
+        uint64_t ninjaStart = traceStart();
+
         ext::optional<int> exitCode = processLauncher->launch(filesystem, &ninja);
+
+        /*
+         * Ninja doesn't report how long its commands took, but logs it.
+         */
+        if (_tracer != nullptr) {
+            TraceLog(filesystem, configurationDirectory, logSize, ninjaStart, _tracer.get());
+        }
+
         if (!exitCode || *exitCode != 0) {
             return false;
         }
@@ -480,9 +1163,10 @@ buildAction(
     pbxbuild::Build::Context const &buildContext,
     pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheToolPath,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
-    std::string const &intermediatesDirectory)
+    std::string const &configurationDirectory)
 {
     /*
      * Write out a Ninja file for the build as a whole. Note each target will have a separate
@@ -503,9 +1187,10 @@ buildAction(
     writer.newline();
 
     /*
-     * Ninja's intermediate outputs should also go in the temp dir.
+     * Ninja's intermediate outputs, like its log and dependencies, should also
+     * be kept with the configuration they describe.
      */
-    writer.binding({ "builddir", { ninja::Value::String(intermediatesDirectory) } });
+    writer.binding({ "builddir", { ninja::Value::String(configurationDirectory) } });
     writer.newline();
 
     /*
@@ -514,122 +1199,100 @@ buildAction(
      * the build command that calls it.
      */
     writer.rule(NinjaRuleName(), ninja::Value::Expression("cd $dir && env -i $env $exec && $depexec"));
+    writer.newline();
 
     /*
-     * Go over each target and write out Ninja targets for the start and end of each.
-     * Don't bother topologically sorting the targets now, since Ninja will do that for us.
+     * Pools must be declared before any target's Ninja file uses them.
      */
-    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
+    writer.include(ninja::Value::String(NinjaPoolsPath(configurationDirectory)));
+    writer.newline();
 
-        /*
-         * Beginning target depends on finishing the targets before that. This is implemented
-         * in three parts:
-         *
-         *  1. Each target has a "target begin" Ninja target depending on completing the build
-         *     of any dependent targets.
-         *  2. Each invocation's Ninja target depends on the "target begin" target to order
-         *     them necessarily after the target started building.
-         *  3. Each target also has a "target finish" Ninja target, which depends on all of
-         *     the invocations created for the target.
-         *
-         * The end result is that targets build in the right order. Note this does not preclude
-         * cross-target parallelization; if the target dependency graph doesn't have an edge,
-         * then they will be parallelized. Linear builds have edges from each target to all
-         * previous targets.
-         */
+    /*
+     * Generator and specification changes can change the target Ninja files,
+     * so they must be regenerated.
+     */
+    std::string generatorFingerprint = processContext->executablePath();
+    uint64_t generatorSize = 0;
+    uint64_t generatorModificationTime = 0;
+    if (filesystem->readInfo(processContext->executablePath(), &generatorSize, &generatorModificationTime)) {
+        generatorFingerprint += ":" + std::to_string(generatorSize) + ":" + std::to_string(generatorModificationTime);
+    }
+    std::string specificationFingerprint = SpecificationFingerprint(filesystem, buildEnvironment.specManager());
 
+    /*
+     * Go over each target and include its Ninja file. Don't bother topologically sorting
+     * the targets now, since Ninja will do that for us.
+     */
+    size_t generatedTargets = 0;
+    std::unordered_map<pbxproj::PBX::Project::shared_ptr, std::string> projectFingerprints;
+    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
         /*
-         * Resolve this target and generate its invocations.
+         * Resolve this target's environment.
          */
+        uint64_t environmentStart = traceStart();
         ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
         if (!targetEnvironment) {
             fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
             continue;
         }
+        traceSpan("plan", "Create Environment: " + target->name(), environmentStart);
 
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> dependencies = targetGraph.adjacent(target);
 
         /*
-         * As described above, the target's begin depends on all of the target dependencies.
+         * Only resolve the target's invocations if something they depend on
+         * changed since its Ninja file was written. This is most of the time
+         * spent generating, so unchanged targets are skipped.
          */
-        std::vector<ninja::Value> dependenciesFinished;
-        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
-            std::string targetFinished = TargetNinjaFinish(dependency);
-            dependenciesFinished.push_back(ninja::Value::String(targetFinished));
+        auto projectFingerprint = projectFingerprints.find(target->project());
+        if (projectFingerprint == projectFingerprints.end()) {
+            projectFingerprint = projectFingerprints.insert({ target->project(), ProjectNinjaFingerprint(target->project()) }).first;
         }
 
-        /*
-         * Add the phony target for beginning this target's build.
-         */
-        std::string targetBegin = TargetNinjaBegin(target);
-        writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
+        std::string targetPath = TargetNinjaPath(*targetEnvironment, configurationDirectory);
+        std::string fingerprint = TargetFingerprint(
+            filesystem,
+            generatorFingerprint,
+            specificationFingerprint,
+            projectFingerprint->second,
+            buildContext,
+            target,
+            *targetEnvironment,
+            dependencies);
+
+        bool generated = false;
+        bool success = GenerateTargetNinja(filesystem, targetPath, fingerprint, [&]() -> bool {
+            uint64_t phaseStart = traceStart();
+            pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+            pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+            traceSpan("plan", "Resolve Phases: " + target->name(), phaseStart);
 
-        /*
-         * Add the phony target for the checkpoint after writing auxiliary files.
-         */
-        std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
-        std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
-                auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
+            /*
+             * Write out the Ninja file to build this target.
+             */
+            if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, actionCacheToolPath, target, *targetEnvironment, dependencies, phaseInvocations.invocations(), targetPath)) {
+                fprintf(stderr, "error: failed to build target ninja\n");
+                return false;
             }
-        }
-        writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
-        /*
-         * Write out the Ninja file to build this target.
-         */
-        if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.invocations())) {
-            fprintf(stderr, "error: failed to build target ninja\n");
+            return true;
+        }, &generated);
+        if (!success) {
             return false;
         }
 
-        /*
-         * Load the Ninja file generated for this target.
-         */
-        std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
-        writer.subninja(ninja::Value::String(targetPath));
-
-        /*
-         * As described above, the target's finish depends on all of the invocation outputs.
-         */
-        std::unordered_set<std::string> invocationOutputs;
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            if (!invocation.executable()) {
-                /* No outputs. */
-                continue;
-            }
-
-            std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
-            invocationOutputs.insert(outputs.begin(), outputs.end());
+        if (generated) {
+            generatedTargets++;
         }
 
         /*
-         * Add phony rules for input dependencies that we don't know if they exist.
-         * This can come up, for example, for user-specified custom script inputs.
-         * However, avoid adding the phony invocation if a real output *does* include
-         * the phony input, to avoid Ninja complaining about duplicate rules.
+         * Load the Ninja file for this target.
          */
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            for (std::string const &phonyInput : invocation.phonyInputs()) {
-                if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
-                    writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
-                }
-            }
-        }
-
-        /*
-         * Add the phony target for ending this target's build.
-         */
-        std::string targetFinish = TargetNinjaFinish(target);
-        std::vector<ninja::Value> invocationOutputsValues;
-        for (std::string const &output : invocationOutputs) {
-            invocationOutputsValues.push_back(ninja::Value::String(output));
-        }
-        writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
+        writer.subninja(ninja::Value::String(targetPath));
     }
 
+    fprintf(stderr, "Generated Ninja for %zu of %zu targets\n", generatedTargets, targetGraph.nodes().size());
+
     /*
      * Build up a list of all of the inputs to the build, so Ninja can regenerate as necessary.
      */
@@ -645,7 +1308,8 @@ buildAction(
         processContext->currentDirectory(),
         ninjaPath,
         configurationHashPath,
-        inputPaths);
+        inputPaths,
+        _actionCache.get());
 
     /*
      * Serialize the Ninja file into the build root.
@@ -668,9 +1332,12 @@ buildTargetInvocations(
     process::Context const *processContext,
     Filesystem *filesystem,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheToolPath,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
-    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> const &dependencies,
+    std::vector<pbxbuild::Tool::Invocation> const &invocations,
+    std::string const &path)
 {
     /*
      * Start building the Ninja file for this target.
@@ -680,8 +1347,52 @@ buildTargetInvocations(
     writer.comment("Target: " + target->name());
     writer.newline();
 
+    /*
+     * Beginning target depends on finishing the targets before that. This is implemented
+     * in three parts:
+     *
+     *  1. Each target has a "target begin" Ninja target depending on completing the build
+     *     of any dependent targets.
+     *  2. Each invocation's Ninja target depends on the "target begin" target to order
+     *     them necessarily after the target started building.
+     *  3. Each target also has a "target finish" Ninja target, which depends on all of
+     *     the invocations created for the target.
+     *
+     * The end result is that targets build in the right order. Note this does not preclude
+     * cross-target parallelization; if the target dependency graph doesn't have an edge,
+     * then they will be parallelized. Linear builds have edges from each target to all
+     * previous targets.
+     *
+     * These are all in the target's Ninja file, so only that file needs to be
+     * regenerated when the target changes.
+     */
+
+    /*
+     * As described above, the target's begin depends on all of the target dependencies.
+     */
+    std::vector<ninja::Value> dependenciesFinished;
+    for (pbxproj::PBX::Target::shared_ptr const &dependency : dependencies) {
+        std::string targetFinished = TargetNinjaFinish(dependency);
+        dependenciesFinished.push_back(ninja::Value::String(targetFinished));
+    }
+
+    /*
+     * Add the phony target for beginning this target's build.
+     */
     std::string targetBegin = TargetNinjaBegin(target);
+    writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
+
+    /*
+     * Add the phony target for the checkpoint after writing auxiliary files.
+     */
     std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
+    std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+            auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
+        }
+    }
+    writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
     pbxsetting::Environment const &environment = targetEnvironment.environment();
     std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
@@ -689,6 +1400,7 @@ buildTargetInvocations(
     /*
      * Add the build command for each invocation.
      */
+    std::string tools;
     for (pbxbuild::Tool::Invocation const &invocation : invocations) {
         /* Write auxiliary files to run first. */
         for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
@@ -708,21 +1420,69 @@ buildTargetInvocations(
             }
 
             /* Write invocations to run after auxiliary files. */
-            if (!buildInvocation(&writer, invocation, *executablePath, dependencyInfoToolPath, temporaryDirectory, targetWriteAuxiliaryFiles)) {
+            if (!buildInvocation(&writer, invocation, *executablePath, dependencyInfoToolPath, actionCacheToolPath, temporaryDirectory, targetWriteAuxiliaryFiles)) {
                 return false;
             }
+
+            if (!invocation.toolIdentifier().empty()) {
+                for (std::string const &output : NinjaInvocationOutputs(invocation)) {
+                    tools += invocation.toolIdentifier() + " " + output + "\n";
+                }
+            }
+        }
+    }
+
+    /*
+     * As described above, the target's finish depends on all of the invocation outputs.
+     */
+    std::unordered_set<std::string> invocationOutputs;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (!invocation.executable()) {
+            /* No outputs. */
+            continue;
+        }
+
+        std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
+        invocationOutputs.insert(outputs.begin(), outputs.end());
+    }
+
+    /*
+     * Add phony rules for input dependencies that we don't know if they exist.
+     * This can come up, for example, for user-specified custom script inputs.
+     * However, avoid adding the phony invocation if a real output *does* include
+     * the phony input, to avoid Ninja complaining about duplicate rules.
+     */
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (std::string const &phonyInput : invocation.phonyInputs()) {
+            if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
+                writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
+            }
         }
     }
 
+    /*
+     * Add the phony target for ending this target's build.
+     */
+    std::string targetFinish = TargetNinjaFinish(target);
+    std::vector<ninja::Value> invocationOutputsValues;
+    for (std::string const &output : invocationOutputs) {
+        invocationOutputsValues.push_back(ninja::Value::String(output));
+    }
+    writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
+
     /*
      * Serialize the Ninja file into the build root.
      */
-    std::string path = TargetNinjaPath(target, targetEnvironment);
     if (!WriteNinja(filesystem, writer, path)) {
         fprintf(stderr, "error: unable to write target ninja: %s\n", path.c_str());
         return false;
     }
 
+    if (!filesystem->write(std::vector<uint8_t>(tools.begin(), tools.end()), TargetNinjaToolsPath(path))) {
+        fprintf(stderr, "error: unable to write target ninja tools: %s\n", path.c_str());
+        return false;
+    }
+
     return true;
 }
 
@@ -792,6 +1552,7 @@ buildInvocation(
     pbxbuild::Tool::Invocation const &invocation,
     std::string const &executablePath,
     std::string const &dependencyInfoToolPath,
+    std::string const &actionCacheToolPath,
     std::string const &temporaryDirectory,
     std::string const &after)
 {
@@ -804,6 +1565,40 @@ buildInvocation(
         exec += " " + Escape::Shell(arg);
     }
 
+    /*
+     * Run through the action cache tool, which restores the outputs instead
+     * of running the command if its inputs are unchanged since it last ran.
+     */
+    if (_actionCache != nullptr) {
+        ActionCache::Action action = ActionCache::Action::Create(invocation, executablePath);
+
+        std::vector<std::string> actionArguments = {
+            "--cache", _actionCache->path(),
+            "--fingerprint", action.fingerprint(),
+            "--executable", executablePath,
+        };
+        for (std::string const &input : action.inputs()) {
+            actionArguments.insert(actionArguments.end(), { "--input", input });
+        }
+        for (std::string const &output : action.outputs()) {
+            actionArguments.insert(actionArguments.end(), { "--output", output });
+        }
+        for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : action.dependencyInfo()) {
+            std::string formatName;
+            if (!dependency::DependencyInfoFormats::Name(dependencyInfo.first, &formatName)) {
+                return false;
+            }
+
+            actionArguments.insert(actionArguments.end(), { "--dependency-info", formatName + ":" + dependencyInfo.second });
+        }
+
+        std::string actionExec = Escape::Shell(actionCacheToolPath);
+        for (std::string const &arg : actionArguments) {
+            actionExec += " " + Escape::Shell(arg);
+        }
+        exec = actionExec + " -- " + exec;
+    }
+
     /*
      * Build the invocation environment. To set the environment, we use standard shell syntax.
      * Use `env` to avoid Bash-specific limitations on environment variables. Specifically, some
@@ -879,6 +1674,9 @@ buildInvocation(
     if (!dependencyInfoFile.empty()) {
         bindings.push_back({ "depfile", ninja::Value::String(dependencyInfoFile) });
     }
+    if (ext::optional<std::string> pool = NinjaPoolName(invocation.toolIdentifier())) {
+        bindings.push_back({ "pool", ninja::Value::String(*pool) });
+    }
 
     /*
      * Build up outputs as literal Ninja values.
@@ -926,11 +1724,14 @@ buildInvocation(
 }
 
 std::unique_ptr<NinjaExecutor> NinjaExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, size_t jobs, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer)
 {
     return std::unique_ptr<NinjaExecutor>(new NinjaExecutor(
         formatter,
         dryRun,
-        generate
+        generate,
+        jobs,
+        actionCache,
+        tracer
     ));
 }
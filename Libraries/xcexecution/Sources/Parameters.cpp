@@ -10,6 +10,7 @@
 #include <xcexecution/Parameters.h>
 
 #include <pbxbuild/Build/DependencyResolver.h>
+#include <pbxsetting/XC/ConfigCache.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <libutil/md5.h>
@@ -151,9 +152,27 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
     }
 }
 
+/*
+ * Parsed configuration files are kept with the workspace's intermediates,
+ * like the generated Ninja files.
+ */
+static std::string
+ConfigCachePath(pbxbuild::Build::Environment const &buildEnvironment, std::string const &workspacePath)
+{
+    pbxbuild::DerivedDataHash derivedDataHash = pbxbuild::DerivedDataHash::Create(workspacePath);
+
+    pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+    environment.insertFront(pbxsetting::Level(derivedDataHash.overrideSettings()), false);
+    return environment.resolve("OBJROOT") + "/" + "xcconfig.cache";
+}
+
 ext::optional<pbxbuild::WorkspaceContext> Parameters::
-loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
+loadWorkspace(Filesystem *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
 {
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext;
+    std::string configCachePath;
+    std::unique_ptr<pbxsetting::XC::ConfigCache> configCache;
+
     if (_workspace) {
         xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, *_workspace);
         if (workspace == nullptr) {
@@ -161,15 +180,29 @@ loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuil
             return ext::nullopt;
         }
 
-        return pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace);
+        configCachePath = ConfigCachePath(buildEnvironment, workspace->projectFile());
+        configCache = pbxsetting::XC::ConfigCache::Read(filesystem, configCachePath);
+        workspaceContext = pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace, configCache.get());
     } else {
         pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, _project, workingDirectory);
         if (project == nullptr) {
             return ext::nullopt;
         }
 
-        return pbxbuild::WorkspaceContext::Project(filesystem, userName, buildEnvironment.baseEnvironment(), project);
+        configCachePath = ConfigCachePath(buildEnvironment, project->projectFile());
+        configCache = pbxsetting::XC::ConfigCache::Read(filesystem, configCachePath);
+        workspaceContext = pbxbuild::WorkspaceContext::Project(filesystem, userName, buildEnvironment.baseEnvironment(), project, configCache.get());
+    }
+
+    /*
+     * Save newly parsed configuration files for next time. The cache is
+     * only an optimization, so failing to write it is not an error.
+     */
+    if (configCache->modified()) {
+        configCache->write(filesystem, configCachePath);
     }
+
+    return workspaceContext;
 }
 
 ext::optional<pbxbuild::Build::Context> Parameters::
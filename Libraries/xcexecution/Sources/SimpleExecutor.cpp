@@ -19,18 +19,69 @@
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
 
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <tuple>
+
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 using xcexecution::SimpleExecutor;
+using xcexecution::ActionCache;
+using xcexecution::BuildState;
+using xcexecution::JobPool;
 using libutil::Filesystem;
 using libutil::FSUtil;
 using libutil::Permissions;
 
+/*
+ * Formatter output of the target building on this thread. Targets building in
+ * parallel collect their output here, to print as one block once they finish.
+ */
+static thread_local std::string *TargetOutput = nullptr;
+
+static void
+Print(std::string const &output)
+{
+    if (TargetOutput != nullptr) {
+        TargetOutput->append(output);
+    } else {
+        xcformatter::Formatter::Print(output);
+    }
+}
+
+/*
+ * Traced jobs the target building on this thread waits on: at first, the
+ * last jobs of the targets it depends on, then its own as it builds. These
+ * are the real predecessors of its first jobs, for finding the critical path.
+ */
+static thread_local std::vector<size_t> *TargetJobs = nullptr;
+
+/*
+ * The union of the traced jobs for some invocations.
+ */
+static std::vector<size_t>
+MergeJobs(std::vector<std::vector<size_t>> const &jobs, std::vector<size_t> const &indexes)
+{
+    std::vector<size_t> merged;
+    for (size_t index : indexes) {
+        merged.insert(merged.end(), jobs[index].begin(), jobs[index].end());
+    }
+
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    return merged;
+}
+
 SimpleExecutor::
-SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins) :
-    Executor (formatter, dryRun, false),
-    _builtins(builtins)
+SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer) :
+    Executor           (formatter, dryRun, false, tracer),
+    _builtins          (builtins),
+    _jobPool           (std::make_shared<JobPool>(jobs)),
+    _parallelizeTargets(parallelizeTargets),
+    _actionCache       (actionCache)
 {
 }
 
@@ -47,6 +98,7 @@ build(
     pbxbuild::Build::Environment const &buildEnvironment,
     Parameters const &buildParameters)
 {
+    uint64_t loadStart = traceStart();
     ext::optional<pbxbuild::WorkspaceContext> workspaceContext = buildParameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
     if (!workspaceContext) {
         return false;
@@ -56,13 +108,16 @@ build(
     if (!buildContext) {
         return false;
     }
+    traceSpan("plan", "Load Workspace", loadStart);
 
-    xcformatter::Formatter::Print(_formatter->begin(*buildContext));
+    Print(_formatter->begin(*buildContext));
 
+    uint64_t resolveStart = traceStart();
     ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
     if (!targetGraph) {
         return false;
     }
+    traceSpan("plan", "Resolve Dependencies", resolveStart);
 
     ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph->ordered();
     if (!orderedTargets) {
@@ -70,35 +125,183 @@ build(
         return false;
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
-        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
-
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            continue;
+    if (_parallelizeTargets) {
+        auto result = buildTargetsInParallel(*targetGraph, *orderedTargets, [&](pbxproj::PBX::Target::shared_ptr const &target) {
+            return planAndBuildTarget(processContext, processLauncher, filesystem, buildEnvironment, *buildContext, target);
+        });
+        if (!result.first) {
+            Print(_formatter->failure(*buildContext, result.second));
+            return false;
         }
 
-        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+        Print(_formatter->success(*buildContext));
+        return true;
+    }
 
-        auto result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations.invocations());
+    /* Each target waits on all of the targets before it. */
+    std::vector<size_t> jobs;
+    TargetJobs = &jobs;
+    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
+        auto result = planAndBuildTarget(processContext, processLauncher, filesystem, buildEnvironment, *buildContext, target);
         if (!result.first) {
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
+            TargetJobs = nullptr;
+            Print(_formatter->failure(*buildContext, result.second));
             return false;
         }
-
-        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
     }
+    TargetJobs = nullptr;
 
-    xcformatter::Formatter::Print(_formatter->success(*buildContext));
+    Print(_formatter->success(*buildContext));
     return true;
 }
 
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+buildTargetsInParallel(
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+    std::function<std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>(pbxproj::PBX::Target::shared_ptr const &target)> const &buildTarget)
+{
+    /* Start each build with a fresh job budget, in case a previous build was cancelled. */
+    _jobPool = std::make_shared<JobPool>(_jobPool->jobs());
+
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> targetToIndex;
+    for (size_t index = 0; index < orderedTargets.size(); ++index) {
+        targetToIndex.insert({ orderedTargets[index], index });
+    }
+
+    /*
+     * A target can start once all of the targets it depends on are built.
+     * Targets with no path between them in the graph build at the same time.
+     */
+    std::vector<size_t> remainingDependencies = std::vector<size_t>(orderedTargets.size(), 0);
+    std::vector<std::vector<size_t>> dependencies = std::vector<std::vector<size_t>>(orderedTargets.size());
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(orderedTargets.size());
+    for (size_t index = 0; index < orderedTargets.size(); ++index) {
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(orderedTargets[index])) {
+            auto it = targetToIndex.find(dependency);
+            if (it != targetToIndex.end() && it->second != index) {
+                dependencies[index].push_back(it->second);
+                dependents[it->second].push_back(index);
+                remainingDependencies[index]++;
+            }
+        }
+    }
+
+    std::set<size_t> ready;
+    for (size_t index = 0; index < orderedTargets.size(); ++index) {
+        if (remainingDependencies[index] == 0) {
+            ready.insert(index);
+        }
+    }
+
+    /*
+     * Targets run on their own threads, but invocations from every target
+     * share the executor's job pool. This separate pool just limits how many
+     * targets are planned and waiting on invocations at once.
+     */
+    JobPool targetPool(_jobPool->jobs());
+    JobPool::Group group(&targetPool);
+
+    std::vector<std::vector<pbxbuild::Tool::Invocation>> targetFailures = std::vector<std::vector<pbxbuild::Tool::Invocation>>(orderedTargets.size());
+    std::vector<std::string> targetOutputs = std::vector<std::string>(orderedTargets.size());
+    std::vector<std::vector<size_t>> targetJobs = std::vector<std::vector<size_t>>(orderedTargets.size());
+    bool failed = false;
+
+    while (true) {
+        while (!failed && !ready.empty() && group.acquire()) {
+            size_t index = *ready.begin();
+            ready.erase(ready.begin());
+
+            pbxproj::PBX::Target::shared_ptr const &target = orderedTargets[index];
+            std::vector<pbxbuild::Tool::Invocation> *failures = &targetFailures[index];
+            std::string *output = &targetOutputs[index];
+
+            /* Dependencies have finished, so their jobs are no longer changing. */
+            std::vector<size_t> *jobs = &targetJobs[index];
+            *jobs = MergeJobs(targetJobs, dependencies[index]);
+
+            group.start(index, [&buildTarget, target, failures, output, jobs] {
+                TargetOutput = output;
+                TargetJobs = jobs;
+                auto result = buildTarget(target);
+                TargetOutput = nullptr;
+                TargetJobs = nullptr;
+
+                *failures = result.second;
+                return result.first;
+            });
+        }
+
+        bool waitForTarget = (!failed && !ready.empty());
+        if (group.running() == 0 && !waitForTarget) {
+            break;
+        }
+
+        for (JobPool::Group::Result const &result : group.wait(waitForTarget)) {
+            Print(targetOutputs[result.first]);
+            targetOutputs[result.first].clear();
+
+            if (!result.second) {
+                /* Stop starting targets and invocations, but let running invocations finish. */
+                failed = true;
+                _jobPool->cancel();
+                continue;
+            }
+
+            for (size_t dependent : dependents[result.first]) {
+                if (--remainingDependencies[dependent] == 0) {
+                    ready.insert(dependent);
+                }
+            }
+        }
+    }
+
+    if (failed) {
+        std::vector<pbxbuild::Tool::Invocation> failures;
+        for (std::vector<pbxbuild::Tool::Invocation> const &targetFailure : targetFailures) {
+            failures.insert(failures.end(), targetFailure.begin(), targetFailure.end());
+        }
+
+        return std::make_pair(false, failures);
+    }
+
+    return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+planAndBuildTarget(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxproj::PBX::Target::shared_ptr const &target)
+{
+    uint64_t targetStart = traceStart();
+    Print(_formatter->beginTarget(buildContext, target));
+
+    uint64_t environmentStart = traceStart();
+    ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+    if (!targetEnvironment) {
+        fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+        Print(_formatter->finishTarget(buildContext, target));
+        return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+    }
+    traceSpan("plan", "Create Environment: " + target->name(), environmentStart);
+
+    uint64_t phaseStart = traceStart();
+    Print(_formatter->beginCheckDependencies(target));
+    pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+    pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+    Print(_formatter->finishCheckDependencies(target));
+    traceSpan("plan", "Resolve Phases: " + target->name(), phaseStart);
+
+    auto result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations.invocations());
+    Print(_formatter->finishTarget(buildContext, target));
+    traceSpan("target", "Build Target: " + target->name(), targetStart);
+    return result;
+}
+
 static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
 SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
@@ -147,6 +350,129 @@ SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
     return result;
 }
 
+/*
+ * Reads the contents of a chunk, if they are not already in memory. Only one
+ * chunk is read at a time, rather than combining them all into one buffer.
+ */
+static std::vector<uint8_t> const *
+AuxiliaryFileChunkContents(Filesystem const *filesystem, pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk, std::vector<uint8_t> *buffer)
+{
+    switch (chunk.type()) {
+        case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::Data:
+            return &*chunk.data();
+        case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::File:
+            buffer->clear();
+            if (!filesystem->read(buffer, *chunk.file())) {
+                return nullptr;
+            }
+            return buffer;
+        default: abort();
+    }
+}
+
+static bool
+AuxiliaryFileUnchanged(Filesystem const *filesystem, pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile)
+{
+    uint64_t size = 0;
+    uint64_t modificationTime = 0;
+    if (!filesystem->readInfo(auxiliaryFile.path(), &size, &modificationTime)) {
+        return false;
+    }
+
+    /*
+     * Compare sizes first. This doesn't need to read any contents.
+     */
+    uint64_t expectedSize = 0;
+    for (pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
+        switch (chunk.type()) {
+            case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::Data: {
+                expectedSize += chunk.data()->size();
+                break;
+            }
+            case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::File: {
+                uint64_t chunkSize = 0;
+                if (!filesystem->readInfo(*chunk.file(), &chunkSize, &modificationTime)) {
+                    return false;
+                }
+                expectedSize += chunkSize;
+                break;
+            }
+            default: abort();
+        }
+    }
+    if (expectedSize != size) {
+        return false;
+    }
+
+    /*
+     * Compare each chunk with the same range of the existing file.
+     */
+    size_t offset = 0;
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> existing;
+    for (pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
+        std::vector<uint8_t> const *contents = AuxiliaryFileChunkContents(filesystem, chunk, &buffer);
+        if (contents == nullptr) {
+            return false;
+        }
+        if (contents->empty()) {
+            continue;
+        }
+
+        existing.clear();
+        if (!filesystem->read(&existing, auxiliaryFile.path(), offset, contents->size()) || existing != *contents) {
+            return false;
+        }
+
+        offset += contents->size();
+    }
+
+    return true;
+}
+
+static bool
+WriteAuxiliaryFile(Filesystem *filesystem, pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile)
+{
+    static std::atomic<uint64_t> counter(0);
+
+    /* Leave unchanged files alone, so anything using them is still up to date. */
+    if (!AuxiliaryFileUnchanged(filesystem, auxiliaryFile)) {
+        /*
+         * Write to a temporary path and move it into place, so a failure
+         * part way through never replaces a good file with a partial one.
+         */
+        std::string temporaryPath = auxiliaryFile.path() + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+        bool written = filesystem->writeChunks([&](std::function<bool(std::vector<uint8_t> const &)> const &write) -> bool {
+            std::vector<uint8_t> buffer;
+            for (pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
+                std::vector<uint8_t> const *contents = AuxiliaryFileChunkContents(filesystem, chunk, &buffer);
+                if (contents == nullptr || !write(*contents)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }, temporaryPath);
+
+        if (!written || !filesystem->moveFile(temporaryPath, auxiliaryFile.path())) {
+            filesystem->removeFile(temporaryPath);
+            return false;
+        }
+    }
+
+    if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
+        Permissions permissions = Permissions(
+            { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
+            { Permissions::Permission::Read, Permissions::Permission::Execute },
+            { Permissions::Permission::Read, Permissions::Permission::Execute });
+        if (!filesystem->writeFilePermissions(auxiliaryFile.path(), Permissions::Operation::Set, permissions)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool SimpleExecutor::
 writeAuxiliaryFiles(
     Filesystem *filesystem,
@@ -154,12 +480,19 @@ writeAuxiliaryFiles(
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
-    xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
+    uint64_t start = traceStart();
+    Print(_formatter->beginWriteAuxiliaryFiles(target));
+
+    /*
+     * Create directories and report each file in order. The files themselves
+     * are independent of each other, so they are written in parallel below.
+     */
+    std::vector<pbxbuild::Tool::Invocation::AuxiliaryFile const *> auxiliaryFiles;
     for (pbxbuild::Tool::Invocation const &invocation : invocations) {
         for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
             std::string directory = FSUtil::GetDirectoryName(auxiliaryFile.path());
             if (filesystem->type(directory) != Filesystem::Type::Directory) {
-                xcformatter::Formatter::Print(_formatter->createAuxiliaryDirectory(directory));
+                Print(_formatter->createAuxiliaryDirectory(directory));
 
                 if (!_dryRun) {
                     if (!filesystem->createDirectory(directory, true)) {
@@ -168,50 +501,83 @@ writeAuxiliaryFiles(
                 }
             }
 
-            xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
-
-            if (!_dryRun) {
-                std::vector<uint8_t> data;
-
-                for (pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
-                    switch (chunk.type()) {
-                        case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::Data: {
-                            data.insert(data.end(), chunk.data()->begin(), chunk.data()->end());
-                            break;
-                        }
-                        case pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Type::File: {
-                            std::vector<uint8_t> contents;
-                            if (!filesystem->read(&contents, *chunk.file())) {
-                                return false;
-                            }
-                            data.insert(data.end(), contents.begin(), contents.end());
-                            break;
-                        }
-                        default: abort();
-                    }
+            Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
+
+            if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
+                Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+            }
+
+            auxiliaryFiles.push_back(&auxiliaryFile);
+        }
+    }
+
+    if (!_dryRun) {
+        bool success = true;
+        JobPool::Group group(_jobPool.get());
+
+        for (size_t index = 0; index < auxiliaryFiles.size() && success; index++) {
+            /* Wait for a job to become available, collecting any writes that finished. */
+            while (success && !group.acquire()) {
+                if (_jobPool->cancelled()) {
+                    success = false;
+                    break;
                 }
 
-                if (!filesystem->write(data, auxiliaryFile.path())) {
-                    return false;
+                for (JobPool::Group::Result const &result : group.wait(true)) {
+                    success &= result.second;
                 }
             }
+            if (!success) {
+                break;
+            }
 
-            if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
-                xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+            pbxbuild::Tool::Invocation::AuxiliaryFile const *auxiliaryFile = auxiliaryFiles[index];
+            group.start(index, [filesystem, auxiliaryFile] {
+                return WriteAuxiliaryFile(filesystem, *auxiliaryFile);
+            });
+        }
 
-                if (!_dryRun) {
-                    Permissions permissions = Permissions(
-                        { Permissions::Permission::Read, Permissions::Permission::Write, Permissions::Permission::Execute },
-                        { Permissions::Permission::Read, Permissions::Permission::Execute },
-                        { Permissions::Permission::Read, Permissions::Permission::Execute });
-                    if (!filesystem->writeFilePermissions(auxiliaryFile.path(), Permissions::Operation::Set, permissions)) {
-                        return false;
-                    }
-                }
+        while (group.running() > 0) {
+            for (JobPool::Group::Result const &result : group.wait(false)) {
+                success &= result.second;
             }
         }
+
+        if (!success) {
+            return false;
+        }
+    }
+
+    Print(_formatter->finishWriteAuxiliaryFiles(target));
+    traceSpan("plan", "Write Auxiliary Files: " + target->name(), start);
+
+    return true;
+}
+
+/*
+ * Run an action, unless its outputs can be restored from the action cache.
+ * Called on a worker thread, as hashing the inputs can be slow.
+ */
+static bool
+PerformCached(Filesystem *filesystem, ActionCache const *actionCache, ActionCache::Action const &action, std::function<bool()> const &perform)
+{
+    if (actionCache == nullptr) {
+        return perform();
+    }
+
+    ext::optional<std::string> key = actionCache->key(filesystem, action);
+    if (key && actionCache->restore(filesystem, action, *key)) {
+        return true;
+    }
+
+    if (!perform()) {
+        return false;
+    }
+
+    if (key) {
+        /* Failing to store is not an error, the action just runs next time. */
+        actionCache->store(filesystem, action, *key);
     }
-    xcformatter::Formatter::Print(_formatter->finishWriteAuxiliaryFiles(target));
 
     return true;
 }
@@ -223,34 +589,133 @@ performInvocations(
     Filesystem *filesystem,
     std::vector<std::string> const &executablePaths,
     std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-    bool createProductStructure)
+    bool createProductStructure,
+    BuildState *buildState)
 {
-    for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
-        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
-        if (!invocation.executable()) {
-            continue;
+    /*
+     * Find the invocations each invocation depends on, by index. This is the
+     * same graph used to order the invocations, but is needed here to know
+     * which invocations are ready to run at the same time.
+     */
+    std::unordered_map<std::string, size_t> outputToIndex;
+    for (size_t index = 0; index < orderedInvocations.size(); ++index) {
+        for (std::string const &output : orderedInvocations[index].outputs()) {
+            outputToIndex.insert({ output, index });
         }
-        pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
+    }
 
-        if (invocation.createsProductStructure() != createProductStructure) {
-            continue;
+    std::vector<size_t> remainingDependencies = std::vector<size_t>(orderedInvocations.size(), 0);
+    std::vector<std::vector<size_t>> invocationDependencies = std::vector<std::vector<size_t>>(orderedInvocations.size());
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(orderedInvocations.size());
+    for (size_t index = 0; index < orderedInvocations.size(); ++index) {
+        pbxbuild::Tool::Invocation const &invocation = orderedInvocations[index];
+
+        std::unordered_set<size_t> dependencies;
+        for (std::vector<std::string> const *paths : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+            for (std::string const &path : *paths) {
+                auto it = outputToIndex.find(path);
+                if (it != outputToIndex.end() && it->second != index) {
+                    dependencies.insert(it->second);
+                }
+            }
         }
 
-        if (!_dryRun) {
-            bool success = true;
+        for (size_t dependency : dependencies) {
+            dependents[dependency].push_back(index);
+        }
+        invocationDependencies[index] = std::vector<size_t>(dependencies.begin(), dependencies.end());
+        remainingDependencies[index] = dependencies.size();
+    }
+
+    /*
+     * When tracing, find the traced jobs each invocation waits on. Invocations
+     * that don't run pass on the jobs they waited on, so dependents of those
+     * wait on the last jobs that did run.
+     */
+    std::vector<size_t> targetJobs = (TargetJobs != nullptr ? *TargetJobs : std::vector<size_t>());
+    std::vector<std::vector<size_t>> finishedJobs = std::vector<std::vector<size_t>>(orderedInvocations.size());
+    std::vector<bool> traced = std::vector<bool>(orderedInvocations.size(), false);
+    auto waitingJobs = [&](size_t index) -> std::vector<size_t> {
+        if (invocationDependencies[index].empty()) {
+            return targetJobs;
+        }
+        return MergeJobs(finishedJobs, invocationDependencies[index]);
+    };
+
+    /*
+     * Ready invocations run in their original order. With a single job, this
+     * is exactly the order the invocations were passed in.
+     */
+    std::set<size_t> ready;
+    for (size_t index = 0; index < orderedInvocations.size(); ++index) {
+        if (remainingDependencies[index] == 0) {
+            ready.insert(index);
+        }
+    }
+
+    size_t finished = 0;
+    auto finish = [&](size_t index) {
+        finished++;
+        if (_tracer != nullptr && !traced[index]) {
+            finishedJobs[index] = waitingJobs(index);
+        }
+        for (size_t dependent : dependents[index]) {
+            if (--remainingDependencies[dependent] == 0) {
+                ready.insert(dependent);
+            }
+        }
+    };
+
+    std::vector<pbxbuild::Tool::Invocation> failures;
+    std::unordered_map<size_t, std::string> runningExecutables;
+    std::unordered_map<size_t, std::tuple<size_t, uint64_t, std::vector<size_t>>> runningTraces;
+    JobPool::Group group(_jobPool.get());
+
+    while (true) {
+        /* Start as many ready invocations as there are jobs available. Stop starting new ones after a failure. */
+        while (failures.empty() && !ready.empty()) {
+            size_t index = *ready.begin();
+            pbxbuild::Tool::Invocation const &invocation = orderedInvocations[index];
+
+            // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+            if (!invocation.executable() || invocation.createsProductStructure() != createProductStructure || _dryRun) {
+                ready.erase(ready.begin());
+                finish(index);
+                continue;
+            }
+
+            /* Nothing changed since the invocation last succeeded. */
+            if (buildState != nullptr && buildState->upToDate(filesystem, invocation)) {
+                ready.erase(ready.begin());
+                finish(index);
+                continue;
+            }
+            pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
 
+            if (!group.acquire()) {
+                break;
+            }
+            ready.erase(ready.begin());
+
+            bool created = true;
             for (std::string const &output : invocation.outputs()) {
                 std::string directory = FSUtil::GetDirectoryName(output);
 
                 if (!filesystem->createDirectory(directory, true)) {
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    created = false;
+                    break;
                 }
             }
+            if (!created) {
+                group.release();
+                failures.push_back(invocation);
+                break;
+            }
 
             if (ext::optional<std::string> const &builtin = executable.builtin()) {
-                /* Builtin tool, find and run in-process. */
+                /* Builtin tool, find and run in-process on a worker thread. */
                 if (std::shared_ptr<builtin::Driver> driver = _builtins.driver(*builtin)) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
+                    Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
 
                     process::MemoryContext context = process::MemoryContext(
                         *builtin,
@@ -261,13 +726,23 @@ performInvocations(
                         processContext->groupID(),
                         processContext->userName(),
                         processContext->groupName());
-                    int exitCode = driver->run(&context, filesystem);
-                    success = (exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure));
+                    runningExecutables.insert({ index, *builtin });
+                    if (_tracer != nullptr) {
+                        runningTraces.insert({ index, std::make_tuple(_tracer->beginJob(), _tracer->now(), waitingJobs(index)) });
+                    }
+                    ActionCache::Action action = ActionCache::Action::Create(invocation, ext::nullopt);
+                    std::shared_ptr<ActionCache> actionCache = _actionCache;
+                    group.start(index, [driver, context, filesystem, action, actionCache] {
+                        return PerformCached(filesystem, actionCache.get(), action, [&] {
+                            int exitCode = driver->run(&context, filesystem);
+                            return (exitCode == 0);
+                        });
+                    });
                 } else {
                     /* Failed to find builtin tool. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    group.release();
+                    failures.push_back(invocation);
+                    break;
                 }
             } else if (ext::optional<std::string> const &external = executable.external()) {
                 /* External tool, find on the filesystem. */
@@ -281,7 +756,7 @@ performInvocations(
                 }
 
                 if (path) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
+                    Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
 
                     process::MemoryContext context = process::MemoryContext(
                         *path,
@@ -292,24 +767,94 @@ performInvocations(
                         processContext->groupID(),
                         processContext->userName(),
                         processContext->groupName());
-                    ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-                    success = (exitCode && *exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *path, createProductStructure));
+                    runningExecutables.insert({ index, *path });
+                    if (_tracer != nullptr) {
+                        runningTraces.insert({ index, std::make_tuple(_tracer->beginJob(), _tracer->now(), waitingJobs(index)) });
+                    }
+                    ActionCache::Action action = ActionCache::Action::Create(invocation, *path);
+                    std::shared_ptr<ActionCache> actionCache = _actionCache;
+                    group.start(index, [processLauncher, context, filesystem, action, actionCache] {
+                        return PerformCached(filesystem, actionCache.get(), action, [&] {
+                            ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
+                            return (exitCode && *exitCode == 0);
+                        });
+                    });
                 } else {
                     /* Failed to find executable. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    group.release();
+                    failures.push_back(invocation);
+                    break;
                 }
             } else {
                 abort();
             }
+        }
 
-            if (!success) {
-                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+        /* Wait for running invocations to finish, or for another job to become available. */
+        bool waitForJob = (failures.empty() && !ready.empty() && !_jobPool->cancelled());
+        if (group.running() == 0 && !waitForJob) {
+            break;
+        }
+
+        for (JobPool::Group::Result const &result : group.wait(waitForJob)) {
+            pbxbuild::Tool::Invocation const &invocation = orderedInvocations[result.first];
+
+            auto it = runningExecutables.find(result.first);
+            Print(_formatter->finishInvocation(invocation, it->second, createProductStructure));
+
+            auto trace = runningTraces.find(result.first);
+            if (trace != runningTraces.end()) {
+                std::string name = (!invocation.logMessage().empty() ? invocation.logMessage() : FSUtil::GetBaseName(it->second));
+                size_t job = _tracer->finishJob(std::get<0>(trace->second), invocation.toolIdentifier(), name, std::get<1>(trace->second), std::get<2>(trace->second));
+                finishedJobs[result.first] = { job };
+                traced[result.first] = true;
+                runningTraces.erase(trace);
             }
+
+            runningExecutables.erase(it);
+
+            if (!result.second) {
+                failures.push_back(invocation);
+            }
+
+            if (buildState != nullptr) {
+                if (result.second) {
+                    buildState->record(filesystem, invocation);
+                } else {
+                    buildState->invalidate(invocation);
+                }
+            }
+            finish(result.first);
         }
     }
 
+    if (!failures.empty()) {
+        return std::make_pair(false, failures);
+    }
+
+    if (finished != orderedInvocations.size()) {
+        if (_jobPool->cancelled()) {
+            /* Stopped because another target failed. */
+            return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+        }
+
+        fprintf(stderr, "error: cycle detected building invocation graph\n");
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
+    /*
+     * Anything after these invocations waits on the last jobs they ran.
+     */
+    if (_tracer != nullptr && TargetJobs != nullptr && !orderedInvocations.empty()) {
+        std::vector<size_t> last;
+        for (size_t index = 0; index < orderedInvocations.size(); ++index) {
+            if (dependents[index].empty()) {
+                last.push_back(index);
+            }
+        }
+        *TargetJobs = MergeJobs(finishedJobs, last);
+    }
+
     return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
 }
 
@@ -332,27 +877,43 @@ buildTarget(
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
-    xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, true);
-    xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
-    if (!structureResult.first) {
-        return structureResult;
+    /*
+     * Load what was built last time. The state is kept in the target's temp
+     * dir so it is specific to the target and configuration. Dry runs don't
+     * run anything, so they don't need it.
+     */
+    std::string buildStatePath = targetEnvironment.environment().resolve("TARGET_TEMP_DIR") + "/" + ".xcbuild-state";
+    ext::optional<BuildState> buildState;
+    if (!_dryRun) {
+        buildState = BuildState::Load(filesystem, buildStatePath);
     }
 
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, false);
-    if (!invocationsResult.first) {
-        return invocationsResult;
+    Print(_formatter->beginCreateProductStructure(target));
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> result = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, true, buildState ? &*buildState : nullptr);
+    Print(_formatter->finishCreateProductStructure(target));
+
+    if (result.first) {
+        result = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, false, buildState ? &*buildState : nullptr);
     }
 
-    return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+    /* Save even if the build failed, so what did succeed won't run again. */
+    if (buildState && !buildState->save(filesystem, buildStatePath)) {
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
+    return result;
 }
 
 std::unique_ptr<SimpleExecutor> SimpleExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, std::shared_ptr<ActionCache> const &actionCache, std::shared_ptr<Tracer> const &tracer)
 {
     return std::unique_ptr<SimpleExecutor>(new SimpleExecutor(
         formatter,
         dryRun,
-        builtins
+        builtins,
+        jobs,
+        parallelizeTargets,
+        actionCache,
+        tracer
     ));
 }
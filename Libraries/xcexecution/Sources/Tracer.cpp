@@ -0,0 +1,275 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/Tracer.h>
+
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/JSON.h>
+
+#include <algorithm>
+#include <ext/optional>
+
+using xcexecution::Tracer;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Tracer::Event::
+Event(std::string const &category, std::string const &name, uint64_t start, uint64_t duration, Lane lane, size_t index) :
+    _category         (category),
+    _name             (name),
+    _start            (start),
+    _duration         (duration),
+    _lane             (lane),
+    _index            (index),
+    _identifier       (0),
+    _dependenciesKnown(false)
+{
+}
+
+Tracer::Event::
+Event(std::string const &category, std::string const &name, uint64_t start, uint64_t duration, Lane lane, size_t index, size_t identifier, std::vector<size_t> const &predecessors) :
+    _category         (category),
+    _name             (name),
+    _start            (start),
+    _duration         (duration),
+    _lane             (lane),
+    _index            (index),
+    _identifier       (identifier),
+    _dependenciesKnown(true),
+    _predecessors     (predecessors)
+{
+}
+
+Tracer::
+Tracer() :
+    _epoch(std::chrono::steady_clock::now()),
+    _jobs (0)
+{
+}
+
+Tracer::
+~Tracer()
+{
+}
+
+uint64_t Tracer::
+now() const
+{
+    auto elapsed = std::chrono::steady_clock::now() - _epoch;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void Tracer::
+span(std::string const &category, std::string const &name, uint64_t start)
+{
+    uint64_t end = now();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    /* Number threads in the order they are first seen. */
+    auto it = _threadLanes.find(std::this_thread::get_id());
+    if (it == _threadLanes.end()) {
+        it = _threadLanes.insert({ std::this_thread::get_id(), _threadLanes.size() }).first;
+    }
+
+    _events.push_back(Event(category, name, start, end - start, Lane::Thread, it->second));
+}
+
+size_t Tracer::
+beginJob()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t lane = 0; lane < _jobLanes.size(); ++lane) {
+        if (!_jobLanes[lane]) {
+            _jobLanes[lane] = true;
+            return lane;
+        }
+    }
+
+    _jobLanes.push_back(true);
+    return _jobLanes.size() - 1;
+}
+
+size_t Tracer::
+finishJob(size_t lane, std::string const &category, std::string const &name, uint64_t start)
+{
+    uint64_t end = now();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobLanes[lane] = false;
+    _events.push_back(Event(category, name, start, end - start, Lane::Job, lane));
+    return _jobs++;
+}
+
+size_t Tracer::
+finishJob(size_t lane, std::string const &category, std::string const &name, uint64_t start, std::vector<size_t> const &predecessors)
+{
+    uint64_t end = now();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobLanes[lane] = false;
+    _events.push_back(Event(category, name, start, end - start, Lane::Job, lane, _jobs, predecessors));
+    return _jobs++;
+}
+
+void Tracer::
+record(Event const &event)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _events.push_back(event);
+}
+
+std::vector<Tracer::Event> Tracer::
+events() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _events;
+}
+
+xcformatter::BuildStatistics Tracer::
+statistics(uint64_t processTime, uint64_t childProcessTime) const
+{
+    std::vector<Event> events = this->events();
+
+    std::vector<xcformatter::BuildStatistics::Invocation> invocations;
+    std::unordered_map<size_t, std::vector<std::pair<uint64_t, uint64_t>>> planning;
+    for (Event const &event : events) {
+        if (event.lane() == Lane::Job) {
+            if (event.dependenciesKnown()) {
+                invocations.push_back(xcformatter::BuildStatistics::Invocation(event.category(), event.name(), event.start(), event.duration(), event.identifier(), event.predecessors()));
+            } else {
+                invocations.push_back(xcformatter::BuildStatistics::Invocation(event.category(), event.name(), event.start(), event.duration()));
+            }
+        } else if (event.category() == "plan") {
+            planning[event.index()].push_back({ event.start(), event.start() + event.duration() });
+        }
+    }
+
+    /*
+     * Merge overlapping planning on each thread, so work recorded both as
+     * a whole and in parts isn't counted twice.
+     */
+    uint64_t planningTime = 0;
+    for (auto &entry : planning) {
+        std::vector<std::pair<uint64_t, uint64_t>> &spans = entry.second;
+        std::sort(spans.begin(), spans.end());
+
+        uint64_t end = 0;
+        for (std::pair<uint64_t, uint64_t> const &span : spans) {
+            uint64_t start = std::max(span.first, end);
+            if (span.second > start) {
+                planningTime += span.second - start;
+                end = span.second;
+            }
+        }
+    }
+
+    return xcformatter::BuildStatistics(now(), planningTime, processTime, childProcessTime, invocations);
+}
+
+/*
+ * Trace viewers group lanes by process, so each kind of lane is shown as a
+ * separate process.
+ */
+static int64_t
+LaneProcess(Tracer::Lane lane)
+{
+    switch (lane) {
+        case Tracer::Lane::Thread:
+            return 1;
+        case Tracer::Lane::Job:
+            return 2;
+        default: abort();
+    }
+}
+
+static std::unique_ptr<plist::Dictionary>
+MetadataEvent(std::string const &name, int64_t process, ext::optional<int64_t> thread, std::string const &value)
+{
+    auto arguments = plist::Dictionary::New();
+    arguments->set("name", plist::String::New(value));
+
+    auto event = plist::Dictionary::New();
+    event->set("name", plist::String::New(name));
+    event->set("ph", plist::String::New("M"));
+    event->set("pid", plist::Integer::New(process));
+    if (thread) {
+        event->set("tid", plist::Integer::New(*thread));
+    }
+    event->set("args", std::move(arguments));
+    return event;
+}
+
+bool Tracer::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    std::vector<Event> events = this->events();
+
+    auto traceEvents = plist::Array::New();
+    traceEvents->append(MetadataEvent("process_name", LaneProcess(Lane::Thread), ext::nullopt, "xcbuild"));
+    traceEvents->append(MetadataEvent("process_name", LaneProcess(Lane::Job), ext::nullopt, "Jobs"));
+
+    /*
+     * Name each lane used.
+     */
+    size_t threadLanes = 0;
+    size_t jobLanes = 0;
+    for (Event const &event : events) {
+        size_t *lanes = (event.lane() == Lane::Thread ? &threadLanes : &jobLanes);
+        *lanes = std::max(*lanes, event.index() + 1);
+    }
+    for (size_t lane = 0; lane < threadLanes; ++lane) {
+        traceEvents->append(MetadataEvent("thread_name", LaneProcess(Lane::Thread), lane, "Thread " + std::to_string(lane)));
+    }
+    for (size_t lane = 0; lane < jobLanes; ++lane) {
+        traceEvents->append(MetadataEvent("thread_name", LaneProcess(Lane::Job), lane, "Job " + std::to_string(lane)));
+    }
+
+    /*
+     * Each event is a complete event, with a start and a duration.
+     */
+    for (Event const &event : events) {
+        auto traceEvent = plist::Dictionary::New();
+        traceEvent->set("name", plist::String::New(event.name()));
+        traceEvent->set("cat", plist::String::New(event.category()));
+        traceEvent->set("ph", plist::String::New("X"));
+        traceEvent->set("ts", plist::Integer::New(event.start()));
+        traceEvent->set("dur", plist::Integer::New(event.duration()));
+        traceEvent->set("pid", plist::Integer::New(LaneProcess(event.lane())));
+        traceEvent->set("tid", plist::Integer::New(event.index()));
+        traceEvents->append(std::move(traceEvent));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("traceEvents", std::move(traceEvents));
+    root->set("displayTimeUnit", plist::String::New("ms"));
+
+    auto serialize = plist::Format::JSON::Serialize(root.get(), plist::Format::JSON::Create());
+    if (serialize.first == nullptr) {
+        return false;
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    return filesystem->write(*serialize.first, path);
+}
+
+std::shared_ptr<Tracer> Tracer::
+Create()
+{
+    return std::make_shared<Tracer>();
+}
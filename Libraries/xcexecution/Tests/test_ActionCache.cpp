@@ -0,0 +1,219 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ActionCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::ActionCache;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(ActionCache, RestoreOutputs)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xcbuild", Contents("xcbuild")),
+        MemoryFilesystem::Entry::File("input", Contents("input")),
+        MemoryFilesystem::Entry::File("header", Contents("header")),
+    });
+
+    auto cache = ActionCache::Create("/cache", std::string("/xcbuild"));
+    auto action = ActionCache::Action(
+        "fingerprint",
+        ext::nullopt,
+        "/",
+        { "input" },
+        { "output/file", "output/file.d" },
+        { { dependency::DependencyInfoFormat::Makefile, "output/file.d" } });
+
+    /* Nothing is cached to begin with. */
+    ext::optional<std::string> key = cache->key(&filesystem, action);
+    ASSERT_TRUE(key);
+    EXPECT_FALSE(cache->restore(&filesystem, action, *key));
+
+    /* Store the outputs of running the action. */
+    ASSERT_TRUE(filesystem.createDirectory("/output", false));
+    ASSERT_TRUE(filesystem.write(Contents("output"), "/output/file"));
+    ASSERT_TRUE(filesystem.write(Contents("/output/file: /header\n"), "/output/file.d"));
+    ASSERT_TRUE(cache->store(&filesystem, action, *key));
+
+    /* Restore after the outputs are removed. */
+    ASSERT_TRUE(filesystem.removeFile("/output/file"));
+    ASSERT_TRUE(cache->restore(&filesystem, action, *key));
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/output/file"));
+    EXPECT_EQ(Contents("output"), contents);
+
+    /* Restored outputs are newer than the inputs. */
+    uint64_t size;
+    uint64_t inputTime;
+    uint64_t outputTime;
+    ASSERT_TRUE(filesystem.readInfo("/input", &size, &inputTime));
+    ASSERT_TRUE(filesystem.readInfo("/output/file", &size, &outputTime));
+    EXPECT_GT(outputTime, inputTime);
+
+    /* Modifying a restored output doesn't modify the cache. */
+    ASSERT_TRUE(filesystem.write(Contents("modified"), "/output/file"));
+    ASSERT_TRUE(cache->restore(&filesystem, action, *key));
+    contents.clear();
+    ASSERT_TRUE(filesystem.read(&contents, "/output/file"));
+    EXPECT_EQ(Contents("output"), contents);
+
+    /* Changing an input changes the key. */
+    ASSERT_TRUE(filesystem.write(Contents("changed"), "/input"));
+    ext::optional<std::string> changedKey = cache->key(&filesystem, action);
+    ASSERT_TRUE(changedKey);
+    EXPECT_NE(*key, *changedKey);
+    EXPECT_FALSE(cache->restore(&filesystem, action, *changedKey));
+
+    /* Changing the input back uses the cached outputs again. */
+    ASSERT_TRUE(filesystem.write(Contents("input"), "/input"));
+    EXPECT_EQ(key, cache->key(&filesystem, action));
+    EXPECT_TRUE(cache->restore(&filesystem, action, *key));
+
+    /* A change to a discovered input isn't part of the key, but prevents restoring. */
+    ASSERT_TRUE(filesystem.write(Contents("changed"), "/header"));
+    EXPECT_EQ(key, cache->key(&filesystem, action));
+    EXPECT_FALSE(cache->restore(&filesystem, action, *key));
+}
+
+TEST(ActionCache, Uncacheable)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xcbuild", Contents("xcbuild")),
+        MemoryFilesystem::Entry::Directory("directory", { }),
+    });
+
+    auto cache = ActionCache::Create("/cache", std::string("/xcbuild"));
+
+    /* No outputs to restore. */
+    auto noOutputs = ActionCache::Action("fingerprint", ext::nullopt, "/", { }, { }, { });
+    EXPECT_FALSE(cache->key(&filesystem, noOutputs));
+
+    /* Directory contents aren't hashed. */
+    auto directoryInput = ActionCache::Action("fingerprint", ext::nullopt, "/", { "/directory" }, { "/output" }, { });
+    EXPECT_FALSE(cache->key(&filesystem, directoryInput));
+
+    /* Missing inputs are fine, they might be optional. */
+    auto missingInput = ActionCache::Action("fingerprint", ext::nullopt, "/", { "/missing" }, { "/output" }, { });
+    EXPECT_TRUE(cache->key(&filesystem, missingInput));
+}
+
+TEST(ActionCache, BuiltinExecutable)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xcbuild", Contents("xcbuild")),
+        MemoryFilesystem::Entry::File("tool", Contents("tool")),
+    });
+
+    auto action = ActionCache::Action("fingerprint", ext::nullopt, "/", { }, { "/output" }, { });
+    auto external = ActionCache::Action("fingerprint", std::string("/tool"), "/", { }, { "/output" }, { });
+
+    /* Builtin tools can't be cached without knowing what runs them. */
+    auto uncached = ActionCache::Create("/cache", ext::nullopt);
+    EXPECT_FALSE(uncached->key(&filesystem, action));
+    EXPECT_TRUE(uncached->key(&filesystem, external));
+
+    /* Updating the builtin executable changes the key of builtin tools only. */
+    auto cache = ActionCache::Create("/cache", std::string("/xcbuild"));
+    ext::optional<std::string> key = cache->key(&filesystem, action);
+    ext::optional<std::string> externalKey = cache->key(&filesystem, external);
+    ASSERT_TRUE(key);
+    ASSERT_TRUE(externalKey);
+
+    ASSERT_TRUE(filesystem.write(Contents("xcbuild updated"), "/xcbuild"));
+    EXPECT_NE(key, cache->key(&filesystem, action));
+    EXPECT_EQ(externalKey, cache->key(&filesystem, external));
+}
+
+TEST(ActionCache, DamagedObject)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xcbuild", Contents("xcbuild")),
+    });
+
+    auto cache = ActionCache::Create("/cache", std::string("/xcbuild"));
+    auto action = ActionCache::Action("fingerprint", ext::nullopt, "/", { }, { "/output" }, { });
+    ext::optional<std::string> key = cache->key(&filesystem, action);
+    ASSERT_TRUE(key);
+
+    ASSERT_TRUE(filesystem.write(Contents("output"), "/output"));
+    ASSERT_TRUE(cache->store(&filesystem, action, *key));
+
+    /* Only the stored object is left in the cache; no temporary files. */
+    std::vector<std::string> objects;
+    ASSERT_TRUE(filesystem.readDirectory("/cache/objects", true, [&](std::string const &path) {
+        if (filesystem.type("/cache/objects/" + path) == libutil::Filesystem::Type::File) {
+            objects.push_back("/cache/objects/" + path);
+        }
+    }));
+    ASSERT_EQ(1, objects.size());
+
+    /* A damaged object is not restored. */
+    ASSERT_TRUE(filesystem.write(Contents("damaged"), objects.front()));
+    ASSERT_TRUE(filesystem.write(Contents("modified"), "/output"));
+    EXPECT_FALSE(cache->restore(&filesystem, action, *key));
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/output"));
+    EXPECT_EQ(Contents("modified"), contents);
+
+    /* Storing again repairs it. */
+    ASSERT_TRUE(filesystem.write(Contents("output"), "/output"));
+    ASSERT_TRUE(cache->store(&filesystem, action, *key));
+    ASSERT_TRUE(filesystem.write(Contents("modified"), "/output"));
+    EXPECT_TRUE(cache->restore(&filesystem, action, *key));
+}
+
+TEST(ActionCache, DiscoveredInputVariants)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xcbuild", Contents("xcbuild")),
+        MemoryFilesystem::Entry::File("header", Contents("one")),
+    });
+
+    auto cache = ActionCache::Create("/cache", std::string("/xcbuild"));
+    auto action = ActionCache::Action(
+        "fingerprint",
+        ext::nullopt,
+        "/",
+        { },
+        { "/output", "/output.d" },
+        { { dependency::DependencyInfoFormat::Makefile, "/output.d" } });
+    ext::optional<std::string> key = cache->key(&filesystem, action);
+    ASSERT_TRUE(key);
+
+    /* Store the results with two versions of a discovered input. */
+    ASSERT_TRUE(filesystem.write(Contents("/output: /header\n"), "/output.d"));
+    ASSERT_TRUE(filesystem.write(Contents("output one"), "/output"));
+    ASSERT_TRUE(cache->store(&filesystem, action, *key));
+
+    ASSERT_TRUE(filesystem.write(Contents("two"), "/header"));
+    EXPECT_FALSE(cache->restore(&filesystem, action, *key));
+    ASSERT_TRUE(filesystem.write(Contents("output two"), "/output"));
+    ASSERT_TRUE(cache->store(&filesystem, action, *key));
+
+    /* Both are kept, so switching back restores the earlier result. */
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.write(Contents("one"), "/header"));
+    ASSERT_TRUE(cache->restore(&filesystem, action, *key));
+    ASSERT_TRUE(filesystem.read(&contents, "/output"));
+    EXPECT_EQ(Contents("output one"), contents);
+
+    ASSERT_TRUE(filesystem.write(Contents("two"), "/header"));
+    ASSERT_TRUE(cache->restore(&filesystem, action, *key));
+    contents.clear();
+    ASSERT_TRUE(filesystem.read(&contents, "/output"));
+    EXPECT_EQ(Contents("output two"), contents);
+}
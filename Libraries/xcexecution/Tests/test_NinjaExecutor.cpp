@@ -0,0 +1,233 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/Tracer.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxproj/PBX/Project.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::NinjaExecutor;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(NinjaExecutor, PruneConfigurations)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("ninja", {
+            MemoryFilesystem::Entry::Directory("unused", { }),
+            MemoryFilesystem::Entry::Directory("a", { }),
+            MemoryFilesystem::Entry::Directory("b", { }),
+            MemoryFilesystem::Entry::Directory("c", { }),
+            MemoryFilesystem::Entry::Directory("d", { }),
+            MemoryFilesystem::Entry::Directory("current", { }),
+        }),
+    });
+
+    /* Use each configuration in turn, least recent first. */
+    for (std::string const &name : { "a", "b", "c", "d" }) {
+        ASSERT_TRUE(NinjaExecutor::MarkConfigurationUsed(&filesystem, "/ninja/" + name));
+    }
+
+    /* Configurations never used are removed first, then the least recently used. */
+    NinjaExecutor::PruneConfigurations(&filesystem, "/ninja/d", 3);
+    EXPECT_FALSE(filesystem.exists("/ninja/unused"));
+    EXPECT_FALSE(filesystem.exists("/ninja/current"));
+    EXPECT_FALSE(filesystem.exists("/ninja/a"));
+    EXPECT_TRUE(filesystem.exists("/ninja/b"));
+    EXPECT_TRUE(filesystem.exists("/ninja/c"));
+    EXPECT_TRUE(filesystem.exists("/ninja/d"));
+
+    /* Using a configuration again makes it the most recent. */
+    ASSERT_TRUE(NinjaExecutor::MarkConfigurationUsed(&filesystem, "/ninja/b"));
+    NinjaExecutor::PruneConfigurations(&filesystem, "/ninja/b", 2);
+    EXPECT_TRUE(filesystem.exists("/ninja/b"));
+    EXPECT_FALSE(filesystem.exists("/ninja/c"));
+    EXPECT_TRUE(filesystem.exists("/ninja/d"));
+}
+
+TEST(NinjaExecutor, PruneKeepsCurrentConfiguration)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("ninja", {
+            MemoryFilesystem::Entry::Directory("current", { }),
+            MemoryFilesystem::Entry::Directory("other", { }),
+        }),
+    });
+
+    /* Even if it looks less recently used than the others, the current configuration stays. */
+    ASSERT_TRUE(NinjaExecutor::MarkConfigurationUsed(&filesystem, "/ninja/other"));
+    NinjaExecutor::PruneConfigurations(&filesystem, "/ninja/current", 1);
+    EXPECT_TRUE(filesystem.exists("/ninja/current"));
+    EXPECT_FALSE(filesystem.exists("/ninja/other"));
+
+    /* With no limit, only the current configuration is kept. */
+    NinjaExecutor::PruneConfigurations(&filesystem, "/ninja/current", 0);
+    EXPECT_TRUE(filesystem.exists("/ninja/current"));
+}
+
+TEST(NinjaExecutor, TraceLog)
+{
+    std::string log =
+        "# ninja log v5\n"
+        "0\t10\t0\t/build/file.aux\thash-aux\n"
+        "0\t20\t0\t/build/a.o\thash-a\n"
+        "20\t50\t0\t/build/app\thash-app\n";
+    std::string tools =
+        "com.apple.compilers.llvm.clang.1_0 /build/a.o\n"
+        "com.apple.pbx.linkers.ld /build/app\n";
+
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("config", {
+            MemoryFilesystem::Entry::File(".ninja_log", std::vector<uint8_t>(log.begin(), log.end())),
+            MemoryFilesystem::Entry::Directory("targets", {
+                MemoryFilesystem::Entry::File("target.ninja-tools", std::vector<uint8_t>(tools.begin(), tools.end())),
+            }),
+        }),
+    });
+
+    auto tracer = xcexecution::Tracer::Create();
+    NinjaExecutor::TraceLog(&filesystem, "/config", 0, 0, tracer.get());
+
+    /* Commands are grouped by the tool that generated them. */
+    xcformatter::BuildStatistics statistics = tracer->statistics(0, 0);
+    std::vector<xcformatter::BuildStatistics::Tool> statisticsTools = statistics.tools();
+    ASSERT_EQ(3, statisticsTools.size());
+    EXPECT_EQ("com.apple.pbx.linkers.ld", statisticsTools[0].name());
+    EXPECT_EQ(30000, statisticsTools[0].duration());
+    EXPECT_EQ("com.apple.compilers.llvm.clang.1_0", statisticsTools[1].name());
+    EXPECT_EQ("ninja", statisticsTools[2].name());
+
+    /* Ninja doesn't log dependencies, so the critical path is from timing. */
+    EXPECT_FALSE(statistics.criticalPathFromDependencies());
+}
+
+TEST(NinjaExecutor, TargetFingerprint)
+{
+    /* A project whose configuration includes a second xcconfig, and two targets. */
+    auto filesystem = MemoryFilesystem({ });
+    ASSERT_TRUE(filesystem.createDirectory("/project/Project.xcodeproj", true));
+    ASSERT_TRUE(filesystem.createDirectory("/specs", true));
+    ASSERT_TRUE(filesystem.createDirectory("/ninja", true));
+    ASSERT_TRUE(filesystem.write(Contents(
+        "{\n"
+        "    archiveVersion = 1;\n"
+        "    objectVersion = 46;\n"
+        "    objects = {\n"
+        "        P = { isa = PBXProject; buildConfigurationList = PL; targets = (A, B); };\n"
+        "        PL = { isa = XCConfigurationList; buildConfigurations = (PD); };\n"
+        "        PD = { isa = XCBuildConfiguration; name = Debug; baseConfigurationReference = F; buildSettings = { }; };\n"
+        "        F = { isa = PBXFileReference; path = /project/Base.xcconfig; sourceTree = \"<absolute>\"; };\n"
+        "        A = { isa = PBXNativeTarget; name = A; productName = A; buildPhases = (); };\n"
+        "        B = { isa = PBXNativeTarget; name = B; productName = B; buildPhases = (); };\n"
+        "    };\n"
+        "    rootObject = P;\n"
+        "}\n"), "/project/Project.xcodeproj/project.pbxproj"));
+    ASSERT_TRUE(filesystem.write(Contents("#include \"Shared.xcconfig\"\nBASE = 1\n"), "/project/Base.xcconfig"));
+    ASSERT_TRUE(filesystem.write(Contents("SHARED = 1\n"), "/project/Shared.xcconfig"));
+    ASSERT_TRUE(filesystem.write(Contents("( )"), "/specs/rules.plist"));
+
+    auto project = pbxproj::PBX::Project::Open(&filesystem, "/project/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+    ASSERT_EQ(2, project->targets().size());
+
+    auto workspaceContext = pbxbuild::WorkspaceContext::Project(&filesystem, "user", pbxsetting::Environment(), project, nullptr);
+    ASSERT_EQ(1, workspaceContext.configs().size());
+    auto buildContext = pbxbuild::Build::Context(workspaceContext, nullptr, nullptr, "build", "Debug", false, { });
+
+    auto specManager = pbxspec::Manager::Create();
+    specManager->registerBuildRules(&filesystem, "/specs/rules.plist");
+
+    std::map<std::string, std::string> settings = { { "A", "1" }, { "B", "1" } };
+    auto fingerprint = [&](pbxproj::PBX::Target::shared_ptr const &target) -> std::string {
+        pbxsetting::Environment environment;
+        environment.insertFront(pbxsetting::Level({ pbxsetting::Setting::Create("VALUE", settings[target->name()]) }), false);
+
+        auto targetEnvironment = pbxbuild::Target::Environment(
+            nullptr,
+            { },
+            { },
+            pbxbuild::Target::BuildRules::Create(specManager, { }, target),
+            { },
+            nullptr,
+            nullptr,
+            nullptr,
+            environment,
+            { },
+            { },
+            "/",
+            { });
+
+        return NinjaExecutor::TargetFingerprint(
+            &filesystem,
+            "generator",
+            NinjaExecutor::SpecificationFingerprint(&filesystem, specManager),
+            "project",
+            buildContext,
+            target,
+            targetEnvironment,
+            { });
+    };
+
+    /* Generate each target, returning the targets written. */
+    auto generate = [&]() -> std::vector<std::string> {
+        std::vector<std::string> written;
+        for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+            std::string path = "/ninja/" + target->name() + ".ninja";
+            bool generated = false;
+            EXPECT_TRUE(NinjaExecutor::GenerateTargetNinja(&filesystem, path, fingerprint(target), [&]() -> bool {
+                return filesystem.write(Contents(target->name()), path);
+            }, &generated));
+            if (generated) {
+                written.push_back(target->name());
+            }
+        }
+        return written;
+    };
+
+    uint64_t size;
+    uint64_t modificationTime;
+    uint64_t unchangedTime;
+
+    EXPECT_EQ(std::vector<std::string>({ "A", "B" }), generate());
+    ASSERT_TRUE(filesystem.readInfo("/ninja/B.ninja", &size, &modificationTime));
+
+    /* Unchanged targets keep their Ninja files untouched. */
+    EXPECT_EQ(std::vector<std::string>(), generate());
+    ASSERT_TRUE(filesystem.readInfo("/ninja/B.ninja", &size, &unchangedTime));
+    EXPECT_EQ(modificationTime, unchangedTime);
+
+    /* Changing one target's settings only writes that target. */
+    settings["A"] = "2";
+    EXPECT_EQ(std::vector<std::string>({ "A" }), generate());
+    ASSERT_TRUE(filesystem.readInfo("/ninja/B.ninja", &size, &unchangedTime));
+    EXPECT_EQ(modificationTime, unchangedTime);
+
+    /* Touching an included xcconfig changes targets using it. */
+    std::string before = fingerprint(project->targets().front());
+    ASSERT_TRUE(filesystem.write(Contents("SHARED = 1\n"), "/project/Shared.xcconfig"));
+    EXPECT_NE(before, fingerprint(project->targets().front()));
+    EXPECT_EQ(std::vector<std::string>({ "A", "B" }), generate());
+
+    /* So does touching a specification file. */
+    std::string specification = NinjaExecutor::SpecificationFingerprint(&filesystem, specManager);
+    before = fingerprint(project->targets().front());
+    ASSERT_TRUE(filesystem.write(Contents("( )"), "/specs/rules.plist"));
+    EXPECT_NE(specification, NinjaExecutor::SpecificationFingerprint(&filesystem, specManager));
+    EXPECT_NE(before, fingerprint(project->targets().front()));
+    EXPECT_EQ(std::vector<std::string>({ "A", "B" }), generate());
+}
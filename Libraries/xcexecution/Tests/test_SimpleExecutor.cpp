@@ -9,14 +9,22 @@
 
 #include <gtest/gtest.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/Tracer.h>
 #include <xcformatter/NullFormatter.h>
+#include <pbxbuild/DirectedGraph.h>
+#include <pbxbuild/Target/Environment.h>
 #include <pbxbuild/Tool/Invocation.h>
+#include <pbxproj/PBX/NativeTarget.h>
 #include <builtin/Driver.h>
 #include <builtin/Registry.h>
 #include <process/MemoryContext.h>
 #include <process/MemoryLauncher.h>
 #include <libutil/MemoryFilesystem.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 using xcexecution::SimpleExecutor;
 using libutil::Filesystem;
 using libutil::MemoryFilesystem;
@@ -95,7 +103,7 @@ TEST(SimpleExecutor, PropagateToolResult)
     /* Create test executor. */
     auto formatter = xcformatter::NullFormatter::Create();
     std::vector<std::string> const executablePaths = { "/" };
-    SimpleExecutor executor = SimpleExecutor(formatter, false, registry);
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 1, false, nullptr, nullptr);
 
     /* Succeed if all tools succeed. */
     auto success = executor.performInvocations(
@@ -143,3 +151,385 @@ TEST(SimpleExecutor, PropagateToolResult)
     EXPECT_EQ(fail2.second.size(), 1);
 }
 
+
+TEST(SimpleExecutor, ParallelInvocations)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("wait-tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("after-tool", std::vector<uint8_t>()),
+    });
+
+    /* Each waiting tool only succeeds if the other one runs at the same time. */
+    std::atomic<int> started = ATOMIC_VAR_INIT(0);
+    std::atomic<int> finished = ATOMIC_VAR_INIT(0);
+    auto launcher = process::MemoryLauncher({
+        { "/wait-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            started++;
+            for (int i = 0; i < 1000 && started < 2; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            finished++;
+            return (started == 2 ? 0 : 1);
+        } },
+        { "/after-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            return (finished == 2 ? 0 : 1);
+        } },
+    });
+
+    auto registry = builtin::Registry::Create({ });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Create invocations to execute. The last depends on the first two. */
+    auto wait1 = pbxbuild::Tool::Invocation();
+    wait1.executable() = pbxbuild::Tool::Invocation::Executable::External("wait-tool");
+    wait1.outputs() = { "/output/wait1" };
+    auto wait2 = pbxbuild::Tool::Invocation();
+    wait2.executable() = pbxbuild::Tool::Invocation::Executable::External("wait-tool");
+    wait2.outputs() = { "/output/wait2" };
+    auto after = pbxbuild::Tool::Invocation();
+    after.executable() = pbxbuild::Tool::Invocation::Executable::External("after-tool");
+    after.inputs() = { "/output/wait1", "/output/wait2" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 4, false, nullptr, nullptr);
+
+    /* Independent invocations run at once; dependent ones wait for them. */
+    auto success = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        executablePaths,
+        {
+            wait1,
+            wait2,
+            after,
+        },
+        false);
+    ASSERT_TRUE(success.first);
+    EXPECT_EQ(success.second.size(), 0);
+    EXPECT_EQ(started, 2);
+    EXPECT_EQ(finished, 2);
+}
+
+TEST(SimpleExecutor, TraceDependencies)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("slow-tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("fast-tool", std::vector<uint8_t>()),
+    });
+
+    auto launcher = process::MemoryLauncher({
+        { "/slow-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return 0;
+        } },
+        { "/fast-tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            return 0;
+        } },
+    });
+
+    auto registry = builtin::Registry::Create({ });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /*
+     * Two compiles, then a link that waits on the slow compile through an
+     * invocation that doesn't run, and on the fast compile directly.
+     */
+    auto slow = pbxbuild::Tool::Invocation();
+    slow.executable() = pbxbuild::Tool::Invocation::Executable::External("slow-tool");
+    slow.toolIdentifier() = "com.apple.compilers.llvm.clang.1_0";
+    slow.outputs() = { "/output/slow.o" };
+    auto fast = pbxbuild::Tool::Invocation();
+    fast.executable() = pbxbuild::Tool::Invocation::Executable::External("fast-tool");
+    fast.toolIdentifier() = "com.apple.compilers.llvm.clang.1_0";
+    fast.outputs() = { "/output/fast.o" };
+    auto skipped = pbxbuild::Tool::Invocation();
+    skipped.inputs() = { "/output/slow.o" };
+    skipped.outputs() = { "/output/skipped" };
+    auto link = pbxbuild::Tool::Invocation();
+    link.executable() = pbxbuild::Tool::Invocation::Executable::External("fast-tool");
+    link.toolIdentifier() = "com.apple.pbx.linkers.ld";
+    link.inputs() = { "/output/skipped", "/output/fast.o" };
+
+    /* Create test executor. */
+    auto tracer = xcexecution::Tracer::Create();
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 4, false, nullptr, tracer);
+
+    auto success = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        executablePaths,
+        {
+            slow,
+            fast,
+            skipped,
+            link,
+        },
+        false);
+    ASSERT_TRUE(success.first);
+
+    /* Time is grouped by each invocation's tool. */
+    xcformatter::BuildStatistics statistics = tracer->statistics(0, 0);
+    std::vector<xcformatter::BuildStatistics::Tool> tools = statistics.tools();
+    ASSERT_EQ(2, tools.size());
+    EXPECT_EQ("com.apple.compilers.llvm.clang.1_0", tools[0].name());
+    EXPECT_EQ(2, tools[0].count());
+    EXPECT_EQ("com.apple.pbx.linkers.ld", tools[1].name());
+
+    /* The critical path follows the real dependencies. */
+    ASSERT_TRUE(statistics.criticalPathFromDependencies());
+    std::vector<xcformatter::BuildStatistics::Invocation> path = statistics.criticalPath();
+    ASSERT_EQ(2, path.size());
+    EXPECT_EQ("slow-tool", path[0].name());
+    EXPECT_EQ("fast-tool", path[1].name());
+    EXPECT_EQ("com.apple.pbx.linkers.ld", path[1].tool());
+}
+
+TEST(SimpleExecutor, ParallelTargets)
+{
+    /* The last target depends on the first two, which are independent. */
+    auto wait1 = std::make_shared<pbxproj::PBX::NativeTarget>();
+    auto wait2 = std::make_shared<pbxproj::PBX::NativeTarget>();
+    auto after = std::make_shared<pbxproj::PBX::NativeTarget>();
+
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> graph;
+    graph.insert(wait1, { });
+    graph.insert(wait2, { });
+    graph.insert(after, { wait1, wait2 });
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 4, true, nullptr, nullptr);
+
+    /* Each waiting target only succeeds if the other one builds at the same time. */
+    std::atomic<int> started = ATOMIC_VAR_INIT(0);
+    std::atomic<int> finished = ATOMIC_VAR_INIT(0);
+    bool afterBuilt = false;
+    auto result = executor.buildTargetsInParallel(graph, { wait1, wait2, after }, [&](pbxproj::PBX::Target::shared_ptr const &target) {
+        if (target == after) {
+            afterBuilt = true;
+            return std::make_pair(finished == 2, std::vector<pbxbuild::Tool::Invocation>());
+        }
+
+        started++;
+        for (int i = 0; i < 1000 && started < 2; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        finished++;
+        return std::make_pair(started == 2, std::vector<pbxbuild::Tool::Invocation>());
+    });
+    EXPECT_TRUE(result.first);
+    EXPECT_TRUE(afterBuilt);
+    EXPECT_EQ(started, 2);
+    EXPECT_EQ(finished, 2);
+
+    /* A dependent target doesn't build after its dependency fails. */
+    afterBuilt = false;
+    auto failure = executor.buildTargetsInParallel(graph, { wait1, wait2, after }, [&](pbxproj::PBX::Target::shared_ptr const &target) {
+        if (target == after) {
+            afterBuilt = true;
+        }
+        return std::make_pair(target != wait1, std::vector<pbxbuild::Tool::Invocation>());
+    });
+    EXPECT_FALSE(failure.first);
+    EXPECT_FALSE(afterBuilt);
+}
+
+TEST(SimpleExecutor, IncrementalInvocations)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("input", std::vector<uint8_t>({ 'a' })),
+        MemoryFilesystem::Entry::File("header", std::vector<uint8_t>({ 'b' })),
+    });
+
+    /* The tool copies its input and reports the header it read as dependency info. */
+    int runs = 0;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            runs++;
+
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, "/input") || !filesystem->write(contents, "/output/file")) {
+                return 1;
+            }
+
+            std::string dependencies = "/output/file: /header\n";
+            if (!filesystem->write(std::vector<uint8_t>(dependencies.begin(), dependencies.end()), "/output/file.d")) {
+                return 1;
+            }
+
+            return 0;
+        } },
+    });
+
+    auto registry = builtin::Registry::Create({ });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.inputs() = { "/input" };
+    invocation.outputs() = { "/output/file" };
+    invocation.dependencyInfo() = { pbxbuild::Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, "/output/file.d") };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 1, false, nullptr, nullptr);
+
+    auto perform = [&](pbxbuild::Tool::Invocation const &invocation, xcexecution::BuildState *state) {
+        return executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, state).first;
+    };
+
+    /* Runs the first time, but not again if nothing changed. */
+    xcexecution::BuildState state;
+    ASSERT_TRUE(perform(invocation, &state));
+    EXPECT_EQ(1, runs);
+    ASSERT_TRUE(perform(invocation, &state));
+    EXPECT_EQ(1, runs);
+
+    /* Runs again when a declared input changes. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'c' }), "/input"));
+    ASSERT_TRUE(perform(invocation, &state));
+    EXPECT_EQ(2, runs);
+
+    /* Runs again when an input from the dependency info changes. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'd' }), "/header"));
+    ASSERT_TRUE(perform(invocation, &state));
+    EXPECT_EQ(3, runs);
+
+    /* Runs again when the command line changes. */
+    auto changed = invocation;
+    changed.arguments() = { "-v" };
+    ASSERT_TRUE(perform(changed, &state));
+    EXPECT_EQ(4, runs);
+
+    /* Runs again when an output is missing. */
+    ASSERT_TRUE(filesystem.removeFile("/output/file"));
+    ASSERT_TRUE(perform(changed, &state));
+    EXPECT_EQ(5, runs);
+
+    /* State persists across builds. */
+    ASSERT_TRUE(state.save(&filesystem, "/state/build-state"));
+    xcexecution::BuildState loaded = xcexecution::BuildState::Load(&filesystem, "/state/build-state");
+    ASSERT_TRUE(perform(changed, &loaded));
+    EXPECT_EQ(5, runs);
+
+    /* Without state, always runs. */
+    ASSERT_TRUE(perform(changed, nullptr));
+    EXPECT_EQ(6, runs);
+}
+
+TEST(SimpleExecutor, AuxiliaryFiles)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("chunk", std::vector<uint8_t>({ 'b' })),
+    });
+
+    auto registry = builtin::Registry::Create({ });
+    auto formatter = xcformatter::NullFormatter::Create();
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 1, false, nullptr, nullptr);
+
+    /* Auxiliary files don't need any of the target environment. */
+    auto target = std::make_shared<pbxproj::PBX::NativeTarget>();
+    auto targetEnvironment = pbxbuild::Target::Environment(
+        nullptr,
+        { },
+        { },
+        pbxbuild::Target::BuildRules::Create(std::make_shared<pbxspec::Manager>(), { }, target),
+        { },
+        nullptr,
+        nullptr,
+        nullptr,
+        pbxsetting::Environment(),
+        { },
+        { },
+        "/",
+        { });
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.auxiliaryFiles().push_back(pbxbuild::Tool::Invocation::AuxiliaryFile("/aux/file", {
+        pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::Data({ 'a' }),
+        pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk::File("/chunk"),
+    }));
+
+    uint64_t size;
+    uint64_t modificationTime;
+    uint64_t unchangedTime;
+    std::vector<uint8_t> contents;
+
+    /* Write the file the first time. */
+    ASSERT_TRUE(executor.writeAuxiliaryFiles(&filesystem, target, targetEnvironment, { invocation }));
+    ASSERT_TRUE(filesystem.read(&contents, "/aux/file"));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'b' }), contents);
+    ASSERT_TRUE(filesystem.readInfo("/aux/file", &size, &modificationTime));
+
+    /* An unchanged file is not written again, so its modification time is kept. */
+    ASSERT_TRUE(executor.writeAuxiliaryFiles(&filesystem, target, targetEnvironment, { invocation }));
+    ASSERT_TRUE(filesystem.readInfo("/aux/file", &size, &unchangedTime));
+    EXPECT_EQ(modificationTime, unchangedTime);
+
+    /* A changed chunk with the same size is written again. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'c' }), "/chunk"));
+    ASSERT_TRUE(executor.writeAuxiliaryFiles(&filesystem, target, targetEnvironment, { invocation }));
+    contents.clear();
+    ASSERT_TRUE(filesystem.read(&contents, "/aux/file"));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'c' }), contents);
+    ASSERT_TRUE(filesystem.readInfo("/aux/file", &size, &unchangedTime));
+    EXPECT_GT(unchangedTime, modificationTime);
+
+    /* So is a file that was changed outside the build. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'x', 'y', 'z' }), "/aux/file"));
+    ASSERT_TRUE(executor.writeAuxiliaryFiles(&filesystem, target, targetEnvironment, { invocation }));
+    contents.clear();
+    ASSERT_TRUE(filesystem.read(&contents, "/aux/file"));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'c' }), contents);
+
+    /* A failed write leaves the existing file in place, and nothing else behind. */
+    ASSERT_TRUE(filesystem.removeFile("/chunk"));
+    EXPECT_FALSE(executor.writeAuxiliaryFiles(&filesystem, target, targetEnvironment, { invocation }));
+    contents.clear();
+    ASSERT_TRUE(filesystem.read(&contents, "/aux/file"));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'c' }), contents);
+
+    std::vector<std::string> files;
+    ASSERT_TRUE(filesystem.readDirectory("/aux", false, [&](std::string const &name) {
+        files.push_back(name);
+    }));
+    EXPECT_EQ(std::vector<std::string>({ "file" }), files);
+}
@@ -0,0 +1,109 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/Tracer.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <thread>
+
+using xcexecution::Tracer;
+using libutil::MemoryFilesystem;
+
+TEST(Tracer, ThreadLanes)
+{
+    auto tracer = Tracer::Create();
+
+    uint64_t start = tracer->now();
+    tracer->span("build", "main", start);
+
+    std::thread thread = std::thread([&] {
+        tracer->span("build", "other", tracer->now());
+    });
+    thread.join();
+
+    /* Each thread gets its own lane, in the order they were seen. */
+    std::vector<Tracer::Event> events = tracer->events();
+    ASSERT_EQ(2, events.size());
+    EXPECT_EQ("main", events[0].name());
+    EXPECT_EQ(Tracer::Lane::Thread, events[0].lane());
+    EXPECT_EQ(0, events[0].index());
+    EXPECT_EQ(start, events[0].start());
+    EXPECT_EQ("other", events[1].name());
+    EXPECT_EQ(Tracer::Lane::Thread, events[1].lane());
+    EXPECT_EQ(1, events[1].index());
+}
+
+TEST(Tracer, JobLanes)
+{
+    auto tracer = Tracer::Create();
+
+    /* Jobs running at the same time use different lanes. */
+    size_t first = tracer->beginJob();
+    size_t second = tracer->beginJob();
+    EXPECT_EQ(0, first);
+    EXPECT_EQ(1, second);
+
+    /* Finished lanes are reused, lowest first. */
+    tracer->finishJob(first, "tool", "first", tracer->now());
+    size_t third = tracer->beginJob();
+    EXPECT_EQ(0, third);
+
+    tracer->finishJob(second, "tool", "second", tracer->now());
+    tracer->finishJob(third, "tool", "third", tracer->now());
+
+    std::vector<Tracer::Event> events = tracer->events();
+    ASSERT_EQ(3, events.size());
+    EXPECT_EQ("first", events[0].name());
+    EXPECT_EQ("tool", events[0].category());
+    EXPECT_EQ(Tracer::Lane::Job, events[0].lane());
+    EXPECT_EQ(0, events[0].index());
+    EXPECT_EQ(1, events[1].index());
+    EXPECT_EQ(0, events[2].index());
+}
+
+TEST(Tracer, Write)
+{
+    auto filesystem = MemoryFilesystem({ });
+    auto tracer = Tracer::Create();
+
+    tracer->span("build", "Load \"Workspace\"", tracer->now());
+    size_t job = tracer->beginJob();
+    tracer->finishJob(job, "com.apple.compilers.llvm.clang.1_0", "CompileC main.o", tracer->now());
+
+    ASSERT_TRUE(tracer->write(&filesystem, "/trace/build.json"));
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/trace/build.json"));
+    std::string json = std::string(contents.begin(), contents.end());
+    EXPECT_NE(std::string::npos, json.find("\"traceEvents\""));
+    EXPECT_NE(std::string::npos, json.find("\"Load \\\"Workspace\\\"\""));
+    EXPECT_NE(std::string::npos, json.find("\"CompileC main.o\""));
+    EXPECT_NE(std::string::npos, json.find("\"thread_name\""));
+}
+
+TEST(Tracer, Statistics)
+{
+    auto tracer = Tracer::Create();
+
+    /* Nested planning on the same thread is only counted once. */
+    tracer->record(Tracer::Event("plan", "Generate", 0, 100, Tracer::Lane::Thread, 0));
+    tracer->record(Tracer::Event("plan", "Resolve Phases", 20, 30, Tracer::Lane::Thread, 0));
+    tracer->record(Tracer::Event("plan", "Create Environment", 10, 50, Tracer::Lane::Thread, 1));
+    tracer->record(Tracer::Event("target", "Build Target", 0, 500, Tracer::Lane::Thread, 0));
+    tracer->record(Tracer::Event("cc", "CompileC main.o", 100, 200, Tracer::Lane::Job, 0));
+
+    xcformatter::BuildStatistics statistics = tracer->statistics(7, 9);
+    EXPECT_EQ(150, statistics.planningTime());
+    EXPECT_EQ(7, statistics.processTime());
+    EXPECT_EQ(9, statistics.childProcessTime());
+    ASSERT_EQ(1, statistics.invocations().size());
+    EXPECT_EQ("cc", statistics.invocations()[0].tool());
+    EXPECT_EQ(200, statistics.invocations()[0].duration());
+}
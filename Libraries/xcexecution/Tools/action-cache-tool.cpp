@@ -0,0 +1,247 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <process/DefaultContext.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+
+using xcexecution::ActionCache;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+
+class Options {
+private:
+    ext::optional<bool>        _help;
+    ext::optional<bool>        _version;
+
+private:
+    ext::optional<std::string> _cache;
+    ext::optional<std::string> _fingerprint;
+    ext::optional<std::string> _executable;
+    std::vector<std::string>   _inputs;
+    std::vector<std::string>   _outputs;
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _dependencyInfo;
+
+private:
+    std::vector<std::string>   _command;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help.value_or(false); }
+    bool version() const
+    { return _version.value_or(false); }
+
+public:
+    ext::optional<std::string> const &cache() const
+    { return _cache; }
+    ext::optional<std::string> const &fingerprint() const
+    { return _fingerprint; }
+    ext::optional<std::string> const &executable() const
+    { return _executable; }
+    std::vector<std::string> const &inputs() const
+    { return _inputs; }
+    std::vector<std::string> const &outputs() const
+    { return _outputs; }
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo() const
+    { return _dependencyInfo; }
+
+public:
+    std::vector<std::string> const &command() const
+    { return _command; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::Current<bool>(&_help, arg);
+    } else if (arg == "-v" || arg == "--version") {
+        return libutil::Options::Current<bool>(&_version, arg);
+    } else if (arg == "--cache") {
+        return libutil::Options::Next<std::string>(&_cache, args, it);
+    } else if (arg == "--fingerprint") {
+        return libutil::Options::Next<std::string>(&_fingerprint, args, it);
+    } else if (arg == "--executable") {
+        return libutil::Options::Next<std::string>(&_executable, args, it);
+    } else if (arg == "--input") {
+        return libutil::Options::AppendNext<std::string>(&_inputs, args, it);
+    } else if (arg == "--output") {
+        return libutil::Options::AppendNext<std::string>(&_outputs, args, it);
+    } else if (arg == "--dependency-info") {
+        ext::optional<std::string> value;
+        std::pair<bool, std::string> result = libutil::Options::Next<std::string>(&value, args, it);
+        if (!result.first) {
+            return result;
+        }
+
+        std::string::size_type offset = value->find(':');
+        if (offset == std::string::npos || offset == 0 || offset == value->size() - 1) {
+            return std::make_pair(false, "unknown dependency info " + *value + " (use format:/path/to/info)");
+        }
+
+        dependency::DependencyInfoFormat format;
+        std::string name = value->substr(0, offset);
+        if (!dependency::DependencyInfoFormats::Parse(name, &format)) {
+            return std::make_pair(false, "unknown format " + name);
+        }
+
+        _dependencyInfo.push_back({ format, value->substr(offset + 1) });
+        return std::make_pair(true, std::string());
+    } else if (arg == "--") {
+        /* Everything after is the command to run. */
+        _command = std::vector<std::string>(std::next(*it), args.end());
+        *it = std::prev(args.end());
+        return std::make_pair(true, std::string());
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: action-cache-tool [options] -- command [arguments]\n\n");
+    fprintf(stderr, "Runs a command, or restores its outputs from the action cache.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, INDENT "-v, --version\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Action Options:\n");
+    fprintf(stderr, INDENT "--cache <path>\n");
+    fprintf(stderr, INDENT "--fingerprint <fingerprint>\n");
+    fprintf(stderr, INDENT "--executable <path>\n");
+    fprintf(stderr, INDENT "--input <path>\n");
+    fprintf(stderr, INDENT "--output <path>\n");
+    fprintf(stderr, INDENT "--dependency-info <format>:<path>\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+static int
+Version()
+{
+    printf("action-cache-tool version 1\n");
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+    process::DefaultLauncher processLauncher = process::DefaultLauncher();
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext.commandLineArguments());
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    /*
+     * Handle the basic options.
+     */
+    if (options.help()) {
+        return Help();
+    } else if (options.version()) {
+        return Version();
+    }
+
+    /*
+     * Diagnose missing options.
+     */
+    if (!options.cache() || !options.fingerprint() || options.command().empty()) {
+        return Help("missing option(s)");
+    }
+
+    ActionCache cache = ActionCache(*options.cache(), ext::nullopt);
+    ActionCache::Action action = ActionCache::Action(
+        *options.fingerprint(),
+        options.executable(),
+        processContext.currentDirectory(),
+        options.inputs(),
+        options.outputs(),
+        options.dependencyInfo());
+
+    /*
+     * Use the cached outputs if possible.
+     */
+    ext::optional<std::string> key = cache.key(&filesystem, action);
+    if (key && cache.restore(&filesystem, action, *key)) {
+        return 0;
+    }
+
+    /*
+     * Run the command in the current environment.
+     */
+    process::MemoryContext context = process::MemoryContext(
+        options.command().front(),
+        processContext.currentDirectory(),
+        std::vector<std::string>(options.command().begin() + 1, options.command().end()),
+        processContext.environmentVariables(),
+        processContext.userID(),
+        processContext.groupID(),
+        processContext.userName(),
+        processContext.groupName());
+
+    ext::optional<int> exitCode = processLauncher.launch(&filesystem, &context);
+    if (!exitCode) {
+        fprintf(stderr, "error: failed to launch %s\n", options.command().front().c_str());
+        return -1;
+    }
+    if (*exitCode != 0) {
+        return *exitCode;
+    }
+
+    /*
+     * Save the outputs for next time. Failing to is not an error.
+     */
+    if (key) {
+        cache.store(&filesystem, action, *key);
+    }
+
+    return 0;
+}
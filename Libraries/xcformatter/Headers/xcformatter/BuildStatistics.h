@@ -0,0 +1,198 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcformatter_BuildStatistics_h
+#define __xcformatter_BuildStatistics_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xcformatter {
+
+/*
+ * Where the time in a build went, for reporting once it finishes. All
+ * times are in microseconds.
+ */
+class BuildStatistics {
+public:
+    /*
+     * An invocation that ran during the build.
+     */
+    class Invocation {
+    private:
+        std::string         _tool;
+        std::string         _name;
+        uint64_t            _start;
+        uint64_t            _duration;
+
+    private:
+        size_t              _identifier;
+        bool                _dependenciesKnown;
+        std::vector<size_t> _predecessors;
+
+    public:
+        Invocation(std::string const &tool, std::string const &name, uint64_t start, uint64_t duration);
+        Invocation(std::string const &tool, std::string const &name, uint64_t start, uint64_t duration, size_t identifier, std::vector<size_t> const &predecessors);
+
+    public:
+        /*
+         * The tool that ran, and a description of what it did.
+         */
+        std::string const &tool() const
+        { return _tool; }
+        std::string const &name() const
+        { return _name; }
+
+    public:
+        /*
+         * When the invocation started, relative to the start of the build,
+         * and how long it ran for.
+         */
+        uint64_t start() const
+        { return _start; }
+        uint64_t duration() const
+        { return _duration; }
+        uint64_t end() const
+        { return _start + _duration; }
+
+    public:
+        /*
+         * Identifies the invocation among those in the build.
+         */
+        size_t identifier() const
+        { return _identifier; }
+
+        /*
+         * If the invocations this one waited on for its inputs are known.
+         */
+        bool dependenciesKnown() const
+        { return _dependenciesKnown; }
+
+        /*
+         * The identifiers of the invocations this one waited on for its
+         * inputs, if known.
+         */
+        std::vector<size_t> const &predecessors() const
+        { return _predecessors; }
+    };
+
+    /*
+     * The time spent in all invocations of one tool.
+     */
+    class Tool {
+    private:
+        std::string _name;
+        size_t      _count;
+        uint64_t    _duration;
+
+    public:
+        Tool(std::string const &name, size_t count, uint64_t duration);
+
+    public:
+        std::string const &name() const
+        { return _name; }
+        size_t count() const
+        { return _count; }
+        uint64_t duration() const
+        { return _duration; }
+    };
+
+private:
+    uint64_t                _wallTime;
+    uint64_t                _planningTime;
+    uint64_t                _processTime;
+    uint64_t                _childProcessTime;
+    std::vector<Invocation> _invocations;
+
+public:
+    BuildStatistics(
+        uint64_t wallTime,
+        uint64_t planningTime,
+        uint64_t processTime,
+        uint64_t childProcessTime,
+        std::vector<Invocation> const &invocations);
+
+public:
+    /*
+     * How long the build took from start to finish.
+     */
+    uint64_t wallTime() const
+    { return _wallTime; }
+
+    /*
+     * Time xcbuild spent preparing to run invocations, like loading the
+     * workspace, creating target environments, and resolving phases.
+     */
+    uint64_t planningTime() const
+    { return _planningTime; }
+
+    /*
+     * CPU time used by xcbuild itself, including built-in tools that run
+     * inside of it.
+     */
+    uint64_t processTime() const
+    { return _processTime; }
+
+    /*
+     * CPU time used by the child processes xcbuild ran.
+     */
+    uint64_t childProcessTime() const
+    { return _childProcessTime; }
+
+public:
+    /*
+     * The invocations run, in the order they finished.
+     */
+    std::vector<Invocation> const &invocations() const
+    { return _invocations; }
+
+    /*
+     * The total time spent running invocations.
+     */
+    uint64_t invocationTime() const;
+
+    /*
+     * The average number of invocations running at once over the build.
+     */
+    double parallelism() const;
+
+public:
+    /*
+     * If the critical path follows the dependencies between invocations,
+     * rather than being estimated from when they ran.
+     */
+    bool criticalPathFromDependencies() const;
+
+    /*
+     * The chain of invocations that determined how long the build took.
+     *
+     * If every invocation knows its predecessors, this is the chain of
+     * dependent invocations with the longest total duration. Otherwise, like
+     * for Ninja logs, it is estimated from timing: starting from the last
+     * invocation to finish, each invocation on the path is preceded by the
+     * last one to finish before it started, whether it waited on that for an
+     * input or for a free job.
+     */
+    std::vector<Invocation> criticalPath() const;
+
+    /*
+     * The `count` invocations that took the longest, slowest first.
+     */
+    std::vector<Invocation> slowestInvocations(size_t count) const;
+
+    /*
+     * The time spent in each tool, slowest first.
+     */
+    std::vector<Tool> tools() const;
+};
+
+}
+
+#endif // !__xcformatter_BuildStatistics_h
@@ -53,6 +53,9 @@ public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
     virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
 
+public:
+    virtual std::string statistics(BuildStatistics const &statistics);
+
 public:
     /*
      * Creates a default formatter. If color is true, terminal escapes
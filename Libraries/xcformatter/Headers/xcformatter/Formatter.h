@@ -19,8 +19,12 @@ namespace Tool { class Invocation; }
 
 namespace xcformatter {
 
+class BuildStatistics;
+
 /*
- * Abstract formatter for build output.
+ * Abstract formatter for build output. When targets build in parallel, the
+ * executor calls the formatter from multiple threads; formatters that keep
+ * state between calls must synchronize access to it.
  */
 class Formatter {
 protected:
@@ -57,6 +61,12 @@ public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
     virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
 
+public:
+    /*
+     * Reports where the time in a build went, after it finishes.
+     */
+    virtual std::string statistics(BuildStatistics const &statistics) = 0;
+
 public:
     /*
      * Utility function to print a formatted string to standard output. This
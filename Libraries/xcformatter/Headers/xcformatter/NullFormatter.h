@@ -50,6 +50,9 @@ public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
     virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
 
+public:
+    virtual std::string statistics(BuildStatistics const &statistics);
+
 public:
     static std::shared_ptr<NullFormatter> Create();
 };
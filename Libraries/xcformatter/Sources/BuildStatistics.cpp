@@ -0,0 +1,213 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcformatter/BuildStatistics.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+using xcformatter::BuildStatistics;
+
+BuildStatistics::Invocation::
+Invocation(std::string const &tool, std::string const &name, uint64_t start, uint64_t duration) :
+    _tool             (tool),
+    _name             (name),
+    _start            (start),
+    _duration         (duration),
+    _identifier       (0),
+    _dependenciesKnown(false)
+{
+}
+
+BuildStatistics::Invocation::
+Invocation(std::string const &tool, std::string const &name, uint64_t start, uint64_t duration, size_t identifier, std::vector<size_t> const &predecessors) :
+    _tool             (tool),
+    _name             (name),
+    _start            (start),
+    _duration         (duration),
+    _identifier       (identifier),
+    _dependenciesKnown(true),
+    _predecessors     (predecessors)
+{
+}
+
+BuildStatistics::Tool::
+Tool(std::string const &name, size_t count, uint64_t duration) :
+    _name    (name),
+    _count   (count),
+    _duration(duration)
+{
+}
+
+BuildStatistics::
+BuildStatistics(
+    uint64_t wallTime,
+    uint64_t planningTime,
+    uint64_t processTime,
+    uint64_t childProcessTime,
+    std::vector<Invocation> const &invocations) :
+    _wallTime        (wallTime),
+    _planningTime    (planningTime),
+    _processTime     (processTime),
+    _childProcessTime(childProcessTime),
+    _invocations     (invocations)
+{
+    std::stable_sort(_invocations.begin(), _invocations.end(), [](Invocation const &a, Invocation const &b) {
+        return a.end() < b.end();
+    });
+}
+
+uint64_t BuildStatistics::
+invocationTime() const
+{
+    uint64_t total = 0;
+    for (Invocation const &invocation : _invocations) {
+        total += invocation.duration();
+    }
+    return total;
+}
+
+double BuildStatistics::
+parallelism() const
+{
+    if (_wallTime == 0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(invocationTime()) / static_cast<double>(_wallTime);
+}
+
+bool BuildStatistics::
+criticalPathFromDependencies() const
+{
+    if (_invocations.empty()) {
+        return false;
+    }
+
+    for (Invocation const &invocation : _invocations) {
+        if (!invocation.dependenciesKnown()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The dependency chain with the longest total duration. Predecessors finish
+ * before their dependents start, so invocations ordered by when they
+ * finished are also ordered after their predecessors.
+ */
+static std::vector<BuildStatistics::Invocation>
+LongestDependencyPath(std::vector<BuildStatistics::Invocation> const &invocations)
+{
+    std::unordered_map<size_t, size_t> identifierToIndex;
+    std::vector<uint64_t> pathDuration = std::vector<uint64_t>(invocations.size(), 0);
+    std::vector<size_t> previous = std::vector<size_t>(invocations.size(), SIZE_MAX);
+
+    size_t last = 0;
+    for (size_t index = 0; index < invocations.size(); ++index) {
+        BuildStatistics::Invocation const &invocation = invocations[index];
+
+        for (size_t predecessor : invocation.predecessors()) {
+            auto it = identifierToIndex.find(predecessor);
+            if (it != identifierToIndex.end() && (previous[index] == SIZE_MAX || pathDuration[it->second] > pathDuration[previous[index]])) {
+                previous[index] = it->second;
+            }
+        }
+
+        pathDuration[index] = invocation.duration() + (previous[index] != SIZE_MAX ? pathDuration[previous[index]] : 0);
+        identifierToIndex.insert({ invocation.identifier(), index });
+
+        if (pathDuration[index] >= pathDuration[last]) {
+            last = index;
+        }
+    }
+
+    std::vector<BuildStatistics::Invocation> path;
+    for (size_t index = last; index != SIZE_MAX; index = previous[index]) {
+        path.push_back(invocations[index]);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<BuildStatistics::Invocation> BuildStatistics::
+criticalPath() const
+{
+    std::vector<Invocation> path;
+    if (_invocations.empty()) {
+        return path;
+    }
+
+    if (criticalPathFromDependencies()) {
+        return LongestDependencyPath(_invocations);
+    }
+
+    /*
+     * Invocations are ordered by when they finished, so the invocation
+     * each one waited on is the last one before it that finished by the
+     * time it started.
+     */
+    size_t index = _invocations.size() - 1;
+    while (true) {
+        Invocation const &invocation = _invocations[index];
+        path.push_back(invocation);
+
+        auto it = std::upper_bound(_invocations.begin(), _invocations.begin() + index, invocation.start(), [](uint64_t start, Invocation const &other) {
+            return start < other.end();
+        });
+        if (it == _invocations.begin()) {
+            break;
+        }
+
+        index = std::distance(_invocations.begin(), it) - 1;
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<BuildStatistics::Invocation> BuildStatistics::
+slowestInvocations(size_t count) const
+{
+    std::vector<Invocation> slowest = _invocations;
+    std::stable_sort(slowest.begin(), slowest.end(), [](Invocation const &a, Invocation const &b) {
+        return a.duration() > b.duration();
+    });
+
+    if (slowest.size() > count) {
+        slowest.erase(slowest.begin() + count, slowest.end());
+    }
+    return slowest;
+}
+
+std::vector<BuildStatistics::Tool> BuildStatistics::
+tools() const
+{
+    std::vector<Tool> tools;
+    std::unordered_map<std::string, size_t> indexes;
+    for (Invocation const &invocation : _invocations) {
+        auto it = indexes.find(invocation.tool());
+        if (it == indexes.end()) {
+            it = indexes.insert({ invocation.tool(), tools.size() }).first;
+            tools.push_back(Tool(invocation.tool(), 0, 0));
+        }
+
+        Tool const &tool = tools[it->second];
+        tools[it->second] = Tool(tool.name(), tool.count() + 1, tool.duration() + invocation.duration());
+    }
+
+    std::stable_sort(tools.begin(), tools.end(), [](Tool const &a, Tool const &b) {
+        return a.duration() > b.duration();
+    });
+    return tools;
+}
@@ -8,10 +8,12 @@
  */
 
 #include <xcformatter/DefaultFormatter.h>
+#include <xcformatter/BuildStatistics.h>
 #include <pbxbuild/Tool/Invocation.h>
 #include <pbxbuild/Build/Context.h>
 
 #include <algorithm>
+#include <cstdio>
 
 using xcformatter::DefaultFormatter;
 
@@ -49,6 +51,14 @@ FormatInvocation(pbxbuild::Tool::Invocation const &invocation, bool _color)
     return message;
 }
 
+static std::string
+FormatTime(uint64_t microseconds)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.2fs", static_cast<double>(microseconds) / 1000000.0);
+    return buffer;
+}
+
 static std::string
 FormatAction(std::string const &action)
 {
@@ -263,6 +273,59 @@ finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
     }
 }
 
+/*
+ * How many of the slowest invocations to report.
+ */
+static size_t const SlowestInvocationCount = 10;
+
+std::string DefaultFormatter::
+statistics(BuildStatistics const &statistics)
+{
+    std::string result;
+
+    result += ANSI_STYLE_BOLD + "Build statistics:" + ANSI_STYLE_NO_BOLD + "\n";
+    result += INDENT + "Wall time: " + FormatTime(statistics.wallTime()) + "\n";
+    result += INDENT + "Planning: " + FormatTime(statistics.planningTime()) + "\n";
+    result += INDENT + "CPU time: " + FormatTime(statistics.processTime()) + " in xcbuild, " + FormatTime(statistics.childProcessTime()) + " in child processes\n";
+
+    char parallelism[32];
+    snprintf(parallelism, sizeof(parallelism), "%.2fx", statistics.parallelism());
+    result += INDENT + "Invocations: " + std::to_string(statistics.invocations().size()) + " taking " + FormatTime(statistics.invocationTime()) + ", " + parallelism + " parallelism\n";
+    result += "\n";
+
+    if (statistics.invocations().empty()) {
+        return result;
+    }
+
+    std::vector<BuildStatistics::Invocation> criticalPath = statistics.criticalPath();
+    uint64_t criticalPathTime = 0;
+    for (BuildStatistics::Invocation const &invocation : criticalPath) {
+        criticalPathTime += invocation.duration();
+    }
+
+    /* Without dependencies, the path is only a guess from when invocations ran. */
+    std::string criticalPathLabel = (statistics.criticalPathFromDependencies() ? "Critical path:" : "Critical path (estimated from timing):");
+    result += ANSI_STYLE_BOLD + criticalPathLabel + ANSI_STYLE_NO_BOLD + " " + std::to_string(criticalPath.size()) + " invocations taking " + FormatTime(criticalPathTime) + "\n";
+    for (BuildStatistics::Invocation const &invocation : criticalPath) {
+        result += INDENT + FormatTime(invocation.duration()) + "  " + invocation.name() + "\n";
+    }
+    result += "\n";
+
+    result += ANSI_STYLE_BOLD + "Slowest invocations:" + ANSI_STYLE_NO_BOLD + "\n";
+    for (BuildStatistics::Invocation const &invocation : statistics.slowestInvocations(SlowestInvocationCount)) {
+        result += INDENT + FormatTime(invocation.duration()) + "  " + invocation.name() + " (" + invocation.tool() + ")\n";
+    }
+    result += "\n";
+
+    result += ANSI_STYLE_BOLD + "Time by tool:" + ANSI_STYLE_NO_BOLD + "\n";
+    for (BuildStatistics::Tool const &tool : statistics.tools()) {
+        result += INDENT + FormatTime(tool.duration()) + "  " + tool.name() + " (" + std::to_string(tool.count()) + " invocation" + (tool.count() != 1 ? "s" : "") + ")\n";
+    }
+    result += "\n";
+
+    return result;
+}
+
 std::shared_ptr<DefaultFormatter> DefaultFormatter::
 Create(bool color)
 {
@@ -122,6 +122,12 @@ finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
     return std::string();
 }
 
+std::string NullFormatter::
+statistics(BuildStatistics const &statistics)
+{
+    return std::string();
+}
+
 std::shared_ptr<NullFormatter> NullFormatter::
 Create()
 {
@@ -0,0 +1,106 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcformatter/BuildStatistics.h>
+#include <xcformatter/DefaultFormatter.h>
+
+using xcformatter::BuildStatistics;
+using xcformatter::DefaultFormatter;
+
+static BuildStatistics
+CreateStatistics()
+{
+    /*
+     * Two compiles run at once, then a link waits on the slower one, then
+     * a copy runs alongside a short compile started while linking.
+     */
+    return BuildStatistics(100, 10, 5, 200, {
+        BuildStatistics::Invocation("cc", "CompileC b.o", 0, 40),
+        BuildStatistics::Invocation("cc", "CompileC a.o", 0, 20),
+        BuildStatistics::Invocation("ld", "Ld app", 40, 30),
+        BuildStatistics::Invocation("cc", "CompileC c.o", 50, 10),
+        BuildStatistics::Invocation("cp", "CpResource data", 70, 30),
+    });
+}
+
+TEST(BuildStatistics, Totals)
+{
+    BuildStatistics statistics = CreateStatistics();
+    EXPECT_EQ(130, statistics.invocationTime());
+    EXPECT_DOUBLE_EQ(1.3, statistics.parallelism());
+
+    /* Invocations are ordered by when they finished. */
+    ASSERT_EQ(5, statistics.invocations().size());
+    EXPECT_EQ("CompileC a.o", statistics.invocations()[0].name());
+    EXPECT_EQ("CpResource data", statistics.invocations()[4].name());
+}
+
+TEST(BuildStatistics, CriticalPath)
+{
+    std::vector<BuildStatistics::Invocation> path = CreateStatistics().criticalPath();
+    ASSERT_EQ(3, path.size());
+    EXPECT_EQ("CompileC b.o", path[0].name());
+    EXPECT_EQ("Ld app", path[1].name());
+    EXPECT_EQ("CpResource data", path[2].name());
+
+    EXPECT_TRUE(BuildStatistics(0, 0, 0, 0, { }).criticalPath().empty());
+}
+
+TEST(BuildStatistics, CriticalPathFromDependencies)
+{
+    /*
+     * The same timing, but the copy only depends on the short compile. The
+     * link and the copy both end the build, and the link's chain is longer.
+     */
+    BuildStatistics statistics = BuildStatistics(100, 10, 5, 200, {
+        BuildStatistics::Invocation("cc", "CompileC b.o", 0, 40, 1, { }),
+        BuildStatistics::Invocation("cc", "CompileC a.o", 0, 20, 0, { }),
+        BuildStatistics::Invocation("ld", "Ld app", 40, 30, 2, { 0, 1 }),
+        BuildStatistics::Invocation("cc", "CompileC c.o", 50, 10, 3, { }),
+        BuildStatistics::Invocation("cp", "CpResource data", 70, 20, 4, { 3 }),
+    });
+    EXPECT_TRUE(statistics.criticalPathFromDependencies());
+
+    std::vector<BuildStatistics::Invocation> path = statistics.criticalPath();
+    ASSERT_EQ(2, path.size());
+    EXPECT_EQ("CompileC b.o", path[0].name());
+    EXPECT_EQ("Ld app", path[1].name());
+
+    /* Timing is only used when dependencies aren't known for every invocation. */
+    EXPECT_FALSE(CreateStatistics().criticalPathFromDependencies());
+}
+
+TEST(BuildStatistics, Slowest)
+{
+    std::vector<BuildStatistics::Invocation> slowest = CreateStatistics().slowestInvocations(2);
+    ASSERT_EQ(2, slowest.size());
+    EXPECT_EQ("CompileC b.o", slowest[0].name());
+    EXPECT_EQ(40, slowest[0].duration());
+    EXPECT_EQ(30, slowest[1].duration());
+}
+
+TEST(BuildStatistics, Tools)
+{
+    std::vector<BuildStatistics::Tool> tools = CreateStatistics().tools();
+    ASSERT_EQ(3, tools.size());
+    EXPECT_EQ("cc", tools[0].name());
+    EXPECT_EQ(3, tools[0].count());
+    EXPECT_EQ(70, tools[0].duration());
+    EXPECT_EQ(1, tools[1].count());
+    EXPECT_EQ(30, tools[1].duration());
+}
+
+TEST(BuildStatistics, DefaultFormatter)
+{
+    std::string output = DefaultFormatter(false).statistics(CreateStatistics());
+    EXPECT_NE(std::string::npos, output.find("Critical path (estimated from timing): 3 invocations"));
+    EXPECT_NE(std::string::npos, output.find("CompileC b.o (cc)"));
+    EXPECT_NE(std::string::npos, output.find("cc (3 invocations)"));
+}